@@ -0,0 +1,51 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "SVolumetricCloudsHistogram.h"
+#include "VolumetricCloudsStatistics.h"
+#include "EditorStyleSet.h"
+#include "Rendering/DrawElements.h"
+
+void SVolumetricCloudsHistogram::Construct(const FArguments& InArgs)
+{
+	Statistics = InArgs._Statistics;
+	Channel = InArgs._Channel;
+	Color = InArgs._Color;
+}
+
+int32 SVolumetricCloudsHistogram::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	const FSlateBrush* WhiteBrush = FEditorStyle::GetBrush("WhiteBrush");
+	const FVector2D Size = AllottedGeometry.GetLocalSize();
+
+	FSlateDrawElement::MakeBox(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(), WhiteBrush, ESlateDrawEffect::None, FLinearColor(0.02f, 0.02f, 0.02f, 1.0f));
+
+	const FVolumetricCloudsStatistics* Stats = Statistics ? Statistics() : nullptr;
+
+	if (Stats == nullptr || !Stats->IsValid())
+	{
+		return LayerId;
+	}
+
+	const uint64* Histogram = Stats->GetHistogram(Channel);
+	const double MaxCount = FMath::Max<double>(Stats->GetMaxBinCount(Channel), 1.0);
+	const float BinWidth = Size.X / FVolumetricCloudsStatistics::NumBins;
+
+	for (int32 Bin = 0; Bin < FVolumetricCloudsStatistics::NumBins; Bin++)
+	{
+		const float BarHeight = Size.Y * float(Histogram[Bin] / MaxCount);
+
+		if (BarHeight > 0.0f)
+		{
+			FSlateDrawElement::MakeBox(OutDrawElements, LayerId + 1,
+				AllottedGeometry.ToPaintGeometry(FVector2D(Bin * BinWidth, Size.Y - BarHeight), FVector2D(FMath::Max(BinWidth - 1.0f, 1.0f), BarHeight)),
+				WhiteBrush, ESlateDrawEffect::None, Color);
+		}
+	}
+
+	return LayerId + 1;
+}
+
+FVector2D SVolumetricCloudsHistogram::ComputeDesiredSize(float LayoutScaleMultiplier) const
+{
+	return FVector2D(FVolumetricCloudsStatistics::NumBins * 4.0f, 48.0f);
+}
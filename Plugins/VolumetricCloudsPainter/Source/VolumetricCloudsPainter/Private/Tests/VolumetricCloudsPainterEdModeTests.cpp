@@ -0,0 +1,373 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VolumetricCloudsPainterTestFixture.h"
+#include "VolumetricCloudsLayerStack.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/Texture2D.h"
+#include "Components/StaticMeshComponent.h"
+#include "Materials/MaterialInstanceConstant.h"
+
+/**
+* Editor mode tests, run headless with:
+* UE4Editor-Cmd FullEnvironmentDev.uproject -nullrhi -unattended -ExecCmds="Automation RunTests VolumetricCloudsPainter.EdMode;Quit"
+*/
+namespace VolumetricCloudsPainterEdModeTests
+{
+	typedef FVolumetricCloudsPainterTestFixture FFixture;
+
+	/** Value a single full opacity stamp adds to the base layer. */
+	const float StampStep = 0.1f;
+
+	/** World position of a weather map UV in the first repeat. */
+	FVector UVToWorld(const FVector2D& UV)
+	{
+		return FVector(UV.X * FFixture::RepeatSize - FFixture::RepeatSize / 2.0f, UV.Y * FFixture::RepeatSize - FFixture::RepeatSize / 2.0f, 0.0f);
+	}
+
+	/** Hard edged full opacity brush, so a stamp changes texels under it by exactly StampStep. */
+	void SetupBrush(FFixture& Fixture, float Radius = 0.02f)
+	{
+		Fixture.EdMode.SetBrushRadius(Radius);
+		Fixture.EdMode.SetBrushFalloff(0.0f);
+		Fixture.EdMode.SetBrushOpacity(1.0f);
+	}
+
+	/** Texture bound to the WeatherMap parameter of the clouds material. */
+	UTexture* GetBoundWeatherMap(const FFixture& Fixture)
+	{
+		UTexture* Texture = nullptr;
+		Fixture.Material->GetTextureParameterValue(FMaterialParameterInfo("WeatherMap"), Texture);
+
+		return Texture;
+	}
+
+	/** Color with every channel set to Base, except channels in Mask which are set to Painted. */
+	FLinearColor MaskedColor(const FLinearColor& Mask, float Painted, float Base = FFixture::BaseValue)
+	{
+		return FLinearColor(
+			Mask.R > 0.0f ? Painted : Base,
+			Mask.G > 0.0f ? Painted : Base,
+			Mask.B > 0.0f ? Painted : Base,
+			Mask.A > 0.0f ? Painted : Base);
+	}
+
+	/** Default painter channels are red and green. */
+	const FLinearColor DefaultMask = FLinearColor(1.0f, 1.0f, 0.0f, 0.0f);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVolumetricCloudsPainterGetCloudsActorTest, "VolumetricCloudsPainter.EdMode.GetCloudsActor",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FVolumetricCloudsPainterGetCloudsActorTest::RunTest(const FString& Parameters)
+{
+	using namespace VolumetricCloudsPainterEdModeTests;
+
+	{
+		FFixture Fixture(256, false);
+
+		TestFalse(TEXT("Plain static mesh actors are not clouds"), Fixture.Attach());
+		TestNull(TEXT("Clouds actor without clouds"), Fixture.EdMode.CloudsActor);
+		TestNull(TEXT("Canvas without clouds"), Fixture.EdMode.GetCanvas());
+	}
+
+	{
+		FFixture Fixture;
+
+		TestTrue(TEXT("Clouds found"), Fixture.Attach());
+		TestEqual(TEXT("Clouds actor"), Fixture.EdMode.CloudsActor, Fixture.CloudsActor);
+		TestEqual(TEXT("Clouds material"), Fixture.EdMode.CloudsMaterial, Fixture.Material);
+		TestEqual(TEXT("Weather map"), Fixture.EdMode.FinalTexture, Fixture.WeatherMap);
+
+		const FVolumetricCloudsCanvas* Canvas = Fixture.EdMode.GetCanvas();
+
+		if (TestNotNull(TEXT("Canvas"), Canvas))
+		{
+			TestEqual(TEXT("Canvas width"), Canvas->GetSizeX(), 256);
+			TestEqual(TEXT("Canvas height"), Canvas->GetSizeY(), 256);
+			FFixture::TestColor(*this, TEXT("Loaded texel"), Fixture.GetCanvasTexel(FVector2D(0.3f, 0.7f)), MaskedColor(DefaultMask, FFixture::BaseValue));
+		}
+
+		//Clouds removed from the level release the weather map.
+		Fixture.CloudsActor->Destroy();
+
+		TestFalse(TEXT("Destroyed clouds are not found"), Fixture.Attach());
+		TestNull(TEXT("Released clouds actor"), Fixture.EdMode.CloudsActor);
+		TestNull(TEXT("Released weather map"), Fixture.EdMode.FinalTexture);
+		TestNull(TEXT("Released canvas"), Fixture.EdMode.GetCanvas());
+	}
+
+	{
+		FFixture Fixture;
+		Fixture.CloudsActor->GetStaticMeshComponent()->SetMaterial(0, nullptr);
+
+		TestTrue(TEXT("Clouds without a material instance are found"), Fixture.Attach());
+		TestNull(TEXT("No material instance"), Fixture.EdMode.CloudsMaterial);
+		TestNull(TEXT("No canvas without a weather map"), Fixture.EdMode.GetCanvas());
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVolumetricCloudsPainterBrushUVTest, "VolumetricCloudsPainter.EdMode.BrushUV",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FVolumetricCloudsPainterBrushUVTest::RunTest(const FString& Parameters)
+{
+	using namespace VolumetricCloudsPainterEdModeTests;
+
+	/** Brush world position and the weather map UV it has to paint, RepeatSize is 1000 units. */
+	struct FCase
+	{
+		FVector WorldPosition;
+		FVector2D UV;
+	};
+
+	const FCase Cases[] =
+	{
+		{ FVector(0.0f, 0.0f, 0.0f), FVector2D(0.5f, 0.5f) },
+		{ FVector(-250.0f, 250.0f, 0.0f), FVector2D(0.25f, 0.75f) },
+		//One repeat further on X and back on Y.
+		{ FVector(1250.0f, -1125.0f, 0.0f), FVector2D(0.75f, 0.375f) },
+		//Several repeats, negative coordinates wrap to the positive UV range.
+		{ FVector(-2250.0f, 3100.0f, 0.0f), FVector2D(0.25f, 0.6f) },
+		//Clouds altitude doesn't matter.
+		{ FVector(-375.0f, -375.0f, 50000.0f), FVector2D(0.125f, 0.125f) },
+	};
+
+	{
+		FFixture Fixture;
+
+		if (!TestTrue(TEXT("Clouds found"), Fixture.Attach()))
+		{
+			return false;
+		}
+
+		SetupBrush(Fixture);
+
+		for (const FCase& Case : Cases)
+		{
+			const FString What = FString::Printf(TEXT("Brush at %s"), *Case.WorldPosition.ToString());
+
+			TestTrue(What + TEXT(" UV"), FFixture::WorldToUV(Case.WorldPosition).Equals(Case.UV, KINDA_SMALL_NUMBER));
+			FFixture::TestColor(*this, What + TEXT(" before"), Fixture.GetCanvasTexel(Case.UV), MaskedColor(DefaultMask, FFixture::BaseValue));
+
+			Fixture.StampAt(Case.WorldPosition);
+
+			FFixture::TestColor(*this, What + TEXT(" after"), Fixture.GetCanvasTexel(Case.UV), MaskedColor(DefaultMask, FFixture::BaseValue + StampStep));
+		}
+
+		//Mirrored UV of the first case must stay untouched.
+		FFixture::TestColor(*this, TEXT("Unpainted texel"), Fixture.GetCanvasTexel(FVector2D(0.9f, 0.1f)), MaskedColor(DefaultMask, FFixture::BaseValue));
+	}
+
+	{
+		FFixture Fixture;
+
+		if (!TestTrue(TEXT("Clouds found"), Fixture.Attach()))
+		{
+			return false;
+		}
+
+		//Brush on the right edge of the repeat paints the left edge as well.
+		SetupBrush(Fixture, 0.1f);
+		Fixture.StampAt(FVector(FFixture::RepeatSize / 2.0f - 0.4f, 0.0f, 0.0f));
+
+		FFixture::TestColor(*this, TEXT("Right edge"), Fixture.GetCanvasTexel(FVector2D(0.995f, 0.5f)), MaskedColor(DefaultMask, FFixture::BaseValue + StampStep));
+		FFixture::TestColor(*this, TEXT("Wrapped left edge"), Fixture.GetCanvasTexel(FVector2D(0.005f, 0.5f)), MaskedColor(DefaultMask, FFixture::BaseValue + StampStep));
+		FFixture::TestColor(*this, TEXT("Map center"), Fixture.GetCanvasTexel(FVector2D(0.5f, 0.5f)), MaskedColor(DefaultMask, FFixture::BaseValue));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVolumetricCloudsPainterChannelMaskTest, "VolumetricCloudsPainter.EdMode.ChannelMask",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FVolumetricCloudsPainterChannelMaskTest::RunTest(const FString& Parameters)
+{
+	using namespace VolumetricCloudsPainterEdModeTests;
+
+	const FName Channels[] = { "RedChannel", "GreenChannel", "BlueChannel", "AlphaChannel" };
+
+	FFixture Fixture;
+
+	if (!TestTrue(TEXT("Clouds found"), Fixture.Attach()))
+	{
+		return false;
+	}
+
+	SetupBrush(Fixture);
+
+	for (int32 Channel = 0; Channel < ARRAY_COUNT(Channels); Channel++)
+	{
+		for (int32 Other = 0; Other < ARRAY_COUNT(Channels); Other++)
+		{
+			Fixture.EdMode.SetChannelState(Other == Channel, Channels[Other]);
+		}
+
+		TestTrue(FString::Printf(TEXT("%s enabled"), *Channels[Channel].ToString()), Fixture.EdMode.IsChannelEnabled(Channels[Channel]));
+
+		FLinearColor Mask(0.0f, 0.0f, 0.0f, 0.0f);
+		Mask.Component(Channel) = 1.0f;
+
+		const FVector2D UV(0.125f + Channel * 0.25f, 0.5f);
+		Fixture.StampAt(UVToWorld(UV));
+
+		FFixture::TestColor(*this, FString::Printf(TEXT("Only %s painted"), *Channels[Channel].ToString()), Fixture.GetCanvasTexel(UV), MaskedColor(Mask, FFixture::BaseValue + StampStep));
+	}
+
+	//Locked channels everywhere leave the map as it is.
+	for (const FName& Channel : Channels)
+	{
+		Fixture.EdMode.SetChannelState(false, Channel);
+	}
+
+	const FVector2D LockedUV(0.5f, 0.25f);
+	Fixture.StampAt(UVToWorld(LockedUV));
+
+	FFixture::TestColor(*this, TEXT("All channels locked"), Fixture.GetCanvasTexel(LockedUV), FLinearColor(FFixture::BaseValue, FFixture::BaseValue, FFixture::BaseValue, FFixture::BaseValue));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVolumetricCloudsPainterPaintModeTest, "VolumetricCloudsPainter.EdMode.PaintMode",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FVolumetricCloudsPainterPaintModeTest::RunTest(const FString& Parameters)
+{
+	using namespace VolumetricCloudsPainterEdModeTests;
+
+	FFixture Fixture;
+
+	if (!TestTrue(TEXT("Clouds found"), Fixture.Attach()))
+	{
+		return false;
+	}
+
+	SetupBrush(Fixture);
+
+	const FVector2D AddUV(0.25f, 0.25f);
+	const FVector2D SubtractUV(0.75f, 0.25f);
+	const FVector2D SaturateUV(0.25f, 0.75f);
+	const FVector2D ClampUV(0.75f, 0.75f);
+
+	Fixture.EdMode.SetPaintMode(true);
+	Fixture.StampAt(UVToWorld(AddUV));
+	FFixture::TestColor(*this, TEXT("Additive stamp"), Fixture.GetCanvasTexel(AddUV), MaskedColor(DefaultMask, FFixture::BaseValue + StampStep));
+
+	for (int32 Index = 0; Index < 10; Index++)
+	{
+		Fixture.StampAt(UVToWorld(SaturateUV));
+	}
+
+	FFixture::TestColor(*this, TEXT("Additive stamps saturate"), Fixture.GetCanvasTexel(SaturateUV), MaskedColor(DefaultMask, 1.0f));
+
+	Fixture.EdMode.SetPaintMode(false);
+	Fixture.StampAt(UVToWorld(SubtractUV));
+	FFixture::TestColor(*this, TEXT("Subtractive stamp"), Fixture.GetCanvasTexel(SubtractUV), MaskedColor(DefaultMask, FFixture::BaseValue - StampStep));
+
+	for (int32 Index = 0; Index < 10; Index++)
+	{
+		Fixture.StampAt(UVToWorld(ClampUV));
+	}
+
+	FFixture::TestColor(*this, TEXT("Subtractive stamps clamp"), Fixture.GetCanvasTexel(ClampUV), MaskedColor(DefaultMask, 0.0f));
+
+	//Holding left control subtracts while painting.
+	Fixture.EdMode.SetPaintMode(true);
+	Fixture.EdMode.SetPaintState(true);
+
+	Fixture.EdMode.InputKey(nullptr, nullptr, EKeys::LeftControl, IE_Pressed);
+	TestFalse(TEXT("Left control pressed subtracts"), Fixture.EdMode.IsAdditivePaint());
+
+	Fixture.EdMode.InputKey(nullptr, nullptr, EKeys::LeftControl, IE_Released);
+	TestTrue(TEXT("Left control released adds"), Fixture.EdMode.IsAdditivePaint());
+
+	Fixture.EdMode.SetPaintState(false);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVolumetricCloudsPainterPaintStateTest, "VolumetricCloudsPainter.EdMode.PaintStateRoundTrip",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FVolumetricCloudsPainterPaintStateTest::RunTest(const FString& Parameters)
+{
+	using namespace VolumetricCloudsPainterEdModeTests;
+
+	FFixture Fixture;
+
+	if (!TestTrue(TEXT("Clouds found"), Fixture.Attach()))
+	{
+		return false;
+	}
+
+	SetupBrush(Fixture);
+
+	const FVector2D PaintUV(0.5f, 0.5f);
+	const FVector2D UnpaintedUV(0.1f, 0.1f);
+	FTextureSource& Source = Fixture.WeatherMap->Source;
+
+	TestFalse(TEXT("Not painting after attach"), Fixture.EdMode.IsPainiting());
+
+	//Painting shows the render target in place of the weather map.
+	Fixture.EdMode.SetPaintState(true);
+	TestTrue(TEXT("Painting"), Fixture.EdMode.IsPainiting());
+	TestEqual(TEXT("Render target bound while painting"), GetBoundWeatherMap(Fixture), (UTexture*)Fixture.RenderTarget);
+
+	Fixture.StampAt(UVToWorld(PaintUV));
+	FFixture::TestColor(*this, TEXT("Weather map before commit"), Fixture.GetSourceTexel(PaintUV), MaskedColor(DefaultMask, FFixture::BaseValue));
+
+	//Leaving paint mode flattens the canvas into the weather map.
+	Fixture.EdMode.SetPaintState(false);
+	TestFalse(TEXT("Not painting"), Fixture.EdMode.IsPainiting());
+	TestEqual(TEXT("Weather map bound after painting"), GetBoundWeatherMap(Fixture), (UTexture*)Fixture.WeatherMap);
+	FFixture::TestColor(*this, TEXT("Committed texel"), Fixture.GetSourceTexel(PaintUV), MaskedColor(DefaultMask, FFixture::BaseValue + StampStep));
+	FFixture::TestColor(*this, TEXT("Committed unpainted texel"), Fixture.GetSourceTexel(UnpaintedUV), MaskedColor(DefaultMask, FFixture::BaseValue));
+
+	if (TestNotNull(TEXT("Layer stack"), Fixture.EdMode.LayerStack))
+	{
+		TestEqual(TEXT("Layer stack matches the committed weather map"), Fixture.EdMode.LayerStack->FlattenedSourceId, Source.GetId());
+	}
+
+	//Leaving paint mode twice doesn't commit again.
+	const FGuid CommittedId = Source.GetId();
+	Fixture.EdMode.SetPaintState(false);
+	TestEqual(TEXT("No commit without painting"), Source.GetId(), CommittedId);
+
+	//Painting again continues on the canvas instead of reloading the quantized weather map.
+	Fixture.EdMode.SetPaintState(true);
+	FFixture::TestColor(*this, TEXT("Canvas kept"), Fixture.GetCanvasTexel(PaintUV), MaskedColor(DefaultMask, FFixture::BaseValue + StampStep));
+
+	Fixture.StampAt(UVToWorld(PaintUV));
+	Fixture.EdMode.SetPaintState(false);
+	FFixture::TestColor(*this, TEXT("Second commit"), Fixture.GetSourceTexel(PaintUV), MaskedColor(DefaultMask, FFixture::BaseValue + StampStep * 2.0f));
+
+	//Weather map changed outside of the painter is reloaded into the base layer.
+	const float ExternalValue = 0.25f;
+	FFloat16Color* Texels = (FFloat16Color*)Source.LockMip(0);
+
+	for (int32 Index = 0; Index < Source.GetSizeX() * Source.GetSizeY(); Index++)
+	{
+		Texels[Index] = FFloat16Color(FLinearColor(ExternalValue, ExternalValue, ExternalValue, ExternalValue));
+	}
+
+	Source.UnlockMip(0);
+	Source.ForceGenerateGuid();
+
+	AddExpectedError(TEXT("was modified outside of the painter"), EAutomationExpectedErrorFlags::Contains, 1);
+
+	Fixture.EdMode.SetPaintState(true);
+	FFixture::TestColor(*this, TEXT("Reloaded texel"), Fixture.GetCanvasTexel(PaintUV), FLinearColor(ExternalValue, ExternalValue, ExternalValue, ExternalValue));
+
+	Fixture.EdMode.SetPaintState(false);
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,315 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VolumetricCloudsPainterTestFixture.h"
+#include "Interfaces/IPluginManager.h"
+#include "Algo/Find.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "RenderingThread.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVolumetricCloudsPainterPerformance, Log, All);
+
+/**
+* Painter timings, run headless with:
+* UE4Editor-Cmd FullEnvironmentDev.uproject -nullrhi -unattended -ExecCmds="Automation RunTests VolumetricCloudsPainter.Performance;Quit"
+*
+* Every case writes its median, 95th percentile and minimum into Saved/Automation/VolumetricCloudsPainter/Performance.json
+* and fails once its median is slower than the stored baseline times the tolerance. Baselines are machine specific, they
+* live in the plugin Tests/PerformanceBaselines.json and are recorded on the test machine by adding -VolumetricCloudsUpdateBaselines.
+*/
+namespace VolumetricCloudsPainterPerformanceTests
+{
+	typedef FVolumetricCloudsPainterTestFixture FFixture;
+
+	/** Weather map size of the brush cases, the size of the project weather maps. */
+	const int32 BrushMapSize = 2048;
+
+	/** Allowed slowdown against a baseline if the baseline file doesn't set one. */
+	const double DefaultTolerance = 1.25;
+
+	/** Timed case. */
+	struct FCase
+	{
+		const TCHAR* Name;
+		int32 WarmupIterations;
+		int32 Iterations;
+	};
+
+	const FCase Cases[] =
+	{
+		{ TEXT("PaintStamp"), 10, 200 },
+		{ TEXT("BlurStamp"), 10, 200 },
+		{ TEXT("SmudgeStroke"), 10, 200 },
+		{ TEXT("NoiseStamp"), 10, 200 },
+		{ TEXT("FullUpload"), 2, 20 },
+		{ TEXT("Commit"), 1, 5 },
+	};
+
+	FString GetBaselinePath()
+	{
+		return IPluginManager::Get().FindPlugin(TEXT("VolumetricCloudsPainter"))->GetBaseDir() / TEXT("Tests/PerformanceBaselines.json");
+	}
+
+	FString GetReportPath()
+	{
+		return FPaths::AutomationDir() / TEXT("VolumetricCloudsPainter/Performance.json");
+	}
+
+	/** Read a JSON object, an empty object if the file is missing or invalid. */
+	TSharedRef<FJsonObject> ReadJson(const FString& Path)
+	{
+		FString Text;
+		TSharedPtr<FJsonObject> Object;
+
+		if (FFileHelper::LoadFileToString(Text, *Path))
+		{
+			FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Text), Object);
+		}
+
+		return Object.IsValid() ? Object.ToSharedRef() : MakeShared<FJsonObject>();
+	}
+
+	bool WriteJson(const FString& Path, const TSharedRef<FJsonObject>& Object)
+	{
+		FString Text;
+		FJsonSerializer::Serialize(Object, TJsonWriterFactory<>::Create(&Text));
+
+		return FFileHelper::SaveStringToFile(Text, *Path);
+	}
+
+	/** Nested object of a JSON object, created if it doesn't exist. */
+	TSharedRef<FJsonObject> FindOrAddObject(const TSharedRef<FJsonObject>& Object, const FString& Field)
+	{
+		const TSharedPtr<FJsonObject>* Existing = nullptr;
+
+		if (Object->TryGetObjectField(Field, Existing) && Existing->IsValid())
+		{
+			return Existing->ToSharedRef();
+		}
+
+		TSharedRef<FJsonObject> Added = MakeShared<FJsonObject>();
+		Object->SetObjectField(Field, Added);
+
+		return Added;
+	}
+
+	/** Golden ratio sequence of weather map UVs, spreads stamps evenly over the map. */
+	FVector2D GetStampUV(int32 Index)
+	{
+		return FVector2D(FMath::Frac(Index * 0.618034f + 0.1f), FMath::Frac(Index * 0.754877f + 0.3f));
+	}
+
+	FVector UVToWorld(const FVector2D& UV)
+	{
+		return FVector(UV.X * FFixture::RepeatSize - FFixture::RepeatSize / 2.0f, UV.Y * FFixture::RepeatSize - FFixture::RepeatSize / 2.0f, 0.0f);
+	}
+
+	/**
+	* Time a case, record it in the report and compare it against its baseline.
+	* @param Function - called once per iteration with the iteration index, warmup included.
+	* @return false if the case regressed.
+	*/
+	bool Measure(FAutomationTestBase& Test, const FCase& Case, TFunctionRef<void(int32)> Function)
+	{
+		for (int32 Index = 0; Index < Case.WarmupIterations; Index++)
+		{
+			Function(Index);
+			FlushRenderingCommands();
+		}
+
+		TArray<double> Times;
+		Times.Reserve(Case.Iterations);
+
+		for (int32 Index = 0; Index < Case.Iterations; Index++)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			Function(Case.WarmupIterations + Index);
+			Times.Add((FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+			//Uploads are queued for the render thread, they are not part of the game thread time.
+			FlushRenderingCommands();
+		}
+
+		Times.Sort();
+
+		const double Median = Times[Times.Num() / 2];
+		const double Percentile95 = Times[FMath::Min(FMath::CeilToInt(Times.Num() * 0.95) - 1, Times.Num() - 1)];
+		const double Minimum = Times[0];
+
+		const FString BaselinePath = GetBaselinePath();
+		TSharedRef<FJsonObject> Baselines = ReadJson(BaselinePath);
+		TSharedRef<FJsonObject> BaselineCases = FindOrAddObject(Baselines, TEXT("Cases"));
+
+		double Tolerance = DefaultTolerance;
+		Baselines->TryGetNumberField(TEXT("Tolerance"), Tolerance);
+
+		double Baseline = 0.0;
+		const bool bHasBaseline = BaselineCases->TryGetNumberField(Case.Name, Baseline) && Baseline > 0.0;
+		const bool bRegressed = bHasBaseline && Median > Baseline * Tolerance;
+
+		const TCHAR* Status = bRegressed ? TEXT("Regressed") : (bHasBaseline ? TEXT("Passed") : TEXT("NoBaseline"));
+
+		//Report collects every case of a run, a case run again replaces its entry.
+		const FString ReportPath = GetReportPath();
+		TSharedRef<FJsonObject> Report = ReadJson(ReportPath);
+		Report->SetStringField(TEXT("Machine"), FPlatformMisc::GetCPUBrand().TrimStartAndEnd());
+		Report->SetStringField(TEXT("Configuration"), LexToString(FApp::GetBuildConfiguration()));
+		Report->SetStringField(TEXT("Date"), FDateTime::UtcNow().ToIso8601());
+		Report->SetNumberField(TEXT("Tolerance"), Tolerance);
+
+		TSharedRef<FJsonObject> Result = MakeShared<FJsonObject>();
+		Result->SetNumberField(TEXT("Iterations"), Case.Iterations);
+		Result->SetNumberField(TEXT("MedianMs"), Median);
+		Result->SetNumberField(TEXT("P95Ms"), Percentile95);
+		Result->SetNumberField(TEXT("MinMs"), Minimum);
+		Result->SetNumberField(TEXT("BaselineMs"), Baseline);
+		Result->SetStringField(TEXT("Status"), Status);
+		FindOrAddObject(Report, TEXT("Cases"))->SetObjectField(Case.Name, Result);
+
+		if (!WriteJson(ReportPath, Report))
+		{
+			Test.AddWarning(FString::Printf(TEXT("Failed to write %s."), *ReportPath));
+		}
+
+		UE_LOG(LogVolumetricCloudsPainterPerformance, Display, TEXT("%s: median %.3f ms, p95 %.3f ms, min %.3f ms, baseline %.3f ms, %s."),
+			Case.Name, Median, Percentile95, Minimum, Baseline, Status);
+
+		if (FParse::Param(FCommandLine::Get(), TEXT("VolumetricCloudsUpdateBaselines")))
+		{
+			BaselineCases->SetNumberField(Case.Name, Median);
+			Baselines->SetNumberField(TEXT("Tolerance"), Tolerance);
+
+			if (!WriteJson(BaselinePath, Baselines))
+			{
+				Test.AddError(FString::Printf(TEXT("Failed to write %s."), *BaselinePath));
+			}
+
+			return true;
+		}
+
+		if (bRegressed)
+		{
+			Test.AddError(FString::Printf(TEXT("%s median %.3f ms is slower than the %.3f ms baseline times %.2f."), Case.Name, Median, Baseline, Tolerance));
+			return false;
+		}
+
+		if (!bHasBaseline)
+		{
+			Test.AddWarning(FString::Printf(TEXT("%s has no baseline, record one with -VolumetricCloudsUpdateBaselines."), Case.Name));
+		}
+
+		return true;
+	}
+
+	/** Stamp a brush tool at spread out positions of a full size weather map. */
+	bool MeasureBrush(FAutomationTestBase& Test, const FCase& Case, EVolumetricCloudsBrushTool Tool)
+	{
+		FFixture Fixture(BrushMapSize);
+
+		if (!Fixture.Attach())
+		{
+			Test.AddError(TEXT("Clouds not found."));
+			return false;
+		}
+
+		Fixture.EdMode.SetBrushRadius(0.05f);
+		Fixture.EdMode.SetBrushTool(Tool);
+
+		return Measure(Test, Case, [&Fixture](int32 Index)
+		{
+			Fixture.StampAt(UVToWorld(GetStampUV(Index)));
+		});
+	}
+}
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FVolumetricCloudsPainterPerformanceTest, "VolumetricCloudsPainter.Performance",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+void FVolumetricCloudsPainterPerformanceTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	using namespace VolumetricCloudsPainterPerformanceTests;
+
+	for (const FCase& Case : Cases)
+	{
+		OutBeautifiedNames.Add(Case.Name);
+		OutTestCommands.Add(Case.Name);
+	}
+}
+
+bool FVolumetricCloudsPainterPerformanceTest::RunTest(const FString& Parameters)
+{
+	using namespace VolumetricCloudsPainterPerformanceTests;
+
+	const FCase* Case = Algo::FindByPredicate(Cases, [&Parameters](const FCase& Candidate) { return Parameters == Candidate.Name; });
+
+	if (Case == nullptr)
+	{
+		AddError(FString::Printf(TEXT("Unknown case %s."), *Parameters));
+		return false;
+	}
+
+	if (Parameters == TEXT("PaintStamp"))
+	{
+		return MeasureBrush(*this, *Case, EVolumetricCloudsBrushTool::Paint);
+	}
+
+	if (Parameters == TEXT("BlurStamp"))
+	{
+		return MeasureBrush(*this, *Case, EVolumetricCloudsBrushTool::Blur);
+	}
+
+	if (Parameters == TEXT("NoiseStamp"))
+	{
+		return MeasureBrush(*this, *Case, EVolumetricCloudsBrushTool::Noise);
+	}
+
+	FFixture Fixture(BrushMapSize);
+
+	if (!TestTrue(TEXT("Clouds found"), Fixture.Attach()))
+	{
+		return false;
+	}
+
+	if (Parameters == TEXT("SmudgeStroke"))
+	{
+		//One continuous stroke, smudge drags along the previous stamp.
+		Fixture.EdMode.SetBrushRadius(0.05f);
+		Fixture.EdMode.SetBrushTool(EVolumetricCloudsBrushTool::Smudge);
+
+		return Measure(*this, *Case, [&Fixture](int32 Index)
+		{
+			Fixture.StampAt(UVToWorld(FVector2D(0.2f + Index * 0.002f, 0.5f)));
+		});
+	}
+
+	if (Parameters == TEXT("FullUpload"))
+	{
+		//Recompose and upload of the whole map, what loading a weather map and undoing a map operation cost.
+		return Measure(*this, *Case, [&Fixture](int32 Index)
+		{
+			Fixture.EdMode.GetCanvas()->MarkAllDirty();
+			Fixture.EdMode.UpdateRenderTarget();
+		});
+	}
+
+	//Flatten into the weather map source and rebuild the texture, what leaving paint mode costs.
+	return Measure(*this, *Case, [&Fixture](int32 Index)
+	{
+		Fixture.StampAt(UVToWorld(GetStampUV(Index)));
+		Fixture.EdMode.CommitFinalTexture();
+	});
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
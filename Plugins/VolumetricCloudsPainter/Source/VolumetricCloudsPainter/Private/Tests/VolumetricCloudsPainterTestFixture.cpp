@@ -0,0 +1,147 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsPainterTestFixture.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Misc/AutomationTest.h"
+#include "Engine/World.h"
+#include "Engine/Texture2D.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/Blueprint.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Components/StaticMeshComponent.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialInstanceConstant.h"
+#include "Kismet2/KismetEditorUtilities.h"
+#include "UObject/Package.h"
+
+const float FVolumetricCloudsPainterTestFixture::WeatherMapSize = 0.001f;
+const float FVolumetricCloudsPainterTestFixture::RepeatSize = FVolumetricCloudsPainterTestFixture::WeatherMapSize * 1000000.0f;
+const float FVolumetricCloudsPainterTestFixture::BaseValue = 0.5f;
+
+FVolumetricCloudsPainterTestFixture::FVolumetricCloudsPainterTestFixture(int32 InMapSize, bool bSpawnClouds)
+	: MapSize(InMapSize)
+{
+	TArray<FFloat16Color> Texels;
+	Texels.Init(FFloat16Color(FLinearColor(BaseValue, BaseValue, BaseValue, BaseValue)), MapSize * MapSize);
+
+	WeatherMap = NewObject<UTexture2D>(GetTransientPackage(), NAME_None, RF_Transient);
+	WeatherMap->SRGB = false;
+	WeatherMap->CompressionSettings = TC_HDR;
+	WeatherMap->Source.Init(MapSize, MapSize, 1, 1, TSF_RGBA16F, (const uint8*)Texels.GetData());
+	WeatherMap->AddToRoot();
+
+	Material = NewObject<UMaterialInstanceConstant>(GetTransientPackage(), NAME_None, RF_Transient);
+	Material->SetParentEditorOnly(UMaterial::GetDefaultMaterial(MD_Surface));
+	Material->SetScalarParameterValueEditorOnly(FMaterialParameterInfo("WeatherMapSize"), WeatherMapSize);
+	Material->SetTextureParameterValueEditorOnly(FMaterialParameterInfo("WeatherMap"), WeatherMap);
+	Material->AddToRoot();
+
+	//Painter render target asset is shared with the editor, tests upload into their own.
+	RenderTarget = NewObject<UTextureRenderTarget2D>(GetTransientPackage(), NAME_None, RF_Transient);
+	RenderTarget->AddToRoot();
+	EdMode.RenderTarget = RenderTarget;
+
+	World = UWorld::CreateWorld(EWorldType::Editor, false);
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.ObjectFlags = RF_Transient;
+
+	if (bSpawnClouds)
+	{
+		CloudsActor = World->SpawnActor<AStaticMeshActor>(GetCloudsClass(), FTransform::Identity, SpawnParameters);
+		CloudsActor->GetStaticMeshComponent()->SetMaterial(0, Material);
+	}
+	else
+	{
+		World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), FTransform::Identity, SpawnParameters);
+	}
+}
+
+FVolumetricCloudsPainterTestFixture::~FVolumetricCloudsPainterTestFixture()
+{
+	EdMode.ReleaseCoudsActor();
+
+	WeatherMap->RemoveFromRoot();
+	Material->RemoveFromRoot();
+	RenderTarget->RemoveFromRoot();
+
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+}
+
+UClass* FVolumetricCloudsPainterTestFixture::GetCloudsClass()
+{
+	//Painter finds the clouds by class name, the project blueprint is not needed.
+	UPackage* Package = CreatePackage(nullptr, TEXT("/Temp/VolumetricCloudsPainterTests"));
+	UBlueprint* Blueprint = FindObject<UBlueprint>(Package, TEXT("VolumetricClouds"));
+
+	if (Blueprint == nullptr)
+	{
+		Blueprint = FKismetEditorUtilities::CreateBlueprint(AStaticMeshActor::StaticClass(), Package, TEXT("VolumetricClouds"),
+			BPTYPE_Normal, UBlueprint::StaticClass(), UBlueprintGeneratedClass::StaticClass());
+		Blueprint->AddToRoot();
+	}
+
+	return Blueprint->GeneratedClass;
+}
+
+bool FVolumetricCloudsPainterTestFixture::Attach()
+{
+	return EdMode.GetCloudsActor(World);
+}
+
+void FVolumetricCloudsPainterTestFixture::StampAt(const FVector& WorldPosition)
+{
+	EdMode.WorldBrushPos = WorldPosition;
+	EdMode.DrawToRenderTaget();
+}
+
+FLinearColor FVolumetricCloudsPainterTestFixture::GetCanvasTexel(const FVector2D& UV) const
+{
+	const FVolumetricCloudsCanvas* Canvas = EdMode.GetCanvas();
+
+	if (Canvas == nullptr)
+	{
+		return FLinearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	}
+
+	const int32 X = FMath::Clamp(FMath::FloorToInt(UV.X * MapSize), 0, MapSize - 1);
+	const int32 Y = FMath::Clamp(FMath::FloorToInt(UV.Y * MapSize), 0, MapSize - 1);
+
+	return Canvas->GetComposite().GetTexel(X, Y);
+}
+
+FLinearColor FVolumetricCloudsPainterTestFixture::GetSourceTexel(const FVector2D& UV) const
+{
+	const int32 X = FMath::Clamp(FMath::FloorToInt(UV.X * MapSize), 0, MapSize - 1);
+	const int32 Y = FMath::Clamp(FMath::FloorToInt(UV.Y * MapSize), 0, MapSize - 1);
+
+	FTextureSource& Source = WeatherMap->Source;
+	const FFloat16Color* Texels = (const FFloat16Color*)Source.LockMip(0);
+	const FLinearColor Texel = Texels != nullptr ? FLinearColor(Texels[Y * MapSize + X]) : FLinearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	Source.UnlockMip(0);
+
+	return Texel;
+}
+
+FVector2D FVolumetricCloudsPainterTestFixture::WorldToUV(const FVector& WorldPosition)
+{
+	const FVector2D UV = (FVector2D(WorldPosition.X, WorldPosition.Y) + RepeatSize / 2.0f) / RepeatSize;
+
+	return FVector2D(FMath::Frac(UV.X), FMath::Frac(UV.Y));
+}
+
+bool FVolumetricCloudsPainterTestFixture::TestColor(FAutomationTestBase& Test, const FString& What, const FLinearColor& Actual, const FLinearColor& Expected, float Tolerance)
+{
+	bool bEqual = Test.TestEqual(What + TEXT(" R"), Actual.R, Expected.R, Tolerance);
+	bEqual &= Test.TestEqual(What + TEXT(" G"), Actual.G, Expected.G, Tolerance);
+	bEqual &= Test.TestEqual(What + TEXT(" B"), Actual.B, Expected.B, Tolerance);
+	bEqual &= Test.TestEqual(What + TEXT(" A"), Actual.A, Expected.A, Tolerance);
+
+	return bEqual;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
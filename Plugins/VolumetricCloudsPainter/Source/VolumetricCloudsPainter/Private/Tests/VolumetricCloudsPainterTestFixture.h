@@ -0,0 +1,73 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VolumetricCloudsPainterEdMode.h"
+
+class FAutomationTestBase;
+class UWorld;
+class UTexture2D;
+class UTextureRenderTarget2D;
+class UMaterialInstanceConstant;
+class AStaticMeshActor;
+
+/**
+* Painter editor mode outside of the level editor: a transient world with a VolumetricClouds_C actor, a material
+* instance with the weather map parameters and a square RGBA16F weather map filled with BaseValue. Nothing needs a
+* viewport or a GPU, so the tests run with -nullrhi. Test objects are rooted until the fixture is destroyed.
+*/
+class FVolumetricCloudsPainterTestFixture
+{
+public:
+	/** Material WeatherMapSize, the weather map repeats every 1000 units. */
+	static const float WeatherMapSize;
+	/** World units of one weather map repeat. */
+	static const float RepeatSize;
+	/** Value of every weather map channel before painting. */
+	static const float BaseValue;
+
+	/** Setup world, clouds actor and weather map.
+	* @param MapSize - weather map width and height.
+	* @param bSpawnClouds - spawn the clouds actor, otherwise the world only has a plain static mesh actor.
+	*/
+	FVolumetricCloudsPainterTestFixture(int32 MapSize = 256, bool bSpawnClouds = true);
+	~FVolumetricCloudsPainterTestFixture();
+
+	/** Find the clouds actor and load the weather map into the painter canvas. */
+	bool Attach();
+
+	/** Stamp the current brush at a world position, like a mouse move while painting. */
+	void StampAt(const FVector& WorldPosition);
+
+	/** Composite texel at a weather map UV. */
+	FLinearColor GetCanvasTexel(const FVector2D& UV) const;
+
+	/** Weather map source texel at a weather map UV. */
+	FLinearColor GetSourceTexel(const FVector2D& UV) const;
+
+	/** Weather map UV of a world position, the mapping DrawToRenderTaget is expected to use. */
+	static FVector2D WorldToUV(const FVector& WorldPosition);
+
+	/** Compare two colors channel by channel and report differences to a test. */
+	static bool TestColor(FAutomationTestBase& Test, const FString& What, const FLinearColor& Actual, const FLinearColor& Expected, float Tolerance = 0.002f);
+
+	UWorld* World = nullptr;
+	UTexture2D* WeatherMap = nullptr;
+	UMaterialInstanceConstant* Material = nullptr;
+	UTextureRenderTarget2D* RenderTarget = nullptr;
+	AStaticMeshActor* CloudsActor = nullptr;
+
+	FVolumetricCloudsPainterEdMode EdMode;
+
+private:
+	/** Blueprint class named VolumetricClouds_C, created once per editor session. */
+	static UClass* GetCloudsClass();
+
+	int32 MapSize;
+};
+
+#endif //WITH_DEV_AUTOMATION_TESTS
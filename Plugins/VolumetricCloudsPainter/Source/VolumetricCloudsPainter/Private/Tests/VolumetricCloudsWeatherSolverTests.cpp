@@ -0,0 +1,137 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VolumetricCloudsWeatherSolver.h"
+#include "Math/RandomStream.h"
+
+/**
+* Weather solver tests, run headless with:
+* UE4Editor-Cmd FullEnvironmentDev.uproject -nullrhi -unattended -ExecCmds="Automation RunTests VolumetricCloudsPainter.WeatherSolver;Quit"
+*/
+namespace VolumetricCloudsWeatherSolverTests
+{
+	/** Small grids keep the tests fast, they still span several vectors and wind cells per row. */
+	FVolumetricCloudsWeatherSolverSettings MakeSettings(int32 Seed)
+	{
+		FVolumetricCloudsWeatherSolverSettings Settings;
+		Settings.Size = 64;
+		Settings.WindSize = 16;
+		Settings.Seed = Seed;
+
+		return Settings;
+	}
+
+	/** Source moisture that is the same on every run. */
+	TArray<float> MakeSource(int32 Size)
+	{
+		FRandomStream Random(1234);
+		TArray<float> Values;
+		Values.SetNumUninitialized(Size * Size);
+
+		for (float& Value : Values)
+		{
+			Value = Random.GetFraction();
+		}
+
+		return Values;
+	}
+
+	/** Fixed steps followed by a few long ones, like a time warp. */
+	void Run(FVolumetricCloudsWeatherSolver& Solver)
+	{
+		for (int32 Step = 0; Step < 200; Step++)
+		{
+			Solver.Step();
+		}
+
+		for (int32 Step = 0; Step < 4; Step++)
+		{
+			Solver.Step(1.5f);
+		}
+	}
+
+	bool IsSameMoisture(const FVolumetricCloudsWeatherSolver& A, const FVolumetricCloudsWeatherSolver& B)
+	{
+		return A.GetMoisture().Num() == B.GetMoisture().Num()
+			&& FMemory::Memcmp(A.GetMoisture().GetData(), B.GetMoisture().GetData(), A.GetMoisture().Num() * sizeof(float)) == 0;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVolumetricCloudsWeatherSolverDeterminismTest, "VolumetricCloudsPainter.WeatherSolver.Determinism",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FVolumetricCloudsWeatherSolverDeterminismTest::RunTest(const FString& Parameters)
+{
+	using namespace VolumetricCloudsWeatherSolverTests;
+
+	const TArray<float> Source = MakeSource(64);
+
+	FVolumetricCloudsWeatherSolver First;
+	First.Init(MakeSettings(7), Source.GetData());
+	Run(First);
+
+	FVolumetricCloudsWeatherSolver Second;
+	Second.Init(MakeSettings(7), Source.GetData());
+	Run(Second);
+
+	TestEqual(TEXT("Step count"), First.GetStepCount(), uint64(204));
+	TestTrue(TEXT("Same seed and input give bit identical moisture"), IsSameMoisture(First, Second));
+
+	//Rows are stepped in parallel, so this also fails if the scheduling leaks into the result.
+	Second.Init(MakeSettings(7), Source.GetData());
+	Run(Second);
+	TestTrue(TEXT("Init again replays the same moisture"), IsSameMoisture(First, Second));
+
+	FVolumetricCloudsWeatherSolver OtherSeed;
+	OtherSeed.Init(MakeSettings(8), Source.GetData());
+	Run(OtherSeed);
+	TestFalse(TEXT("Another seed gives other weather"), IsSameMoisture(First, OtherSeed));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVolumetricCloudsWeatherSolverResampleTest, "VolumetricCloudsPainter.WeatherSolver.ResampleRect",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FVolumetricCloudsWeatherSolverResampleTest::RunTest(const FString& Parameters)
+{
+	using namespace VolumetricCloudsWeatherSolverTests;
+
+	const TArray<float> Source = MakeSource(64);
+	const int32 DestSize = 160;
+
+	TArray<float> Full;
+	Full.SetNumUninitialized(DestSize * DestSize);
+	FVolumetricCloudsWeatherSolver::Resample(Source.GetData(), 64, 64, Full.GetData(), DestSize, DestSize);
+
+	//Tiles of the weather map are resampled on their own, they have to match the full resample along the wrapped edges too.
+	const FIntRect Rects[] = { FIntRect(0, 0, 64, 64), FIntRect(128, 96, 160, 160), FIntRect(37, 5, 38, 150) };
+
+	for (const FIntRect& Rect : Rects)
+	{
+		const int32 Stride = 64;
+		TArray<float> Part;
+		Part.SetNumZeroed(Rect.Height() * Stride);
+		FVolumetricCloudsWeatherSolver::ResampleRect(Source.GetData(), 64, 64, DestSize, DestSize, Rect, Part.GetData(), Stride);
+
+		bool bSame = true;
+
+		for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+		{
+			for (int32 X = Rect.Min.X; X < Rect.Max.X; X++)
+			{
+				bSame &= Part[(Y - Rect.Min.Y) * Stride + X - Rect.Min.X] == Full[Y * DestSize + X];
+			}
+		}
+
+		TestTrue(FString::Printf(TEXT("Rect %s matches the full resample"), *Rect.ToString()), bSame);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,13 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsAssetUtils.h"
+
+bool VolumetricCloudsAssetUtils::SaveAsset(UObject* Asset)
+{
+	UPackage* Package = Asset->GetOutermost();
+	const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+
+	Package->MarkPackageDirty();
+
+	return UPackage::SavePackage(Package, Asset, RF_Public | RF_Standalone, *Filename, GError, nullptr, false, true, SAVE_NoError);
+}
@@ -0,0 +1,64 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsLayerChange.h"
+#include "VolumetricCloudsLayerStack.h"
+
+FVolumetricCloudsLayerChange::FVolumetricCloudsLayerChange(const FVolumetricCloudsLayer& Layer, const TArray<int32>& InTileIndices)
+	: LayerId(Layer.Id)
+	, Size(Layer.Values.GetSizeX(), Layer.Values.GetSizeY())
+	, TileIndices(InTileIndices)
+{
+	const bool bBaseLayer = LayerId == 0;
+
+	Values.SetNum(TileIndices.Num());
+	Coverage.SetNum(TileIndices.Num());
+
+	for (int32 Index = 0; Index < TileIndices.Num(); Index++)
+	{
+		const int32 TileIndex = TileIndices[Index];
+
+		if (const FFloat16Color* TileData = Layer.Values.GetTileData(TileIndex))
+		{
+			Values[Index].Append(TileData, FVolumetricCloudsTiledImage::TileTexels);
+		}
+
+		//Base layer coverage is never allocated.
+		if (const FFloat16Color* TileData = bBaseLayer ? nullptr : Layer.Coverage.GetTileData(TileIndex))
+		{
+			Coverage[Index].Append(TileData, FVolumetricCloudsTiledImage::TileTexels);
+		}
+	}
+}
+
+void FVolumetricCloudsLayerChange::Apply(UObject* Object)
+{
+	SwapWithLayer(Object);
+}
+
+void FVolumetricCloudsLayerChange::Revert(UObject* Object)
+{
+	SwapWithLayer(Object);
+}
+
+bool FVolumetricCloudsLayerChange::HasExpired(UObject* Object) const
+{
+	//Layer was removed or the stack was reloaded for another weather map.
+	const UVolumetricCloudsLayerStack* LayerStack = Cast<UVolumetricCloudsLayerStack>(Object);
+
+	return LayerStack == nullptr || LayerStack->Canvas.FindLayerIndex(LayerId) == INDEX_NONE
+		|| LayerStack->Canvas.GetSizeX() != Size.X || LayerStack->Canvas.GetSizeY() != Size.Y;
+}
+
+FString FVolumetricCloudsLayerChange::ToString() const
+{
+	return FString::Printf(TEXT("Volumetric Clouds Layer Change (Layer Id %d, %d Tiles)"), LayerId, TileIndices.Num());
+}
+
+void FVolumetricCloudsLayerChange::SwapWithLayer(UObject* Object)
+{
+	UVolumetricCloudsLayerStack* LayerStack = CastChecked<UVolumetricCloudsLayerStack>(Object);
+
+	//Render target picks up dirty tiles on the next painter tick.
+	LayerStack->Canvas.SwapLayerTiles(LayerStack->Canvas.FindLayerIndex(LayerId), TileIndices, Values, Coverage);
+	LayerStack->MarkPackageDirty();
+}
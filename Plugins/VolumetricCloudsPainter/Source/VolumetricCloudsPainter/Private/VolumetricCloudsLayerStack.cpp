@@ -0,0 +1,67 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsLayerStack.h"
+#include "Engine/Texture2D.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+#include "Misc/PackageName.h"
+#include "AssetRegistryModule.h"
+
+void UVolumetricCloudsLayerStack::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	//Layer tiles are bulk serialized, there is no reflection for the texel data.
+	if (!Ar.IsObjectReferenceCollector() && !Ar.IsCountingMemory())
+	{
+		Ar << Canvas;
+	}
+}
+
+void UVolumetricCloudsLayerStack::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(Canvas.GetAllocatedSize());
+}
+
+FString UVolumetricCloudsLayerStack::GetSidecarPackageName(const UTexture2D* WeatherMap)
+{
+	return WeatherMap->GetOutermost()->GetName() + TEXT("_Layers");
+}
+
+UVolumetricCloudsLayerStack* UVolumetricCloudsLayerStack::Load(const UTexture2D* WeatherMap)
+{
+	const FString PackageName = GetSidecarPackageName(WeatherMap);
+
+	if (FindPackage(nullptr, *PackageName) == nullptr && !FPackageName::DoesPackageExist(PackageName))
+	{
+		return nullptr;
+	}
+
+	const FString ObjectPath = PackageName + TEXT(".") + FPackageName::GetLongPackageAssetName(PackageName);
+
+	return LoadObject<UVolumetricCloudsLayerStack>(nullptr, *ObjectPath, nullptr, LOAD_NoWarn);
+}
+
+void UVolumetricCloudsLayerStack::SaveAsSidecar(const UTexture2D* WeatherMap)
+{
+	if (IsSidecar())
+	{
+		return;
+	}
+
+	const FString PackageName = GetSidecarPackageName(WeatherMap);
+	UPackage* Package = CreatePackage(nullptr, *PackageName);
+
+	Rename(*FPackageName::GetLongPackageAssetName(PackageName), Package, REN_DontCreateRedirectors);
+	SetFlags(RF_Public | RF_Standalone);
+
+	FAssetRegistryModule::AssetCreated(this);
+	Package->MarkPackageDirty();
+}
+
+bool UVolumetricCloudsLayerStack::IsSidecar() const
+{
+	return GetOutermost() != GetTransientPackage();
+}
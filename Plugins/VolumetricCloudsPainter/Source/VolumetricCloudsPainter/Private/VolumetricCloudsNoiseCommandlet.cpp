@@ -0,0 +1,166 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsNoiseCommandlet.h"
+#include "VolumetricCloudsNoiseVolume.h"
+#include "VolumetricCloudsAssetUtils.h"
+#include "Engine/Texture2D.h"
+#include "Engine/VolumeTexture.h"
+#include "Misc/PackageName.h"
+#include "Misc/Parse.h"
+#include "HAL/PlatformTime.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVolumetricCloudsNoise, Log, All);
+
+namespace VolumetricCloudsNoiseCommandlet
+{
+	/** Parse Type:Frequency:Octaves:Persistence, missing fields keep their values. */
+	bool ParseChannel(const FString& Value, FVolumetricCloudsNoiseChannel& OutChannel)
+	{
+		TArray<FString> Fields;
+		Value.ParseIntoArray(Fields, TEXT(":"));
+
+		if (Fields.Num() > 0)
+		{
+			bool bTypeFound = false;
+
+			for (int32 Type = 0; Type < (int32)EVolumetricCloudsNoiseType::Count; Type++)
+			{
+				if (Fields[0] == GetVolumetricCloudsNoiseTypeName((EVolumetricCloudsNoiseType)Type))
+				{
+					OutChannel.Type = (EVolumetricCloudsNoiseType)Type;
+					bTypeFound = true;
+				}
+			}
+
+			if (!bTypeFound)
+			{
+				return false;
+			}
+		}
+
+		if (Fields.Num() > 1)
+		{
+			OutChannel.Frequency = FMath::Max(FCString::Atoi(*Fields[1]), 1);
+		}
+
+		if (Fields.Num() > 2)
+		{
+			OutChannel.Octaves = FMath::Max(FCString::Atoi(*Fields[2]), 0);
+		}
+
+		if (Fields.Num() > 3)
+		{
+			OutChannel.Persistence = FCString::Atof(*Fields[3]);
+		}
+
+		return true;
+	}
+}
+
+UVolumetricCloudsNoiseCommandlet::UVolumetricCloudsNoiseCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UVolumetricCloudsNoiseCommandlet::Main(const FString& Params)
+{
+	using namespace VolumetricCloudsNoiseCommandlet;
+	using namespace VolumetricCloudsAssetUtils;
+
+	FString VolumePackageName;
+
+	if (!FParse::Value(*Params, TEXT("Volume="), VolumePackageName) || !FPackageName::IsValidLongPackageName(VolumePackageName))
+	{
+		UE_LOG(LogVolumetricCloudsNoise, Error, TEXT("-Volume=/Game/Path/VolumeTexture is required."));
+		return 1;
+	}
+
+	FVolumetricCloudsNoiseVolumeSettings Settings;
+	FParse::Value(*Params, TEXT("Size="), Settings.Size);
+	FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+	Settings.Size = FMath::Clamp(Settings.Size, 4, 512);
+
+	static const TCHAR* ChannelParams[] = { TEXT("R="), TEXT("G="), TEXT("B="), TEXT("A=") };
+
+	for (int32 Channel = 0; Channel < 4; Channel++)
+	{
+		FString ChannelValue;
+
+		if (FParse::Value(*Params, ChannelParams[Channel], ChannelValue) && !ParseChannel(ChannelValue, Settings.Channels[Channel]))
+		{
+			UE_LOG(LogVolumetricCloudsNoise, Error, TEXT("Invalid channel settings %s%s, expected Type:Frequency:Octaves:Persistence."), ChannelParams[Channel], *ChannelValue);
+			return 1;
+		}
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<FColor> Texels;
+	FVolumetricCloudsNoiseVolume::Generate(Settings, Texels);
+
+	UE_LOG(LogVolumetricCloudsNoise, Display, TEXT("Generated %d^3 noise volume in %.2f s."), Settings.Size, FPlatformTime::Seconds() - StartTime);
+
+	const int32 Size = Settings.Size;
+	UVolumeTexture* Volume = FindOrCreateAsset<UVolumeTexture>(VolumePackageName);
+	FString AtlasPackageName;
+
+	if (FParse::Value(*Params, TEXT("Atlas="), AtlasPackageName) && FPackageName::IsValidLongPackageName(AtlasPackageName))
+	{
+		//Slices are laid out in rows of a power of two number of tiles.
+		const int32 NumTilesX = FMath::RoundUpToPowerOfTwo(FMath::CeilToInt(FMath::Sqrt(float(Size))));
+		const int32 NumTilesY = FMath::DivideAndRoundUp(Size, NumTilesX);
+		const int32 AtlasSizeX = NumTilesX * Size;
+		const int32 AtlasSizeY = NumTilesY * Size;
+
+		TArray<FColor> AtlasTexels;
+		AtlasTexels.SetNumZeroed(AtlasSizeX * AtlasSizeY);
+
+		for (int32 Z = 0; Z < Size; Z++)
+		{
+			const int32 TileX = (Z % NumTilesX) * Size;
+			const int32 TileY = (Z / NumTilesX) * Size;
+
+			for (int32 Y = 0; Y < Size; Y++)
+			{
+				FMemory::Memcpy(&AtlasTexels[(TileY + Y) * AtlasSizeX + TileX], &Texels[(Z * Size + Y) * Size], Size * sizeof(FColor));
+			}
+		}
+
+		UTexture2D* Atlas = FindOrCreateAsset<UTexture2D>(AtlasPackageName);
+		Atlas->Source.Init(AtlasSizeX, AtlasSizeY, 1, 1, TSF_BGRA8, (const uint8*)AtlasTexels.GetData());
+		Atlas->SRGB = false;
+		Atlas->MipGenSettings = TMGS_NoMipmaps;
+		Atlas->PostEditChange();
+
+		Volume->Source2DTexture = Atlas;
+		Volume->Source2DTileSizeX = Size;
+		Volume->Source2DTileSizeY = Size;
+		Volume->UpdateSourceFromSourceTexture();
+
+		if (!SaveAsset(Atlas))
+		{
+			UE_LOG(LogVolumetricCloudsNoise, Error, TEXT("Failed to save %s."), *AtlasPackageName);
+			return 1;
+		}
+	}
+	else
+	{
+		Volume->Source.Init(Size, Size, Size, 1, TSF_BGRA8, (const uint8*)Texels.GetData());
+	}
+
+	Volume->SRGB = false;
+	Volume->PostEditChange();
+
+	if (!SaveAsset(Volume))
+	{
+		UE_LOG(LogVolumetricCloudsNoise, Error, TEXT("Failed to save %s."), *VolumePackageName);
+		return 1;
+	}
+
+	UE_LOG(LogVolumetricCloudsNoise, Display, TEXT("Saved %s."), *VolumePackageName);
+
+	return 0;
+}
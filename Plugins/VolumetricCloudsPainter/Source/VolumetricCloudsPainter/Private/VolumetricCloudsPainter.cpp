@@ -2,13 +2,41 @@
 
 #include "VolumetricCloudsPainter.h"
 #include "VolumetricCloudsPainterEdMode.h"
+#include "VolumetricCloudsMemoryReport.h"
+#include "EditorModeManager.h"
+#include "Engine/Texture2D.h"
+#include "Engine/TextureRenderTarget2D.h"
 
 #define LOCTEXT_NAMESPACE "FVolumetricCloudsPainterModule"
 
+namespace VolumetricCloudsPainter
+{
+	/** Add painter memory to a memory report, nothing is allocated while the painter mode is inactive. */
+	void CollectMemory(UWorld* World, FVolumetricCloudsMemoryReport& Report)
+	{
+		const FVolumetricCloudsPainterEdMode* EdMode = GLevelEditorModeTools().GetActiveModeTyped<FVolumetricCloudsPainterEdMode>(FVolumetricCloudsPainterEdMode::EM_VolumetricCloudsPainterEdModeId);
+
+		if (EdMode == nullptr)
+		{
+			return;
+		}
+
+		Report.AddTexture(EVolumetricCloudsMemorySystem::PainterRenderTarget, EdMode->RenderTarget);
+		Report.AddTexture(EVolumetricCloudsMemorySystem::PainterFinalTexture, EdMode->FinalTexture);
+
+		if (const FVolumetricCloudsCanvas* Canvas = EdMode->GetCanvas())
+		{
+			Report.AddBytes(EVolumetricCloudsMemorySystem::PainterCanvas, Canvas->GetAllocatedSize());
+		}
+	}
+}
+
 void FVolumetricCloudsPainterModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
 	FEditorModeRegistry::Get().RegisterMode<FVolumetricCloudsPainterEdMode>(FVolumetricCloudsPainterEdMode::EM_VolumetricCloudsPainterEdModeId, LOCTEXT("VolumetricCloudsPainterEdModeName", "VolumetricCloudsPainterEdMode"), FSlateIcon(), true);
+
+	CollectMemoryHandle = FVolumetricCloudsMemoryReport::OnCollect.AddStatic(&VolumetricCloudsPainter::CollectMemory);
 }
 
 void FVolumetricCloudsPainterModule::ShutdownModule()
@@ -16,6 +44,8 @@ void FVolumetricCloudsPainterModule::ShutdownModule()
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
 	FEditorModeRegistry::Get().UnregisterMode(FVolumetricCloudsPainterEdMode::EM_VolumetricCloudsPainterEdModeId);
+
+	FVolumetricCloudsMemoryReport::OnCollect.Remove(CollectMemoryHandle);
 }
 
 #undef LOCTEXT_NAMESPACE
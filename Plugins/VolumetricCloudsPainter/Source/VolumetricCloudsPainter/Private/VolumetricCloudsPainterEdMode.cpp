@@ -29,25 +29,143 @@
 
 #include "EngineUtils.h"
 
+#include "VolumetricCloudsLayerStack.h"
+#include "VolumetricCloudsLayerChange.h"
+#include "VolumetricCloudsMemory.h"
+#include "ScopedTransaction.h"
+#include "Editor.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "RenderingThread.h"
+#include "RHI.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVolumetricCloudsPainter, Log, All);
+
+namespace VolumetricCloudsPainter
+{
+	/** Read first mip of a weather map source as linear texels. */
+	bool ReadTextureSource(UTexture2D* Texture, TArray<FLinearColor>& OutTexels)
+	{
+		FTextureSource& Source = Texture->Source;
 
-const FEditorModeID FVolumetricCloudsPainterEdMode::EM_VolumetricCloudsPainterEdModeId = TEXT("EM_VolumetricCloudsPainterEdMode");
+		if (!Source.IsValid())
+		{
+			return false;
+		}
 
-FVolumetricCloudsPainterEdMode::FVolumetricCloudsPainterEdMode()
-{
-	ColorBlendMaterialInstance = Cast<UMaterialInstanceConstant>(StaticLoadObject(UMaterialInstanceConstant::StaticClass(), NULL,
-		TEXT("MaterialInstanceConstant'/VolumetricCloudsPainter/Materials/MI_ColorBlend.MI_ColorBlend'")));
-	AlphaBlendMaterialInstance = Cast<UMaterialInstanceConstant>(StaticLoadObject(UMaterialInstanceConstant::StaticClass(), NULL,
-		TEXT("MaterialInstanceConstant'/VolumetricCloudsPainter/Materials/MI_AlphaBlend.MI_AlphaBlend'")));
+		const int32 NumTexels = Source.GetSizeX() * Source.GetSizeY();
+		const ETextureSourceFormat Format = Source.GetFormat();
+
+		if (Format != TSF_RGBA16F && Format != TSF_BGRA8 && Format != TSF_RGBA16)
+		{
+			UE_LOG(LogVolumetricCloudsPainter, Warning, TEXT("Weather map %s has unsupported source format %d."), *Texture->GetName(), (int32)Format);
+			return false;
+		}
+
+		const uint8* Data = Source.LockMip(0);
+
+		if (Data == nullptr)
+		{
+			return false;
+		}
+
+		OutTexels.SetNumUninitialized(NumTexels);
+
+		if (Format == TSF_RGBA16F)
+		{
+			const FFloat16Color* Texels = (const FFloat16Color*)Data;
+
+			for (int32 Index = 0; Index < NumTexels; Index++)
+			{
+				OutTexels[Index] = FLinearColor(Texels[Index]);
+			}
+		}
+		else if (Format == TSF_BGRA8)
+		{
+			const FColor* Texels = (const FColor*)Data;
+
+			for (int32 Index = 0; Index < NumTexels; Index++)
+			{
+				OutTexels[Index] = Texture->SRGB ? FLinearColor(Texels[Index]) : Texels[Index].ReinterpretAsLinear();
+			}
+		}
+		else
+		{
+			const uint16* Texels = (const uint16*)Data;
+
+			for (int32 Index = 0; Index < NumTexels; Index++)
+			{
+				OutTexels[Index] = FLinearColor(Texels[Index * 4 + 0], Texels[Index * 4 + 1], Texels[Index * 4 + 2], Texels[Index * 4 + 3]) / 65535.0f;
+			}
+		}
+
+		Source.UnlockMip(0);
+
+		return true;
+	}
+
+	/** Write linear texels to the first mip of a weather map source, keeping the source format. */
+	bool WriteTextureSource(UTexture2D* Texture, const TArray<FLinearColor>& Texels)
+	{
+		FTextureSource& Source = Texture->Source;
+		const int32 NumTexels = Source.GetSizeX() * Source.GetSizeY();
+		const ETextureSourceFormat Format = Source.GetFormat();
+
+		if (Texels.Num() != NumTexels || (Format != TSF_RGBA16F && Format != TSF_BGRA8 && Format != TSF_RGBA16))
+		{
+			return false;
+		}
+
+		uint8* Data = Source.LockMip(0);
 
-	AlphCombineMaterial = Cast<UMaterial>(StaticLoadObject(UMaterial::StaticClass(), NULL,
-		TEXT("Material'/VolumetricCloudsPainter/Materials/M_AlphaCombine.M_AlphaCombine'")));
+		if (Data == nullptr)
+		{
+			return false;
+		}
 
+		if (Format == TSF_RGBA16F)
+		{
+			FFloat16Color* Output = (FFloat16Color*)Data;
 
-	ColorBlendRenderTarget = Cast<UTextureRenderTarget2D>(StaticLoadObject(UTextureRenderTarget2D::StaticClass(), NULL,
-		TEXT("TextureRenderTarget2D'/VolumetricCloudsPainter/Textures/RT_ColorBlend.RT_ColorBlend'")));
-	AlphaBlendRenderTarget = Cast<UTextureRenderTarget2D>(StaticLoadObject(UTextureRenderTarget2D::StaticClass(), NULL,
-		TEXT("TextureRenderTarget2D'/VolumetricCloudsPainter/Textures/RT_AlphaBlend.RT_AlphaBlend'")));
+			for (int32 Index = 0; Index < NumTexels; Index++)
+			{
+				Output[Index] = FFloat16Color(Texels[Index]);
+			}
+		}
+		else if (Format == TSF_BGRA8)
+		{
+			FColor* Output = (FColor*)Data;
+
+			for (int32 Index = 0; Index < NumTexels; Index++)
+			{
+				Output[Index] = Texels[Index].ToFColor(Texture->SRGB);
+			}
+		}
+		else
+		{
+			uint16* Output = (uint16*)Data;
+
+			for (int32 Index = 0; Index < NumTexels; Index++)
+			{
+				const FLinearColor Texel = Texels[Index].GetClamped();
+				Output[Index * 4 + 0] = (uint16)FMath::RoundToInt(Texel.R * 65535.0f);
+				Output[Index * 4 + 1] = (uint16)FMath::RoundToInt(Texel.G * 65535.0f);
+				Output[Index * 4 + 2] = (uint16)FMath::RoundToInt(Texel.B * 65535.0f);
+				Output[Index * 4 + 3] = (uint16)FMath::RoundToInt(Texel.A * 65535.0f);
+			}
+		}
+
+		Source.UnlockMip(0);
+		Source.ForceGenerateGuid();
+
+		return true;
+	}
+}
 
+
+const FEditorModeID FVolumetricCloudsPainterEdMode::EM_VolumetricCloudsPainterEdModeId = TEXT("EM_VolumetricCloudsPainterEdMode");
+
+FVolumetricCloudsPainterEdMode::FVolumetricCloudsPainterEdMode()
+{
 	RenderTarget = Cast<UTextureRenderTarget2D>(StaticLoadObject(UTextureRenderTarget2D::StaticClass(), NULL,
 		TEXT("TextureRenderTarget2D'/VolumetricCloudsPainter/Textures/RT_FinalRenderTarget.RT_FinalRenderTarget'")));
 }
@@ -65,17 +183,17 @@ void FVolumetricCloudsPainterEdMode::Enter()
 
 	if (!Toolkit.IsValid() && UsesToolkits())
 	{
-		Toolkit = MakeShareable(new FVolumetricCloudsPainterEdModeToolkit);
+		Toolkit = MakeShareable(new FVolumetricCloudsPainterEdModeToolkit(this));
 		Toolkit->Init(Owner->GetToolkitHost());
 	}
 }
 
 /** Find volumetric clouds actor in scene.*/
-bool FVolumetricCloudsPainterEdMode::GetCloudsActor()
+bool FVolumetricCloudsPainterEdMode::GetCloudsActor(UWorld* World)
 {
 	bool bCloudsFound = false;
 
-	for (TActorIterator<AStaticMeshActor> StaticMeshItr(GetWorld()); StaticMeshItr; ++StaticMeshItr)
+	for (TActorIterator<AStaticMeshActor> StaticMeshItr(World != nullptr ? World : GetWorld()); StaticMeshItr; ++StaticMeshItr)
 	{
 		AStaticMeshActor* SelectedCloudsActor = Cast<AStaticMeshActor>(*StaticMeshItr);
 
@@ -88,8 +206,9 @@ bool FVolumetricCloudsPainterEdMode::GetCloudsActor()
 				CloudsActor = SelectedCloudsActor;
 				CloudsMaterial = Cast<UMaterialInstanceConstant>(CloudsActor->GetStaticMeshComponent()->GetMaterial(0));
 
-				UTexture* TempTexturePointer;
-				bool bTextureFound = CloudsMaterial->GetTextureParameterValue(FMaterialParameterInfo("WeatherMap"), TempTexturePointer);
+				//Clouds without a material instance have no weather map to paint.
+				UTexture* TempTexturePointer = nullptr;
+				bool bTextureFound = CloudsMaterial != nullptr && CloudsMaterial->GetTextureParameterValue(FMaterialParameterInfo("WeatherMap"), TempTexturePointer);
 
 				if (bTextureFound)
 				{
@@ -98,6 +217,7 @@ bool FVolumetricCloudsPainterEdMode::GetCloudsActor()
 				}
 
 				bCloudsFound = true;
+				NotifyChanged(EVolumetricCloudsPainterChange::Settings | EVolumetricCloudsPainterChange::Layers | EVolumetricCloudsPainterChange::Statistics);
 				break;
 			}
 		}
@@ -133,6 +253,14 @@ void FVolumetricCloudsPainterEdMode::ReleaseCoudsActor()
 	CloudsActor = nullptr;
 	CloudsMaterial = nullptr;
 	FinalTexture = nullptr;
+	LayerStack = nullptr;
+	LayerStackTexture = nullptr;
+	FilterBrush.Empty();
+	Statistics.Reset();
+	bStatisticsChanged = false;
+	bFinalTextureDirty = false;
+
+	NotifyChanged(EVolumetricCloudsPainterChange::Settings | EVolumetricCloudsPainterChange::Layers | EVolumetricCloudsPainterChange::Statistics);
 }
 
 bool FVolumetricCloudsPainterEdMode::UsesToolkits() const
@@ -166,6 +294,7 @@ bool FVolumetricCloudsPainterEdMode::InputKey(FEditorViewportClient* ViewportCli
 				if (Event == EInputEvent::IE_Released)
 				{
 					bPressedLMB = false;
+					bHasPreviousBrushUV = false;
 					PreviousMousePosition = FVector2D(-10000.0, -10000.0);
 					return false;
 				}
@@ -204,6 +333,13 @@ void FVolumetricCloudsPainterEdMode::ActorSelectionChangeNotify()
 
 }
 
+void FVolumetricCloudsPainterEdMode::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	FEdMode::AddReferencedObjects(Collector);
+
+	Collector.AddReferencedObject(LayerStack);
+}
+
 void FVolumetricCloudsPainterEdMode::Render(const FSceneView* View, FViewport* Viewport, FPrimitiveDrawInterface* PDI)
 {
 	//Draw editor helper only if volumetric clouds class exist and editor mode in enabled painiting.
@@ -277,6 +413,14 @@ void FVolumetricCloudsPainterEdMode::DrawHUD(FEditorViewportClient* ViewportClie
 			PaintModeTooltip = FString("SUB");
 		}
 
+		//Show layer name when painting to a paint layer.
+		const FVolumetricCloudsCanvas* PaintCanvas = GetCanvas();
+
+		if (PaintCanvas != nullptr && PaintCanvas->GetActiveLayer() > 0)
+		{
+			PaintModeTooltip += FString(" ") + PaintCanvas->GetLayer(PaintCanvas->GetActiveLayer()).Name;
+		}
+
 		Canvas->DrawShadowedString(MousePos.X + 10.0f, MousePos.Y + 10.0f, *PaintModeTooltip, GEngine->GetSmallFont(), FLinearColor(1, 1, 1, 1));
 	}
 }
@@ -284,152 +428,402 @@ void FVolumetricCloudsPainterEdMode::DrawHUD(FEditorViewportClient* ViewportClie
 /** Load texture to a render target and setup base parameters. */
 void FVolumetricCloudsPainterEdMode::LoadTexture()
 {
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::PainterCanvas);
+
+	if (FinalTexture == nullptr || RenderTarget == nullptr)
+	{
+		return;
+	}
+
 	FinalTextureSize = FVector2D(FinalTexture->GetSizeX(), FinalTexture->GetSizeY());
 
-	RenderTarget->ResizeTarget(FinalTextureSize.X, FinalTextureSize.Y);
-	ColorBlendRenderTarget->ResizeTarget(FinalTextureSize.X, FinalTextureSize.Y);
-	AlphaBlendRenderTarget->ResizeTarget(FinalTextureSize.X, FinalTextureSize.Y);
+	if (LayerStack == nullptr || LayerStackTexture != FinalTexture)
+	{
+		LayerStack = UVolumetricCloudsLayerStack::Load(FinalTexture);
+		LayerStackTexture = FinalTexture;
+	}
 
-	ColorBlendMaterialInstance->SetVectorParameterValueEditorOnly(FName("BrushColor"), BrushColor);
-	ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BrushFalloff"), BrushFalloff);
-	ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BrushOpacity"), BrushOpacity * 0.1);
-	ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BrushRadius"), BrushRadius);
+	const FGuid SourceId = FinalTexture->Source.GetId();
+	const int32 SizeX = FinalTexture->Source.GetSizeX();
+	const int32 SizeY = FinalTexture->Source.GetSizeY();
 
-	AlphaBlendMaterialInstance->SetVectorParameterValueEditorOnly(FName("BrushColor"), BrushColor);
-	AlphaBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BrushFalloff"), BrushFalloff);
-	AlphaBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BrushOpacity"), BrushOpacity * 0.1);
-	AlphaBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BrushRadius"), BrushRadius);
+	TArray<FLinearColor> Texels;
 
-	ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("RedChannelEnabled"), (float)bRedChannelEnabled);
-	ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("GreenChannelEnabled"), (float)bGreenChannelEnabled);
-	ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BlueChannelEnabled"), (float)bBlueChannelEnabled);
-	AlphaBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("AlphaChannelEnabled"), (float)bAlphaChannelEnabled);
+	if (LayerStack != nullptr && LayerStack->Canvas.IsValid() && LayerStack->Canvas.GetSizeX() == SizeX && LayerStack->Canvas.GetSizeY() == SizeY)
+	{
+		//Weather map was changed outside of the painter, layers can't be trusted to produce it any more.
+		if (LayerStack->FlattenedSourceId != SourceId && VolumetricCloudsPainter::ReadTextureSource(FinalTexture, Texels))
+		{
+			UE_LOG(LogVolumetricCloudsPainter, Warning, TEXT("%s was modified outside of the painter. Base layer was reloaded and paint layers were hidden."), *FinalTexture->GetName());
 
-	//Base draw parameters.
-	UCanvas* DrawCanvas;
-	FVector2D DrawSize = FVector2D(1.0f, 1.0f);
+			LayerStack->Canvas.ResetBaseLayer(Texels.GetData());
+			LayerStack->FlattenedSourceId = SourceId;
+		}
+	}
+	else
+	{
+		if (!VolumetricCloudsPainter::ReadTextureSource(FinalTexture, Texels))
+		{
+			return;
+		}
 
-	AlphaBlendMaterialInstance->SetTextureParameterValueEditorOnly(FName("TextureToRead"), FinalTexture);
-	ColorBlendMaterialInstance->SetTextureParameterValueEditorOnly(FName("TextureToRead"), FinalTexture);
+		if (LayerStack == nullptr)
+		{
+			LayerStack = NewObject<UVolumetricCloudsLayerStack>(GetTransientPackage());
+		}
+		else if (LayerStack->Canvas.IsValid())
+		{
+			UE_LOG(LogVolumetricCloudsPainter, Warning, TEXT("%s was resized, paint layers of %s were discarded."), *FinalTexture->GetName(), *LayerStack->GetName());
+		}
 
-	AlphaBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("bReadTexture"), 1);
-	ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("bReadTexture"), 1);
+		LayerStack->Canvas.Init(SizeX, SizeY, Texels.GetData());
+		LayerStack->FlattenedSourceId = SourceId;
+	}
+
+	{
+		VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::PainterRenderTarget);
+		RenderTarget->InitCustomFormat(SizeX, SizeY, PF_FloatRGBA, true);
+	}
+
+	LayerStack->Canvas.MarkAllDirty();
+	UpdateRenderTarget();
+
+	//Layers were just loaded from the final texture or flattened into it, selecting the clouds doesn't commit.
+	bFinalTextureDirty = false;
+}
+
+FVolumetricCloudsCanvas* FVolumetricCloudsPainterEdMode::GetCanvas() const
+{
+	if (LayerStack != nullptr && LayerStack->Canvas.IsValid())
+	{
+		return &LayerStack->Canvas;
+	}
+
+	return nullptr;
+}
+
+/** Recompose dirty canvas tiles and upload them to the render target. */
+void FVolumetricCloudsPainterEdMode::UpdateRenderTarget()
+{
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::PainterCanvas);
+
+	FVolumetricCloudsCanvas* Canvas = GetCanvas();
+
+	if (Canvas == nullptr || !Canvas->HasDirtyTiles())
+	{
+		return;
+	}
+
+	//Layer edits clear the dirty tiles right away, the final texture still has to pick them up.
+	bFinalTextureDirty = true;
+
+	if (RenderTarget == nullptr)
+	{
+		return;
+	}
+
+	TArray<int32> ResolvedTiles;
+	Canvas->Resolve(&ResolvedTiles);
+
+	if (Statistics.UpdateTiles(Canvas->GetComposite(), ResolvedTiles))
+	{
+		bStatisticsChanged = true;
+	}
+
+	FTextureRenderTargetResource* RenderTargetResource = RenderTarget->GameThread_GetRenderTargetResource();
+
+	if (RenderTargetResource == nullptr)
+	{
+		return;
+	}
 
-	//Base draw parameters.
-	FDrawToRenderTargetContext DrawContext;
+	/** Tile texels converted to the render target format. */
+	struct FTileUpload
+	{
+		FUpdateTextureRegion2D Region;
+		TArray<FFloat16Color> Texels;
+	};
 
-	//Render to color blend render target.
-	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(GetWorld(), ColorBlendRenderTarget, DrawCanvas, DrawSize, DrawContext);
-	DrawCanvas->K2_DrawMaterial(ColorBlendMaterialInstance, FVector2D(0.0f, 0.0f), FinalTextureSize, FVector2D(0.0f, 0.0f));
-	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(GetWorld(), DrawContext);
+	//Staged texels belong to the render target until the upload is done.
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::PainterRenderTarget);
 
-	//Base draw parameters.
-	FDrawToRenderTargetContext AlphaBlendRenderTargetDrawContext;
+	const FVolumetricCloudsTiledImage& Composite = Canvas->GetComposite();
+	TArray<FTileUpload> Uploads;
+	Uploads.SetNum(ResolvedTiles.Num());
 
-	//Render to alpha blend render target.
-	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(GetWorld(), AlphaBlendRenderTarget, DrawCanvas, DrawSize, AlphaBlendRenderTargetDrawContext);
-	DrawCanvas->K2_DrawMaterial(AlphaBlendMaterialInstance, FVector2D(0.0f, 0.0f), FinalTextureSize, FVector2D(0.0f, 0.0f));
-	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(GetWorld(), AlphaBlendRenderTargetDrawContext);
+	for (int32 Index = 0; Index < ResolvedTiles.Num(); Index++)
+	{
+		const FIntRect Rect = Composite.GetTileRect(ResolvedTiles[Index]);
+		const FFloat16Color* TileData = Composite.GetTileData(ResolvedTiles[Index]);
 
-	//Update Render target.
+		FTileUpload& Upload = Uploads[Index];
+		Upload.Region = FUpdateTextureRegion2D(Rect.Min.X, Rect.Min.Y, 0, 0, Rect.Width(), Rect.Height());
+		Upload.Texels.SetNumUninitialized(Rect.Width() * Rect.Height());
 
-	//Base draw parameters.
-	FDrawToRenderTargetContext RenderTargetDrawContext;
+		//Composite is stored in the render target format, rows are copied as is.
+		for (int32 Y = 0; Y < Rect.Height(); Y++)
+		{
+			FMemory::Memcpy(&Upload.Texels[Y * Rect.Width()], TileData + Y * FVolumetricCloudsTiledImage::TileSize, Rect.Width() * sizeof(FFloat16Color));
+		}
+	}
 
-	//Blend colors to one render target.
-	UKismetRenderingLibrary::ClearRenderTarget2D(GetWorld(), RenderTarget, FLinearColor(0.0f, 0.0f, 0.0f, 1.0f));
-	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(GetWorld(), RenderTarget, DrawCanvas, DrawSize, RenderTargetDrawContext);
-	DrawCanvas->K2_DrawMaterial(AlphCombineMaterial, FVector2D(0.0f, 0.0f), FinalTextureSize, FVector2D(0.0f, 0.0f));
-	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(GetWorld(), RenderTargetDrawContext);
+	ENQUEUE_RENDER_COMMAND(VolumetricCloudsPainterUploadTiles)(
+		[RenderTargetResource, Uploads = MoveTemp(Uploads)](FRHICommandListImmediate& RHICmdList)
+	{
+		FTexture2DRHIRef Texture = RenderTargetResource->GetRenderTargetTexture();
 
-	AlphaBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("bReadTexture"), 0);
-	ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("bReadTexture"), 0);
+		if (Texture.IsValid())
+		{
+			for (const FTileUpload& Upload : Uploads)
+			{
+				RHIUpdateTexture2D(Texture, 0, Upload.Region, Upload.Region.Width * sizeof(FFloat16Color), (const uint8*)Upload.Texels.GetData());
+			}
+		}
+	});
 }
 
+/** Write flattened layers to the final texture. */
+void FVolumetricCloudsPainterEdMode::CommitFinalTexture()
+{
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::PainterFinalTexture);
+
+	FVolumetricCloudsCanvas* Canvas = GetCanvas();
+	bFinalTextureDirty = false;
 
-/** Draw to a render target. */
-void FVolumetricCloudsPainterEdMode::DrawToRenderTaget()
+	if (Canvas == nullptr || FinalTexture == nullptr)
+	{
+		return;
+	}
+
+	TArray<FLinearColor> Texels;
+	Canvas->Flatten(Texels);
+
+	if (!VolumetricCloudsPainter::WriteTextureSource(FinalTexture, Texels))
+	{
+		UE_LOG(LogVolumetricCloudsPainter, Warning, TEXT("Failed to write painted layers to %s."), *FinalTexture->GetName());
+		return;
+	}
+
+	FinalTexture->PostEditChange();
+	FinalTexture->MarkPackageDirty();
+
+	LayerStack->FlattenedSourceId = FinalTexture->Source.GetId();
+
+	if (LayerStack->IsSidecar())
+	{
+		LayerStack->MarkPackageDirty();
+	}
+}
+
+/** Apply MapOperation to the active layer as a single undoable transaction. */
+void FVolumetricCloudsPainterEdMode::ApplyMapOperation()
 {
-	if (CloudsActor != nullptr && CloudsMaterial != nullptr && RenderTarget != nullptr && FinalTexture != nullptr)
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::PainterCanvas);
+
+	FVolumetricCloudsCanvas* Canvas = GetCanvas();
+
+	if (Canvas == nullptr)
 	{
-		if (ColorBlendRenderTarget != nullptr && AlphaBlendRenderTarget != nullptr && ColorBlendMaterialInstance != nullptr && AlphaBlendMaterialInstance != nullptr)
-		{
-			//Calculate brush screen position based on a world position of the brush.
-			FVector2D ScreenPosition;
-			ScreenPosition.X = WorldBrushPos.X;
-			ScreenPosition.Y = WorldBrushPos.Y;
+		return;
+	}
 
-			//Get parameters from a material.
-			float WeatherMapSize = 0.0;
-			CloudsMaterial->GetScalarParameterValue(FMaterialParameterInfo("WeatherMapSize"), WeatherMapSize);
-			float RepeatSize = WeatherMapSize * 1000000.0f;
+	const FVolumetricCloudsLayer& Layer = Canvas->GetLayer(Canvas->GetActiveLayer());
 
+	const FScopedTransaction Transaction(FText::Format(NSLOCTEXT("CloudsPaintSettings", "MapOperationTransaction", "Clouds {0}"), FText::FromString(GetVolumetricCloudsMapOperationName(MapOperation.Type))));
 
-			ScreenPosition = (ScreenPosition + RepeatSize / 2.0f) / (RepeatSize);
+	//Texels of the tiles the operation changes, swapped back on undo.
+	TArray<int32> TileIndices;
+	Canvas->GetMapOperationTiles(MapOperation, TileIndices);
 
-			int BrushPosIndexX = (int)(ScreenPosition.X);
-			int BrushPosIndexY = (int)(ScreenPosition.Y);
+	TUniquePtr<FVolumetricCloudsLayerChange> Change = MakeUnique<FVolumetricCloudsLayerChange>(Layer, TileIndices);
 
-			ScreenPosition = ScreenPosition - FVector2D(BrushPosIndexX, BrushPosIndexY);
+	Canvas->ApplyMapOperation(MapOperation, GetBrush().ChannelMask);
+
+	if (GUndo != nullptr)
+	{
+		GUndo->StoreUndo(LayerStack, MoveTemp(Change));
+	}
 
-			ColorBlendMaterialInstance->SetVectorParameterValueEditorOnly(FName("BrushPosition"), FVector(ScreenPosition.X, ScreenPosition.Y, 0));
-			AlphaBlendMaterialInstance->SetVectorParameterValueEditorOnly(FName("BrushPosition"), FVector(ScreenPosition.X, ScreenPosition.Y, 0));
+	if (LayerStack->IsSidecar())
+	{
+		LayerStack->MarkPackageDirty();
+	}
 
-			//Update brush channel values based on a paint state.
-			SetPreRenderBrushParameters();
+	UpdateRenderTarget();
 
-			//Base draw parameters.
-			UCanvas* DrawCanvas;
-			FVector2D DrawSize = FVector2D(1.0f, 1.0f);
+	//Painting flattens layers when it ends, otherwise the weather map is updated right away.
+	if (!IsPainiting())
+	{
+		CommitFinalTexture();
+	}
+}
 
-			//Base draw parameters.
-			FDrawToRenderTargetContext DrawContext;
+/** Add a new paint layer on top of the layer stack and make it active. */
+void FVolumetricCloudsPainterEdMode::AddLayer()
+{
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::PainterCanvas);
 
-			//Render to color blend render target.
-			UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(GetWorld(), ColorBlendRenderTarget, DrawCanvas, DrawSize, DrawContext);
-			DrawCanvas->K2_DrawMaterial(ColorBlendMaterialInstance, FVector2D(0.0f, 0.0f), FinalTextureSize, FVector2D(0.0f, 0.0f));
-			UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(GetWorld(), DrawContext);
+	FVolumetricCloudsCanvas* Canvas = GetCanvas();
 
-			//Base draw parameters.
-			FDrawToRenderTargetContext AlphaBlendRenderTargetDrawContext;
+	if (Canvas != nullptr)
+	{
+		//Layers are kept in a sidecar asset next to the weather map as soon as there is more than the base layer.
+		LayerStack->SaveAsSidecar(FinalTexture);
 
-			//Render to alpha blend render target.
-			UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(GetWorld(), AlphaBlendRenderTarget, DrawCanvas, DrawSize, AlphaBlendRenderTargetDrawContext);
-			DrawCanvas->K2_DrawMaterial(AlphaBlendMaterialInstance, FVector2D(0.0f, 0.0f), FinalTextureSize, FVector2D(0.0f, 0.0f));
-			UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(GetWorld(), AlphaBlendRenderTargetDrawContext);
+		const int32 LayerIndex = Canvas->AddLayer(FString::Printf(TEXT("Layer %d"), Canvas->GetNumLayers()));
+		Canvas->SetActiveLayer(LayerIndex);
 
-			//Update Render target.
+		LayerStack->MarkPackageDirty();
+		NotifyChanged(EVolumetricCloudsPainterChange::Layers);
+	}
+}
 
-			//Base draw parameters.
-			FDrawToRenderTargetContext RenderTargetDrawContext;
+/** Remove a paint layer. */
+void FVolumetricCloudsPainterEdMode::RemoveLayer(int32 LayerIndex)
+{
+	FVolumetricCloudsCanvas* Canvas = GetCanvas();
 
-			//Blend colors to one render target.
-			UKismetRenderingLibrary::ClearRenderTarget2D(GetWorld(), RenderTarget, FLinearColor(0.0f, 0.0f, 0.0f, 1.0f));
-			UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(GetWorld(), RenderTarget, DrawCanvas, DrawSize, RenderTargetDrawContext);
-			DrawCanvas->K2_DrawMaterial(AlphCombineMaterial, FVector2D(0.0f, 0.0f), FinalTextureSize, FVector2D(0.0f, 0.0f));
-			UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(GetWorld(), RenderTargetDrawContext);
-		}
+	if (Canvas != nullptr)
+	{
+		Canvas->RemoveLayer(LayerIndex);
+		LayerStack->MarkPackageDirty();
+		UpdateRenderTarget();
+		NotifyChanged(EVolumetricCloudsPainterChange::Layers);
 	}
+}
+
+/** Move a paint layer up or down. */
+void FVolumetricCloudsPainterEdMode::MoveLayer(int32 LayerIndex, int32 Direction)
+{
+	FVolumetricCloudsCanvas* Canvas = GetCanvas();
 
+	if (Canvas != nullptr)
+	{
+		Canvas->MoveLayer(LayerIndex, Direction);
+		LayerStack->MarkPackageDirty();
+		UpdateRenderTarget();
+		NotifyChanged(EVolumetricCloudsPainterChange::Layers);
+	}
 }
 
-/** Update brush color parameters based on paint state when rendering to a texture. */
-void FVolumetricCloudsPainterEdMode::SetPreRenderBrushParameters()
+/** Select layer that receives brush strokes. */
+void FVolumetricCloudsPainterEdMode::SetActiveLayer(int32 LayerIndex)
 {
-	if (ColorBlendMaterialInstance != nullptr && AlphaBlendMaterialInstance != nullptr)
+	FVolumetricCloudsCanvas* Canvas = GetCanvas();
+
+	if (Canvas != nullptr)
 	{
-		if (!bAdditivePaint)
+		Canvas->SetActiveLayer(LayerIndex);
+		NotifyChanged(EVolumetricCloudsPainterChange::Layers);
+	}
+}
+
+/** Show or hide a paint layer. */
+void FVolumetricCloudsPainterEdMode::SetLayerVisible(int32 LayerIndex, bool bVisible)
+{
+	FVolumetricCloudsCanvas* Canvas = GetCanvas();
+
+	if (Canvas != nullptr)
+	{
+		Canvas->SetLayerVisible(LayerIndex, bVisible);
+		LayerStack->MarkPackageDirty();
+		UpdateRenderTarget();
+		NotifyChanged(EVolumetricCloudsPainterChange::Layers);
+	}
+}
+
+/** Change paint layer opacity. */
+void FVolumetricCloudsPainterEdMode::SetLayerOpacity(int32 LayerIndex, float Opacity)
+{
+	FVolumetricCloudsCanvas* Canvas = GetCanvas();
+
+	if (Canvas != nullptr)
+	{
+		Canvas->SetLayerOpacity(LayerIndex, Opacity);
+		LayerStack->MarkPackageDirty();
+		UpdateRenderTarget();
+		NotifyChanged(EVolumetricCloudsPainterChange::Values);
+	}
+}
+
+/** Change paint layer blend mode. */
+void FVolumetricCloudsPainterEdMode::SetLayerBlendMode(int32 LayerIndex, EVolumetricCloudsBlendMode BlendMode)
+{
+	FVolumetricCloudsCanvas* Canvas = GetCanvas();
+
+	if (Canvas != nullptr)
+	{
+		Canvas->SetLayerBlendMode(LayerIndex, BlendMode);
+		LayerStack->MarkPackageDirty();
+		UpdateRenderTarget();
+		NotifyChanged(EVolumetricCloudsPainterChange::Layers);
+	}
+}
+
+
+/** Draw to a render target. */
+void FVolumetricCloudsPainterEdMode::DrawToRenderTaget()
+{
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::PainterCanvas);
+
+	FVolumetricCloudsCanvas* Canvas = GetCanvas();
+
+	if (CloudsActor != nullptr && CloudsMaterial != nullptr && RenderTarget != nullptr && FinalTexture != nullptr && Canvas != nullptr)
+	{
+		//Calculate brush screen position based on a world position of the brush.
+		FVector2D ScreenPosition;
+		ScreenPosition.X = WorldBrushPos.X;
+		ScreenPosition.Y = WorldBrushPos.Y;
+
+		//Get parameters from a material.
+		float WeatherMapSize = 0.0;
+		CloudsMaterial->GetScalarParameterValue(FMaterialParameterInfo("WeatherMapSize"), WeatherMapSize);
+		float RepeatSize = WeatherMapSize * 1000000.0f;
+
+
+		ScreenPosition = (ScreenPosition + RepeatSize / 2.0f) / (RepeatSize);
+
+		//Weather map repeats every RepeatSize units.
+		ScreenPosition.X = FMath::Frac(ScreenPosition.X);
+		ScreenPosition.Y = FMath::Frac(ScreenPosition.Y);
+
+		const FVolumetricCloudsBrush Brush = GetBrush();
+
+		if (Brush.Tool == EVolumetricCloudsBrushTool::Paint)
 		{
-			ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("AdditivePaint"), -1);
-			AlphaBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("AdditivePaint"), -1);
+			Canvas->Stamp(Brush, ScreenPosition);
 		}
 		else
 		{
-			ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("AdditivePaint"), 1);
-			AlphaBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("AdditivePaint"), 1);
+			//Smudge needs a stroke direction, the first stamp of a stroke only records the position.
+			FilterBrush.Apply(*Canvas, Brush, ScreenPosition, bHasPreviousBrushUV ? PreviousBrushUV : ScreenPosition);
 		}
 
+		PreviousBrushUV = ScreenPosition;
+		bHasPreviousBrushUV = true;
+
+		UpdateRenderTarget();
 	}
+
+}
+
+/** Current brush parameters. */
+FVolumetricCloudsBrush FVolumetricCloudsPainterEdMode::GetBrush() const
+{
+	FVolumetricCloudsBrush Brush;
+	Brush.Radius = BrushRadius;
+	Brush.Falloff = BrushFalloff;
+	Brush.Opacity = BrushOpacity;
+	Brush.Color = BrushColor;
+	Brush.ChannelMask = FLinearColor(bRedChannelEnabled, bGreenChannelEnabled, bBlueChannelEnabled, bAlphaChannelEnabled);
+	Brush.bAdditive = bAdditivePaint;
+	Brush.Tool = BrushTool;
+	Brush.BlurSize = BrushBlurSize;
+	Brush.NoiseFrequency = BrushNoiseFrequency;
+	Brush.NoiseOctaves = BrushNoiseOctaves;
+	Brush.NoiseSeed = BrushNoiseSeed;
+
+	return Brush;
 }
 
 /** Update brush radius
@@ -438,12 +832,7 @@ void FVolumetricCloudsPainterEdMode::SetPreRenderBrushParameters()
 void FVolumetricCloudsPainterEdMode::SetBrushRadius(float NewRadius)
 {
 	BrushRadius = NewRadius;
-
-	if (ColorBlendMaterialInstance != nullptr && AlphaBlendMaterialInstance != nullptr)
-	{
-		ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BrushRadius"), BrushRadius);
-		AlphaBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BrushRadius"), BrushRadius);
-	}
+	NotifyChanged(EVolumetricCloudsPainterChange::Values);
 }
 
 /** Update brush falloff
@@ -452,12 +841,7 @@ void FVolumetricCloudsPainterEdMode::SetBrushRadius(float NewRadius)
 void FVolumetricCloudsPainterEdMode::SetBrushFalloff(float NewFalloff)
 {
 	BrushFalloff = NewFalloff;
-
-	if (ColorBlendMaterialInstance != nullptr && AlphaBlendMaterialInstance != nullptr)
-	{
-		ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BrushFalloff"), BrushFalloff);
-		AlphaBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BrushFalloff"), BrushFalloff);
-	}
+	NotifyChanged(EVolumetricCloudsPainterChange::Values);
 }
 
 
@@ -467,12 +851,7 @@ void FVolumetricCloudsPainterEdMode::SetBrushFalloff(float NewFalloff)
 void FVolumetricCloudsPainterEdMode::SetBrushOpacity(float NewOpacity)
 {
 	BrushOpacity = NewOpacity;
-
-	if (ColorBlendMaterialInstance != nullptr && AlphaBlendMaterialInstance != nullptr)
-	{
-		ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BrushOpacity"), BrushOpacity * 0.1f);
-		AlphaBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BrushOpacity"), BrushOpacity * 0.1f);
-	}
+	NotifyChanged(EVolumetricCloudsPainterChange::Values);
 }
 
 /** Update brush color.
@@ -498,11 +877,7 @@ void FVolumetricCloudsPainterEdMode::SetBrushChannelValue(float NewValue, FName
 		BrushColor.A = NewValue;
 	}
 
-	if (ColorBlendMaterialInstance != nullptr && AlphaBlendMaterialInstance != nullptr)
-	{
-		ColorBlendMaterialInstance->SetVectorParameterValueEditorOnly(FName("BrushColor"), BrushColor);
-		AlphaBlendMaterialInstance->SetVectorParameterValueEditorOnly(FName("BrushColor"), BrushColor);
-	}
+	NotifyChanged(EVolumetricCloudsPainterChange::Values);
 }
 /** Recieve brush color value by channel.
 * @param Channel - brush color channel.
@@ -567,31 +942,21 @@ void FVolumetricCloudsPainterEdMode::SetChannelState(bool NewValue, FName Channe
 	if (Channel == "RedChannel")
 	{
 		bRedChannelEnabled = NewValue;
-
-		ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("RedChannelEnabled"), (float)NewValue);
-
 	}
 	else if (Channel == "GreenChannel")
 	{
 		bGreenChannelEnabled = NewValue;
-		ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("GreenChannelEnabled"), (float)NewValue);
 	}
 	else if (Channel == "BlueChannel")
 	{
 		bBlueChannelEnabled = NewValue;
-		ColorBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("BlueChannelEnabled"), (float)NewValue);
 	}
 	else if (Channel == "AlphaChannel")
 	{
 		bAlphaChannelEnabled = NewValue;
-		AlphaBlendMaterialInstance->SetScalarParameterValueEditorOnly(FName("AlphaChannelEnabled"), (float)NewValue);
 	}
 
-	if (RenderTarget != nullptr)
-	{
-		ColorBlendMaterialInstance->SetTextureParameterValueEditorOnly(FName("RenderTarget"), RenderTarget);
-		AlphaBlendMaterialInstance->SetTextureParameterValueEditorOnly(FName("RenderTarget"), RenderTarget);
-	}
+	NotifyChanged(EVolumetricCloudsPainterChange::Settings);
 }
 
 /** Change painting state.
@@ -599,6 +964,7 @@ void FVolumetricCloudsPainterEdMode::SetChannelState(bool NewValue, FName Channe
 */
 void FVolumetricCloudsPainterEdMode::SetPaintState(bool newState)
 {
+	const bool bWasPainting = bPainiting;
 	bPainiting = newState;
 
 	if (!bPainiting)
@@ -606,7 +972,12 @@ void FVolumetricCloudsPainterEdMode::SetPaintState(bool newState)
 		if (CloudsMaterial != nullptr && FinalTexture != nullptr)
 		{
 			CloudsMaterial->SetTextureParameterValueEditorOnly(FName("WeatherMap"), FinalTexture);
-			UKismetRenderingLibrary::ConvertRenderTargetToTexture2DEditorOnly(GetWorld(), RenderTarget, FinalTexture);
+
+			//Only flatten layers when leaving paint mode, nothing was painted otherwise.
+			if (bWasPainting)
+			{
+				CommitFinalTexture();
+			}
 		}
 	}
 	else
@@ -625,6 +996,8 @@ void FVolumetricCloudsPainterEdMode::SetPaintState(bool newState)
 		CloudsMaterial->PostLoad();
 	}
 
+	//Layer stack is reloaded when painting starts.
+	NotifyChanged(EVolumetricCloudsPainterChange::Settings | EVolumetricCloudsPainterChange::Layers);
 };
 
 /** Tick function for every frame. */
@@ -632,6 +1005,30 @@ void FVolumetricCloudsPainterEdMode::Tick(FEditorViewportClient * ViewportClient
 {
 	FEdMode::Tick(ViewportClient, DeltaTime);
 
+	//Undo and redo of layer edits only dirty the canvas, layer property edits resolve it right away.
+	FVolumetricCloudsCanvas* Canvas = GetCanvas();
+
+	if (Canvas != nullptr && Canvas->HasDirtyTiles())
+	{
+		UpdateRenderTarget();
+	}
+
+	//Painting flattens layers when it ends.
+	if (bFinalTextureDirty && !IsPainiting())
+	{
+		CommitFinalTexture();
+	}
+
+	//Statistics rows are rebuilt on every notification, so strokes send them a few times a second.
+	const double CurrentTime = FPlatformTime::Seconds();
+
+	if (bStatisticsChanged && (!IsPainiting() || CurrentTime - StatisticsNotifyTime >= StatisticsNotifyInterval))
+	{
+		bStatisticsChanged = false;
+		StatisticsNotifyTime = CurrentTime;
+		NotifyChanged(EVolumetricCloudsPainterChange::Statistics);
+	}
+
 	//Draw this information only if painting is enabled.
 	if (IsPainiting())
 	{
@@ -12,27 +12,73 @@
 #include "SlateFwd.h"
 #include "Widgets/Input/SCheckBox.h"
 #include "Widgets/Input/SNumericEntryBox.h"
+#include "Widgets/Input/SComboBox.h"
+#include "Widgets/Layout/SSpacer.h"
+#include "Widgets/Layout/SBox.h"
+#include "Widgets/SInvalidationPanel.h"
+#include "SVolumetricCloudsHistogram.h"
 
 #define LOCTEXT_NAMESPACE "FVolumetricCloudsPainterEdModeToolkit"
 
-FVolumetricCloudsPainterEdModeToolkit::FVolumetricCloudsPainterEdModeToolkit()
+FVolumetricCloudsPainterEdModeToolkit::FVolumetricCloudsPainterEdModeToolkit(FVolumetricCloudsPainterEdMode* InEdMode)
+	: EdMode(InEdMode)
 {
 }
 
-void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>& InitToolkitHost)
+FVolumetricCloudsPainterEdModeToolkit::~FVolumetricCloudsPainterEdModeToolkit()
 {
-	
-	const float SlotHeight = 40.0f;
+	if (EdMode != nullptr)
+	{
+		EdMode->OnChanged.Remove(OnChangedHandle);
+	}
+}
 
+void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>& InitToolkitHost)
+{
 	const FButtonStyle& EditorButtonStyle = FEditorStyle::GetWidgetStyle<FButtonStyle>("Button");
 	const FCheckBoxStyle& EditorCheckBoxStyle = FEditorStyle::GetWidgetStyle<FCheckBoxStyle>("ToggleButtonCheckbox");
 
 	PaintCheckBoxStyle = FCheckBoxStyle(EditorCheckBoxStyle);
 	PaintTypeCheckBoxStyle = FCheckBoxStyle(EditorCheckBoxStyle);
 	PaintTypeCheckBoxStyle.SetBorderBackgroundColor(FSlateColor(FLinearColor(0.5f, 0.5f, 0.5f, 0.9f)));
-	
 
-	SAssignNew(ToolkitWidget, SBorder)
+	for (int32 BlendMode = 0; BlendMode < (int32)EVolumetricCloudsBlendMode::Count; BlendMode++)
+	{
+		BlendModeOptions.Add(MakeShareable(new EVolumetricCloudsBlendMode((EVolumetricCloudsBlendMode)BlendMode)));
+	}
+
+	for (int32 Operation = 0; Operation < (int32)EVolumetricCloudsMapOperation::Count; Operation++)
+	{
+		MapOperationOptions.Add(MakeShareable(new EVolumetricCloudsMapOperation((EVolumetricCloudsMapOperation)Operation)));
+	}
+
+	for (int32 Channel = 0; Channel < 4; Channel++)
+	{
+		ChannelOptions.Add(MakeShareable(new int32(Channel)));
+	}
+
+	//Widgets are cached by the invalidation panel and only rebuilt when the editor mode reports a change.
+	SAssignNew(ToolkitWidget, SInvalidationPanel)
+		[
+			SAssignNew(ToolkitContent, SBox)
+		];
+
+	if (EdMode != nullptr)
+	{
+		OnChangedHandle = EdMode->OnChanged.AddRaw(this, &FVolumetricCloudsPainterEdModeToolkit::OnPainterChanged);
+	}
+
+	RebuildToolkitContent();
+
+	FModeToolkit::Init(InitToolkitHost);
+}
+
+/** Create toolkit widgets bound to the editor mode state. */
+TSharedRef<SWidget> FVolumetricCloudsPainterEdModeToolkit::BuildToolkitContent()
+{
+	const float SlotHeight = 40.0f;
+
+	return SNew(SBorder)
 		.HAlign(HAlign_Fill)
 		.VAlign(VAlign_Fill)
 		.Padding(FMargin(10, 10))
@@ -131,6 +177,117 @@ void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>&
 		]
 		]
 
+	+ SVerticalBox::Slot()
+		.HAlign(HAlign_Fill)
+		.VAlign(VAlign_Top)
+		.AutoHeight()
+		[
+			SNew(SSpacer)
+			.Size(FVector2D(5.0f, 5.0f))
+		]
+
+	+ SVerticalBox::Slot()
+		.HAlign(HAlign_Fill)
+		.VAlign(VAlign_Top)
+		.AutoHeight()
+		[
+			SNew(SHorizontalBox)
+
+			+ SHorizontalBox::Slot()
+		.HAlign(HAlign_Fill)
+		[
+			MakeBrushToolCheckBox(EVolumetricCloudsBrushTool::Paint, NSLOCTEXT("CloudsPaintSettings", "PaintToolLabel", "Brush"))
+		]
+
+	+ SHorizontalBox::Slot()
+		.HAlign(HAlign_Fill)
+		[
+			MakeBrushToolCheckBox(EVolumetricCloudsBrushTool::Blur, NSLOCTEXT("CloudsPaintSettings", "BlurToolLabel", "Blur"))
+		]
+
+	+ SHorizontalBox::Slot()
+		.HAlign(HAlign_Fill)
+		[
+			MakeBrushToolCheckBox(EVolumetricCloudsBrushTool::Smudge, NSLOCTEXT("CloudsPaintSettings", "SmudgeToolLabel", "Smudge"))
+		]
+
+	+ SHorizontalBox::Slot()
+		.HAlign(HAlign_Fill)
+		[
+			MakeBrushToolCheckBox(EVolumetricCloudsBrushTool::Noise, NSLOCTEXT("CloudsPaintSettings", "NoiseToolLabel", "Noise"))
+		]
+		]
+
+	+ SVerticalBox::Slot()
+		.HAlign(HAlign_Fill)
+		.VAlign(VAlign_Top)
+		.AutoHeight()
+		[
+			SNew(SVerticalBox)
+			.Visibility_Lambda([=]() { return EdMode != nullptr && EdMode->GetBrushTool() == EVolumetricCloudsBrushTool::Blur ? EVisibility::Visible : EVisibility::Collapsed; })
+
+			+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			MakeBrushSettingRow(NSLOCTEXT("CloudsPaintSettings", "BlurSizeLabel", "BlurSize"),
+				SNew(SNumericEntryBox<float>)
+				.AllowSpin(true)
+				.Value_Lambda([=]() -> float { return EdMode->BrushBlurSize; })
+				.MinValue(0.0f)
+				.MaxSliderValue(1.0f)
+				.MaxValue(1.0f)
+				.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { EdMode->BrushBlurSize = Value; EdMode->NotifyChanged(EVolumetricCloudsPainterChange::Values); }))
+				.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { EdMode->BrushBlurSize = Value; EdMode->NotifyChanged(EVolumetricCloudsPainterChange::Values); })))
+		]
+		]
+
+	+ SVerticalBox::Slot()
+		.HAlign(HAlign_Fill)
+		.VAlign(VAlign_Top)
+		.AutoHeight()
+		[
+			SNew(SVerticalBox)
+			.Visibility_Lambda([=]() { return EdMode != nullptr && EdMode->GetBrushTool() == EVolumetricCloudsBrushTool::Noise ? EVisibility::Visible : EVisibility::Collapsed; })
+
+			+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			MakeBrushSettingRow(NSLOCTEXT("CloudsPaintSettings", "NoiseFrequencyLabel", "NoiseFrequency"),
+				SNew(SNumericEntryBox<int32>)
+				.AllowSpin(true)
+				.Value_Lambda([=]() -> int32 { return EdMode->BrushNoiseFrequency; })
+				.MinValue(1)
+				.MaxSliderValue(256)
+				.MaxValue(4096)
+				.OnValueChanged(SNumericEntryBox<int32>::FOnValueChanged::CreateLambda([=](int32 Value) { EdMode->BrushNoiseFrequency = Value; EdMode->NotifyChanged(EVolumetricCloudsPainterChange::Values); }))
+				.OnValueCommitted(SNumericEntryBox<int32>::FOnValueCommitted::CreateLambda([=](int32 Value, ETextCommit::Type CommitType) { EdMode->BrushNoiseFrequency = Value; EdMode->NotifyChanged(EVolumetricCloudsPainterChange::Values); })))
+		]
+
+	+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			MakeBrushSettingRow(NSLOCTEXT("CloudsPaintSettings", "NoiseOctavesLabel", "NoiseOctaves"),
+				SNew(SNumericEntryBox<int32>)
+				.AllowSpin(true)
+				.Value_Lambda([=]() -> int32 { return EdMode->BrushNoiseOctaves; })
+				.MinValue(1)
+				.MaxSliderValue(8)
+				.MaxValue(8)
+				.OnValueChanged(SNumericEntryBox<int32>::FOnValueChanged::CreateLambda([=](int32 Value) { EdMode->BrushNoiseOctaves = Value; EdMode->NotifyChanged(EVolumetricCloudsPainterChange::Values); }))
+				.OnValueCommitted(SNumericEntryBox<int32>::FOnValueCommitted::CreateLambda([=](int32 Value, ETextCommit::Type CommitType) { EdMode->BrushNoiseOctaves = Value; EdMode->NotifyChanged(EVolumetricCloudsPainterChange::Values); })))
+		]
+
+	+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			MakeBrushSettingRow(NSLOCTEXT("CloudsPaintSettings", "NoiseSeedLabel", "NoiseSeed"),
+				SNew(SNumericEntryBox<int32>)
+				.AllowSpin(false)
+				.Value_Lambda([=]() -> int32 { return EdMode->BrushNoiseSeed; })
+				.OnValueCommitted(SNumericEntryBox<int32>::FOnValueCommitted::CreateLambda([=](int32 Value, ETextCommit::Type CommitType) { EdMode->BrushNoiseSeed = Value; EdMode->NotifyChanged(EVolumetricCloudsPainterChange::Values); })))
+		]
+		]
+
 	+ SVerticalBox::Slot()
 		.HAlign(HAlign_Fill)
 		.VAlign(VAlign_Top)
@@ -298,12 +455,12 @@ void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>&
 		[
 			SNew(SNumericEntryBox<float>)
 			.AllowSpin(true)
-		.Value_Lambda([=]() -> float { return ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->GetBrushRadius(); })
+		.Value_Lambda([=]() -> float { return EdMode->GetBrushRadius(); })
 		.MinValue(0.0f)
 		.MaxSliderValue(1.0f)
 		.MaxValue(1.0f)
-		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetBrushRadius(Value); }))
-		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetBrushRadius(Value); }))
+		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { EdMode->SetBrushRadius(Value); }))
+		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { EdMode->SetBrushRadius(Value); }))
 		]
 		]
 		]
@@ -324,12 +481,12 @@ void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>&
 		[
 			SNew(SNumericEntryBox<float>)
 			.AllowSpin(true)
-		.Value_Lambda([=]() -> float { return ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->GetBrushFalloff(); })
+		.Value_Lambda([=]() -> float { return EdMode->GetBrushFalloff(); })
 		.MinValue(0.0f)
 		.MaxSliderValue(1.0f)
 		.MaxValue(1.0f)
-		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetBrushFalloff(Value); }))
-		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetBrushFalloff(Value); }))
+		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { EdMode->SetBrushFalloff(Value); }))
+		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { EdMode->SetBrushFalloff(Value); }))
 		]
 		]
 		]
@@ -350,12 +507,12 @@ void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>&
 		[
 			SNew(SNumericEntryBox<float>)
 			.AllowSpin(true)
-		.Value_Lambda([=]() -> float { return ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->GetBrushOpacity(); })
+		.Value_Lambda([=]() -> float { return EdMode->GetBrushOpacity(); })
 		.MinValue(0.0f)
 		.MaxSliderValue(1.0f)
 		.MaxValue(1.0f)
-		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetBrushOpacity(Value); }))
-		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetBrushOpacity(Value); }))
+		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { EdMode->SetBrushOpacity(Value); }))
+		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { EdMode->SetBrushOpacity(Value); }))
 		]
 		]
 		]
@@ -380,12 +537,12 @@ void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>&
 		[
 			SNew(SNumericEntryBox<float>)
 			.AllowSpin(true)
-		.Value_Lambda([=]() -> float { return ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->GetBrushChannelValue("RedChannel"); })
+		.Value_Lambda([=]() -> float { return EdMode->GetBrushChannelValue("RedChannel"); })
 		.MinValue(0.0f)
 		.MaxValue(1.0f)
 		.MaxSliderValue(1.0f)
-		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetBrushChannelValue(Value, "RedChannel"); }))
-		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetBrushChannelValue(Value, "RedChannel"); }))
+		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { EdMode->SetBrushChannelValue(Value, "RedChannel"); }))
+		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { EdMode->SetBrushChannelValue(Value, "RedChannel"); }))
 		]
 
 	+ SHorizontalBox::Slot()
@@ -408,7 +565,7 @@ void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>&
 		[
 			SNew(STextBlock)
 			.AutoWrapText(false)
-		.Text_Lambda([=]() -> FText { return ChannelCheckBoxText("RedChannel"); })
+		.Text_Raw(this, &FVolumetricCloudsPainterEdModeToolkit::ChannelCheckBoxText, FName("RedChannel"))
 		//.ToolTipText(NSLOCTEXT("CloudsPaintSettings", "RedChannelToolTip", "Colors Channels which should be influenced during Painting."))
 		]
 		]
@@ -433,12 +590,12 @@ void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>&
 		[
 			SNew(SNumericEntryBox<float>)
 			.AllowSpin(true)
-		.Value_Lambda([=]() -> float { return ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->GetBrushChannelValue("GreenChannel"); })
+		.Value_Lambda([=]() -> float { return EdMode->GetBrushChannelValue("GreenChannel"); })
 		.MinValue(0.0f)
 		.MaxValue(1.0f)
 		.MaxSliderValue(1.0f)
-		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetBrushChannelValue(Value, "GreenChannel"); }))
-		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->GetBrushChannelValue("GreenChannel"); }))
+		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { EdMode->SetBrushChannelValue(Value, "GreenChannel"); }))
+		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { EdMode->SetBrushChannelValue(Value, "GreenChannel"); }))
 		]
 
 	+ SHorizontalBox::Slot()
@@ -461,7 +618,7 @@ void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>&
 		[
 			SNew(STextBlock)
 			.AutoWrapText(false)
-		.Text_Lambda([=]() -> FText { return ChannelCheckBoxText("GreenChannel"); })
+		.Text_Raw(this, &FVolumetricCloudsPainterEdModeToolkit::ChannelCheckBoxText, FName("GreenChannel"))
 		//.ToolTipText(NSLOCTEXT("CloudsPaintSettings", "RedChannelToolTip", "Colors Channels which should be influenced during Painting."))
 		]
 		]
@@ -486,12 +643,12 @@ void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>&
 		[
 			SNew(SNumericEntryBox<float>)
 			.AllowSpin(true)
-		.Value_Lambda([=]() -> float { return ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->GetBrushChannelValue("BlueChannel"); })
+		.Value_Lambda([=]() -> float { return EdMode->GetBrushChannelValue("BlueChannel"); })
 		.MinValue(0.0f)
 		.MaxValue(1.0f)
 		.MaxSliderValue(1.0f)
-		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetBrushChannelValue(Value, "BlueChannel"); }))
-		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetBrushChannelValue(Value, "BlueChannel"); }))
+		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { EdMode->SetBrushChannelValue(Value, "BlueChannel"); }))
+		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { EdMode->SetBrushChannelValue(Value, "BlueChannel"); }))
 		]
 
 	+ SHorizontalBox::Slot()
@@ -514,7 +671,7 @@ void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>&
 		[
 			SNew(STextBlock)
 			.AutoWrapText(false)
-		.Text_Lambda([=]() -> FText { return ChannelCheckBoxText("BlueChannel"); })
+		.Text_Raw(this, &FVolumetricCloudsPainterEdModeToolkit::ChannelCheckBoxText, FName("BlueChannel"))
 		//.ToolTipText(NSLOCTEXT("CloudsPaintSettings", "RedChannelToolTip", "Colors Channels which should be influenced during Painting."))
 		]
 		]
@@ -539,12 +696,12 @@ void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>&
 		[
 			SNew(SNumericEntryBox<float>)
 			.AllowSpin(true)
-		.Value_Lambda([=]() -> float { return ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->GetBrushChannelValue("AlphaChannel"); })
+		.Value_Lambda([=]() -> float { return EdMode->GetBrushChannelValue("AlphaChannel"); })
 		.MinValue(0.0f)
 		.MaxValue(1.0f)
 		.MaxSliderValue(1.0f)
-		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetBrushChannelValue(Value, "AlphaChannel"); }))
-		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetBrushChannelValue(Value, "AlphaChannel"); }))
+		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { EdMode->SetBrushChannelValue(Value, "AlphaChannel"); }))
+		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { EdMode->SetBrushChannelValue(Value, "AlphaChannel"); }))
 		]
 
 	+ SHorizontalBox::Slot()
@@ -567,7 +724,7 @@ void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>&
 		[
 			SNew(STextBlock)
 			.AutoWrapText(false)
-		.Text_Lambda([=]() -> FText { return ChannelCheckBoxText("AlphaChannel"); })
+		.Text_Raw(this, &FVolumetricCloudsPainterEdModeToolkit::ChannelCheckBoxText, FName("AlphaChannel"))
 		//.ToolTipText(NSLOCTEXT("CloudsPaintSettings", "RedChannelToolTip", "Colors Channels which should be influenced during Painting."))
 		]
 		]
@@ -585,15 +742,243 @@ void FVolumetricCloudsPainterEdModeToolkit::Init(const TSharedPtr<IToolkitHost>&
 	///////////////////////////////////////////////
 		]
 
+	+ SVerticalBox::Slot()
+		.HAlign(HAlign_Fill)
+		.VAlign(VAlign_Top)
+		.AutoHeight()
+		[
+			SNew(SSpacer)
+			.Size(FVector2D(10.0f, 10.0f))
+		]
+
+	+ SVerticalBox::Slot()
+		.HAlign(HAlign_Fill)
+		.VAlign(VAlign_Top)
+		.AutoHeight()
+		[
+			SNew(SHorizontalBox)
+
+			+ SHorizontalBox::Slot()
+		.FillWidth(1.0f)
+		.VAlign(VAlign_Center)
+		[
+			SNew(STextBlock)
+			.AutoWrapText(false)
+		.Text(NSLOCTEXT("CloudsPaintSettings", "LayersLabel", "Layers"))
+		]
+
+	+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.Text(NSLOCTEXT("CloudsPaintSettings", "AddLayerLabel", "Add Layer"))
+		.OnClicked_Raw(this, &FVolumetricCloudsPainterEdModeToolkit::OnAddLayerClicked)
+		]
+		]
+
+	+ SVerticalBox::Slot()
+		.HAlign(HAlign_Fill)
+		.VAlign(VAlign_Top)
+		.AutoHeight()
+		[
+			SAssignNew(LayerList, SVerticalBox)
+		]
+
+	+ SVerticalBox::Slot()
+		.HAlign(HAlign_Fill)
+		.VAlign(VAlign_Top)
+		.AutoHeight()
+		[
+			SNew(SSpacer)
+			.Size(FVector2D(10.0f, 10.0f))
+		]
+
+	+ SVerticalBox::Slot()
+		.HAlign(HAlign_Fill)
+		.VAlign(VAlign_Top)
+		.AutoHeight()
+		[
+			SNew(SVerticalBox)
+			.IsEnabled(GetCanvas() != nullptr)
+
+			+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			SNew(SHorizontalBox)
+
+			+ SHorizontalBox::Slot()
+		.FillWidth(1.0f)
+		.VAlign(VAlign_Center)
+		[
+			SNew(STextBlock)
+			.AutoWrapText(false)
+		.Text(NSLOCTEXT("CloudsPaintSettings", "MapOperationsLabel", "Map Operations"))
+		]
+
+	+ SHorizontalBox::Slot()
+		.FillWidth(1.0f)
+		[
+			SNew(SComboBox<TSharedPtr<EVolumetricCloudsMapOperation>>)
+			.OptionsSource(&MapOperationOptions)
+		.OnGenerateWidget_Lambda([](TSharedPtr<EVolumetricCloudsMapOperation> Option) -> TSharedRef<SWidget>
+		{
+			return SNew(STextBlock).Text(FText::FromString(GetVolumetricCloudsMapOperationName(*Option)));
+		})
+		.OnSelectionChanged_Lambda([=](TSharedPtr<EVolumetricCloudsMapOperation> Option, ESelectInfo::Type SelectInfo)
+		{
+			if (Option.IsValid() && EdMode != nullptr)
+			{
+				EdMode->SetMapOperationType(*Option);
+			}
+		})
+		[
+			SNew(STextBlock)
+			.Text_Lambda([=]() { return EdMode != nullptr ? FText::FromString(GetVolumetricCloudsMapOperationName(EdMode->MapOperation.Type)) : FText::GetEmpty(); })
+		]
+		]
+
+	+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.Text(NSLOCTEXT("CloudsPaintSettings", "ApplyMapOperationLabel", "Apply"))
+		.ToolTipText(NSLOCTEXT("CloudsPaintSettings", "ApplyMapOperationToolTip", "Apply operation to enabled channels of the active layer."))
+		.OnClicked_Lambda([=]() -> FReply
+		{
+			EdMode->ApplyMapOperation();
+			return FReply::Handled();
+		})
+		]
+		]
+
+	+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			MakeMapOperationValueRow(EVolumetricCloudsMapOperation::Levels, NSLOCTEXT("CloudsPaintSettings", "InBlackLabel", "InputBlack"), &FVolumetricCloudsMapOperation::InBlack, 1.0f)
+		]
+
+	+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			MakeMapOperationValueRow(EVolumetricCloudsMapOperation::Levels, NSLOCTEXT("CloudsPaintSettings", "InWhiteLabel", "InputWhite"), &FVolumetricCloudsMapOperation::InWhite, 1.0f)
+		]
+
+	+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			MakeMapOperationValueRow(EVolumetricCloudsMapOperation::Levels, NSLOCTEXT("CloudsPaintSettings", "GammaLabel", "Gamma"), &FVolumetricCloudsMapOperation::Gamma, 4.0f)
+		]
+
+	+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			MakeMapOperationValueRow(EVolumetricCloudsMapOperation::Levels, NSLOCTEXT("CloudsPaintSettings", "OutBlackLabel", "OutputBlack"), &FVolumetricCloudsMapOperation::OutBlack, 1.0f)
+		]
+
+	+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			MakeMapOperationValueRow(EVolumetricCloudsMapOperation::Levels, NSLOCTEXT("CloudsPaintSettings", "OutWhiteLabel", "OutputWhite"), &FVolumetricCloudsMapOperation::OutWhite, 1.0f)
+		]
+
+	+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			MakeMapOperationValueRow(EVolumetricCloudsMapOperation::Fill, NSLOCTEXT("CloudsPaintSettings", "FillValueLabel", "FillValue"), &FVolumetricCloudsMapOperation::FillValue, 1.0f)
+		]
+
+	+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			MakeMapOperationValueRow(EVolumetricCloudsMapOperation::Threshold, NSLOCTEXT("CloudsPaintSettings", "ThresholdLabel", "Threshold"), &FVolumetricCloudsMapOperation::Threshold, 1.0f)
+		]
+
+	+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			SNew(SHorizontalBox)
+			.Visibility_Raw(this, &FVolumetricCloudsPainterEdModeToolkit::GetMapOperationVisibility, EVolumetricCloudsMapOperation::Swizzle)
+
+			+ SHorizontalBox::Slot()
+		.FillWidth(1.0f)
+		[
+			MakeSwizzleComboBox(0)
+		]
+
+	+ SHorizontalBox::Slot()
+		.FillWidth(1.0f)
+		[
+			MakeSwizzleComboBox(1)
+		]
+
+	+ SHorizontalBox::Slot()
+		.FillWidth(1.0f)
+		[
+			MakeSwizzleComboBox(2)
+		]
+
+	+ SHorizontalBox::Slot()
+		.FillWidth(1.0f)
+		[
+			MakeSwizzleComboBox(3)
+		]
+		]
+		]
+
+	+ SVerticalBox::Slot()
+		.HAlign(HAlign_Fill)
+		.VAlign(VAlign_Top)
+		.AutoHeight()
+		[
+			SNew(SSpacer)
+			.Size(FVector2D(10.0f, 10.0f))
+		]
+
+	+ SVerticalBox::Slot()
+		.HAlign(HAlign_Fill)
+		.VAlign(VAlign_Top)
+		.AutoHeight()
+		[
+			SAssignNew(StatisticsBox, SBox)
+		]
+
 
 
 		];
+}
 
+/** Replace all toolkit widgets. */
+void FVolumetricCloudsPainterEdModeToolkit::RebuildToolkitContent()
+{
+	if (!ToolkitContent.IsValid())
+	{
+		return;
+	}
 
+	ToolkitContent->SetContent(BuildToolkitContent());
 
+	RebuildLayerList();
+	RebuildStatistics();
+}
 
+/** Rebuild widgets affected by an editor mode change. */
+void FVolumetricCloudsPainterEdModeToolkit::OnPainterChanged(EVolumetricCloudsPainterChange Change)
+{
+	if (EnumHasAnyFlags(Change, EVolumetricCloudsPainterChange::Layers))
+	{
+		RebuildLayerList();
+	}
 
-	FModeToolkit::Init(InitToolkitHost);
+	if (EnumHasAnyFlags(Change, EVolumetricCloudsPainterChange::Statistics))
+	{
+		RebuildStatistics();
+	}
+
+	//Setting and value widgets are bound to the editor mode, a change only needs the cached widgets repainted.
+	if (EnumHasAnyFlags(Change, EVolumetricCloudsPainterChange::Settings | EVolumetricCloudsPainterChange::Values) && ToolkitContent.IsValid())
+	{
+		ToolkitContent->Invalidate(EInvalidateWidget::Layout | EInvalidateWidget::Visibility);
+	}
 }
 
 FName FVolumetricCloudsPainterEdModeToolkit::GetToolkitFName() const
@@ -608,33 +993,214 @@ FText FVolumetricCloudsPainterEdModeToolkit::GetBaseToolkitName() const
 
 class FEdMode* FVolumetricCloudsPainterEdModeToolkit::GetEditorMode() const
 {
-	return GLevelEditorModeTools().GetActiveMode(FVolumetricCloudsPainterEdMode::EM_VolumetricCloudsPainterEdModeId);
+	return EdMode;
 }
 
 /** Is editor mode have a clouds actor. */
 bool FVolumetricCloudsPainterEdModeToolkit::IsActorSelected() const
 {
-	return (((FVolumetricCloudsPainterEdMode*)GetEditorMode()) != nullptr && ((FVolumetricCloudsPainterEdMode*)GetEditorMode())->CloudsActor != nullptr);
+	return (EdMode != nullptr && EdMode->CloudsActor != nullptr);
 }
 
 
 
+/** Create a toggle that selects a brush tool.
+* @param Tool - brush tool selected by the toggle.
+* @param Label - toggle text.
+*/
+TSharedRef<SWidget> FVolumetricCloudsPainterEdModeToolkit::MakeBrushToolCheckBox(EVolumetricCloudsBrushTool Tool, const FText& Label)
+{
+	return SNew(SCheckBox)
+		.HAlign(HAlign_Center)
+		.Style(&PaintTypeCheckBoxStyle)
+		.IsChecked_Lambda([=]() { return EdMode != nullptr && EdMode->GetBrushTool() == Tool ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+		.OnCheckStateChanged_Lambda([=](ECheckBoxState NewState)
+		{
+			if (EdMode != nullptr)
+			{
+				EdMode->SetBrushTool(Tool);
+			}
+		})
+		[
+			SNew(SBorder)
+			.HAlign(EHorizontalAlignment::HAlign_Left)
+		.VAlign(EVerticalAlignment::VAlign_Center)
+		.BorderBackgroundColor(FLinearColor(0, 0, 0, 0))
+		.Padding(FMargin(5, 5))
+		[
+			SNew(STextBlock)
+			.AutoWrapText(false)
+		.Text(Label)
+		]
+		];
+}
+
+/** Create a labeled brush setting row.
+* @param Label - setting name.
+* @param ValueWidget - widget that edits the setting.
+*/
+TSharedRef<SWidget> FVolumetricCloudsPainterEdModeToolkit::MakeBrushSettingRow(const FText& Label, const TSharedRef<SWidget>& ValueWidget)
+{
+	return SNew(SHorizontalBox)
+
+		+ SHorizontalBox::Slot()
+		.FillWidth(1.0f)
+		.VAlign(VAlign_Center)
+		[
+			SNew(STextBlock)
+			.AutoWrapText(false)
+		.Text(Label)
+		]
+
+	+ SHorizontalBox::Slot()
+		.FillWidth(1.0f)
+		.VAlign(VAlign_Center)
+		[
+			ValueWidget
+		];
+}
+
+/** Map operation settings are only shown for the selected operation. */
+EVisibility FVolumetricCloudsPainterEdModeToolkit::GetMapOperationVisibility(EVolumetricCloudsMapOperation Operation) const
+{
+	return EdMode != nullptr && EdMode->MapOperation.Type == Operation ? EVisibility::Visible : EVisibility::Collapsed;
+}
+
+/** Create a map operation setting row with a value per channel.
+* @param Operation - operation that uses the setting.
+* @param Label - setting name.
+* @param Value - operation member edited by the row.
+* @param MaxValue - largest slider value.
+*/
+TSharedRef<SWidget> FVolumetricCloudsPainterEdModeToolkit::MakeMapOperationValueRow(EVolumetricCloudsMapOperation Operation, const FText& Label, FLinearColor FVolumetricCloudsMapOperation::* Value, float MaxValue)
+{
+	static const TCHAR* ChannelNames[] = { TEXT("R"), TEXT("G"), TEXT("B"), TEXT("A") };
+
+	TSharedRef<SHorizontalBox> Channels = SNew(SHorizontalBox);
+
+	for (int32 Channel = 0; Channel < 4; Channel++)
+	{
+		Channels->AddSlot()
+			.FillWidth(1.0f)
+			[
+				SNew(SNumericEntryBox<float>)
+				.AllowSpin(true)
+			.LabelVAlign(VAlign_Center)
+			.Label()
+			[
+				SNew(STextBlock)
+				.Text(FText::FromString(ChannelNames[Channel]))
+			]
+		.Value_Lambda([=]() -> float { return (&(EdMode->MapOperation.*Value).R)[Channel]; })
+			.MinValue(0.0f)
+			.MaxSliderValue(MaxValue)
+			.MaxValue(MaxValue)
+			.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float NewValue) { (&(EdMode->MapOperation.*Value).R)[Channel] = NewValue; EdMode->NotifyChanged(EVolumetricCloudsPainterChange::Values); }))
+			.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float NewValue, ETextCommit::Type CommitType) { (&(EdMode->MapOperation.*Value).R)[Channel] = NewValue; EdMode->NotifyChanged(EVolumetricCloudsPainterChange::Values); }))
+			];
+	}
+
+	TSharedRef<SWidget> Row = MakeBrushSettingRow(Label, Channels);
+
+	Row->SetVisibility(TAttribute<EVisibility>::Create(TAttribute<EVisibility>::FGetter::CreateRaw(this, &FVolumetricCloudsPainterEdModeToolkit::GetMapOperationVisibility, Operation)));
+
+	return Row;
+}
+
+/** Create a combo box that selects the source channel of a swizzle output channel.
+* @param Channel - output channel index.
+*/
+TSharedRef<SWidget> FVolumetricCloudsPainterEdModeToolkit::MakeSwizzleComboBox(int32 Channel)
+{
+	static const TCHAR* ChannelNames[] = { TEXT("R"), TEXT("G"), TEXT("B"), TEXT("A") };
+
+	return SNew(SComboBox<TSharedPtr<int32>>)
+		.OptionsSource(&ChannelOptions)
+		.OnGenerateWidget_Lambda([](TSharedPtr<int32> Option) -> TSharedRef<SWidget>
+		{
+			return SNew(STextBlock).Text(FText::FromString(ChannelNames[*Option]));
+		})
+		.OnSelectionChanged_Lambda([=](TSharedPtr<int32> Option, ESelectInfo::Type SelectInfo)
+		{
+			if (Option.IsValid() && EdMode != nullptr)
+			{
+				EdMode->MapOperation.Swizzle[Channel] = *Option;
+				EdMode->NotifyChanged(EVolumetricCloudsPainterChange::Settings);
+			}
+		})
+		[
+			SNew(STextBlock)
+			.Text_Lambda([=]() { return FText::FromString(FString::Printf(TEXT("%s <- %s"), ChannelNames[Channel], ChannelNames[EdMode != nullptr ? FMath::Clamp(EdMode->MapOperation.Swizzle[Channel], 0, 3) : Channel])); })
+		];
+}
+
+/** Create statistics text and histogram of a weather map channel.
+* @param Channel - channel index.
+* @param Label - channel name.
+* @param Color - histogram bar color.
+*/
+TSharedRef<SWidget> FVolumetricCloudsPainterEdModeToolkit::MakeStatisticsRow(int32 Channel, const FText& Label, const FLinearColor& Color)
+{
+	const FVolumetricCloudsStatistics* Statistics = GetStatistics();
+
+	if (Statistics == nullptr)
+	{
+		return SNullWidget::NullWidget;
+	}
+
+	FNumberFormattingOptions PercentFormat;
+	PercentFormat.SetMaximumFractionalDigits(1);
+	FNumberFormattingOptions ValueFormat;
+	ValueFormat.SetMinimumFractionalDigits(3).SetMaximumFractionalDigits(3);
+
+	return SNew(SVerticalBox)
+
+		+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			SNew(STextBlock)
+			.AutoWrapText(false)
+		.Text(FText::Format(NSLOCTEXT("CloudsPaintSettings", "ChannelStatistics", "{0}: coverage {1}%, mean {2}, min {3}, max {4}"),
+			Label,
+			FText::AsNumber(Statistics->GetCoverage(Channel) * 100.0f, &PercentFormat),
+			FText::AsNumber(Statistics->GetMean(Channel), &ValueFormat),
+			FText::AsNumber(Statistics->GetMin(Channel), &ValueFormat),
+			FText::AsNumber(Statistics->GetMax(Channel), &ValueFormat)))
+		]
+
+	+ SVerticalBox::Slot()
+		.AutoHeight()
+		.Padding(FMargin(0, 2, 0, 5))
+		[
+			SNew(SVolumetricCloudsHistogram)
+			.Statistics([=]() { return GetStatistics(); })
+		.Channel(Channel)
+		.Color(Color)
+		];
+}
+
+/** Statistics of the painted weather map, nullptr if nothing is loaded. */
+const FVolumetricCloudsStatistics* FVolumetricCloudsPainterEdModeToolkit::GetStatistics() const
+{
+	return EdMode != nullptr && EdMode->Statistics.IsValid() ? &EdMode->Statistics : nullptr;
+}
+
 /** Event that called when painter checkbox state changed.
 * @param newState - new checkbox state.
 */
 void FVolumetricCloudsPainterEdModeToolkit::OnPainterCheckBoxStateChanged(ECheckBoxState newState)
 {
-	if ((FVolumetricCloudsPainterEdMode*)GetEditorMode() != nullptr)
+	if (EdMode != nullptr)
 	{
-		((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetPaintState(newState == ECheckBoxState::Checked);
+		EdMode->SetPaintState(newState == ECheckBoxState::Checked);
 	}
 }
 /** Is painter checkbox is checked. */
 ECheckBoxState FVolumetricCloudsPainterEdModeToolkit::IsPainterCheckBoxChecked() const
 {
-	if ((FVolumetricCloudsPainterEdMode*)GetEditorMode() != nullptr)
+	if (EdMode != nullptr)
 	{
-		if (((FVolumetricCloudsPainterEdMode*)GetEditorMode())->IsPainiting())
+		if (EdMode->IsPainiting())
 		{
 			return ECheckBoxState::Checked;
 		}
@@ -648,9 +1214,9 @@ ECheckBoxState FVolumetricCloudsPainterEdModeToolkit::IsPainterCheckBoxChecked()
 }
 FText FVolumetricCloudsPainterEdModeToolkit::PainterCheckBoxText() const
 {
-	if ((FVolumetricCloudsPainterEdMode*)GetEditorMode() != nullptr)
+	if (EdMode != nullptr)
 	{
-		if (((FVolumetricCloudsPainterEdMode*)GetEditorMode())->IsPainiting())
+		if (EdMode->IsPainiting())
 		{
 			return FText::FromString("STOP PAINT");
 		}
@@ -669,17 +1235,17 @@ FText FVolumetricCloudsPainterEdModeToolkit::PainterCheckBoxText() const
 */
 void FVolumetricCloudsPainterEdModeToolkit::OnPaintModeCheckBoxStateChanged(ECheckBoxState newState)
 {
-	if ((FVolumetricCloudsPainterEdMode*)GetEditorMode() != nullptr)
+	if (EdMode != nullptr)
 	{
-		((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetPaintMode(newState == ECheckBoxState::Checked);
+		EdMode->SetPaintMode(newState == ECheckBoxState::Checked);
 	}
 }
 /** Is paint mode checkbox is checked. */
 ECheckBoxState FVolumetricCloudsPainterEdModeToolkit::IsPaintModeCheckBoxChecked() const
 {
-	if ((FVolumetricCloudsPainterEdMode*)GetEditorMode() != nullptr)
+	if (EdMode != nullptr)
 	{
-		if (((FVolumetricCloudsPainterEdMode*)GetEditorMode())->IsAdditivePaint())
+		if (EdMode->IsAdditivePaint())
 		{
 			return ECheckBoxState::Checked;
 		}
@@ -697,17 +1263,17 @@ ECheckBoxState FVolumetricCloudsPainterEdModeToolkit::IsPaintModeCheckBoxChecked
 */
 void FVolumetricCloudsPainterEdModeToolkit::OnEraseModeCheckBoxStateChanged(ECheckBoxState newState)
 {
-	if ((FVolumetricCloudsPainterEdMode*)GetEditorMode() != nullptr)
+	if (EdMode != nullptr)
 	{
-		((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetPaintMode(newState != ECheckBoxState::Checked);
+		EdMode->SetPaintMode(newState != ECheckBoxState::Checked);
 	}
 }
 /** Is paint mode checkbox is checked. */
 ECheckBoxState FVolumetricCloudsPainterEdModeToolkit::IsEraseModeCheckBoxChecked() const
 {
-	if ((FVolumetricCloudsPainterEdMode*)GetEditorMode() != nullptr)
+	if (EdMode != nullptr)
 	{
-		if (((FVolumetricCloudsPainterEdMode*)GetEditorMode())->IsAdditivePaint())
+		if (EdMode->IsAdditivePaint())
 		{
 			return ECheckBoxState::Unchecked;
 		}
@@ -724,16 +1290,16 @@ ECheckBoxState FVolumetricCloudsPainterEdModeToolkit::IsEraseModeCheckBoxChecked
 /** Event that called when channel checkbox state changed.	*/
 void FVolumetricCloudsPainterEdModeToolkit::OnChannelCheckBoxStateChanged(ECheckBoxState newState, FName ChannelName)
 {
-	if ((FVolumetricCloudsPainterEdMode*)GetEditorMode() != nullptr)
+	if (EdMode != nullptr)
 	{
-		((FVolumetricCloudsPainterEdMode*)GetEditorMode())->SetChannelState(newState == ECheckBoxState::Checked, ChannelName);
+		EdMode->SetChannelState(newState == ECheckBoxState::Checked, ChannelName);
 	}
 }
 ECheckBoxState FVolumetricCloudsPainterEdModeToolkit::IsChannelBoxChecked(FName ChannelName) const
 {
-	if ((FVolumetricCloudsPainterEdMode*)GetEditorMode() != nullptr)
+	if (EdMode != nullptr)
 	{
-		if (((FVolumetricCloudsPainterEdMode*)GetEditorMode())->IsChannelEnabled(ChannelName))
+		if (EdMode->IsChannelEnabled(ChannelName))
 		{
 			return ECheckBoxState::Checked;
 		}
@@ -747,9 +1313,9 @@ ECheckBoxState FVolumetricCloudsPainterEdModeToolkit::IsChannelBoxChecked(FName
 }
 FText FVolumetricCloudsPainterEdModeToolkit::ChannelCheckBoxText(FName ChannelName) const
 {
-	if ((FVolumetricCloudsPainterEdMode*)GetEditorMode() != nullptr)
+	if (EdMode != nullptr)
 	{
-		if (((FVolumetricCloudsPainterEdMode*)GetEditorMode())->IsChannelEnabled(ChannelName))
+		if (EdMode->IsChannelEnabled(ChannelName))
 		{
 			return FText::FromString("ENABLED");
 		}
@@ -762,5 +1328,201 @@ FText FVolumetricCloudsPainterEdModeToolkit::ChannelCheckBoxText(FName ChannelNa
 	return FText::FromString("DISABLED");
 }
 
+/** Painted canvas of the editor mode, nullptr if there is nothing to paint. */
+FVolumetricCloudsCanvas* FVolumetricCloudsPainterEdModeToolkit::GetCanvas() const
+{
+	if (EdMode != nullptr)
+	{
+		return EdMode->GetCanvas();
+	}
+
+	return nullptr;
+}
+
+/** Rebuild layer rows from the painter layer stack. */
+void FVolumetricCloudsPainterEdModeToolkit::RebuildLayerList()
+{
+	if (!LayerList.IsValid())
+	{
+		return;
+	}
+
+	LayerList->ClearChildren();
+
+	FVolumetricCloudsCanvas* Canvas = GetCanvas();
+
+	if (Canvas == nullptr)
+	{
+		return;
+	}
+
+	//Top layer is listed first.
+	for (int32 LayerIndex = Canvas->GetNumLayers() - 1; LayerIndex >= 0; LayerIndex--)
+	{
+		LayerList->AddSlot()
+			.AutoHeight()
+			.Padding(FMargin(0, 2))
+			[
+				MakeLayerRow(LayerIndex)
+			];
+	}
+}
+
+/** Rebuild statistics rows from the latest weather map statistics. */
+void FVolumetricCloudsPainterEdModeToolkit::RebuildStatistics()
+{
+	if (!StatisticsBox.IsValid())
+	{
+		return;
+	}
+
+	StatisticsBox->SetContent(
+		SNew(SVerticalBox)
+
+		+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			MakeStatisticsRow(0, NSLOCTEXT("CloudsPaintSettings", "RedChannelLabel", "Clouds Probability"), FLinearColor(0.8f, 0.2f, 0.2f, 1.0f))
+		]
+
+	+ SVerticalBox::Slot()
+		.AutoHeight()
+		[
+			MakeStatisticsRow(1, NSLOCTEXT("CloudsPaintSettings", "GreenChannelLabel", "Clouds Type"), FLinearColor(0.2f, 0.8f, 0.2f, 1.0f))
+		]);
+}
+
+/** Create widgets for a single layer row. */
+TSharedRef<SWidget> FVolumetricCloudsPainterEdModeToolkit::MakeLayerRow(int32 LayerIndex)
+{
+	const FVolumetricCloudsCanvas* Canvas = GetCanvas();
+	const FVolumetricCloudsLayer& Layer = Canvas->GetLayer(LayerIndex);
+	const bool bPaintLayer = LayerIndex > 0;
+
+	return SNew(SHorizontalBox)
+
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		.VAlign(VAlign_Center)
+		[
+			SNew(SCheckBox)
+			.IsEnabled(bPaintLayer)
+		.ToolTipText(NSLOCTEXT("CloudsPaintSettings", "LayerVisibleToolTip", "Show layer in the weather map."))
+		.IsChecked(Layer.bVisible ? ECheckBoxState::Checked : ECheckBoxState::Unchecked)
+		.OnCheckStateChanged_Lambda([=](ECheckBoxState NewState)
+		{
+			EdMode->SetLayerVisible(LayerIndex, NewState == ECheckBoxState::Checked);
+		})
+		]
+
+	+ SHorizontalBox::Slot()
+		.FillWidth(1.0f)
+		[
+			SNew(SCheckBox)
+			.Style(&PaintTypeCheckBoxStyle)
+		.IsChecked(Canvas->GetActiveLayer() == LayerIndex ? ECheckBoxState::Checked : ECheckBoxState::Unchecked)
+		.OnCheckStateChanged_Lambda([=](ECheckBoxState NewState)
+		{
+			EdMode->SetActiveLayer(LayerIndex);
+		})
+		[
+			SNew(STextBlock)
+			.AutoWrapText(false)
+		.Text(FText::FromString(Layer.Name))
+		]
+		]
+
+	+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SComboBox<TSharedPtr<EVolumetricCloudsBlendMode>>)
+			.IsEnabled(bPaintLayer)
+		.OptionsSource(&BlendModeOptions)
+		.OnGenerateWidget_Lambda([](TSharedPtr<EVolumetricCloudsBlendMode> Option) -> TSharedRef<SWidget>
+		{
+			return SNew(STextBlock).Text(FText::FromString(GetVolumetricCloudsBlendModeName(*Option)));
+		})
+		.OnSelectionChanged_Lambda([=](TSharedPtr<EVolumetricCloudsBlendMode> Option, ESelectInfo::Type SelectInfo)
+		{
+			if (Option.IsValid())
+			{
+				EdMode->SetLayerBlendMode(LayerIndex, *Option);
+			}
+		})
+		[
+			SNew(STextBlock)
+			.Text(FText::FromString(GetVolumetricCloudsBlendModeName(Layer.BlendMode)))
+		]
+		]
+
+	+ SHorizontalBox::Slot()
+		.FillWidth(0.5f)
+		[
+			SNew(SNumericEntryBox<float>)
+			.IsEnabled(bPaintLayer)
+		.AllowSpin(true)
+		.MinValue(0.0f)
+		.MaxSliderValue(1.0f)
+		.MaxValue(1.0f)
+		.Value_Lambda([=]() -> float
+		{
+			FVolumetricCloudsCanvas* CurrentCanvas = GetCanvas();
+			return CurrentCanvas != nullptr && LayerIndex < CurrentCanvas->GetNumLayers() ? CurrentCanvas->GetLayer(LayerIndex).Opacity : 1.0f;
+		})
+		.OnValueChanged(SNumericEntryBox<float>::FOnValueChanged::CreateLambda([=](float Value) { EdMode->SetLayerOpacity(LayerIndex, Value); }))
+		.OnValueCommitted(SNumericEntryBox<float>::FOnValueCommitted::CreateLambda([=](float Value, ETextCommit::Type CommitType) { EdMode->SetLayerOpacity(LayerIndex, Value); }))
+		]
+
+	+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.IsEnabled(bPaintLayer)
+		.Text(NSLOCTEXT("CloudsPaintSettings", "MoveLayerUpLabel", "Up"))
+		.OnClicked_Lambda([=]() -> FReply
+		{
+			EdMode->MoveLayer(LayerIndex, 1);
+			return FReply::Handled();
+		})
+		]
+
+	+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.IsEnabled(bPaintLayer)
+		.Text(NSLOCTEXT("CloudsPaintSettings", "MoveLayerDownLabel", "Down"))
+		.OnClicked_Lambda([=]() -> FReply
+		{
+			EdMode->MoveLayer(LayerIndex, -1);
+			return FReply::Handled();
+		})
+		]
+
+	+ SHorizontalBox::Slot()
+		.AutoWidth()
+		[
+			SNew(SButton)
+			.IsEnabled(bPaintLayer)
+		.Text(NSLOCTEXT("CloudsPaintSettings", "RemoveLayerLabel", "Remove"))
+		.OnClicked_Lambda([=]() -> FReply
+		{
+			EdMode->RemoveLayer(LayerIndex);
+			return FReply::Handled();
+		})
+		];
+}
+
+/** Event that called when add layer button clicked. */
+FReply FVolumetricCloudsPainterEdModeToolkit::OnAddLayerClicked()
+{
+	if (EdMode != nullptr)
+	{
+		EdMode->AddLayer();
+	}
+
+	return FReply::Handled();
+}
+
 
 #undef LOCTEXT_NAMESPACE
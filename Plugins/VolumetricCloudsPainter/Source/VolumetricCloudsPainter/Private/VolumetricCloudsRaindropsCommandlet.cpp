@@ -0,0 +1,90 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsRaindropsCommandlet.h"
+#include "VolumetricCloudsRaindrops.h"
+#include "VolumetricCloudsAssetUtils.h"
+#include "Engine/Texture2D.h"
+#include "Misc/PackageName.h"
+#include "Misc/Parse.h"
+#include "HAL/PlatformTime.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVolumetricCloudsRaindrops, Log, All);
+
+namespace VolumetricCloudsRaindropsCommandlet
+{
+	/** Write texels to a texture asset source and save it. */
+	bool SaveTexture(const FString& PackageName, const TArray<FColor>& Texels, const FIntPoint& Size, bool bNormalMap)
+	{
+		UTexture2D* Texture = VolumetricCloudsAssetUtils::FindOrCreateAsset<UTexture2D>(PackageName);
+		Texture->Source.Init(Size.X, Size.Y, 1, 1, TSF_BGRA8, (const uint8*)Texels.GetData());
+		Texture->SRGB = false;
+
+		if (bNormalMap)
+		{
+			Texture->CompressionSettings = TC_Normalmap;
+		}
+
+		Texture->PostEditChange();
+
+		return VolumetricCloudsAssetUtils::SaveAsset(Texture);
+	}
+}
+
+UVolumetricCloudsRaindropsCommandlet::UVolumetricCloudsRaindropsCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UVolumetricCloudsRaindropsCommandlet::Main(const FString& Params)
+{
+	using namespace VolumetricCloudsRaindropsCommandlet;
+
+	FString NormalPackageName = TEXT("/Game/Raindrops/T_DrippingRain_N");
+	FString MaskPackageName = TEXT("/Game/Raindrops/T_DrippingRain_MA");
+	FParse::Value(*Params, TEXT("Normal="), NormalPackageName);
+	FParse::Value(*Params, TEXT("Mask="), MaskPackageName);
+
+	if (!FPackageName::IsValidLongPackageName(NormalPackageName) || !FPackageName::IsValidLongPackageName(MaskPackageName))
+	{
+		UE_LOG(LogVolumetricCloudsRaindrops, Error, TEXT("-Normal= and -Mask= have to be long package names, /Game/Path/Texture."));
+		return 1;
+	}
+
+	FVolumetricCloudsRaindropSettings Settings;
+	FParse::Value(*Params, TEXT("Size="), Settings.Size);
+	FParse::Value(*Params, TEXT("Frames="), Settings.NumFrames);
+	FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+	FParse::Value(*Params, TEXT("SpawnRate="), Settings.SpawnRate);
+	FParse::Value(*Params, TEXT("Warmup="), Settings.WarmupSteps);
+	FParse::Value(*Params, TEXT("StepsPerFrame="), Settings.StepsPerFrame);
+	Settings.Size = FMath::Clamp(Settings.Size, 16, 4096);
+	Settings.NumFrames = FMath::Clamp(Settings.NumFrames, 1, 64);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<FColor> Normals;
+	TArray<FColor> Masks;
+	FIntPoint Size;
+	FVolumetricCloudsRaindrops::Bake(Settings, Normals, Masks, Size);
+
+	UE_LOG(LogVolumetricCloudsRaindrops, Display, TEXT("Baked %d raindrop frames (%dx%d) in %.2f s."), Settings.NumFrames, Size.X, Size.Y, FPlatformTime::Seconds() - StartTime);
+
+	if (!SaveTexture(NormalPackageName, Normals, Size, true))
+	{
+		UE_LOG(LogVolumetricCloudsRaindrops, Error, TEXT("Failed to save %s."), *NormalPackageName);
+		return 1;
+	}
+
+	if (!SaveTexture(MaskPackageName, Masks, Size, false))
+	{
+		UE_LOG(LogVolumetricCloudsRaindrops, Error, TEXT("Failed to save %s."), *MaskPackageName);
+		return 1;
+	}
+
+	UE_LOG(LogVolumetricCloudsRaindrops, Display, TEXT("Saved %s and %s."), *NormalPackageName, *MaskPackageName);
+
+	return 0;
+}
@@ -0,0 +1,37 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SLeafWidget.h"
+
+class FVolumetricCloudsStatistics;
+
+/** Histogram of a single weather map channel. */
+class SVolumetricCloudsHistogram : public SLeafWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SVolumetricCloudsHistogram)
+		: _Channel(0)
+		, _Color(FLinearColor::White)
+	{}
+		/** Returns statistics to draw, may return nullptr. */
+		SLATE_ARGUMENT(TFunction<const FVolumetricCloudsStatistics*()>, Statistics)
+		/** Channel index. */
+		SLATE_ARGUMENT(int32, Channel)
+		/** Bar color. */
+		SLATE_ARGUMENT(FLinearColor, Color)
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs);
+
+	// SWidget interface
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
+	// End of SWidget interface
+
+private:
+	TFunction<const FVolumetricCloudsStatistics*()> Statistics;
+	int32 Channel = 0;
+	FLinearColor Color;
+};
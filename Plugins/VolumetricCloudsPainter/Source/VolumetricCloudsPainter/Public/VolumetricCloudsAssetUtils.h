@@ -0,0 +1,34 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Package.h"
+#include "Misc/PackageName.h"
+#include "AssetRegistryModule.h"
+
+/** Asset helpers of the bake commandlets. */
+namespace VolumetricCloudsAssetUtils
+{
+	/** Find an asset in its package or create a new one. */
+	template<typename AssetType>
+	AssetType* FindOrCreateAsset(const FString& PackageName)
+	{
+		UPackage* Package = CreatePackage(nullptr, *PackageName);
+		Package->FullyLoad();
+
+		const FString AssetName = FPackageName::GetLongPackageAssetName(PackageName);
+		AssetType* Asset = FindObject<AssetType>(Package, *AssetName);
+
+		if (Asset == nullptr)
+		{
+			Asset = NewObject<AssetType>(Package, *AssetName, RF_Public | RF_Standalone);
+			FAssetRegistryModule::AssetCreated(Asset);
+		}
+
+		return Asset;
+	}
+
+	/** Save the package of an asset to disk. */
+	bool SaveAsset(UObject* Asset);
+}
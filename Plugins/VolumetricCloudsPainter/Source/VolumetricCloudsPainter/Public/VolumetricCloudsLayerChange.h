@@ -0,0 +1,42 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Change.h"
+#include "VolumetricCloudsCanvas.h"
+
+/**
+* Undo record of a layer edit. Holds texels of the edited tiles from the other side of the edit and swaps them
+* with the layer stack on undo and redo, so only a single copy of the touched tiles is kept per transaction.
+*/
+class FVolumetricCloudsLayerChange : public FCommandChange
+{
+public:
+	/** Capture layer tiles before an edit.
+	* @param Layer - edited layer before the edit.
+	* @param InTileIndices - tiles the edit changes, unallocated paint layer tiles are recorded as empty.
+	*/
+	FVolumetricCloudsLayerChange(const FVolumetricCloudsLayer& Layer, const TArray<int32>& InTileIndices);
+
+	// FCommandChange interface
+	virtual void Apply(UObject* Object) override;
+	virtual void Revert(UObject* Object) override;
+	virtual bool HasExpired(UObject* Object) const override;
+	virtual FString ToString() const override;
+	// End of FCommandChange interface
+
+private:
+	/** Swap stored tiles with the layer stack layer. */
+	void SwapWithLayer(UObject* Object);
+
+	/** Layer stack changes aren't transacted, the edited layer is found by id so moves and removals of other layers don't redirect the change. */
+	int32 LayerId;
+
+	/** Layer size the tiles were recorded at. */
+	FIntPoint Size;
+
+	TArray<int32> TileIndices;
+	TArray<TArray<FFloat16Color>> Values;
+	TArray<TArray<FFloat16Color>> Coverage;
+};
@@ -0,0 +1,48 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "VolumetricCloudsCanvas.h"
+
+#include "VolumetricCloudsLayerStack.generated.h"
+
+class UTexture2D;
+
+/**
+* Sidecar asset stored next to a weather map. Holds the painter layers the weather map was flattened from.
+*/
+UCLASS()
+class UVolumetricCloudsLayerStack : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Source id of the weather map at the time layers were last flattened into it. */
+	UPROPERTY()
+	FGuid FlattenedSourceId;
+
+	/** Painter layers. */
+	FVolumetricCloudsCanvas Canvas;
+
+	// UObject interface
+	virtual void Serialize(FArchive& Ar) override;
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+	// End of UObject interface
+
+	/** Package name of the layer stack that belongs to a weather map. */
+	static FString GetSidecarPackageName(const UTexture2D* WeatherMap);
+
+	/** Load layer stack of a weather map.
+	* @param WeatherMap - weather map texture.
+	* @return layer stack or nullptr if the weather map has no layers yet.
+	*/
+	static UVolumetricCloudsLayerStack* Load(const UTexture2D* WeatherMap);
+
+	/** Move a transient layer stack into its sidecar package next to the weather map. */
+	void SaveAsSidecar(const UTexture2D* WeatherMap);
+
+	/** Is layer stack stored in a sidecar package. */
+	bool IsSidecar() const;
+};
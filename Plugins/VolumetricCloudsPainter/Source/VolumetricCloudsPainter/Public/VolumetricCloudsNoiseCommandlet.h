@@ -0,0 +1,32 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "VolumetricCloudsNoiseCommandlet.generated.h"
+
+/**
+* Bakes tileable 3D Perlin-Worley noise into a volume texture asset.
+*
+* UE4Editor-Cmd.exe FullEnvironmentDev.uproject -run=VolumetricCloudsNoise
+*	-Volume=/Game/VolumetricClouds/Textures/VolumeTextures/VT_DetailNoise
+*	[-Atlas=/Game/VolumetricClouds/Textures/RTS_DetailedNoise] [-Size=128] [-Seed=0]
+*	[-R=PerlinWorley:4:4:0.5] [-G=Worley:8:3:0.5] [-B=Worley:16:3:0.5] [-A=Worley:32:3:0.5]
+*
+* Channel settings are Type:Frequency:Octaves:Persistence, omitted channels keep their defaults.
+* Atlas writes the slices to a 2D texture as well and makes it the source of the volume texture.
+*/
+UCLASS()
+class UVolumetricCloudsNoiseCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UVolumetricCloudsNoiseCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End of UCommandlet interface
+};
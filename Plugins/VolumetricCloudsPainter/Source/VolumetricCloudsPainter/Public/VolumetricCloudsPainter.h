@@ -12,4 +12,8 @@ public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+private:
+	/** Painter memory collector of the environment memory report. */
+	FDelegateHandle CollectMemoryHandle;
 };
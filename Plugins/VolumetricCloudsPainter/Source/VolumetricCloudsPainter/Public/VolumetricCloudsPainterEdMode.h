@@ -8,6 +8,30 @@
 #include "Materials/MaterialInstanceConstant.h"
 #include "Engine/StaticMeshActor.h"
 
+#include "VolumetricCloudsBrush.h"
+#include "VolumetricCloudsCanvas.h"
+#include "VolumetricCloudsFilterBrush.h"
+#include "VolumetricCloudsStatistics.h"
+
+class UVolumetricCloudsLayerStack;
+
+/** Editor mode state that changed. Setting and value widgets are bound to the editor mode and only repainted, layer and statistics rows are rebuilt. */
+enum class EVolumetricCloudsPainterChange : uint8
+{
+	None = 0,
+	/** Clouds actor, paint state, paint mode, channels, brush tool or map operation type. */
+	Settings = 1 << 0,
+	/** Numeric brush, layer or map operation values. */
+	Values = 1 << 1,
+	/** Layer list, active layer or layer properties. */
+	Layers = 1 << 2,
+	/** Weather map statistics. */
+	Statistics = 1 << 3
+};
+ENUM_CLASS_FLAGS(EVolumetricCloudsPainterChange);
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnVolumetricCloudsPainterChanged, EVolumetricCloudsPainterChange);
+
 class FVolumetricCloudsPainterEdMode : public FEdMode
 {
 public:
@@ -22,9 +46,12 @@ public:
 	//virtual void Tick(FEditorViewportClient* ViewportClient, float DeltaTime) override;
 	virtual void Render(const FSceneView* View, FViewport* Viewport, FPrimitiveDrawInterface* PDI) override;
 	virtual void ActorSelectionChangeNotify() override;
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
 
-	/** Find volumetric clouds actor in scene.*/
-	bool GetCloudsActor();
+	/** Find volumetric clouds actor in scene.
+	* @param World - world to search, the editor world if nullptr.
+	*/
+	bool GetCloudsActor(UWorld* World = nullptr);
 
 	/** Release clouds actor. */
 	void ReleaseCoudsActor();
@@ -43,6 +70,13 @@ public:
 
 	// End of FEdMode interface
 
+	/** Called after editor mode state has changed. */
+	FOnVolumetricCloudsPainterChanged OnChanged;
+	/** Broadcast a state change to listeners.
+	* @param Change - changed state.
+	*/
+	void NotifyChanged(EVolumetricCloudsPainterChange Change) { OnChanged.Broadcast(Change); };
+
 	/** Selected clouds actor. */
 	AStaticMeshActor* CloudsActor = nullptr;
 
@@ -69,7 +103,7 @@ public:
 	/** Change painting mode.
 	* @param NewState - new paint mode.
 	*/
-	void SetPaintMode(bool newState) { bAdditivePaint = newState; };
+	void SetPaintMode(bool newState) { bAdditivePaint = newState; NotifyChanged(EVolumetricCloudsPainterChange::Settings); };
 
 	/** Render target texture. */
 	UTextureRenderTarget2D* RenderTarget = nullptr;
@@ -85,16 +119,49 @@ public:
 	/** Load texture to a render target and setup base parameters. */
 	void LoadTexture();
 
-	/** Painter color blend material instance. */
-	UMaterialInstanceConstant* ColorBlendMaterialInstance = nullptr;
-	/** Painter alpha blend material instance. */
-	UMaterialInstanceConstant* AlphaBlendMaterialInstance = nullptr;
-	/** Painter material for combining alpha with a RGB values. */
-	UMaterial* AlphCombineMaterial = nullptr;
-	/** Color blend render target. */
-	UTextureRenderTarget2D* ColorBlendRenderTarget = nullptr;
-	/** Alpha blend render target. */
-	UTextureRenderTarget2D* AlphaBlendRenderTarget = nullptr;
+	/** Painter layers of the final texture. Transient until the first paint layer is added. */
+	UVolumetricCloudsLayerStack* LayerStack = nullptr;
+	/** Texture the layer stack was loaded for. */
+	UTexture2D* LayerStackTexture = nullptr;
+
+	/** Layered weather map that is painted, nullptr if no texture is loaded. */
+	FVolumetricCloudsCanvas* GetCanvas() const;
+
+	/** Recompose dirty canvas tiles and upload them to the render target. */
+	void UpdateRenderTarget();
+
+	/** Per channel statistics of the flattened layers, updated from the recomposed tiles. */
+	FVolumetricCloudsStatistics Statistics;
+	/** Statistics changed since the last notification, sent from Tick. */
+	bool bStatisticsChanged = false;
+	/** Time of the last statistics notification, they are sent at most every StatisticsNotifyInterval while painting. */
+	double StatisticsNotifyTime = 0.0;
+	static constexpr double StatisticsNotifyInterval = 0.25;
+
+	/** Write flattened layers to the final texture. */
+	void CommitFinalTexture();
+	/** Layers were resolved since the last commit, they're written to the final texture on the next tick outside of paint mode. */
+	bool bFinalTextureDirty = false;
+
+	/** Add a new paint layer on top of the layer stack and make it active. */
+	void AddLayer();
+	/** Remove a paint layer.
+	* @param LayerIndex - layer index, base layer can't be removed.
+	*/
+	void RemoveLayer(int32 LayerIndex);
+	/** Move a paint layer up or down.
+	* @param LayerIndex - layer index.
+	* @param Direction - positive to move up, negative to move down.
+	*/
+	void MoveLayer(int32 LayerIndex, int32 Direction);
+	/** Select layer that receives brush strokes. */
+	void SetActiveLayer(int32 LayerIndex);
+	/** Show or hide a paint layer. */
+	void SetLayerVisible(int32 LayerIndex, bool bVisible);
+	/** Change paint layer opacity. */
+	void SetLayerOpacity(int32 LayerIndex, float Opacity);
+	/** Change paint layer blend mode. */
+	void SetLayerBlendMode(int32 LayerIndex, EVolumetricCloudsBlendMode BlendMode);
 
 	/** Brush radius in a UV (0-1) coordinates divided by 2. */
 	float BrushRadius = 0.1f;
@@ -123,11 +190,46 @@ public:
 	/** Recieve brush opacity parameter. */
 	float GetBrushOpacity() { return BrushOpacity; };
 
+	/** Brush stroke type. */
+	EVolumetricCloudsBrushTool BrushTool = EVolumetricCloudsBrushTool::Paint;
+	/** Change brush stroke type.
+	* @param NewTool - new brush tool.
+	*/
+	void SetBrushTool(EVolumetricCloudsBrushTool NewTool) { BrushTool = NewTool; NotifyChanged(EVolumetricCloudsPainterChange::Settings); };
+	/** Recieve brush stroke type. */
+	EVolumetricCloudsBrushTool GetBrushTool() { return BrushTool; };
+
+	/** Blur kernel size relative to the brush radius. */
+	float BrushBlurSize = 0.25f;
+	/** Noise cells across the whole weather map. */
+	int32 BrushNoiseFrequency = 16;
+	/** Number of noise octaves. */
+	int32 BrushNoiseOctaves = 4;
+	/** Noise pattern seed. */
+	int32 BrushNoiseSeed = 0;
+
+	/** Blur, smudge and noise brushes with their scratch buffers. */
+	FVolumetricCloudsFilterBrush FilterBrush;
+
+	/** Weather map UV of the previous stamp in the current stroke. */
+	FVector2D PreviousBrushUV;
+	/** Is PreviousBrushUV valid for the current stroke. */
+	bool bHasPreviousBrushUV = false;
+
+	/** Whole map operation edited in the toolkit. */
+	FVolumetricCloudsMapOperation MapOperation;
+	/** Change edited map operation.
+	* @param NewType - new map operation type.
+	*/
+	void SetMapOperationType(EVolumetricCloudsMapOperation NewType) { MapOperation.Type = NewType; NotifyChanged(EVolumetricCloudsPainterChange::Settings); };
+	/** Apply MapOperation to the active layer as a single undoable transaction. */
+	void ApplyMapOperation();
+
 	/** Draw to a render target. */
 	void DrawToRenderTaget();
 
-	/** Update brush color parameters based on paint state when rendering to a texture. */
-	void SetPreRenderBrushParameters();
+	/** Current brush parameters. */
+	FVolumetricCloudsBrush GetBrush() const;
 
 	/** Brush color. */
 	FLinearColor BrushColor = FLinearColor(1.0f, 1.0f, 1.0f, 1.0f);
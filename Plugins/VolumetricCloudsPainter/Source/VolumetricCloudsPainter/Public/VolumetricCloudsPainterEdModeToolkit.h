@@ -8,6 +8,14 @@
 #include "Runtime/Engine/Classes/Engine/TextureRenderTarget.h"
 #include "Editor/PropertyEditor/Public/PropertyCustomizationHelpers.h"
 
+#include "VolumetricCloudsCanvas.h"
+#include "VolumetricCloudsStatistics.h"
+
+class SVerticalBox;
+class SBox;
+class FVolumetricCloudsPainterEdMode;
+enum class EVolumetricCloudsPainterChange : uint8;
+
 
 
 
@@ -16,7 +24,8 @@ class FVolumetricCloudsPainterEdModeToolkit : public FModeToolkit
 {
 public:
 
-	FVolumetricCloudsPainterEdModeToolkit();
+	FVolumetricCloudsPainterEdModeToolkit(FVolumetricCloudsPainterEdMode* InEdMode);
+	virtual ~FVolumetricCloudsPainterEdModeToolkit();
 
 	/** FModeToolkit interface */
 	virtual void Init(const TSharedPtr<IToolkitHost>& InitToolkitHost) override;
@@ -31,6 +40,25 @@ private:
 
 	TSharedPtr<SWidget> ToolkitWidget;
 
+	/** Editor mode that owns the toolkit. */
+	FVolumetricCloudsPainterEdMode* EdMode;
+
+	/** Toolkit widgets container inside the invalidation panel. */
+	TSharedPtr<SBox> ToolkitContent;
+
+	/** Handle of the editor mode change delegate. */
+	FDelegateHandle OnChangedHandle;
+
+	/** Create toolkit widgets bound to the editor mode state. */
+	TSharedRef<SWidget> BuildToolkitContent();
+
+	/** Replace all toolkit widgets. */
+	void RebuildToolkitContent();
+
+	/** Rebuild widgets affected by an editor mode change.
+	* @param Change - changed editor mode state.
+	*/
+	void OnPainterChanged(EVolumetricCloudsPainterChange Change);
 
 
 private:
@@ -87,5 +115,75 @@ private:
 	ECheckBoxState IsChannelBoxChecked(FName ChannelName) const;
 	FText ChannelCheckBoxText(FName ChannelName) const;
 
+	/** Layer rows container. */
+	TSharedPtr<SVerticalBox> LayerList;
+
+	/** Blend modes listed in layer blend mode combo boxes. */
+	TArray<TSharedPtr<EVolumetricCloudsBlendMode>> BlendModeOptions;
+
+	/** Painted canvas of the editor mode, nullptr if there is nothing to paint. */
+	FVolumetricCloudsCanvas* GetCanvas() const;
+
+	/** Rebuild layer rows from the painter layer stack. */
+	void RebuildLayerList();
+
+	/** Create widgets for a single layer row.
+	* @param LayerIndex - layer index in the layer stack.
+	*/
+	TSharedRef<SWidget> MakeLayerRow(int32 LayerIndex);
+
+	/** Event that called when add layer button clicked. */
+	FReply OnAddLayerClicked();
+
+	/** Create a toggle that selects a brush tool.
+	* @param Tool - brush tool selected by the toggle.
+	* @param Label - toggle text.
+	*/
+	TSharedRef<SWidget> MakeBrushToolCheckBox(EVolumetricCloudsBrushTool Tool, const FText& Label);
+
+	/** Create a labeled brush setting row.
+	* @param Label - setting name.
+	* @param ValueWidget - widget that edits the setting.
+	*/
+	TSharedRef<SWidget> MakeBrushSettingRow(const FText& Label, const TSharedRef<SWidget>& ValueWidget);
+
+	/** Operations listed in the map operation combo box. */
+	TArray<TSharedPtr<EVolumetricCloudsMapOperation>> MapOperationOptions;
+
+	/** Channel indices listed in swizzle combo boxes. */
+	TArray<TSharedPtr<int32>> ChannelOptions;
+
+	/** Map operation settings are only shown for the selected operation. */
+	EVisibility GetMapOperationVisibility(EVolumetricCloudsMapOperation Operation) const;
+
+	/** Create a map operation setting row with a separate value per channel.
+	* @param Operation - operation that uses the setting.
+	* @param Label - setting name.
+	* @param Value - operation member edited by the row.
+	* @param MaxValue - largest slider value.
+	*/
+	TSharedRef<SWidget> MakeMapOperationValueRow(EVolumetricCloudsMapOperation Operation, const FText& Label, FLinearColor FVolumetricCloudsMapOperation::* Value, float MaxValue);
+
+	/** Create a combo box that selects the source channel of a swizzle output channel.
+	* @param Channel - output channel index.
+	*/
+	TSharedRef<SWidget> MakeSwizzleComboBox(int32 Channel);
+
+	/** Create statistics text and histogram of a weather map channel.
+	* @param Channel - channel index.
+	* @param Label - channel name.
+	* @param Color - histogram bar color.
+	*/
+	TSharedRef<SWidget> MakeStatisticsRow(int32 Channel, const FText& Label, const FLinearColor& Color);
+
+	/** Statistics of the painted weather map, nullptr if nothing is loaded. */
+	const FVolumetricCloudsStatistics* GetStatistics() const;
+
+	/** Statistics rows container. */
+	TSharedPtr<SBox> StatisticsBox;
+
+	/** Rebuild statistics rows from the latest weather map statistics. */
+	void RebuildStatistics();
+
 };
 
@@ -0,0 +1,30 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "VolumetricCloudsRaindropsCommandlet.generated.h"
+
+/**
+* Bakes raindrop normal and mask textures in the layout MF_DrippingRain samples.
+*
+* UE4Editor-Cmd.exe FullEnvironmentDev.uproject -run=VolumetricCloudsRaindrops
+*	[-Normal=/Game/Raindrops/T_DrippingRain_N] [-Mask=/Game/Raindrops/T_DrippingRain_MA]
+*	[-Size=512] [-Frames=1] [-Seed=0] [-SpawnRate=12] [-Warmup=400] [-StepsPerFrame=4]
+*
+* Single frame bakes tileable drop-in textures, more frames bake flipbook atlases of Size sized frames.
+*/
+UCLASS()
+class UVolumetricCloudsRaindropsCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UVolumetricCloudsRaindropsCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End of UCommandlet interface
+};
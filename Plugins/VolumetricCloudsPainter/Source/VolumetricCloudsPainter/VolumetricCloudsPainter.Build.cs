@@ -26,6 +26,7 @@ public class VolumetricCloudsPainter : ModuleRules
 			new string[]
 			{
 				"Core",
+				"VolumetricCloudsPainterCore",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -41,7 +42,12 @@ public class VolumetricCloudsPainter : ModuleRules
 				"InputCore",
 				"UnrealEd",
 				"LevelEditor",
-                "EditorStyle"
+                "EditorStyle",
+				"RenderCore",
+				"RHI",
+				"Json",
+				"Projects",
+				"VolumetricCloudsPainterRuntime"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
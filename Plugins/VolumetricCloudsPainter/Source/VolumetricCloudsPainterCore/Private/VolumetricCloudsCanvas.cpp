@@ -0,0 +1,927 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsCanvas.h"
+#include "Math/VectorRegister.h"
+#include "Async/ParallelFor.h"
+#include "Serialization/Archive.h"
+
+namespace VolumetricCloudsCanvas
+{
+	/** Version of the serialized canvas data. */
+	enum EVersion
+	{
+		InitialVersion = 1,
+		HalfPrecisionTiles,
+		StableLayerIds,
+
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	FORCEINLINE VectorRegister VectorSaturate(const VectorRegister& Value)
+	{
+		return VectorMin(VectorMax(Value, VectorZero()), VectorOne());
+	}
+
+	/** Combine layer value with the composite below it. */
+	template<EVolumetricCloudsBlendMode BlendMode>
+	FORCEINLINE VectorRegister BlendTexel(const VectorRegister& Below, const VectorRegister& Value)
+	{
+		switch (BlendMode)
+		{
+		case EVolumetricCloudsBlendMode::Add:		return VectorSaturate(VectorAdd(Below, Value));
+		case EVolumetricCloudsBlendMode::Subtract:	return VectorSaturate(VectorSubtract(Below, Value));
+		case EVolumetricCloudsBlendMode::Multiply:	return VectorMultiply(Below, Value);
+		case EVolumetricCloudsBlendMode::Max:		return VectorMax(Below, Value);
+		case EVolumetricCloudsBlendMode::Min:		return VectorMin(Below, Value);
+		default:									return Value;
+		}
+	}
+
+	/** Blend one layer tile row over a composite row, weighted by layer coverage and opacity. */
+	template<EVolumetricCloudsBlendMode BlendMode>
+	void BlendRow(FLinearColor* RESTRICT Composite, const FLinearColor* RESTRICT Values, const FLinearColor* RESTRICT Coverage, float Opacity)
+	{
+		const VectorRegister LayerOpacity = VectorSetFloat1(Opacity);
+
+		for (int32 Index = 0; Index < FVolumetricCloudsTiledImage::TileSize; Index++)
+		{
+			const VectorRegister Below = VectorLoad(&Composite[Index]);
+			const VectorRegister Blended = BlendTexel<BlendMode>(Below, VectorLoad(&Values[Index]));
+			const VectorRegister Weight = VectorMultiply(VectorLoad(&Coverage[Index]), LayerOpacity);
+
+			VectorStore(VectorMultiplyAdd(VectorSubtract(Blended, Below), Weight, Below), &Composite[Index]);
+		}
+	}
+
+	/** Serialize a layer saved with the given canvas version. */
+	void SerializeLayer(FArchive& Ar, FVolumetricCloudsLayer& Layer, int32 Version)
+	{
+		uint8 BlendMode = (uint8)Layer.BlendMode;
+
+		if (Version >= StableLayerIds)
+		{
+			Ar << Layer.Id;
+		}
+
+		Ar << Layer.Name;
+		Ar << BlendMode;
+		Ar << Layer.Opacity;
+		Ar << Layer.bVisible;
+
+		if (Ar.IsLoading() && Version < HalfPrecisionTiles)
+		{
+			Layer.Values.LoadFullPrecision(Ar);
+			Layer.Coverage.LoadFullPrecision(Ar);
+		}
+		else
+		{
+			Ar << Layer.Values;
+			Ar << Layer.Coverage;
+		}
+
+		if (Ar.IsLoading())
+		{
+			Layer.BlendMode = (EVolumetricCloudsBlendMode)FMath::Min<uint8>(BlendMode, (uint8)EVolumetricCloudsBlendMode::Count - 1);
+		}
+	}
+}
+
+const TCHAR* GetVolumetricCloudsBlendModeName(EVolumetricCloudsBlendMode BlendMode)
+{
+	switch (BlendMode)
+	{
+	case EVolumetricCloudsBlendMode::Normal:	return TEXT("Normal");
+	case EVolumetricCloudsBlendMode::Add:		return TEXT("Add");
+	case EVolumetricCloudsBlendMode::Subtract:	return TEXT("Subtract");
+	case EVolumetricCloudsBlendMode::Multiply:	return TEXT("Multiply");
+	case EVolumetricCloudsBlendMode::Max:		return TEXT("Max");
+	case EVolumetricCloudsBlendMode::Min:		return TEXT("Min");
+	default:									return TEXT("Unknown");
+	}
+}
+
+FArchive& operator<<(FArchive& Ar, FVolumetricCloudsLayer& Layer)
+{
+	VolumetricCloudsCanvas::SerializeLayer(Ar, Layer, VolumetricCloudsCanvas::LatestVersion);
+
+	return Ar;
+}
+
+void FVolumetricCloudsCanvas::Init(int32 SizeX, int32 SizeY, const FLinearColor* BaseTexels)
+{
+	InitBaseLayer(SizeX, SizeY).Import(BaseTexels);
+}
+
+void FVolumetricCloudsCanvas::Init(int32 SizeX, int32 SizeY, const FFloat16Color* BaseTexels)
+{
+	InitBaseLayer(SizeX, SizeY).Import(BaseTexels);
+}
+
+FVolumetricCloudsTiledImage& FVolumetricCloudsCanvas::InitBaseLayer(int32 SizeX, int32 SizeY)
+{
+	Layers.Reset();
+	ActiveLayer = 0;
+	NextLayerId = 1;
+
+	FVolumetricCloudsLayer& BaseLayer = Layers.AddDefaulted_GetRef();
+	BaseLayer.Name = TEXT("Base");
+	BaseLayer.Values.Init(SizeX, SizeY);
+	BaseLayer.Coverage.Init(0, 0);
+
+	Composite.Init(SizeX, SizeY);
+	Composite.AllocateAllTiles();
+
+	MarkAllDirty();
+
+	return BaseLayer.Values;
+}
+
+void FVolumetricCloudsCanvas::Reset()
+{
+	Layers.Empty();
+	ActiveLayer = 0;
+	NextLayerId = 1;
+	Composite.Reset();
+	DirtyTileMask.Empty();
+	DirtyTiles.Empty();
+}
+
+void FVolumetricCloudsCanvas::ResetBaseLayer(const FLinearColor* BaseTexels)
+{
+	check(IsValid());
+
+	Layers[0].Values.Import(BaseTexels);
+
+	for (int32 LayerIndex = 1; LayerIndex < Layers.Num(); LayerIndex++)
+	{
+		Layers[LayerIndex].bVisible = false;
+	}
+
+	MarkAllDirty();
+}
+
+int32 FVolumetricCloudsCanvas::SetBaseLayerChannel(int32 Channel, const float* Values, float Threshold)
+{
+	check(IsValid() && Channel >= 0 && Channel < 4);
+
+	FVolumetricCloudsTiledImage& Base = Layers[0].Values;
+
+	TArray<bool> ChangedTiles;
+	ChangedTiles.SetNumZeroed(Base.GetNumTiles());
+
+	ParallelFor(Base.GetNumTiles(), [&](int32 TileIndex)
+	{
+		const FIntRect Rect = Base.GetTileRect(TileIndex);
+		FFloat16Color* TileData = Base.GetTileData(TileIndex);
+		float MaxDifference = 0.0f;
+
+		//Compared at storage precision, so an unchanged field doesn't rewrite tiles over rounding.
+		for (int32 Y = 0; Y < Rect.Height() && MaxDifference <= Threshold; Y++)
+		{
+			const float* Row = Values + (Rect.Min.Y + Y) * GetSizeX() + Rect.Min.X;
+
+			for (int32 X = 0; X < Rect.Width(); X++)
+			{
+				const FFloat16& Stored = (&TileData[Y * FVolumetricCloudsTiledImage::TileSize + X].R)[Channel];
+				MaxDifference = FMath::Max(MaxDifference, FMath::Abs(Stored.GetFloat() - FFloat16(Row[X]).GetFloat()));
+			}
+		}
+
+		if (MaxDifference <= Threshold)
+		{
+			return;
+		}
+
+		for (int32 Y = 0; Y < Rect.Height(); Y++)
+		{
+			const float* Row = Values + (Rect.Min.Y + Y) * GetSizeX() + Rect.Min.X;
+
+			for (int32 X = 0; X < Rect.Width(); X++)
+			{
+				(&TileData[Y * FVolumetricCloudsTiledImage::TileSize + X].R)[Channel] = FFloat16(Row[X]);
+			}
+		}
+
+		ChangedTiles[TileIndex] = true;
+	});
+
+	int32 NumChanged = 0;
+
+	for (int32 TileIndex = 0; TileIndex < ChangedTiles.Num(); TileIndex++)
+	{
+		if (ChangedTiles[TileIndex])
+		{
+			MarkTileDirty(TileIndex);
+			NumChanged++;
+		}
+	}
+
+	return NumChanged;
+}
+
+void FVolumetricCloudsCanvas::SetBaseLayerChannelTiles(int32 Channel, const TArray<int32>& TileIndices, const TArray<float>& Values)
+{
+	check(IsValid() && Channel >= 0 && Channel < 4 && Values.Num() == TileIndices.Num() * FVolumetricCloudsTiledImage::TileTexels);
+
+	FVolumetricCloudsTiledImage& Base = Layers[0].Values;
+
+	for (int32 Index = 0; Index < TileIndices.Num(); Index++)
+	{
+		FFloat16Color* TileData = Base.FindOrAllocateTile(TileIndices[Index]);
+		const float* TileValues = &Values[Index * FVolumetricCloudsTiledImage::TileTexels];
+
+		for (int32 Texel = 0; Texel < FVolumetricCloudsTiledImage::TileTexels; Texel++)
+		{
+			(&TileData[Texel].R)[Channel] = FFloat16(TileValues[Texel]);
+		}
+
+		MarkTileDirty(TileIndices[Index]);
+	}
+}
+
+void FVolumetricCloudsCanvas::SetBaseLayerTiles(const TArray<int32>& TileIndices, const TArray<FFloat16Color>& Texels)
+{
+	check(IsValid() && Texels.Num() == TileIndices.Num() * FVolumetricCloudsTiledImage::TileTexels);
+
+	FVolumetricCloudsTiledImage& Base = Layers[0].Values;
+
+	//Tiles are stored at the precision they arrive in, a plain copy.
+	for (int32 Index = 0; Index < TileIndices.Num(); Index++)
+	{
+		FFloat16Color* TileData = Base.FindOrAllocateTile(TileIndices[Index]);
+		FMemory::Memcpy(TileData, &Texels[Index * FVolumetricCloudsTiledImage::TileTexels], FVolumetricCloudsTiledImage::TileTexels * sizeof(FFloat16Color));
+
+		MarkTileDirty(TileIndices[Index]);
+	}
+}
+
+int32 FVolumetricCloudsCanvas::AddLayer(const FString& Name)
+{
+	check(IsValid());
+
+	FVolumetricCloudsLayer& Layer = Layers.AddDefaulted_GetRef();
+	Layer.Id = NextLayerId++;
+	Layer.Name = Name;
+	Layer.Values.Init(GetSizeX(), GetSizeY());
+	Layer.Coverage.Init(GetSizeX(), GetSizeY());
+
+	//Nothing is painted yet, so the composite is still valid.
+	return Layers.Num() - 1;
+}
+
+int32 FVolumetricCloudsCanvas::FindLayerIndex(int32 LayerId) const
+{
+	return Layers.IndexOfByPredicate([LayerId](const FVolumetricCloudsLayer& Layer) { return Layer.Id == LayerId; });
+}
+
+void FVolumetricCloudsCanvas::RemoveLayer(int32 LayerIndex)
+{
+	if (LayerIndex <= 0 || !Layers.IsValidIndex(LayerIndex))
+	{
+		return;
+	}
+
+	MarkLayerDirty(LayerIndex);
+	Layers.RemoveAt(LayerIndex);
+
+	ActiveLayer = FMath::Clamp(ActiveLayer >= LayerIndex ? ActiveLayer - 1 : ActiveLayer, 0, Layers.Num() - 1);
+}
+
+void FVolumetricCloudsCanvas::MoveLayer(int32 LayerIndex, int32 Direction)
+{
+	const int32 NewIndex = LayerIndex + FMath::Sign(Direction);
+
+	if (LayerIndex <= 0 || NewIndex <= 0 || !Layers.IsValidIndex(LayerIndex) || !Layers.IsValidIndex(NewIndex))
+	{
+		return;
+	}
+
+	//Order only matters where both layers are painted, but both footprints have to be recomposed.
+	MarkLayerDirty(LayerIndex);
+	MarkLayerDirty(NewIndex);
+	Layers.Swap(LayerIndex, NewIndex);
+
+	if (ActiveLayer == LayerIndex)
+	{
+		ActiveLayer = NewIndex;
+	}
+	else if (ActiveLayer == NewIndex)
+	{
+		ActiveLayer = LayerIndex;
+	}
+}
+
+void FVolumetricCloudsCanvas::SetLayerName(int32 LayerIndex, const FString& Name)
+{
+	if (Layers.IsValidIndex(LayerIndex))
+	{
+		Layers[LayerIndex].Name = Name;
+	}
+}
+
+void FVolumetricCloudsCanvas::SetLayerVisible(int32 LayerIndex, bool bVisible)
+{
+	if (LayerIndex > 0 && Layers.IsValidIndex(LayerIndex) && Layers[LayerIndex].bVisible != bVisible)
+	{
+		Layers[LayerIndex].bVisible = bVisible;
+		MarkLayerDirty(LayerIndex);
+	}
+}
+
+void FVolumetricCloudsCanvas::SetLayerOpacity(int32 LayerIndex, float Opacity)
+{
+	Opacity = FMath::Clamp(Opacity, 0.0f, 1.0f);
+
+	if (LayerIndex > 0 && Layers.IsValidIndex(LayerIndex) && Layers[LayerIndex].Opacity != Opacity)
+	{
+		Layers[LayerIndex].Opacity = Opacity;
+
+		if (Layers[LayerIndex].bVisible)
+		{
+			MarkLayerDirty(LayerIndex);
+		}
+	}
+}
+
+void FVolumetricCloudsCanvas::SetLayerBlendMode(int32 LayerIndex, EVolumetricCloudsBlendMode BlendMode)
+{
+	if (LayerIndex > 0 && Layers.IsValidIndex(LayerIndex) && Layers[LayerIndex].BlendMode != BlendMode)
+	{
+		Layers[LayerIndex].BlendMode = BlendMode;
+
+		if (Layers[LayerIndex].bVisible)
+		{
+			MarkLayerDirty(LayerIndex);
+		}
+	}
+}
+
+void FVolumetricCloudsCanvas::SetActiveLayer(int32 LayerIndex)
+{
+	if (Layers.IsValidIndex(LayerIndex))
+	{
+		ActiveLayer = LayerIndex;
+	}
+}
+
+FIntRect FVolumetricCloudsCanvas::GetBrushRect(const FVolumetricCloudsBrush& Brush, const FVector2D& UV) const
+{
+	const FVector2D TexelRadius = Brush.GetTexelRadius(GetSizeX(), GetSizeY());
+	const FVector2D Center = FVector2D(FMath::Frac(UV.X) * GetSizeX(), FMath::Frac(UV.Y) * GetSizeY());
+
+	return FIntRect(
+		FMath::FloorToInt(Center.X - TexelRadius.X), FMath::FloorToInt(Center.Y - TexelRadius.Y),
+		FMath::CeilToInt(Center.X + TexelRadius.X), FMath::CeilToInt(Center.Y + TexelRadius.Y));
+}
+
+template<typename FunctionType>
+void FVolumetricCloudsCanvas::ForEachBrushTexel(const FVolumetricCloudsBrush& Brush, const FVector2D& UV, bool bAllocate, FunctionType Function)
+{
+	const FVector2D TexelRadius = Brush.GetTexelRadius(GetSizeX(), GetSizeY());
+
+	if (!IsValid() || !Layers.IsValidIndex(ActiveLayer) || TexelRadius.X <= 0.0f || TexelRadius.Y <= 0.0f)
+	{
+		return;
+	}
+
+	const FVector2D Center = FVector2D(FMath::Frac(UV.X) * GetSizeX(), FMath::Frac(UV.Y) * GetSizeY());
+	const FVector2D InvRadius = FVector2D(1.0f / TexelRadius.X, 1.0f / TexelRadius.Y);
+
+	const bool bBaseLayer = ActiveLayer == 0;
+	FVolumetricCloudsLayer& Layer = Layers[ActiveLayer];
+
+	TArray<FIntRect, TInlineAllocator<4>> Rects;
+	TArray<FIntPoint, TInlineAllocator<4>> Offsets;
+	Composite.SplitWrappedRect(GetBrushRect(Brush, UV), Rects, Offsets);
+
+	for (int32 RectIndex = 0; RectIndex < Rects.Num(); RectIndex++)
+	{
+		const FIntRect& Rect = Rects[RectIndex];
+		const FIntPoint& Offset = Offsets[RectIndex];
+
+		const int32 FirstTileX = Rect.Min.X / FVolumetricCloudsTiledImage::TileSize;
+		const int32 FirstTileY = Rect.Min.Y / FVolumetricCloudsTiledImage::TileSize;
+		const int32 LastTileX = (Rect.Max.X - 1) / FVolumetricCloudsTiledImage::TileSize;
+		const int32 LastTileY = (Rect.Max.Y - 1) / FVolumetricCloudsTiledImage::TileSize;
+
+		for (int32 TileY = FirstTileY; TileY <= LastTileY; TileY++)
+		{
+			for (int32 TileX = FirstTileX; TileX <= LastTileX; TileX++)
+			{
+				const int32 TileIndex = TileY * Composite.GetNumTilesX() + TileX;
+				const FIntRect TileRect = Composite.GetTileRect(TileIndex);
+				const FIntRect SubRect(TileRect.Min.ComponentMax(Rect.Min), TileRect.Max.ComponentMin(Rect.Max));
+
+				if (!bBaseLayer && !bAllocate && !Layer.Coverage.IsTileAllocated(TileIndex))
+				{
+					continue;
+				}
+
+				FFloat16Color* Values = Layer.Values.FindOrAllocateTile(TileIndex);
+				FFloat16Color* Coverage = bBaseLayer ? nullptr : Layer.Coverage.FindOrAllocateTile(TileIndex);
+
+				for (int32 Y = SubRect.Min.Y; Y < SubRect.Max.Y; Y++)
+				{
+					const float DistanceY = ((Y + Offset.Y) + 0.5f - Center.Y) * InvRadius.Y;
+
+					for (int32 X = SubRect.Min.X; X < SubRect.Max.X; X++)
+					{
+						const float DistanceX = ((X + Offset.X) + 0.5f - Center.X) * InvRadius.X;
+						const float Mask = Brush.GetMask(FMath::Sqrt(DistanceX * DistanceX + DistanceY * DistanceY));
+
+						if (Mask <= 0.0f)
+						{
+							continue;
+						}
+
+						//Brush math runs in full precision on a copy of the stored texel.
+						const int32 Index = (Y - TileRect.Min.Y) * FVolumetricCloudsTiledImage::TileSize + (X - TileRect.Min.X);
+						FLinearColor Value(Values[Index]);
+						FLinearColor TexelCoverage = Coverage != nullptr ? FLinearColor(Coverage[Index]) : FLinearColor::White;
+
+						Function(&Value, Coverage != nullptr ? &TexelCoverage : nullptr, FIntPoint(X + Offset.X, Y + Offset.Y), Mask);
+
+						Values[Index] = FFloat16Color(Value);
+
+						if (Coverage != nullptr)
+						{
+							Coverage[Index] = FFloat16Color(TexelCoverage);
+						}
+					}
+				}
+
+				MarkTileDirty(TileIndex);
+			}
+		}
+	}
+}
+
+void FVolumetricCloudsCanvas::Stamp(const FVolumetricCloudsBrush& Brush, const FVector2D& UV)
+{
+	using namespace VolumetricCloudsCanvas;
+
+	const VectorRegister ChannelMask = VectorLoad(&Brush.ChannelMask);
+	const VectorRegister Color = VectorLoad(&Brush.Color);
+	const VectorRegister SignedColor = VectorMultiply(Color, VectorSetFloat1(Brush.bAdditive ? 1.0f : -1.0f));
+	const VectorRegister MinWeight = VectorSetFloat1(KINDA_SMALL_NUMBER);
+	const float Strength = Brush.GetStrength();
+
+	//Nothing to erase in tiles the layer never painted.
+	ForEachBrushTexel(Brush, UV, Brush.bAdditive, [&](FLinearColor* Values, FLinearColor* Coverage, const FIntPoint& Texel, float Mask)
+	{
+		const VectorRegister Weight = VectorMultiply(ChannelMask, VectorSetFloat1(Strength * Mask));
+		const VectorRegister Value = VectorLoad(Values);
+
+		if (Coverage == nullptr)
+		{
+			//Base layer keeps the original add/subtract painting.
+			VectorStore(VectorSaturate(VectorMultiplyAdd(SignedColor, Weight, Value)), Values);
+		}
+		else if (Brush.bAdditive)
+		{
+			//Raise coverage and move value towards the brush color by the amount of coverage added.
+			const VectorRegister OldCoverage = VectorLoad(Coverage);
+			const VectorRegister NewCoverage = VectorMin(VectorAdd(OldCoverage, Weight), VectorOne());
+			const VectorRegister Added = VectorSubtract(NewCoverage, OldCoverage);
+			const VectorRegister Sum = VectorMultiplyAdd(Value, OldCoverage, VectorMultiply(Color, Added));
+
+			VectorStore(VectorMultiply(Sum, VectorReciprocalAccurate(VectorMax(NewCoverage, MinWeight))), Values);
+			VectorStore(NewCoverage, Coverage);
+		}
+		else
+		{
+			//Erasing only removes layer coverage.
+			const VectorRegister OldCoverage = VectorLoad(Coverage);
+			VectorStore(VectorMax(VectorSubtract(OldCoverage, Weight), VectorZero()), Coverage);
+		}
+	});
+}
+
+void FVolumetricCloudsCanvas::ReadLayerRegion(const FIntRect& Rect, TArray<FLinearColor>& OutValues, TArray<FLinearColor>& OutCoverage) const
+{
+	const int32 Width = Rect.Width();
+	OutValues.SetNumUninitialized(Width * Rect.Height());
+	OutCoverage.SetNumUninitialized(Width * Rect.Height());
+
+	if (!IsValid())
+	{
+		return;
+	}
+
+	const bool bBaseLayer = ActiveLayer == 0;
+	const FVolumetricCloudsLayer& Layer = Layers[ActiveLayer];
+
+	TArray<FIntRect, TInlineAllocator<4>> Rects;
+	TArray<FIntPoint, TInlineAllocator<4>> Offsets;
+	Composite.SplitWrappedRect(Rect, Rects, Offsets);
+
+	for (int32 RectIndex = 0; RectIndex < Rects.Num(); RectIndex++)
+	{
+		const FIntRect& WrappedRect = Rects[RectIndex];
+		const FIntPoint& Offset = Offsets[RectIndex];
+
+		for (int32 Y = WrappedRect.Min.Y; Y < WrappedRect.Max.Y; Y++)
+		{
+			const int32 Row = (Y + Offset.Y - Rect.Min.Y) * Width;
+
+			for (int32 X = WrappedRect.Min.X; X < WrappedRect.Max.X; X++)
+			{
+				const int32 Index = Row + (X + Offset.X - Rect.Min.X);
+
+				if (bBaseLayer)
+				{
+					OutValues[Index] = Layer.Values.GetTexel(X, Y);
+					OutCoverage[Index] = FLinearColor(1.0f, 1.0f, 1.0f, 1.0f);
+				}
+				else
+				{
+					//Paint layers are filtered premultiplied by coverage so unpainted texels don't bleed in.
+					const FLinearColor Coverage = Layer.Coverage.GetTexel(X, Y);
+					OutValues[Index] = Layer.Values.GetTexel(X, Y) * Coverage;
+					OutCoverage[Index] = Coverage;
+				}
+			}
+		}
+	}
+
+	//Footprints larger than the map are clamped by the wrap, repeat the texels that were read.
+	const int32 ReadWidth = FMath::Min(Width, GetSizeX());
+	const int32 ReadHeight = FMath::Min(Rect.Height(), GetSizeY());
+
+	for (int32 Y = 0; Y < Rect.Height(); Y++)
+	{
+		for (int32 X = 0; X < Width; X++)
+		{
+			if (X >= ReadWidth || Y >= ReadHeight)
+			{
+				OutValues[Y * Width + X] = OutValues[(Y % ReadHeight) * Width + (X % ReadWidth)];
+				OutCoverage[Y * Width + X] = OutCoverage[(Y % ReadHeight) * Width + (X % ReadWidth)];
+			}
+		}
+	}
+}
+
+void FVolumetricCloudsCanvas::BlendBrushRegion(const FVolumetricCloudsBrush& Brush, const FVector2D& UV, const FIntRect& Rect, const TArray<FLinearColor>& Values, const TArray<FLinearColor>& Coverage)
+{
+	using namespace VolumetricCloudsCanvas;
+
+	const VectorRegister ChannelMask = VectorLoad(&Brush.ChannelMask);
+	const VectorRegister MinWeight = VectorSetFloat1(KINDA_SMALL_NUMBER);
+	const float Strength = Brush.GetFilterStrength();
+	const int32 Width = Rect.Width();
+
+	ForEachBrushTexel(Brush, UV, true, [&](FLinearColor* LayerValues, FLinearColor* LayerCoverage, const FIntPoint& Texel, float Mask)
+	{
+		if (!Rect.Contains(Texel))
+		{
+			return;
+		}
+
+		const int32 Index = (Texel.Y - Rect.Min.Y) * Width + (Texel.X - Rect.Min.X);
+		const VectorRegister Weight = VectorMultiply(ChannelMask, VectorSetFloat1(Strength * Mask));
+		const VectorRegister Filtered = VectorLoad(&Values[Index]);
+
+		if (LayerCoverage == nullptr)
+		{
+			const VectorRegister Value = VectorLoad(LayerValues);
+			VectorStore(VectorSaturate(VectorMultiplyAdd(VectorSubtract(Filtered, Value), Weight, Value)), LayerValues);
+		}
+		else
+		{
+			const VectorRegister OldCoverage = VectorLoad(LayerCoverage);
+			const VectorRegister OldValue = VectorMultiply(VectorLoad(LayerValues), OldCoverage);
+			const VectorRegister NewCoverage = VectorSaturate(VectorMultiplyAdd(VectorSubtract(VectorLoad(&Coverage[Index]), OldCoverage), Weight, OldCoverage));
+			const VectorRegister NewValue = VectorMultiplyAdd(VectorSubtract(Filtered, OldValue), Weight, OldValue);
+
+			VectorStore(VectorSaturate(VectorMultiply(NewValue, VectorReciprocalAccurate(VectorMax(NewCoverage, MinWeight)))), LayerValues);
+			VectorStore(NewCoverage, LayerCoverage);
+		}
+	});
+}
+
+void FVolumetricCloudsCanvas::GetMapOperationTiles(const FVolumetricCloudsMapOperation& Operation, TArray<int32>& OutTileIndices) const
+{
+	OutTileIndices.Reset();
+
+	if (!IsValid())
+	{
+		return;
+	}
+
+	const FVolumetricCloudsLayer& Layer = Layers[ActiveLayer];
+
+	if (Operation.Type == EVolumetricCloudsMapOperation::Fill || ActiveLayer == 0)
+	{
+		OutTileIndices.Reserve(Layer.Values.GetNumTiles());
+
+		for (int32 TileIndex = 0; TileIndex < Layer.Values.GetNumTiles(); TileIndex++)
+		{
+			OutTileIndices.Add(TileIndex);
+		}
+	}
+	else
+	{
+		Layer.Values.GetAllocatedTiles(OutTileIndices);
+	}
+}
+
+void FVolumetricCloudsCanvas::ApplyMapOperation(const FVolumetricCloudsMapOperation& Operation, const FLinearColor& ChannelMask)
+{
+	if (!IsValid())
+	{
+		return;
+	}
+
+	const bool bBaseLayer = ActiveLayer == 0;
+	FVolumetricCloudsLayer& Layer = Layers[ActiveLayer];
+
+	TArray<int32> LayerTiles;
+	GetMapOperationTiles(Operation, LayerTiles);
+
+	for (int32 TileIndex : LayerTiles)
+	{
+		Layer.Values.FindOrAllocateTile(TileIndex);
+
+		if (!bBaseLayer)
+		{
+			Layer.Coverage.FindOrAllocateTile(TileIndex);
+		}
+	}
+
+	//Filled channels become fully covered.
+	FVolumetricCloudsMapOperation CoverageFill;
+	CoverageFill.Type = EVolumetricCloudsMapOperation::Fill;
+	CoverageFill.FillValue = FLinearColor(1.0f, 1.0f, 1.0f, 1.0f);
+
+	//Operations run a row at a time in full precision.
+	auto ApplyToTile = [&ChannelMask](const FVolumetricCloudsMapOperation& TileOperation, FFloat16Color* TileData)
+	{
+		FLinearColor Row[FVolumetricCloudsTiledImage::TileSize];
+
+		for (int32 Y = 0; Y < FVolumetricCloudsTiledImage::TileSize; Y++)
+		{
+			FFloat16Color* TileRow = TileData + Y * FVolumetricCloudsTiledImage::TileSize;
+
+			FVolumetricCloudsTiledImage::UnpackTexels(TileRow, Row, FVolumetricCloudsTiledImage::TileSize);
+			TileOperation.Apply(Row, FVolumetricCloudsTiledImage::TileSize, ChannelMask);
+			FVolumetricCloudsTiledImage::PackTexels(Row, TileRow, FVolumetricCloudsTiledImage::TileSize);
+		}
+	};
+
+	ParallelFor(LayerTiles.Num(), [&](int32 Index)
+	{
+		const int32 TileIndex = LayerTiles[Index];
+		ApplyToTile(Operation, Layer.Values.GetTileData(TileIndex));
+
+		if (Operation.Type == EVolumetricCloudsMapOperation::Fill && !bBaseLayer)
+		{
+			ApplyToTile(CoverageFill, Layer.Coverage.GetTileData(TileIndex));
+		}
+	});
+
+	for (int32 TileIndex : LayerTiles)
+	{
+		MarkTileDirty(TileIndex);
+	}
+}
+
+void FVolumetricCloudsCanvas::SwapLayerTiles(int32 LayerIndex, const TArray<int32>& TileIndices, TArray<TArray<FFloat16Color>>& Values, TArray<TArray<FFloat16Color>>& Coverage)
+{
+	if (!Layers.IsValidIndex(LayerIndex))
+	{
+		return;
+	}
+
+	const bool bBaseLayer = LayerIndex == 0;
+	FVolumetricCloudsLayer& Layer = Layers[LayerIndex];
+
+	for (int32 Index = 0; Index < TileIndices.Num(); Index++)
+	{
+		const int32 TileIndex = TileIndices[Index];
+
+		//Base layer tiles are always allocated.
+		if (bBaseLayer && Values[Index].Num() == 0)
+		{
+			continue;
+		}
+
+		Layer.Values.SwapTile(TileIndex, Values[Index]);
+
+		if (!bBaseLayer)
+		{
+			Layer.Coverage.SwapTile(TileIndex, Coverage[Index]);
+		}
+
+		MarkTileDirty(TileIndex);
+	}
+}
+
+void FVolumetricCloudsCanvas::MarkTileDirty(int32 TileIndex)
+{
+	if (!DirtyTileMask[TileIndex])
+	{
+		DirtyTileMask[TileIndex] = true;
+		DirtyTiles.Add(TileIndex);
+	}
+}
+
+void FVolumetricCloudsCanvas::MarkLayerDirty(int32 LayerIndex)
+{
+	if (LayerIndex == 0)
+	{
+		MarkAllDirty();
+		return;
+	}
+
+	TArray<int32> LayerTiles;
+	Layers[LayerIndex].Values.GetAllocatedTiles(LayerTiles);
+
+	for (int32 TileIndex : LayerTiles)
+	{
+		MarkTileDirty(TileIndex);
+	}
+}
+
+void FVolumetricCloudsCanvas::MarkAllDirty()
+{
+	DirtyTileMask.Init(true, Composite.GetNumTiles());
+	DirtyTiles.Reset(Composite.GetNumTiles());
+
+	for (int32 TileIndex = 0; TileIndex < Composite.GetNumTiles(); TileIndex++)
+	{
+		DirtyTiles.Add(TileIndex);
+	}
+}
+
+void FVolumetricCloudsCanvas::ComposeTile(int32 TileIndex)
+{
+	using namespace VolumetricCloudsCanvas;
+
+	const int32 TileSize = FVolumetricCloudsTiledImage::TileSize;
+
+	TArray<const FVolumetricCloudsLayer*, TInlineAllocator<8>> BlendedLayers;
+
+	for (int32 LayerIndex = 1; LayerIndex < Layers.Num(); LayerIndex++)
+	{
+		const FVolumetricCloudsLayer& Layer = Layers[LayerIndex];
+
+		if (Layer.bVisible && Layer.Opacity > 0.0f && Layer.Values.IsTileAllocated(TileIndex) && Layer.Coverage.IsTileAllocated(TileIndex))
+		{
+			BlendedLayers.Add(&Layer);
+		}
+	}
+
+	const FFloat16Color* Base = Layers[0].Values.GetTileData(TileIndex);
+	FFloat16Color* Output = Composite.FindOrAllocateTile(TileIndex);
+
+	if (BlendedLayers.Num() == 0)
+	{
+		FMemory::Memcpy(Output, Base, FVolumetricCloudsTiledImage::TileTexels * sizeof(FFloat16Color));
+		return;
+	}
+
+	//Layers are stored in half precision and blended a row at a time in full precision.
+	FLinearColor Row[TileSize];
+	FLinearColor Values[TileSize];
+	FLinearColor Coverage[TileSize];
+
+	for (int32 Y = 0; Y < TileSize; Y++)
+	{
+		const int32 RowOffset = Y * TileSize;
+		FVolumetricCloudsTiledImage::UnpackTexels(Base + RowOffset, Row, TileSize);
+
+		for (const FVolumetricCloudsLayer* Layer : BlendedLayers)
+		{
+			FVolumetricCloudsTiledImage::UnpackTexels(Layer->Values.GetTileData(TileIndex) + RowOffset, Values, TileSize);
+			FVolumetricCloudsTiledImage::UnpackTexels(Layer->Coverage.GetTileData(TileIndex) + RowOffset, Coverage, TileSize);
+
+			switch (Layer->BlendMode)
+			{
+			case EVolumetricCloudsBlendMode::Add:		BlendRow<EVolumetricCloudsBlendMode::Add>(Row, Values, Coverage, Layer->Opacity); break;
+			case EVolumetricCloudsBlendMode::Subtract:	BlendRow<EVolumetricCloudsBlendMode::Subtract>(Row, Values, Coverage, Layer->Opacity); break;
+			case EVolumetricCloudsBlendMode::Multiply:	BlendRow<EVolumetricCloudsBlendMode::Multiply>(Row, Values, Coverage, Layer->Opacity); break;
+			case EVolumetricCloudsBlendMode::Max:		BlendRow<EVolumetricCloudsBlendMode::Max>(Row, Values, Coverage, Layer->Opacity); break;
+			case EVolumetricCloudsBlendMode::Min:		BlendRow<EVolumetricCloudsBlendMode::Min>(Row, Values, Coverage, Layer->Opacity); break;
+			default:									BlendRow<EVolumetricCloudsBlendMode::Normal>(Row, Values, Coverage, Layer->Opacity); break;
+			}
+		}
+
+		FVolumetricCloudsTiledImage::PackTexels(Row, Output + RowOffset, TileSize);
+	}
+}
+
+void FVolumetricCloudsCanvas::Resolve(TArray<int32>* OutResolvedTiles)
+{
+	if (OutResolvedTiles != nullptr)
+	{
+		*OutResolvedTiles = DirtyTiles;
+	}
+
+	if (DirtyTiles.Num() == 0)
+	{
+		return;
+	}
+
+	//Tiles are independent, a single stroke usually touches only a few of them.
+	ParallelFor(DirtyTiles.Num(), [this](int32 Index)
+	{
+		ComposeTile(DirtyTiles[Index]);
+	}, DirtyTiles.Num() < 4);
+
+	for (int32 TileIndex : DirtyTiles)
+	{
+		DirtyTileMask[TileIndex] = false;
+	}
+
+	DirtyTiles.Reset();
+}
+
+void FVolumetricCloudsCanvas::Flatten(TArray<FLinearColor>& OutTexels)
+{
+	Resolve();
+
+	OutTexels.SetNumUninitialized(GetSizeX() * GetSizeY());
+	Composite.Export(OutTexels.GetData());
+}
+
+SIZE_T FVolumetricCloudsCanvas::GetAllocatedSize() const
+{
+	SIZE_T Size = Composite.GetAllocatedSize() + DirtyTiles.GetAllocatedSize();
+
+	for (const FVolumetricCloudsLayer& Layer : Layers)
+	{
+		Size += Layer.Values.GetAllocatedSize() + Layer.Coverage.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+FArchive& operator<<(FArchive& Ar, FVolumetricCloudsCanvas& Canvas)
+{
+	int32 Version = VolumetricCloudsCanvas::LatestVersion;
+	Ar << Version;
+
+	if (Ar.IsLoading() && (Version <= 0 || Version > VolumetricCloudsCanvas::LatestVersion))
+	{
+		Ar.SetError();
+		return Ar;
+	}
+
+	//Layers are serialized like a TArray, the tile format depends on the version.
+	int32 NumLayers = Canvas.Layers.Num();
+	Ar << NumLayers;
+
+	if (Ar.IsLoading())
+	{
+		if (NumLayers < 0)
+		{
+			Ar.SetError();
+			return Ar;
+		}
+
+		Canvas.Layers.Reset(NumLayers);
+		Canvas.Layers.SetNum(NumLayers);
+	}
+
+	for (FVolumetricCloudsLayer& Layer : Canvas.Layers)
+	{
+		VolumetricCloudsCanvas::SerializeLayer(Ar, Layer, Version);
+	}
+
+	Ar << Canvas.ActiveLayer;
+
+	if (Version >= VolumetricCloudsCanvas::StableLayerIds)
+	{
+		Ar << Canvas.NextLayerId;
+	}
+
+	if (Ar.IsLoading())
+	{
+		if (Canvas.Layers.Num() == 0)
+		{
+			Canvas.Reset();
+			return Ar;
+		}
+
+		//Older data has no ids, layers are numbered in stack order.
+		if (Version < VolumetricCloudsCanvas::StableLayerIds)
+		{
+			for (int32 LayerIndex = 0; LayerIndex < Canvas.Layers.Num(); LayerIndex++)
+			{
+				Canvas.Layers[LayerIndex].Id = LayerIndex;
+			}
+
+			Canvas.NextLayerId = Canvas.Layers.Num();
+		}
+
+		const FVolumetricCloudsTiledImage& BaseValues = Canvas.Layers[0].Values;
+
+		Canvas.ActiveLayer = FMath::Clamp(Canvas.ActiveLayer, 0, Canvas.Layers.Num() - 1);
+		Canvas.Composite.Init(BaseValues.GetSizeX(), BaseValues.GetSizeY());
+		Canvas.Composite.AllocateAllTiles();
+		Canvas.MarkAllDirty();
+	}
+
+	return Ar;
+}
@@ -0,0 +1,282 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsFilterBrush.h"
+#include "VolumetricCloudsCanvas.h"
+#include "Math/VectorRegister.h"
+#include "Async/ParallelFor.h"
+
+namespace VolumetricCloudsFilterBrush
+{
+	/** Largest blur kernel radius in texels, keeps the cost of a single stamp bounded. */
+	static const int32 MaxKernelRadius = 64;
+
+	/** Largest number of noise octaves. */
+	static const int32 MaxNoiseOctaves = 8;
+
+	/** Rows are filtered on a single thread below this number of texels. */
+	static const int32 MinParallelTexels = 4096;
+
+	/** 1D convolution, Out[Y * OutWidth + X] = Sum(Source[Y * SourceStride + X + Tap * TapStride] * Kernel[Tap]). */
+	void Convolve(const TArray<FLinearColor>& Source, TArray<FLinearColor>& Out, int32 OutWidth, int32 OutHeight, int32 SourceStride, int32 TapStride, const TArray<float>& Kernel)
+	{
+		Out.SetNumUninitialized(OutWidth * OutHeight);
+
+		const FLinearColor* RESTRICT SourceData = Source.GetData();
+		FLinearColor* RESTRICT OutData = Out.GetData();
+		const float* RESTRICT Weights = Kernel.GetData();
+		const int32 NumTaps = Kernel.Num();
+
+		ParallelFor(OutHeight, [=](int32 Y)
+		{
+			for (int32 X = 0; X < OutWidth; X++)
+			{
+				const FLinearColor* Taps = SourceData + Y * SourceStride + X;
+				VectorRegister Sum = VectorZero();
+
+				for (int32 Tap = 0; Tap < NumTaps; Tap++)
+				{
+					Sum = VectorMultiplyAdd(VectorLoad(Taps + Tap * TapStride), VectorLoadFloat1(&Weights[Tap]), Sum);
+				}
+
+				VectorStore(Sum, &OutData[Y * OutWidth + X]);
+			}
+		}, OutWidth * OutHeight < MinParallelTexels);
+	}
+
+	/** Integer hash of a lattice point mapped to 0-1. */
+	FORCEINLINE float HashLattice(int32 X, int32 Y, int32 Seed)
+	{
+		uint32 Hash = uint32(X) * 0x8da6b343u ^ uint32(Y) * 0xd8163841u ^ uint32(Seed) * 0xcb1ab31fu;
+		Hash ^= Hash >> 13;
+		Hash *= 0x5bd1e995u;
+		Hash ^= Hash >> 15;
+
+		return float(Hash & 0xffffff) / float(0xffffff);
+	}
+}
+
+void FVolumetricCloudsFilterBrush::Apply(FVolumetricCloudsCanvas& Canvas, const FVolumetricCloudsBrush& Brush, const FVector2D& UV, const FVector2D& PreviousUV)
+{
+	if (!Canvas.IsValid())
+	{
+		return;
+	}
+
+	switch (Brush.Tool)
+	{
+	case EVolumetricCloudsBrushTool::Blur:		ApplyBlur(Canvas, Brush, UV); break;
+	case EVolumetricCloudsBrushTool::Smudge:	ApplySmudge(Canvas, Brush, UV, PreviousUV); break;
+	case EVolumetricCloudsBrushTool::Noise:		ApplyNoise(Canvas, Brush, UV); break;
+	default: break;
+	}
+}
+
+const TArray<float>& FVolumetricCloudsFilterBrush::GetGaussianKernel(int32 KernelRadius)
+{
+	if (const TArray<float>* Kernel = GaussianKernels.Find(KernelRadius))
+	{
+		return *Kernel;
+	}
+
+	//Kernel covers 3 sigma on each side.
+	const float Sigma = FMath::Max(KernelRadius / 3.0f, 0.5f);
+	TArray<float>& Kernel = GaussianKernels.Add(KernelRadius);
+	Kernel.SetNumUninitialized(KernelRadius * 2 + 1);
+
+	float Sum = 0.0f;
+
+	for (int32 Tap = -KernelRadius; Tap <= KernelRadius; Tap++)
+	{
+		const float Weight = FMath::Exp(-(Tap * Tap) / (2.0f * Sigma * Sigma));
+		Kernel[Tap + KernelRadius] = Weight;
+		Sum += Weight;
+	}
+
+	for (float& Weight : Kernel)
+	{
+		Weight /= Sum;
+	}
+
+	return Kernel;
+}
+
+float FVolumetricCloudsFilterBrush::GetNoise(int32 X, int32 Y, int32 SizeX, int32 SizeY, int32 Frequency, int32 Octaves, int32 Seed)
+{
+	using namespace VolumetricCloudsFilterBrush;
+
+	float Sum = 0.0f;
+	float TotalAmplitude = 0.0f;
+	float Amplitude = 1.0f;
+	int32 Period = FMath::Max(Frequency, 1);
+
+	for (int32 Octave = 0; Octave < FMath::Clamp(Octaves, 1, MaxNoiseOctaves); Octave++)
+	{
+		//Lattice repeats every Period cells so the noise tiles with the weather map.
+		const float CellX = (X + 0.5f) / SizeX * Period;
+		const float CellY = (Y + 0.5f) / SizeY * Period;
+		const int32 X0 = FMath::FloorToInt(CellX);
+		const int32 Y0 = FMath::FloorToInt(CellY);
+		const float TX = FMath::SmoothStep(0.0f, 1.0f, CellX - X0);
+		const float TY = FMath::SmoothStep(0.0f, 1.0f, CellY - Y0);
+
+		const int32 LX0 = X0 % Period;
+		const int32 LY0 = Y0 % Period;
+		const int32 LX1 = (X0 + 1) % Period;
+		const int32 LY1 = (Y0 + 1) % Period;
+		const int32 OctaveSeed = Seed * MaxNoiseOctaves + Octave;
+
+		const float Top = FMath::Lerp(HashLattice(LX0, LY0, OctaveSeed), HashLattice(LX1, LY0, OctaveSeed), TX);
+		const float Bottom = FMath::Lerp(HashLattice(LX0, LY1, OctaveSeed), HashLattice(LX1, LY1, OctaveSeed), TX);
+
+		Sum += FMath::Lerp(Top, Bottom, TY) * Amplitude;
+		TotalAmplitude += Amplitude;
+		Amplitude *= 0.5f;
+		Period *= 2;
+	}
+
+	return Sum / TotalAmplitude;
+}
+
+void FVolumetricCloudsFilterBrush::Empty()
+{
+	GaussianKernels.Empty();
+	SourceValues.Empty();
+	SourceCoverage.Empty();
+	TempValues.Empty();
+	TempCoverage.Empty();
+	FilteredValues.Empty();
+	FilteredCoverage.Empty();
+}
+
+void FVolumetricCloudsFilterBrush::ApplyBlur(FVolumetricCloudsCanvas& Canvas, const FVolumetricCloudsBrush& Brush, const FVector2D& UV)
+{
+	using namespace VolumetricCloudsFilterBrush;
+
+	const FVector2D TexelRadius = Brush.GetTexelRadius(Canvas.GetSizeX(), Canvas.GetSizeY());
+	const float Sigma = FMath::Max(Brush.BlurSize * TexelRadius.GetMax(), 0.5f);
+	const int32 KernelRadius = FMath::Clamp(FMath::CeilToInt(Sigma * 3.0f), 1, MaxKernelRadius);
+	const TArray<float>& Kernel = GetGaussianKernel(KernelRadius);
+
+	const FIntRect Rect = Canvas.GetBrushRect(Brush, UV);
+	const FIntRect SourceRect(Rect.Min - FIntPoint(KernelRadius, KernelRadius), Rect.Max + FIntPoint(KernelRadius, KernelRadius));
+
+	if (Rect.Width() <= 0 || Rect.Height() <= 0)
+	{
+		return;
+	}
+
+	Canvas.ReadLayerRegion(SourceRect, SourceValues, SourceCoverage);
+
+	//Separable gaussian, horizontal pass keeps the vertical apron for the second pass.
+	Convolve(SourceValues, TempValues, Rect.Width(), SourceRect.Height(), SourceRect.Width(), 1, Kernel);
+	Convolve(SourceCoverage, TempCoverage, Rect.Width(), SourceRect.Height(), SourceRect.Width(), 1, Kernel);
+	Convolve(TempValues, FilteredValues, Rect.Width(), Rect.Height(), Rect.Width(), Rect.Width(), Kernel);
+	Convolve(TempCoverage, FilteredCoverage, Rect.Width(), Rect.Height(), Rect.Width(), Rect.Width(), Kernel);
+
+	Canvas.BlendBrushRegion(Brush, UV, Rect, FilteredValues, FilteredCoverage);
+}
+
+void FVolumetricCloudsFilterBrush::ApplySmudge(FVolumetricCloudsCanvas& Canvas, const FVolumetricCloudsBrush& Brush, const FVector2D& UV, const FVector2D& PreviousUV)
+{
+	using namespace VolumetricCloudsFilterBrush;
+
+	//Shortest stroke delta on the wrapped map, in texels and no longer than the brush radius.
+	FVector2D DeltaUV = UV - PreviousUV;
+	DeltaUV.X -= FMath::RoundToFloat(DeltaUV.X);
+	DeltaUV.Y -= FMath::RoundToFloat(DeltaUV.Y);
+
+	const FVector2D TexelRadius = Brush.GetTexelRadius(Canvas.GetSizeX(), Canvas.GetSizeY());
+	const FVector2D Delta = (DeltaUV * FVector2D(Canvas.GetSizeX(), Canvas.GetSizeY())).ClampAxes(-TexelRadius.GetMax(), TexelRadius.GetMax());
+
+	const FIntRect Rect = Canvas.GetBrushRect(Brush, UV);
+
+	if (Delta.SizeSquared() < KINDA_SMALL_NUMBER || Rect.Width() <= 0 || Rect.Height() <= 0)
+	{
+		return;
+	}
+
+	const FIntPoint Padding(FMath::CeilToInt(FMath::Abs(Delta.X)) + 1, FMath::CeilToInt(FMath::Abs(Delta.Y)) + 1);
+	const FIntRect SourceRect(Rect.Min - Padding, Rect.Max + Padding);
+
+	Canvas.ReadLayerRegion(SourceRect, SourceValues, SourceCoverage);
+
+	const int32 Width = Rect.Width();
+	const int32 Height = Rect.Height();
+	const int32 SourceWidth = SourceRect.Width();
+	const int32 SourceHeight = SourceRect.Height();
+
+	FilteredValues.SetNumUninitialized(Width * Height);
+	FilteredCoverage.SetNumUninitialized(Width * Height);
+
+	//Every texel pulls the layer from where the brush was on the previous stamp.
+	for (int32 Y = 0; Y < Height; Y++)
+	{
+		const float SampleY = Y + Padding.Y - Delta.Y;
+		const int32 Y0 = FMath::Clamp(FMath::FloorToInt(SampleY), 0, SourceHeight - 2);
+		const VectorRegister FracY = VectorSetFloat1(FMath::Clamp(SampleY - Y0, 0.0f, 1.0f));
+
+		for (int32 X = 0; X < Width; X++)
+		{
+			const float SampleX = X + Padding.X - Delta.X;
+			const int32 X0 = FMath::Clamp(FMath::FloorToInt(SampleX), 0, SourceWidth - 2);
+			const VectorRegister FracX = VectorSetFloat1(FMath::Clamp(SampleX - X0, 0.0f, 1.0f));
+			const int32 Index00 = Y0 * SourceWidth + X0;
+			const int32 Index01 = Index00 + SourceWidth;
+
+			auto Bilinear = [&](const TArray<FLinearColor>& Source)
+			{
+				const VectorRegister V00 = VectorLoad(&Source[Index00]);
+				const VectorRegister V10 = VectorLoad(&Source[Index00 + 1]);
+				const VectorRegister V01 = VectorLoad(&Source[Index01]);
+				const VectorRegister V11 = VectorLoad(&Source[Index01 + 1]);
+				const VectorRegister Top = VectorMultiplyAdd(VectorSubtract(V10, V00), FracX, V00);
+				const VectorRegister Bottom = VectorMultiplyAdd(VectorSubtract(V11, V01), FracX, V01);
+
+				return VectorMultiplyAdd(VectorSubtract(Bottom, Top), FracY, Top);
+			};
+
+			VectorStore(Bilinear(SourceValues), &FilteredValues[Y * Width + X]);
+			VectorStore(Bilinear(SourceCoverage), &FilteredCoverage[Y * Width + X]);
+		}
+	}
+
+	Canvas.BlendBrushRegion(Brush, UV, Rect, FilteredValues, FilteredCoverage);
+}
+
+void FVolumetricCloudsFilterBrush::ApplyNoise(FVolumetricCloudsCanvas& Canvas, const FVolumetricCloudsBrush& Brush, const FVector2D& UV)
+{
+	using namespace VolumetricCloudsFilterBrush;
+
+	const FIntRect Rect = Canvas.GetBrushRect(Brush, UV);
+
+	if (Rect.Width() <= 0 || Rect.Height() <= 0)
+	{
+		return;
+	}
+
+	const int32 Width = Rect.Width();
+	const int32 Height = Rect.Height();
+	const int32 SizeX = Canvas.GetSizeX();
+	const int32 SizeY = Canvas.GetSizeY();
+	const VectorRegister Color = VectorLoad(&Brush.Color);
+
+	FilteredValues.SetNumUninitialized(Width * Height);
+	FilteredCoverage.Init(FLinearColor(1.0f, 1.0f, 1.0f, 1.0f), Width * Height);
+
+	FLinearColor* RESTRICT Values = FilteredValues.GetData();
+
+	ParallelFor(Height, [=, &Brush](int32 Y)
+	{
+		const int32 WrappedY = ((Rect.Min.Y + Y) % SizeY + SizeY) % SizeY;
+
+		for (int32 X = 0; X < Width; X++)
+		{
+			const int32 WrappedX = ((Rect.Min.X + X) % SizeX + SizeX) % SizeX;
+			const float Noise = GetNoise(WrappedX, WrappedY, SizeX, SizeY, Brush.NoiseFrequency, Brush.NoiseOctaves, Brush.NoiseSeed);
+
+			VectorStore(VectorMultiply(Color, VectorSetFloat1(Noise)), &Values[Y * Width + X]);
+		}
+	}, Width * Height < MinParallelTexels);
+
+	Canvas.BlendBrushRegion(Brush, UV, Rect, FilteredValues, FilteredCoverage);
+}
@@ -0,0 +1,108 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsMapOperation.h"
+#include "Math/VectorRegister.h"
+
+const TCHAR* GetVolumetricCloudsMapOperationName(EVolumetricCloudsMapOperation Operation)
+{
+	switch (Operation)
+	{
+	case EVolumetricCloudsMapOperation::Levels:		return TEXT("Levels");
+	case EVolumetricCloudsMapOperation::Swizzle:	return TEXT("Swizzle");
+	case EVolumetricCloudsMapOperation::Invert:		return TEXT("Invert");
+	case EVolumetricCloudsMapOperation::Fill:		return TEXT("Fill");
+	case EVolumetricCloudsMapOperation::Threshold:	return TEXT("Threshold");
+	default:										return TEXT("Unknown");
+	}
+}
+
+void FVolumetricCloudsMapOperation::Apply(FLinearColor* Texels, int32 NumTexels, const FLinearColor& ChannelMask) const
+{
+	const VectorRegister Mask = VectorLoad(&ChannelMask);
+
+	switch (Type)
+	{
+	case EVolumetricCloudsMapOperation::Levels:
+	{
+		FLinearColor InvInRange, InvGamma;
+
+		for (int32 Channel = 0; Channel < 4; Channel++)
+		{
+			(&InvInRange.R)[Channel] = 1.0f / FMath::Max((&InWhite.R)[Channel] - (&InBlack.R)[Channel], KINDA_SMALL_NUMBER);
+			(&InvGamma.R)[Channel] = 1.0f / FMath::Max((&Gamma.R)[Channel], KINDA_SMALL_NUMBER);
+		}
+
+		const VectorRegister Black = VectorLoad(&InBlack);
+		const VectorRegister Scale = VectorLoad(&InvInRange);
+		const VectorRegister Exponent = VectorLoad(&InvGamma);
+		const VectorRegister Output = VectorLoad(&OutBlack);
+		const VectorRegister OutputRange = VectorSubtract(VectorLoad(&OutWhite), Output);
+
+		for (int32 Index = 0; Index < NumTexels; Index++)
+		{
+			const VectorRegister Value = VectorLoad(&Texels[Index]);
+			const VectorRegister Normalized = VectorMin(VectorMax(VectorMultiply(VectorSubtract(Value, Black), Scale), VectorZero()), VectorOne());
+			const VectorRegister Result = VectorMultiplyAdd(VectorPow(Normalized, Exponent), OutputRange, Output);
+
+			VectorStore(VectorMultiplyAdd(VectorSubtract(Result, Value), Mask, Value), &Texels[Index]);
+		}
+		break;
+	}
+	case EVolumetricCloudsMapOperation::Swizzle:
+	{
+		int32 Source[4];
+
+		for (int32 Channel = 0; Channel < 4; Channel++)
+		{
+			Source[Channel] = FMath::Clamp(Swizzle[Channel], 0, 3);
+		}
+
+		for (int32 Index = 0; Index < NumTexels; Index++)
+		{
+			const FLinearColor Value = Texels[Index];
+			const FLinearColor Result((&Value.R)[Source[0]], (&Value.R)[Source[1]], (&Value.R)[Source[2]], (&Value.R)[Source[3]]);
+			const VectorRegister Old = VectorLoad(&Value);
+
+			VectorStore(VectorMultiplyAdd(VectorSubtract(VectorLoad(&Result), Old), Mask, Old), &Texels[Index]);
+		}
+		break;
+	}
+	case EVolumetricCloudsMapOperation::Invert:
+	{
+		for (int32 Index = 0; Index < NumTexels; Index++)
+		{
+			const VectorRegister Value = VectorLoad(&Texels[Index]);
+			const VectorRegister Result = VectorSubtract(VectorOne(), Value);
+
+			VectorStore(VectorMultiplyAdd(VectorSubtract(Result, Value), Mask, Value), &Texels[Index]);
+		}
+		break;
+	}
+	case EVolumetricCloudsMapOperation::Fill:
+	{
+		const VectorRegister Result = VectorLoad(&FillValue);
+
+		for (int32 Index = 0; Index < NumTexels; Index++)
+		{
+			const VectorRegister Value = VectorLoad(&Texels[Index]);
+			VectorStore(VectorMultiplyAdd(VectorSubtract(Result, Value), Mask, Value), &Texels[Index]);
+		}
+		break;
+	}
+	case EVolumetricCloudsMapOperation::Threshold:
+	{
+		const VectorRegister Limit = VectorLoad(&Threshold);
+
+		for (int32 Index = 0; Index < NumTexels; Index++)
+		{
+			const VectorRegister Value = VectorLoad(&Texels[Index]);
+			const VectorRegister Result = VectorSelect(VectorCompareGE(Value, Limit), VectorOne(), VectorZero());
+
+			VectorStore(VectorMultiplyAdd(VectorSubtract(Result, Value), Mask, Value), &Texels[Index]);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
@@ -0,0 +1,62 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsMemory.h"
+#include "Stats/Stats.h"
+
+const TCHAR* GetVolumetricCloudsMemorySystemName(EVolumetricCloudsMemorySystem System)
+{
+	switch (System)
+	{
+	case EVolumetricCloudsMemorySystem::PainterRenderTarget:
+		return TEXT("PainterRenderTarget");
+	case EVolumetricCloudsMemorySystem::PainterCanvas:
+		return TEXT("PainterCanvas");
+	case EVolumetricCloudsMemorySystem::PainterFinalTexture:
+		return TEXT("PainterFinalTexture");
+	case EVolumetricCloudsMemorySystem::WeatherMap:
+		return TEXT("WeatherMap");
+	case EVolumetricCloudsMemorySystem::CloudAssets:
+		return TEXT("CloudAssets");
+	case EVolumetricCloudsMemorySystem::Sky:
+		return TEXT("Sky");
+	case EVolumetricCloudsMemorySystem::WeatherEffects:
+		return TEXT("WeatherEffects");
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+
+DECLARE_LLM_MEMORY_STAT(TEXT("PainterRenderTarget"), STAT_PainterRenderTargetLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("PainterCanvas"), STAT_PainterCanvasLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("PainterFinalTexture"), STAT_PainterFinalTextureLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("WeatherMap"), STAT_WeatherMapLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("CloudAssets"), STAT_CloudAssetsLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Sky"), STAT_SkyLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("WeatherEffects"), STAT_WeatherEffectsLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Environment"), STAT_EnvironmentSummaryLLM, STATGROUP_LLM);
+
+void RegisterVolumetricCloudsLLMTags()
+{
+	const FName StatNames[] =
+	{
+		GET_STATFNAME(STAT_PainterRenderTargetLLM),
+		GET_STATFNAME(STAT_PainterCanvasLLM),
+		GET_STATFNAME(STAT_PainterFinalTextureLLM),
+		GET_STATFNAME(STAT_WeatherMapLLM),
+		GET_STATFNAME(STAT_CloudAssetsLLM),
+		GET_STATFNAME(STAT_SkyLLM),
+		GET_STATFNAME(STAT_WeatherEffectsLLM),
+	};
+
+	static_assert(ARRAY_COUNT(StatNames) == (int32)EVolumetricCloudsMemorySystem::Count, "Every memory system needs an LLM stat.");
+
+	for (int32 System = 0; System < (int32)EVolumetricCloudsMemorySystem::Count; System++)
+	{
+		FLowLevelMemTracker::Get().RegisterProjectTag((int32)GetVolumetricCloudsLLMTag((EVolumetricCloudsMemorySystem)System),
+			GetVolumetricCloudsMemorySystemName((EVolumetricCloudsMemorySystem)System), StatNames[System], GET_STATFNAME(STAT_EnvironmentSummaryLLM));
+	}
+}
+
+#endif
@@ -0,0 +1,384 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsNoiseVolume.h"
+#include "Math/VectorRegister.h"
+#include "Async/ParallelFor.h"
+
+namespace VolumetricCloudsNoiseVolume
+{
+	/** Number of texels evaluated together, one per vector lane. */
+	static const int32 NumLanes = 4;
+
+	/** Perlin gradients, the 12 cube edge directions. */
+	static const float Gradients[12][3] =
+	{
+		{ 1.0f, 1.0f, 0.0f }, { -1.0f, 1.0f, 0.0f }, { 1.0f, -1.0f, 0.0f }, { -1.0f, -1.0f, 0.0f },
+		{ 1.0f, 0.0f, 1.0f }, { -1.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, -1.0f }, { -1.0f, 0.0f, -1.0f },
+		{ 0.0f, 1.0f, 1.0f }, { 0.0f, -1.0f, 1.0f }, { 0.0f, 1.0f, -1.0f }, { 0.0f, -1.0f, -1.0f }
+	};
+
+	/** Integer hash of a lattice point. Salt separates lattices of different channels and octaves. */
+	FORCEINLINE uint32 HashLattice(int32 X, int32 Y, int32 Z, int32 Seed, uint32 Salt)
+	{
+		uint32 Hash = uint32(X) * 0x8da6b343u ^ uint32(Y) * 0xd8163841u ^ uint32(Z) * 0xcb1ab31fu ^ (uint32(Seed) + Salt * 0x9e3779b9u) * 0x165667b1u;
+		Hash ^= Hash >> 13;
+		Hash *= 0x5bd1e995u;
+		Hash ^= Hash >> 15;
+
+		return Hash;
+	}
+
+	FORCEINLINE float HashToFloat(uint32 Hash)
+	{
+		return float(Hash & 0xffffff) / float(0xffffff);
+	}
+
+	/** Cyclic lattice of one octave, a single point per cell stored as separate X, Y and Z arrays. */
+	struct FLattice
+	{
+		int32 Frequency = 0;
+		TArray<float> PointX;
+		TArray<float> PointY;
+		TArray<float> PointZ;
+
+		/** Setup random Worley feature points, 0-1 inside of a cell. */
+		void InitFeaturePoints(int32 InFrequency, int32 Seed, uint32 Salt)
+		{
+			Init(InFrequency);
+
+			for (int32 Index = 0; Index < PointX.Num(); Index++)
+			{
+				const int32 X = Index % Frequency;
+				const int32 Y = (Index / Frequency) % Frequency;
+				const int32 Z = Index / (Frequency * Frequency);
+
+				PointX[Index] = HashToFloat(HashLattice(X, Y, Z, Seed, Salt));
+				PointY[Index] = HashToFloat(HashLattice(X, Y, Z, Seed, Salt + 1));
+				PointZ[Index] = HashToFloat(HashLattice(X, Y, Z, Seed, Salt + 2));
+			}
+		}
+
+		/** Setup random Perlin gradients. */
+		void InitGradients(int32 InFrequency, int32 Seed, uint32 Salt)
+		{
+			Init(InFrequency);
+
+			for (int32 Index = 0; Index < PointX.Num(); Index++)
+			{
+				const int32 X = Index % Frequency;
+				const int32 Y = (Index / Frequency) % Frequency;
+				const int32 Z = Index / (Frequency * Frequency);
+				const float* Gradient = Gradients[HashLattice(X, Y, Z, Seed, Salt) % 12];
+
+				PointX[Index] = Gradient[0];
+				PointY[Index] = Gradient[1];
+				PointZ[Index] = Gradient[2];
+			}
+		}
+
+		FORCEINLINE int32 GetIndex(int32 CellX, int32 CellY, int32 CellZ) const
+		{
+			return (CellZ * Frequency + CellY) * Frequency + CellX;
+		}
+
+		FORCEINLINE int32 Wrap(int32 Cell) const
+		{
+			return (Cell + Frequency) % Frequency;
+		}
+
+	private:
+		void Init(int32 InFrequency)
+		{
+			Frequency = InFrequency;
+
+			const int32 NumCells = Frequency * Frequency * Frequency;
+			PointX.SetNumUninitialized(NumCells);
+			PointY.SetNumUninitialized(NumCells);
+			PointZ.SetNumUninitialized(NumCells);
+		}
+	};
+
+	/** NumLanes consecutive texels of a row in lattice cell units. Y and Z are shared by all lanes. */
+	struct FLanes
+	{
+		int32 CellX[NumLanes];
+		VectorRegister FracX;
+		int32 CellY;
+		int32 CellZ;
+		float FracY;
+		float FracZ;
+
+		FLanes(const FLattice& Lattice, int32 X, int32 Y, int32 Z, int32 Size)
+		{
+			const float Scale = float(Lattice.Frequency) / Size;
+			float Frac[NumLanes];
+
+			//Lanes past the end of a row wrap around, their results are discarded.
+			for (int32 Lane = 0; Lane < NumLanes; Lane++)
+			{
+				const float Position = (X + Lane + 0.5f) * Scale;
+				const int32 Cell = FMath::FloorToInt(Position);
+
+				CellX[Lane] = Cell % Lattice.Frequency;
+				Frac[Lane] = Position - Cell;
+			}
+
+			FracX = MakeVectorRegister(Frac[0], Frac[1], Frac[2], Frac[3]);
+
+			const float PositionY = (Y + 0.5f) * Scale;
+			const float PositionZ = (Z + 0.5f) * Scale;
+			CellY = FMath::FloorToInt(PositionY);
+			CellZ = FMath::FloorToInt(PositionZ);
+			FracY = PositionY - CellY;
+			FracZ = PositionZ - CellZ;
+		}
+	};
+
+	/** Inverted distance to the closest feature point in 0-1 range. */
+	VectorRegister Worley(const FLattice& Lattice, const FLanes& Lanes)
+	{
+		VectorRegister MinDistanceSquared = VectorSetFloat1(MAX_flt);
+
+		for (int32 OffsetZ = -1; OffsetZ <= 1; OffsetZ++)
+		{
+			const int32 CellZ = Lattice.Wrap(Lanes.CellZ + OffsetZ);
+			const VectorRegister BaseZ = VectorSetFloat1(OffsetZ - Lanes.FracZ);
+
+			for (int32 OffsetY = -1; OffsetY <= 1; OffsetY++)
+			{
+				const int32 CellY = Lattice.Wrap(Lanes.CellY + OffsetY);
+				const VectorRegister BaseY = VectorSetFloat1(OffsetY - Lanes.FracY);
+
+				for (int32 OffsetX = -1; OffsetX <= 1; OffsetX++)
+				{
+					const VectorRegister BaseX = VectorSubtract(VectorSetFloat1(float(OffsetX)), Lanes.FracX);
+					int32 Index[NumLanes];
+
+					for (int32 Lane = 0; Lane < NumLanes; Lane++)
+					{
+						Index[Lane] = Lattice.GetIndex(Lattice.Wrap(Lanes.CellX[Lane] + OffsetX), CellY, CellZ);
+					}
+
+					const VectorRegister DeltaX = VectorAdd(BaseX, MakeVectorRegister(Lattice.PointX[Index[0]], Lattice.PointX[Index[1]], Lattice.PointX[Index[2]], Lattice.PointX[Index[3]]));
+					const VectorRegister DeltaY = VectorAdd(BaseY, MakeVectorRegister(Lattice.PointY[Index[0]], Lattice.PointY[Index[1]], Lattice.PointY[Index[2]], Lattice.PointY[Index[3]]));
+					const VectorRegister DeltaZ = VectorAdd(BaseZ, MakeVectorRegister(Lattice.PointZ[Index[0]], Lattice.PointZ[Index[1]], Lattice.PointZ[Index[2]], Lattice.PointZ[Index[3]]));
+
+					MinDistanceSquared = VectorMin(MinDistanceSquared, VectorMultiplyAdd(DeltaX, DeltaX, VectorMultiplyAdd(DeltaY, DeltaY, VectorMultiply(DeltaZ, DeltaZ))));
+				}
+			}
+		}
+
+		//Vector reciprocal square root differs between CPUs, scalar square root keeps bakes byte identical.
+		float DistanceSquared[NumLanes];
+		VectorStore(MinDistanceSquared, DistanceSquared);
+
+		return MakeVectorRegister(
+			1.0f - FMath::Min(FMath::Sqrt(DistanceSquared[0]), 1.0f),
+			1.0f - FMath::Min(FMath::Sqrt(DistanceSquared[1]), 1.0f),
+			1.0f - FMath::Min(FMath::Sqrt(DistanceSquared[2]), 1.0f),
+			1.0f - FMath::Min(FMath::Sqrt(DistanceSquared[3]), 1.0f));
+	}
+
+	/** Quintic interpolation curve of Perlin noise. */
+	FORCEINLINE VectorRegister Fade(const VectorRegister& T)
+	{
+		const VectorRegister Curve = VectorMultiplyAdd(T, VectorMultiplyAdd(T, VectorSetFloat1(6.0f), VectorSetFloat1(-15.0f)), VectorSetFloat1(10.0f));
+		return VectorMultiply(VectorMultiply(VectorMultiply(T, T), T), Curve);
+	}
+
+	FORCEINLINE VectorRegister Lerp(const VectorRegister& A, const VectorRegister& B, const VectorRegister& Alpha)
+	{
+		return VectorMultiplyAdd(VectorSubtract(B, A), Alpha, A);
+	}
+
+	/** Gradient noise in 0-1 range. */
+	VectorRegister Perlin(const FLattice& Lattice, const FLanes& Lanes)
+	{
+		VectorRegister Corners[8];
+
+		for (int32 Corner = 0; Corner < 8; Corner++)
+		{
+			const int32 OffsetX = Corner & 1;
+			const int32 OffsetY = (Corner >> 1) & 1;
+			const int32 OffsetZ = (Corner >> 2) & 1;
+			const int32 CellY = Lattice.Wrap(Lanes.CellY + OffsetY);
+			const int32 CellZ = Lattice.Wrap(Lanes.CellZ + OffsetZ);
+			int32 Index[NumLanes];
+
+			for (int32 Lane = 0; Lane < NumLanes; Lane++)
+			{
+				Index[Lane] = Lattice.GetIndex(Lattice.Wrap(Lanes.CellX[Lane] + OffsetX), CellY, CellZ);
+			}
+
+			const VectorRegister GradientX = MakeVectorRegister(Lattice.PointX[Index[0]], Lattice.PointX[Index[1]], Lattice.PointX[Index[2]], Lattice.PointX[Index[3]]);
+			const VectorRegister GradientY = MakeVectorRegister(Lattice.PointY[Index[0]], Lattice.PointY[Index[1]], Lattice.PointY[Index[2]], Lattice.PointY[Index[3]]);
+			const VectorRegister GradientZ = MakeVectorRegister(Lattice.PointZ[Index[0]], Lattice.PointZ[Index[1]], Lattice.PointZ[Index[2]], Lattice.PointZ[Index[3]]);
+
+			const VectorRegister DeltaX = VectorSubtract(Lanes.FracX, VectorSetFloat1(float(OffsetX)));
+			const VectorRegister DeltaY = VectorSetFloat1(Lanes.FracY - OffsetY);
+			const VectorRegister DeltaZ = VectorSetFloat1(Lanes.FracZ - OffsetZ);
+
+			Corners[Corner] = VectorMultiplyAdd(GradientX, DeltaX, VectorMultiplyAdd(GradientY, DeltaY, VectorMultiply(GradientZ, DeltaZ)));
+		}
+
+		const VectorRegister U = Fade(Lanes.FracX);
+		const VectorRegister V = Fade(VectorSetFloat1(Lanes.FracY));
+		const VectorRegister W = Fade(VectorSetFloat1(Lanes.FracZ));
+
+		const VectorRegister Noise = Lerp(
+			Lerp(Lerp(Corners[0], Corners[1], U), Lerp(Corners[2], Corners[3], U), V),
+			Lerp(Lerp(Corners[4], Corners[5], U), Lerp(Corners[6], Corners[7], U), V),
+			W);
+
+		return VectorMin(VectorMax(VectorMultiplyAdd(Noise, VectorSetFloat1(0.5f), VectorSetFloat1(0.5f)), VectorZero()), VectorOne());
+	}
+
+	/** Octave lattices of a channel with their normalized amplitudes. */
+	struct FChannelOctaves
+	{
+		TArray<FLattice> PerlinLattices;
+		TArray<FLattice> WorleyLattices;
+		TArray<float> Amplitudes;
+
+		void Init(const FVolumetricCloudsNoiseChannel& Channel, int32 ChannelIndex, int32 Seed, int32 Size)
+		{
+			const bool bPerlin = Channel.Type == EVolumetricCloudsNoiseType::Perlin || Channel.Type == EVolumetricCloudsNoiseType::PerlinWorley;
+			const bool bWorley = Channel.Type == EVolumetricCloudsNoiseType::Worley || Channel.Type == EVolumetricCloudsNoiseType::PerlinWorley;
+
+			float Amplitude = 1.0f;
+			float AmplitudeSum = 0.0f;
+
+			for (int32 Octave = 0; Octave < Channel.Octaves; Octave++)
+			{
+				const int32 Frequency = FMath::Max(Channel.Frequency, 1) << Octave;
+
+				//Cells smaller than a texel only add aliasing.
+				if (Frequency > FVolumetricCloudsNoiseVolume::MaxFrequency || Frequency > Size)
+				{
+					break;
+				}
+
+				const uint32 Salt = uint32(ChannelIndex * 64 + Octave * 4);
+
+				if (bPerlin)
+				{
+					PerlinLattices.AddDefaulted_GetRef().InitGradients(Frequency, Seed, Salt);
+				}
+
+				if (bWorley)
+				{
+					WorleyLattices.AddDefaulted_GetRef().InitFeaturePoints(Frequency, Seed, Salt + 1);
+				}
+
+				Amplitudes.Add(Amplitude);
+				AmplitudeSum += Amplitude;
+				Amplitude *= Channel.Persistence;
+			}
+
+			for (float& OctaveAmplitude : Amplitudes)
+			{
+				OctaveAmplitude /= AmplitudeSum;
+			}
+		}
+
+		/** Fractal sum of all octaves. */
+		VectorRegister Evaluate(EVolumetricCloudsNoiseType Type, int32 X, int32 Y, int32 Z, int32 Size) const
+		{
+			VectorRegister PerlinSum = VectorZero();
+			VectorRegister WorleySum = VectorZero();
+
+			for (int32 Octave = 0; Octave < Amplitudes.Num(); Octave++)
+			{
+				const VectorRegister Amplitude = VectorSetFloat1(Amplitudes[Octave]);
+
+				if (PerlinLattices.Num() > 0)
+				{
+					PerlinSum = VectorMultiplyAdd(Perlin(PerlinLattices[Octave], FLanes(PerlinLattices[Octave], X, Y, Z, Size)), Amplitude, PerlinSum);
+				}
+
+				if (WorleyLattices.Num() > 0)
+				{
+					WorleySum = VectorMultiplyAdd(Worley(WorleyLattices[Octave], FLanes(WorleyLattices[Octave], X, Y, Z, Size)), Amplitude, WorleySum);
+				}
+			}
+
+			switch (Type)
+			{
+			case EVolumetricCloudsNoiseType::Perlin:		return PerlinSum;
+			case EVolumetricCloudsNoiseType::Worley:		return WorleySum;
+			//Perlin noise remapped from 0-1 to Worley-1, Worley cells give the Perlin noise billowy edges.
+			case EVolumetricCloudsNoiseType::PerlinWorley:	return VectorMultiplyAdd(PerlinSum, VectorSubtract(VectorOne(), WorleySum), WorleySum);
+			default:										return VectorZero();
+			}
+		}
+	};
+}
+
+const TCHAR* GetVolumetricCloudsNoiseTypeName(EVolumetricCloudsNoiseType Type)
+{
+	switch (Type)
+	{
+	case EVolumetricCloudsNoiseType::Perlin:		return TEXT("Perlin");
+	case EVolumetricCloudsNoiseType::Worley:		return TEXT("Worley");
+	case EVolumetricCloudsNoiseType::PerlinWorley:	return TEXT("PerlinWorley");
+	default:										return TEXT("Unknown");
+	}
+}
+
+FVolumetricCloudsNoiseVolumeSettings::FVolumetricCloudsNoiseVolumeSettings()
+{
+	Channels[0].Type = EVolumetricCloudsNoiseType::PerlinWorley;
+	Channels[0].Frequency = 4;
+	Channels[0].Octaves = 4;
+
+	for (int32 Channel = 1; Channel < 4; Channel++)
+	{
+		Channels[Channel].Type = EVolumetricCloudsNoiseType::Worley;
+		Channels[Channel].Frequency = 4 << Channel;
+		Channels[Channel].Octaves = 3;
+	}
+}
+
+void FVolumetricCloudsNoiseVolume::Generate(const FVolumetricCloudsNoiseVolumeSettings& Settings, TArray<FColor>& OutTexels)
+{
+	using namespace VolumetricCloudsNoiseVolume;
+
+	const int32 Size = FMath::Max(Settings.Size, 1);
+
+	FChannelOctaves Channels[4];
+
+	for (int32 Channel = 0; Channel < 4; Channel++)
+	{
+		Channels[Channel].Init(Settings.Channels[Channel], Channel, Settings.Seed, Size);
+	}
+
+	OutTexels.SetNumUninitialized(Size * Size * Size);
+
+	//Every slice is written by a single task, the result doesn't depend on scheduling.
+	ParallelFor(Size, [&](int32 Z)
+	{
+		FColor* Slice = OutTexels.GetData() + Z * Size * Size;
+
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			for (int32 X = 0; X < Size; X += NumLanes)
+			{
+				float Values[4][NumLanes];
+
+				for (int32 Channel = 0; Channel < 4; Channel++)
+				{
+					VectorStore(Channels[Channel].Evaluate(Settings.Channels[Channel].Type, X, Y, Z, Size), Values[Channel]);
+				}
+
+				for (int32 Lane = 0; Lane < NumLanes && X + Lane < Size; Lane++)
+				{
+					Slice[Y * Size + X + Lane] = FColor(
+						uint8(FMath::RoundToInt(FMath::Clamp(Values[0][Lane], 0.0f, 1.0f) * 255.0f)),
+						uint8(FMath::RoundToInt(FMath::Clamp(Values[1][Lane], 0.0f, 1.0f) * 255.0f)),
+						uint8(FMath::RoundToInt(FMath::Clamp(Values[2][Lane], 0.0f, 1.0f) * 255.0f)),
+						uint8(FMath::RoundToInt(FMath::Clamp(Values[3][Lane], 0.0f, 1.0f) * 255.0f)));
+				}
+			}
+		}
+	});
+}
@@ -0,0 +1,16 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+#include "VolumetricCloudsMemory.h"
+
+class FVolumetricCloudsPainterCoreModule : public IModuleInterface
+{
+public:
+	virtual void StartupModule() override
+	{
+		LLM(RegisterVolumetricCloudsLLMTags());
+	}
+};
+
+IMPLEMENT_MODULE(FVolumetricCloudsPainterCoreModule, VolumetricCloudsPainterCore)
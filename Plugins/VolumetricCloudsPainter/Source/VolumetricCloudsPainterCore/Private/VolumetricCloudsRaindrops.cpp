@@ -0,0 +1,374 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsRaindrops.h"
+#include "Async/ParallelFor.h"
+
+namespace VolumetricCloudsRaindrops
+{
+	/** Droplets below this fraction of MinRadius are evaporated. */
+	static const float MinRadiusScale = 0.25f;
+
+	/** Sliding droplets stop once they shrink below this fraction of SlideRadius. */
+	static const float StopRadiusScale = 0.5f;
+
+	/** Trail point radius relative to the sliding droplet. */
+	static const float TrailRadiusScale = 0.6f;
+
+	/** Radius of droplets left behind relative to the sliding droplet. */
+	static const float ResidueRadiusScale = 0.3f;
+
+	/** Largest number of merge grid cells per side. */
+	static const int32 MaxMergeCells = 256;
+
+	FORCEINLINE float GetVolume(float Radius)
+	{
+		return Radius * Radius * Radius;
+	}
+
+	FORCEINLINE float GetRadius(float Volume)
+	{
+		return FMath::Pow(FMath::Max(Volume, 0.0f), 1.0f / 3.0f);
+	}
+
+	FORCEINLINE FVector2D Wrap(const FVector2D& Position)
+	{
+		return FVector2D(FMath::Frac(Position.X), FMath::Frac(Position.Y));
+	}
+}
+
+int32 FVolumetricCloudsRaindrops::GetNumFramesX(int32 NumFrames)
+{
+	return FMath::RoundUpToPowerOfTwo(FMath::CeilToInt(FMath::Sqrt(float(FMath::Max(NumFrames, 1)))));
+}
+
+void FVolumetricCloudsRaindrops::Bake(const FVolumetricCloudsRaindropSettings& Settings, TArray<FColor>& OutNormals, TArray<FColor>& OutMasks, FIntPoint& OutSize)
+{
+	const int32 Size = FMath::Max(Settings.Size, 1);
+	const int32 NumFrames = FMath::Max(Settings.NumFrames, 1);
+	const int32 NumFramesX = GetNumFramesX(NumFrames);
+	const int32 NumFramesY = FMath::DivideAndRoundUp(NumFrames, NumFramesX);
+
+	FVolumetricCloudsRaindrops Simulation(Settings);
+
+	for (int32 Step = 0; Step < Settings.WarmupSteps; Step++)
+	{
+		Simulation.Step();
+	}
+
+	//Simulation is sequential, only droplet snapshots are kept so frames can be rasterized in parallel.
+	TArray<TArray<FVolumetricCloudsRaindrop>> FrameDroplets;
+	TArray<TArray<FVolumetricCloudsRaindrop>> FrameTrails;
+	FrameDroplets.SetNum(NumFrames);
+	FrameTrails.SetNum(NumFrames);
+
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		for (int32 Step = 0; Step < FMath::Max(Settings.StepsPerFrame, 1); Step++)
+		{
+			Simulation.Step();
+		}
+
+		FrameDroplets[Frame] = Simulation.GetDroplets();
+		FrameTrails[Frame] = Simulation.GetTrails();
+	}
+
+	OutSize = FIntPoint(NumFramesX * Size, NumFramesY * Size);
+	OutNormals.Init(FColor(128, 128, 255, 255), OutSize.X * OutSize.Y);
+	OutMasks.Init(FColor(0, 0, 0, 255), OutSize.X * OutSize.Y);
+
+	ParallelFor(NumFrames, [&](int32 Frame)
+	{
+		const int32 FrameOffset = (Frame / NumFramesX) * Size * OutSize.X + (Frame % NumFramesX) * Size;
+		TArray<float> Scratch;
+
+		Simulation.Rasterize(FrameDroplets[Frame], FrameTrails[Frame], Scratch, OutNormals.GetData() + FrameOffset, OutMasks.GetData() + FrameOffset, OutSize.X);
+	});
+}
+
+FVolumetricCloudsRaindrops::FVolumetricCloudsRaindrops(const FVolumetricCloudsRaindropSettings& InSettings)
+	: Settings(InSettings)
+	, Random(InSettings.Seed)
+{
+}
+
+void FVolumetricCloudsRaindrops::Step()
+{
+	using namespace VolumetricCloudsRaindrops;
+
+	//Fractional spawn rate is a chance of one more droplet.
+	int32 NumSpawned = FMath::FloorToInt(Settings.SpawnRate);
+
+	if (Random.FRand() < Settings.SpawnRate - NumSpawned)
+	{
+		NumSpawned++;
+	}
+
+	for (int32 Index = 0; Index < NumSpawned; Index++)
+	{
+		FVolumetricCloudsRaindrop Droplet;
+		Droplet.Position = FVector2D(Random.FRand(), Random.FRand());
+		Droplet.Radius = Random.FRandRange(Settings.MinRadius, Settings.MaxRadius);
+		Droplet.Speed = 0.0f;
+		Droplets.Add(Droplet);
+	}
+
+	for (int32 Index = Trails.Num() - 1; Index >= 0; Index--)
+	{
+		Trails[Index].Speed += 1.0f;
+
+		if (Trails[Index].Speed >= Settings.TrailLifetime)
+		{
+			Trails.RemoveAt(Index, 1, false);
+		}
+	}
+
+	const float StopRadius = Settings.SlideRadius * StopRadiusScale;
+	TArray<FVolumetricCloudsRaindrop> Residue;
+
+	for (FVolumetricCloudsRaindrop& Droplet : Droplets)
+	{
+		Droplet.Radius -= Settings.Evaporation;
+
+		const bool bSliding = Droplet.Radius >= Settings.SlideRadius || (Droplet.Speed > 0.0f && Droplet.Radius >= StopRadius);
+
+		if (!bSliding)
+		{
+			Droplet.Speed = 0.0f;
+			continue;
+		}
+
+		//Heavier droplets accelerate faster.
+		Droplet.Speed += Settings.Gravity * Droplet.Radius / Settings.SlideRadius;
+
+		const FVector2D Start = Droplet.Position;
+		const FVector2D Delta(Random.FRandRange(-0.25f, 0.25f) * Droplet.Speed, Droplet.Speed);
+		const float TrailRadius = Droplet.Radius * TrailRadiusScale;
+		const int32 NumTrailPoints = FMath::Max(FMath::CeilToInt(Delta.Size() / TrailRadius), 1);
+
+		for (int32 Point = 0; Point < NumTrailPoints; Point++)
+		{
+			FVolumetricCloudsRaindrop Trail;
+			Trail.Position = Wrap(Start + Delta * (float(Point) / NumTrailPoints));
+			Trail.Radius = TrailRadius;
+			Trail.Speed = 0.0f;
+			Trails.Add(Trail);
+		}
+
+		//Small droplets are left behind and the volume is taken from the sliding droplet.
+		if (Random.FRand() < Settings.TrailDropletChance)
+		{
+			FVolumetricCloudsRaindrop LeftDroplet;
+			LeftDroplet.Position = Start;
+			LeftDroplet.Radius = Droplet.Radius * ResidueRadiusScale;
+			LeftDroplet.Speed = 0.0f;
+			Residue.Add(LeftDroplet);
+
+			Droplet.Radius = GetRadius(GetVolume(Droplet.Radius) - GetVolume(LeftDroplet.Radius));
+		}
+
+		Droplet.Position = Wrap(Start + Delta);
+	}
+
+	Droplets.Append(Residue);
+
+	const float MinRadius = Settings.MinRadius * MinRadiusScale;
+	Droplets.RemoveAll([MinRadius](const FVolumetricCloudsRaindrop& Droplet) { return Droplet.Radius < MinRadius; });
+
+	MergeDroplets();
+}
+
+void FVolumetricCloudsRaindrops::MergeDroplets()
+{
+	using namespace VolumetricCloudsRaindrops;
+
+	if (Droplets.Num() < 2)
+	{
+		return;
+	}
+
+	float MaxRadius = 0.0f;
+
+	for (const FVolumetricCloudsRaindrop& Droplet : Droplets)
+	{
+		MaxRadius = FMath::Max(MaxRadius, Droplet.Radius);
+	}
+
+	//Touching droplets are at most two radii apart, so only neighbor cells have to be tested.
+	const int32 NumCells = FMath::Clamp(FMath::FloorToInt(1.0f / (2.0f * MaxRadius)), 1, MaxMergeCells);
+
+	auto GetCell = [NumCells](const FVector2D& Position) -> FIntPoint
+	{
+		return FIntPoint(FMath::Min(FMath::FloorToInt(Position.X * NumCells), NumCells - 1), FMath::Min(FMath::FloorToInt(Position.Y * NumCells), NumCells - 1));
+	};
+
+	//Counting sort of droplets by cell.
+	CellStart.Reset();
+	CellStart.SetNumZeroed(NumCells * NumCells + 1);
+
+	for (const FVolumetricCloudsRaindrop& Droplet : Droplets)
+	{
+		const FIntPoint Cell = GetCell(Droplet.Position);
+		CellStart[Cell.Y * NumCells + Cell.X + 1]++;
+	}
+
+	for (int32 Cell = 1; Cell < CellStart.Num(); Cell++)
+	{
+		CellStart[Cell] += CellStart[Cell - 1];
+	}
+
+	TArray<int32> CellFill(CellStart);
+	CellDroplets.SetNumUninitialized(Droplets.Num());
+
+	for (int32 Index = 0; Index < Droplets.Num(); Index++)
+	{
+		const FIntPoint Cell = GetCell(Droplets[Index].Position);
+		CellDroplets[CellFill[Cell.Y * NumCells + Cell.X]++] = Index;
+	}
+
+	for (int32 Index = 0; Index < Droplets.Num(); Index++)
+	{
+		FVolumetricCloudsRaindrop& Droplet = Droplets[Index];
+
+		if (Droplet.Radius <= 0.0f)
+		{
+			continue;
+		}
+
+		const FIntPoint Cell = GetCell(Droplet.Position);
+
+		for (int32 OffsetY = -1; OffsetY <= 1; OffsetY++)
+		{
+			for (int32 OffsetX = -1; OffsetX <= 1; OffsetX++)
+			{
+				const int32 NeighborX = (Cell.X + OffsetX + NumCells) % NumCells;
+				const int32 NeighborY = (Cell.Y + OffsetY + NumCells) % NumCells;
+				const int32 Neighbor = NeighborY * NumCells + NeighborX;
+
+				for (int32 Slot = CellStart[Neighbor]; Slot < CellStart[Neighbor + 1]; Slot++)
+				{
+					const int32 OtherIndex = CellDroplets[Slot];
+					FVolumetricCloudsRaindrop& Other = Droplets[OtherIndex];
+
+					//Every pair is tested once, merged droplets have zero radius.
+					if (OtherIndex <= Index || Other.Radius <= 0.0f)
+					{
+						continue;
+					}
+
+					const FVector2D Delta = GetWrappedDelta(Droplet.Position, Other.Position);
+
+					if (Delta.SizeSquared() >= FMath::Square(Droplet.Radius + Other.Radius))
+					{
+						continue;
+					}
+
+					//Volume is preserved, the merged droplet moves towards the heavier one.
+					const float Volume = GetVolume(Droplet.Radius);
+					const float OtherVolume = GetVolume(Other.Radius);
+
+					Droplet.Position = Wrap(Droplet.Position + Delta * (OtherVolume / (Volume + OtherVolume)));
+					Droplet.Radius = GetRadius(Volume + OtherVolume);
+					Droplet.Speed = FMath::Max(Droplet.Speed, Other.Speed);
+					Other.Radius = 0.0f;
+				}
+			}
+		}
+	}
+
+	Droplets.RemoveAll([](const FVolumetricCloudsRaindrop& Droplet) { return Droplet.Radius <= 0.0f; });
+}
+
+FVector2D FVolumetricCloudsRaindrops::GetWrappedDelta(const FVector2D& From, const FVector2D& To)
+{
+	FVector2D Delta = To - From;
+	Delta.X -= FMath::RoundToFloat(Delta.X);
+	Delta.Y -= FMath::RoundToFloat(Delta.Y);
+
+	return Delta;
+}
+
+void FVolumetricCloudsRaindrops::Rasterize(const TArray<FVolumetricCloudsRaindrop>& InDroplets, const TArray<FVolumetricCloudsRaindrop>& InTrails, TArray<float>& Scratch, FColor* Normals, FColor* Masks, int32 Stride) const
+{
+	const int32 Size = FMath::Max(Settings.Size, 1);
+	const int32 NumTexels = Size * Size;
+
+	//Height field, droplet mask and trail mask.
+	Scratch.Reset();
+	Scratch.SetNumZeroed(NumTexels * 3);
+
+	float* Heights = Scratch.GetData();
+	float* DropletMask = Heights + NumTexels;
+	float* TrailMask = DropletMask + NumTexels;
+
+	//Call Function(TexelIndex, Distance, Radius) for every texel inside of a circle, wrapping around the frame edges.
+	auto ForEachTexel = [Size](const FVolumetricCloudsRaindrop& Drop, auto Function)
+	{
+		const FVector2D Center = Drop.Position * Size;
+		const float Radius = Drop.Radius * Size;
+		const int32 MinX = FMath::FloorToInt(Center.X - Radius - 1.0f);
+		const int32 MinY = FMath::FloorToInt(Center.Y - Radius - 1.0f);
+		const int32 MaxX = FMath::CeilToInt(Center.X + Radius + 1.0f);
+		const int32 MaxY = FMath::CeilToInt(Center.Y + Radius + 1.0f);
+
+		for (int32 Y = MinY; Y <= MaxY; Y++)
+		{
+			for (int32 X = MinX; X <= MaxX; X++)
+			{
+				const float Distance = FVector2D(X + 0.5f - Center.X, Y + 0.5f - Center.Y).Size();
+
+				if (Distance < Radius)
+				{
+					const int32 WrappedX = ((X % Size) + Size) % Size;
+					const int32 WrappedY = ((Y % Size) + Size) % Size;
+
+					Function(WrappedY * Size + WrappedX, Distance, Radius);
+				}
+			}
+		}
+	};
+
+	for (const FVolumetricCloudsRaindrop& Droplet : InDroplets)
+	{
+		ForEachTexel(Droplet, [&](int32 Texel, float Distance, float Radius)
+		{
+			//Hemisphere height in texels, one texel wide antialiased edge.
+			Heights[Texel] = FMath::Max(Heights[Texel], FMath::Sqrt(Radius * Radius - Distance * Distance));
+			DropletMask[Texel] = FMath::Max(DropletMask[Texel], FMath::Min(Radius - Distance, 1.0f));
+		});
+	}
+
+	for (const FVolumetricCloudsRaindrop& Trail : InTrails)
+	{
+		const float Intensity = 1.0f - Trail.Speed / FMath::Max(Settings.TrailLifetime, 1);
+
+		ForEachTexel(Trail, [&](int32 Texel, float Distance, float Radius)
+		{
+			TrailMask[Texel] = FMath::Max(TrailMask[Texel], Intensity * (1.0f - Distance / Radius));
+		});
+	}
+
+	auto ToByte = [](float Value) -> uint8
+	{
+		return uint8(FMath::RoundToInt(FMath::Clamp(Value, 0.0f, 1.0f) * 255.0f));
+	};
+
+	for (int32 Y = 0; Y < Size; Y++)
+	{
+		const int32 Up = ((Y + Size - 1) % Size) * Size;
+		const int32 Down = ((Y + 1) % Size) * Size;
+
+		for (int32 X = 0; X < Size; X++)
+		{
+			const int32 Left = (X + Size - 1) % Size;
+			const int32 Right = (X + 1) % Size;
+			const int32 Texel = Y * Size + X;
+
+			const float SlopeX = (Heights[Y * Size + Right] - Heights[Y * Size + Left]) * 0.5f;
+			const float SlopeY = (Heights[Down + X] - Heights[Up + X]) * 0.5f;
+			const FVector Normal = FVector(-SlopeX * Settings.NormalStrength, -SlopeY * Settings.NormalStrength, 1.0f).GetSafeNormal();
+
+			Normals[Y * Stride + X] = FColor(ToByte(Normal.X * 0.5f + 0.5f), ToByte(Normal.Y * 0.5f + 0.5f), ToByte(Normal.Z * 0.5f + 0.5f), 255);
+			Masks[Y * Stride + X] = FColor(ToByte(DropletMask[Texel]), ToByte(TrailMask[Texel]), 0, 255);
+		}
+	}
+}
@@ -0,0 +1,180 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsStatistics.h"
+#include "VolumetricCloudsTiledImage.h"
+#include "Async/ParallelFor.h"
+
+void FVolumetricCloudsStatistics::Init(const FVolumetricCloudsTiledImage& Image)
+{
+	Reset();
+
+	SizeX = Image.GetSizeX();
+	SizeY = Image.GetSizeY();
+	NumTexels = int64(SizeX) * SizeY;
+	Tiles.SetNumUninitialized(Image.GetNumTiles());
+
+	ParallelFor(Tiles.Num(), [&](int32 TileIndex)
+	{
+		ComputeTile(Image, TileIndex, Tiles[TileIndex]);
+	});
+
+	for (const FTileStatistics& Tile : Tiles)
+	{
+		Accumulate(Tile, 1);
+	}
+}
+
+void FVolumetricCloudsStatistics::Reset()
+{
+	Tiles.Empty();
+	FMemory::Memzero(Histogram);
+	FMemory::Memzero(NumCovered);
+	FMemory::Memzero(Sum);
+	bRangeDirty = true;
+	NumTexels = 0;
+	SizeX = 0;
+	SizeY = 0;
+}
+
+bool FVolumetricCloudsStatistics::UpdateTiles(const FVolumetricCloudsTiledImage& Image, const TArray<int32>& TileIndices)
+{
+	if (Image.GetSizeX() != SizeX || Image.GetSizeY() != SizeY || Tiles.Num() != Image.GetNumTiles())
+	{
+		Init(Image);
+		return true;
+	}
+
+	//Recompute touched tiles in parallel, then replace only the ones whose statistics differ.
+	TArray<FTileStatistics> NewTiles;
+	NewTiles.SetNumUninitialized(TileIndices.Num());
+
+	ParallelFor(TileIndices.Num(), [&](int32 Index)
+	{
+		ComputeTile(Image, TileIndices[Index], NewTiles[Index]);
+	}, TileIndices.Num() < 4);
+
+	bool bChanged = false;
+
+	for (int32 Index = 0; Index < TileIndices.Num(); Index++)
+	{
+		FTileStatistics& Tile = Tiles[TileIndices[Index]];
+
+		if (FMemory::Memcmp(&Tile, &NewTiles[Index], sizeof(FTileStatistics)) != 0)
+		{
+			Accumulate(Tile, -1);
+			Tile = NewTiles[Index];
+			Accumulate(Tile, 1);
+			bChanged = true;
+		}
+	}
+
+	return bChanged;
+}
+
+float FVolumetricCloudsStatistics::GetCoverage(int32 Channel) const
+{
+	return NumTexels > 0 ? float(double(NumCovered[Channel]) / NumTexels) : 0.0f;
+}
+
+float FVolumetricCloudsStatistics::GetMean(int32 Channel) const
+{
+	return NumTexels > 0 ? float(Sum[Channel] / NumTexels) : 0.0f;
+}
+
+float FVolumetricCloudsStatistics::GetMin(int32 Channel) const
+{
+	UpdateRange();
+	return Min[Channel];
+}
+
+float FVolumetricCloudsStatistics::GetMax(int32 Channel) const
+{
+	UpdateRange();
+	return Max[Channel];
+}
+
+void FVolumetricCloudsStatistics::UpdateRange() const
+{
+	if (!bRangeDirty)
+	{
+		return;
+	}
+
+	//Range can't be updated by removing a tile, so it is reduced from the tile ranges instead.
+	for (int32 Channel = 0; Channel < NumChannels; Channel++)
+	{
+		Min[Channel] = Tiles.Num() > 0 ? MAX_flt : 0.0f;
+		Max[Channel] = Tiles.Num() > 0 ? -MAX_flt : 0.0f;
+
+		for (const FTileStatistics& Tile : Tiles)
+		{
+			Min[Channel] = FMath::Min(Min[Channel], Tile.Min[Channel]);
+			Max[Channel] = FMath::Max(Max[Channel], Tile.Max[Channel]);
+		}
+	}
+
+	bRangeDirty = false;
+}
+
+uint64 FVolumetricCloudsStatistics::GetMaxBinCount(int32 Channel) const
+{
+	uint64 MaxCount = 0;
+
+	for (int32 Bin = 0; Bin < NumBins; Bin++)
+	{
+		MaxCount = FMath::Max(MaxCount, Histogram[Channel][Bin]);
+	}
+
+	return MaxCount;
+}
+
+void FVolumetricCloudsStatistics::ComputeTile(const FVolumetricCloudsTiledImage& Image, int32 TileIndex, FTileStatistics& OutStatistics)
+{
+	FMemory::Memzero(OutStatistics);
+
+	for (int32 Channel = 0; Channel < NumChannels; Channel++)
+	{
+		OutStatistics.Min[Channel] = MAX_flt;
+		OutStatistics.Max[Channel] = -MAX_flt;
+	}
+
+	//Edge tiles are allocated at full size, only texels inside the image are counted.
+	const FIntRect Rect = Image.GetTileRect(TileIndex);
+	const FFloat16Color* TileData = Image.GetTileData(TileIndex);
+
+	for (int32 Y = 0; Y < Rect.Height(); Y++)
+	{
+		for (int32 X = 0; X < Rect.Width(); X++)
+		{
+			const FLinearColor Value = TileData != nullptr ? FLinearColor(TileData[Y * FVolumetricCloudsTiledImage::TileSize + X]) : Image.GetDefaultValue();
+
+			for (int32 Channel = 0; Channel < NumChannels; Channel++)
+			{
+				const float ChannelValue = (&Value.R)[Channel];
+				const int32 Bin = FMath::Clamp(FMath::FloorToInt(ChannelValue * NumBins), 0, NumBins - 1);
+
+				OutStatistics.Histogram[Channel][Bin]++;
+				OutStatistics.NumCovered[Channel] += ChannelValue > CoverageThreshold ? 1 : 0;
+				OutStatistics.Sum[Channel] += ChannelValue;
+				OutStatistics.Min[Channel] = FMath::Min(OutStatistics.Min[Channel], ChannelValue);
+				OutStatistics.Max[Channel] = FMath::Max(OutStatistics.Max[Channel], ChannelValue);
+			}
+		}
+	}
+}
+
+void FVolumetricCloudsStatistics::Accumulate(const FTileStatistics& Tile, int32 Sign)
+{
+	for (int32 Channel = 0; Channel < NumChannels; Channel++)
+	{
+		for (int32 Bin = 0; Bin < NumBins; Bin++)
+		{
+			Histogram[Channel][Bin] += Sign * int64(Tile.Histogram[Channel][Bin]);
+		}
+
+		NumCovered[Channel] += Sign * int64(Tile.NumCovered[Channel]);
+		Sum[Channel] += Sign * double(Tile.Sum[Channel]);
+	}
+
+	bRangeDirty = true;
+}
@@ -0,0 +1,296 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsTiledImage.h"
+#include "Serialization/Archive.h"
+
+void FVolumetricCloudsTiledImage::Init(int32 InSizeX, int32 InSizeY, const FLinearColor& InDefaultValue)
+{
+	check(InSizeX >= 0 && InSizeY >= 0);
+
+	SizeX = InSizeX;
+	SizeY = InSizeY;
+	NumTilesX = FMath::DivideAndRoundUp(SizeX, TileSize);
+	NumTilesY = FMath::DivideAndRoundUp(SizeY, TileSize);
+	DefaultValue = InDefaultValue;
+
+	Tiles.Empty(NumTilesX * NumTilesY);
+	Tiles.SetNum(NumTilesX * NumTilesY);
+}
+
+void FVolumetricCloudsTiledImage::Reset()
+{
+	Init(0, 0, DefaultValue);
+}
+
+FIntRect FVolumetricCloudsTiledImage::GetTileRect(int32 TileIndex) const
+{
+	const int32 TileX = TileIndex % NumTilesX;
+	const int32 TileY = TileIndex / NumTilesX;
+
+	const FIntPoint Min(TileX * TileSize, TileY * TileSize);
+	const FIntPoint Max(FMath::Min(Min.X + TileSize, SizeX), FMath::Min(Min.Y + TileSize, SizeY));
+
+	return FIntRect(Min, Max);
+}
+
+FFloat16Color* FVolumetricCloudsTiledImage::FindOrAllocateTile(int32 TileIndex)
+{
+	TArray<FFloat16Color>& Tile = Tiles[TileIndex];
+
+	if (Tile.Num() == 0)
+	{
+		Tile.Init(FFloat16Color(DefaultValue), TileTexels);
+	}
+
+	return Tile.GetData();
+}
+
+void FVolumetricCloudsTiledImage::FreeTile(int32 TileIndex)
+{
+	Tiles[TileIndex].Empty();
+}
+
+void FVolumetricCloudsTiledImage::SwapTile(int32 TileIndex, TArray<FFloat16Color>& Texels)
+{
+	check(Texels.Num() == 0 || Texels.Num() == TileTexels);
+
+	Swap(Tiles[TileIndex], Texels);
+}
+
+void FVolumetricCloudsTiledImage::AllocateAllTiles()
+{
+	for (int32 TileIndex = 0; TileIndex < Tiles.Num(); TileIndex++)
+	{
+		FindOrAllocateTile(TileIndex);
+	}
+}
+
+int32 FVolumetricCloudsTiledImage::GetNumAllocatedTiles() const
+{
+	int32 NumAllocated = 0;
+
+	for (const TArray<FFloat16Color>& Tile : Tiles)
+	{
+		NumAllocated += Tile.Num() > 0 ? 1 : 0;
+	}
+
+	return NumAllocated;
+}
+
+void FVolumetricCloudsTiledImage::GetAllocatedTiles(TArray<int32>& OutTileIndices) const
+{
+	OutTileIndices.Reset();
+
+	for (int32 TileIndex = 0; TileIndex < Tiles.Num(); TileIndex++)
+	{
+		if (Tiles[TileIndex].Num() > 0)
+		{
+			OutTileIndices.Add(TileIndex);
+		}
+	}
+}
+
+FLinearColor FVolumetricCloudsTiledImage::GetTexel(int32 X, int32 Y) const
+{
+	const FFloat16Color* TileData = GetTileData(GetTileIndex(X, Y));
+
+	if (TileData == nullptr)
+	{
+		return DefaultValue;
+	}
+
+	return FLinearColor(TileData[(Y % TileSize) * TileSize + (X % TileSize)]);
+}
+
+void FVolumetricCloudsTiledImage::SetTexel(int32 X, int32 Y, const FLinearColor& Value)
+{
+	FFloat16Color* TileData = FindOrAllocateTile(GetTileIndex(X, Y));
+	TileData[(Y % TileSize) * TileSize + (X % TileSize)] = FFloat16Color(Value);
+}
+
+void FVolumetricCloudsTiledImage::Import(const FLinearColor* Texels)
+{
+	for (int32 TileIndex = 0; TileIndex < Tiles.Num(); TileIndex++)
+	{
+		const FIntRect Rect = GetTileRect(TileIndex);
+		FFloat16Color* TileData = FindOrAllocateTile(TileIndex);
+
+		for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+		{
+			PackTexels(Texels + Y * SizeX + Rect.Min.X, TileData + (Y - Rect.Min.Y) * TileSize, Rect.Width());
+		}
+	}
+}
+
+void FVolumetricCloudsTiledImage::Import(const FFloat16Color* Texels)
+{
+	for (int32 TileIndex = 0; TileIndex < Tiles.Num(); TileIndex++)
+	{
+		const FIntRect Rect = GetTileRect(TileIndex);
+		FFloat16Color* TileData = FindOrAllocateTile(TileIndex);
+
+		for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+		{
+			FMemory::Memcpy(TileData + (Y - Rect.Min.Y) * TileSize, Texels + Y * SizeX + Rect.Min.X, Rect.Width() * sizeof(FFloat16Color));
+		}
+	}
+}
+
+void FVolumetricCloudsTiledImage::Export(FLinearColor* OutTexels) const
+{
+	for (int32 TileIndex = 0; TileIndex < Tiles.Num(); TileIndex++)
+	{
+		const FIntRect Rect = GetTileRect(TileIndex);
+		const FFloat16Color* TileData = GetTileData(TileIndex);
+
+		for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+		{
+			FLinearColor* Row = OutTexels + Y * SizeX + Rect.Min.X;
+
+			if (TileData != nullptr)
+			{
+				UnpackTexels(TileData + (Y - Rect.Min.Y) * TileSize, Row, Rect.Width());
+			}
+			else
+			{
+				for (int32 X = 0; X < Rect.Width(); X++)
+				{
+					Row[X] = DefaultValue;
+				}
+			}
+		}
+	}
+}
+
+SIZE_T FVolumetricCloudsTiledImage::GetAllocatedSize() const
+{
+	SIZE_T Size = Tiles.GetAllocatedSize();
+
+	for (const TArray<FFloat16Color>& Tile : Tiles)
+	{
+		Size += Tile.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+void FVolumetricCloudsTiledImage::SerializeHeader(FArchive& Ar, TArray<int32>& AllocatedTiles)
+{
+	int32 SavedSizeX = SizeX;
+	int32 SavedSizeY = SizeY;
+	FLinearColor SavedDefaultValue = DefaultValue;
+
+	Ar << SavedSizeX << SavedSizeY << SavedDefaultValue;
+
+	if (Ar.IsLoading())
+	{
+		Init(SavedSizeX, SavedSizeY, SavedDefaultValue);
+	}
+
+	if (Ar.IsSaving())
+	{
+		GetAllocatedTiles(AllocatedTiles);
+	}
+
+	Ar << AllocatedTiles;
+
+	for (int32 TileIndex : AllocatedTiles)
+	{
+		if (!Tiles.IsValidIndex(TileIndex))
+		{
+			Ar.SetError();
+			AllocatedTiles.Reset();
+			break;
+		}
+	}
+}
+
+FArchive& operator<<(FArchive& Ar, FVolumetricCloudsTiledImage& Image)
+{
+	TArray<int32> AllocatedTiles;
+	Image.SerializeHeader(Ar, AllocatedTiles);
+
+	//Tiles are written as raw texel blocks, no per texel serialization.
+	for (int32 TileIndex : AllocatedTiles)
+	{
+		FFloat16Color* TileData = Image.FindOrAllocateTile(TileIndex);
+		Ar.Serialize(TileData, FVolumetricCloudsTiledImage::TileTexels * sizeof(FFloat16Color));
+	}
+
+	return Ar;
+}
+
+void FVolumetricCloudsTiledImage::LoadFullPrecision(FArchive& Ar)
+{
+	check(Ar.IsLoading());
+
+	TArray<int32> AllocatedTiles;
+	SerializeHeader(Ar, AllocatedTiles);
+
+	TArray<FLinearColor> Texels;
+	Texels.SetNumUninitialized(TileTexels);
+
+	for (int32 TileIndex : AllocatedTiles)
+	{
+		Ar.Serialize(Texels.GetData(), TileTexels * sizeof(FLinearColor));
+		PackTexels(Texels.GetData(), FindOrAllocateTile(TileIndex), TileTexels);
+	}
+}
+
+void FVolumetricCloudsTiledImage::UnpackTexels(const FFloat16Color* Texels, FLinearColor* OutTexels, int32 NumTexels)
+{
+	for (int32 Index = 0; Index < NumTexels; Index++)
+	{
+		OutTexels[Index] = FLinearColor(Texels[Index]);
+	}
+}
+
+void FVolumetricCloudsTiledImage::PackTexels(const FLinearColor* Texels, FFloat16Color* OutTexels, int32 NumTexels)
+{
+	for (int32 Index = 0; Index < NumTexels; Index++)
+	{
+		OutTexels[Index] = FFloat16Color(Texels[Index]);
+	}
+}
+
+void FVolumetricCloudsTiledImage::SplitWrappedRect(const FIntRect& Rect, TArray<FIntRect, TInlineAllocator<4>>& OutRects, TArray<FIntPoint, TInlineAllocator<4>>& OutOffsets) const
+{
+	OutRects.Reset();
+	OutOffsets.Reset();
+
+	if (SizeX <= 0 || SizeY <= 0 || Rect.Width() <= 0 || Rect.Height() <= 0)
+	{
+		return;
+	}
+
+	//Wrapped ranges along one axis, a footprint larger than the image is clamped so no texel is visited twice.
+	auto SplitAxis = [](int32 Min, int32 Max, int32 Size, TArray<FIntPoint, TInlineAllocator<2>>& OutRanges, TArray<int32, TInlineAllocator<2>>& OutRangeOffsets)
+	{
+		const int32 Length = FMath::Min(Max - Min, Size);
+		const int32 WrappedMin = ((Min % Size) + Size) % Size;
+		const int32 Offset = Min - WrappedMin;
+
+		OutRanges.Add(FIntPoint(WrappedMin, FMath::Min(WrappedMin + Length, Size)));
+		OutRangeOffsets.Add(Offset);
+
+		if (WrappedMin + Length > Size)
+		{
+			OutRanges.Add(FIntPoint(0, WrappedMin + Length - Size));
+			OutRangeOffsets.Add(Offset + Size);
+		}
+	};
+
+	TArray<FIntPoint, TInlineAllocator<2>> RangesX, RangesY;
+	TArray<int32, TInlineAllocator<2>> OffsetsX, OffsetsY;
+	SplitAxis(Rect.Min.X, Rect.Max.X, SizeX, RangesX, OffsetsX);
+	SplitAxis(Rect.Min.Y, Rect.Max.Y, SizeY, RangesY, OffsetsY);
+
+	for (int32 IndexY = 0; IndexY < RangesY.Num(); IndexY++)
+	{
+		for (int32 IndexX = 0; IndexX < RangesX.Num(); IndexX++)
+		{
+			OutRects.Add(FIntRect(RangesX[IndexX].X, RangesY[IndexY].X, RangesX[IndexX].Y, RangesY[IndexY].Y));
+			OutOffsets.Add(FIntPoint(OffsetsX[IndexX], OffsetsY[IndexY]));
+		}
+	}
+}
@@ -0,0 +1,394 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsWeatherSolver.h"
+#include "Math/VectorRegister.h"
+#include "Math/RandomStream.h"
+#include "Async/ParallelFor.h"
+
+namespace VolumetricCloudsWeatherSolver
+{
+	/** Number of cells stepped together, one per vector lane. */
+	static const int32 NumLanes = 4;
+
+	/** Swirl modes added to the prevailing wind. */
+	static const int32 NumWindModes = 4;
+
+	/** Bilinear sample of a power of two grid, wraps around its edges.
+	* @param Grid - (Mask + 1)^2 values.
+	* @param Mask - grid size minus one.
+	* @param X - position in cells, cell centers are at whole numbers.
+	* @param Y - position in cells.
+	*/
+	FORCEINLINE float SampleWrapped(const float* Grid, int32 Mask, float X, float Y)
+	{
+		const int32 X0 = FMath::FloorToInt(X);
+		const int32 Y0 = FMath::FloorToInt(Y);
+		const float FracX = X - X0;
+		const float FracY = Y - Y0;
+		const int32 Stride = Mask + 1;
+
+		const float* Row0 = Grid + (Y0 & Mask) * Stride;
+		const float* Row1 = Grid + ((Y0 + 1) & Mask) * Stride;
+
+		const float Top = FMath::Lerp(Row0[X0 & Mask], Row0[(X0 + 1) & Mask], FracX);
+		const float Bottom = FMath::Lerp(Row1[X0 & Mask], Row1[(X0 + 1) & Mask], FracX);
+
+		return FMath::Lerp(Top, Bottom, FracY);
+	}
+
+	FORCEINLINE VectorRegister Lerp(const VectorRegister& A, const VectorRegister& B, const VectorRegister& Alpha)
+	{
+		return VectorMultiplyAdd(VectorSubtract(B, A), Alpha, A);
+	}
+
+	FORCEINLINE int32 Wrap(int32 Value, int32 Size)
+	{
+		return ((Value % Size) + Size) % Size;
+	}
+}
+
+void FVolumetricCloudsWeatherSolver::Init(const FVolumetricCloudsWeatherSolverSettings& InSettings, const float* InMoisture)
+{
+	using namespace VolumetricCloudsWeatherSolver;
+
+	Settings = InSettings;
+	Settings.Diffusion = FMath::Clamp(Settings.Diffusion, 0.0f, 0.25f);
+	Settings.TimeStep = FMath::Max(Settings.TimeStep, KINDA_SMALL_NUMBER);
+
+	//Power of two sizes wrap with a mask, at least 16 keeps every row a whole number of vectors.
+	Size = FMath::RoundUpToPowerOfTwo(FMath::Clamp(Settings.Size, 16, MaxSize));
+	WindSize = FMath::Min<int32>(FMath::RoundUpToPowerOfTwo(FMath::Max(Settings.WindSize, 1)), Size);
+	StepCount = 0;
+
+	Moisture.SetNumZeroed(Size * Size);
+	Scratch.SetNumZeroed(Size * Size);
+	Source.SetNumZeroed(Size * Size);
+
+	if (InMoisture != nullptr)
+	{
+		Reset(InMoisture);
+	}
+
+	//Undisturbed wind is the prevailing wind plus the curl of a few plane waves, swirls without sources or sinks.
+	//Integer wave numbers keep the field tileable.
+	FRandomStream Random(Settings.Seed);
+
+	int32 WaveX[NumWindModes];
+	int32 WaveY[NumWindModes];
+	float Phase[NumWindModes];
+
+	for (int32 Mode = 0; Mode < NumWindModes; Mode++)
+	{
+		do
+		{
+			WaveX[Mode] = Random.RandRange(-3, 3);
+			WaveY[Mode] = Random.RandRange(-3, 3);
+		}
+		while (WaveX[Mode] == 0 && WaveY[Mode] == 0);
+
+		Phase[Mode] = Random.FRand() * 2.0f * PI;
+	}
+
+	TargetWindU.SetNumUninitialized(WindSize * WindSize);
+	TargetWindV.SetNumUninitialized(WindSize * WindSize);
+
+	const float ModeSpeed = Settings.Turbulence / NumWindModes;
+
+	for (int32 Y = 0; Y < WindSize; Y++)
+	{
+		for (int32 X = 0; X < WindSize; X++)
+		{
+			FVector2D Wind = Settings.PrevailingWind;
+
+			for (int32 Mode = 0; Mode < NumWindModes; Mode++)
+			{
+				const float Length = FMath::Sqrt(float(WaveX[Mode] * WaveX[Mode] + WaveY[Mode] * WaveY[Mode]));
+				const float Wave = FMath::Cos(2.0f * PI * (WaveX[Mode] * X + WaveY[Mode] * Y) / WindSize + Phase[Mode]);
+
+				Wind.X += ModeSpeed * WaveY[Mode] / Length * Wave;
+				Wind.Y -= ModeSpeed * WaveX[Mode] / Length * Wave;
+			}
+
+			TargetWindU[Y * WindSize + X] = Wind.X;
+			TargetWindV[Y * WindSize + X] = Wind.Y;
+		}
+	}
+
+	WindU = TargetWindU;
+	WindV = TargetWindV;
+	PreviousWindU.SetNumUninitialized(WindSize * WindSize);
+	PreviousWindV.SetNumUninitialized(WindSize * WindSize);
+}
+
+void FVolumetricCloudsWeatherSolver::Reset(const float* InMoisture)
+{
+	FMemory::Memcpy(Moisture.GetData(), InMoisture, Size * Size * sizeof(float));
+	FMemory::Memcpy(Source.GetData(), InMoisture, Size * Size * sizeof(float));
+}
+
+void FVolumetricCloudsWeatherSolver::SetPrevailingWind(const FVector2D& Wind)
+{
+	const FVector2D Delta = Wind - Settings.PrevailingWind;
+	Settings.PrevailingWind = Wind;
+
+	//Undisturbed field is the prevailing wind plus fixed swirls, so it only shifts.
+	for (int32 Index = 0; Index < TargetWindU.Num(); Index++)
+	{
+		TargetWindU[Index] += Delta.X;
+		TargetWindV[Index] += Delta.Y;
+	}
+}
+
+void FVolumetricCloudsWeatherSolver::Step(float DeltaTime)
+{
+	check(IsValid());
+
+	StepWind(DeltaTime);
+	AdvectMoisture(DeltaTime);
+	DiffuseMoisture(DeltaTime);
+
+	StepCount++;
+}
+
+void FVolumetricCloudsWeatherSolver::Settle(float DeltaTime)
+{
+	check(IsValid());
+
+	const float WindRelax = ScaleFraction(Settings.WindRelax, DeltaTime);
+
+	for (int32 Index = 0; Index < WindU.Num(); Index++)
+	{
+		WindU[Index] = FMath::Lerp(WindU[Index], TargetWindU[Index], WindRelax);
+		WindV[Index] = FMath::Lerp(WindV[Index], TargetWindV[Index], WindRelax);
+	}
+
+	//Diffusion reads Scratch, which normally holds the advected moisture.
+	FMemory::Memcpy(Scratch.GetData(), Moisture.GetData(), Size * Size * sizeof(float));
+	DiffuseMoisture(DeltaTime);
+
+	StepCount++;
+}
+
+float FVolumetricCloudsWeatherSolver::GetMaxStableTimeStep() const
+{
+	float MaxSpeedSquared = 0.0f;
+
+	for (int32 Index = 0; Index < WindU.Num(); Index++)
+	{
+		MaxSpeedSquared = FMath::Max(MaxSpeedSquared, FMath::Square(WindU[Index]) + FMath::Square(WindV[Index]));
+		MaxSpeedSquared = FMath::Max(MaxSpeedSquared, FMath::Square(TargetWindU[Index]) + FMath::Square(TargetWindV[Index]));
+	}
+
+	return MaxSpeedSquared > 0.0f ? CourantLimit / FMath::Sqrt(MaxSpeedSquared) : BIG_NUMBER;
+}
+
+float FVolumetricCloudsWeatherSolver::ScaleFraction(float Fraction, float DeltaTime) const
+{
+	if (DeltaTime == Settings.TimeStep)
+	{
+		return Fraction;
+	}
+
+	//Applying a fraction N times leaves (1 - Fraction)^N.
+	return 1.0f - FMath::Pow(1.0f - FMath::Clamp(Fraction, 0.0f, 1.0f), DeltaTime / Settings.TimeStep);
+}
+
+void FVolumetricCloudsWeatherSolver::StepWind(float DeltaTime)
+{
+	using namespace VolumetricCloudsWeatherSolver;
+
+	Swap(WindU, PreviousWindU);
+	Swap(WindV, PreviousWindV);
+
+	//Wind is stored in moisture cells per second, a coarse cell is Size / WindSize of them.
+	const float Distance = DeltaTime * WindSize / Size;
+	const float WindRelax = ScaleFraction(Settings.WindRelax, DeltaTime);
+	const int32 Mask = WindSize - 1;
+
+	//Coarse grid is a few thousand cells, not worth the task overhead.
+	for (int32 Y = 0; Y < WindSize; Y++)
+	{
+		for (int32 X = 0; X < WindSize; X++)
+		{
+			const int32 Index = Y * WindSize + X;
+			const float SourceX = X - PreviousWindU[Index] * Distance;
+			const float SourceY = Y - PreviousWindV[Index] * Distance;
+
+			WindU[Index] = FMath::Lerp(SampleWrapped(PreviousWindU.GetData(), Mask, SourceX, SourceY), TargetWindU[Index], WindRelax);
+			WindV[Index] = FMath::Lerp(SampleWrapped(PreviousWindV.GetData(), Mask, SourceX, SourceY), TargetWindV[Index], WindRelax);
+		}
+	}
+}
+
+void FVolumetricCloudsWeatherSolver::AdvectMoisture(float DeltaTime)
+{
+	using namespace VolumetricCloudsWeatherSolver;
+
+	const int32 Mask = Size - 1;
+	const int32 WindMask = WindSize - 1;
+	const float Ratio = float(WindSize) / Size;
+	const VectorRegister Distance = VectorSetFloat1(-DeltaTime);
+	const VectorRegister LaneOffsets = MakeVectorRegister(0.0f, 1.0f, 2.0f, 3.0f);
+
+	//Every row only reads the previous grids and writes its own cells, the result doesn't depend on scheduling.
+	ParallelFor(Size, [&](int32 Y)
+	{
+		float CoarseRowU[MaxSize];
+		float CoarseRowV[MaxSize];
+		float RowU[MaxSize];
+		float RowV[MaxSize];
+
+		//Upsample wind to the row, first vertically between two coarse rows, then horizontally.
+		const float CoarseY = (Y + 0.5f) * Ratio - 0.5f;
+		const int32 CoarseY0 = FMath::FloorToInt(CoarseY);
+		const float FracY = CoarseY - CoarseY0;
+		const int32 Row0 = (CoarseY0 & WindMask) * WindSize;
+		const int32 Row1 = ((CoarseY0 + 1) & WindMask) * WindSize;
+
+		for (int32 X = 0; X < WindSize; X++)
+		{
+			CoarseRowU[X] = FMath::Lerp(WindU[Row0 + X], WindU[Row1 + X], FracY);
+			CoarseRowV[X] = FMath::Lerp(WindV[Row0 + X], WindV[Row1 + X], FracY);
+		}
+
+		for (int32 X = 0; X < Size; X++)
+		{
+			const float CoarseX = (X + 0.5f) * Ratio - 0.5f;
+			const int32 CoarseX0 = FMath::FloorToInt(CoarseX);
+			const float FracX = CoarseX - CoarseX0;
+
+			RowU[X] = FMath::Lerp(CoarseRowU[CoarseX0 & WindMask], CoarseRowU[(CoarseX0 + 1) & WindMask], FracX);
+			RowV[X] = FMath::Lerp(CoarseRowV[CoarseX0 & WindMask], CoarseRowV[(CoarseX0 + 1) & WindMask], FracX);
+		}
+
+		const float* Grid = Moisture.GetData();
+		float* Out = Scratch.GetData() + Y * Size;
+		const VectorRegister RowY = VectorSetFloat1(float(Y));
+
+		for (int32 X = 0; X < Size; X += NumLanes)
+		{
+			//Trace every cell center back along the wind.
+			const VectorRegister CellX = VectorAdd(VectorSetFloat1(float(X)), LaneOffsets);
+			const VectorRegister SourceX = VectorMultiplyAdd(VectorLoad(RowU + X), Distance, CellX);
+			const VectorRegister SourceY = VectorMultiplyAdd(VectorLoad(RowV + X), Distance, RowY);
+
+			float SourceXs[NumLanes];
+			float SourceYs[NumLanes];
+			VectorStore(SourceX, SourceXs);
+			VectorStore(SourceY, SourceYs);
+
+			//Gathers are scalar, the interpolation is done on all lanes at once.
+			float Corners[4][NumLanes];
+			float FracXs[NumLanes];
+			float FracYs[NumLanes];
+
+			for (int32 Lane = 0; Lane < NumLanes; Lane++)
+			{
+				const int32 X0 = FMath::FloorToInt(SourceXs[Lane]);
+				const int32 Y0 = FMath::FloorToInt(SourceYs[Lane]);
+				FracXs[Lane] = SourceXs[Lane] - X0;
+				FracYs[Lane] = SourceYs[Lane] - Y0;
+
+				const float* Top = Grid + (Y0 & Mask) * Size;
+				const float* Bottom = Grid + ((Y0 + 1) & Mask) * Size;
+
+				Corners[0][Lane] = Top[X0 & Mask];
+				Corners[1][Lane] = Top[(X0 + 1) & Mask];
+				Corners[2][Lane] = Bottom[X0 & Mask];
+				Corners[3][Lane] = Bottom[(X0 + 1) & Mask];
+			}
+
+			const VectorRegister FracX = VectorLoad(FracXs);
+			const VectorRegister FracY = VectorLoad(FracYs);
+
+			const VectorRegister Top = Lerp(VectorLoad(Corners[0]), VectorLoad(Corners[1]), FracX);
+			const VectorRegister Bottom = Lerp(VectorLoad(Corners[2]), VectorLoad(Corners[3]), FracX);
+
+			VectorStore(Lerp(Top, Bottom, FracY), Out + X);
+		}
+	});
+}
+
+void FVolumetricCloudsWeatherSolver::DiffuseMoisture(float DeltaTime)
+{
+	using namespace VolumetricCloudsWeatherSolver;
+
+	//Explicit diffusion is only stable up to a quarter of the neighbour difference per step.
+	const float Diffusion = FMath::Min(Settings.Diffusion * DeltaTime / Settings.TimeStep, 0.25f);
+
+	const int32 Mask = Size - 1;
+	const VectorRegister CenterWeight = VectorSetFloat1(1.0f - 4.0f * Diffusion);
+	const VectorRegister NeighbourWeight = VectorSetFloat1(Diffusion);
+	const VectorRegister Relax = VectorSetFloat1(ScaleFraction(Settings.SourceRelax, DeltaTime));
+
+	ParallelFor(Size, [&](int32 Y)
+	{
+		const float* Row = Scratch.GetData() + Y * Size;
+		const float* Up = Scratch.GetData() + ((Y - 1) & Mask) * Size;
+		const float* Down = Scratch.GetData() + ((Y + 1) & Mask) * Size;
+		const float* SourceRow = Source.GetData() + Y * Size;
+		float* Out = Moisture.GetData() + Y * Size;
+
+		for (int32 X = 0; X < Size; X += NumLanes)
+		{
+			//Only the first and last vector of a row wrap around.
+			const VectorRegister Left = X > 0 ? VectorLoad(Row + X - 1) : MakeVectorRegister(Row[Size - 1], Row[0], Row[1], Row[2]);
+			const VectorRegister Right = X + NumLanes < Size ? VectorLoad(Row + X + 1) : MakeVectorRegister(Row[X + 1], Row[X + 2], Row[X + 3], Row[0]);
+			const VectorRegister Neighbours = VectorAdd(VectorAdd(Left, Right), VectorAdd(VectorLoad(Up + X), VectorLoad(Down + X)));
+
+			const VectorRegister Diffused = VectorMultiplyAdd(VectorLoad(Row + X), CenterWeight, VectorMultiply(Neighbours, NeighbourWeight));
+			const VectorRegister Relaxed = Lerp(Diffused, VectorLoad(SourceRow + X), Relax);
+
+			VectorStore(VectorMin(VectorMax(Relaxed, VectorZero()), VectorOne()), Out + X);
+		}
+	});
+}
+
+float FVolumetricCloudsWeatherSolver::SampleMoisture(const FVector2D& UV) const
+{
+	using namespace VolumetricCloudsWeatherSolver;
+
+	if (!IsValid())
+	{
+		return 0.0f;
+	}
+
+	return SampleWrapped(Moisture.GetData(), Size - 1, UV.X * Size - 0.5f, UV.Y * Size - 0.5f);
+}
+
+void FVolumetricCloudsWeatherSolver::Resample(const float* Source, int32 SourceSizeX, int32 SourceSizeY, float* Dest, int32 DestSizeX, int32 DestSizeY)
+{
+	ParallelFor(DestSizeY, [&](int32 Y)
+	{
+		ResampleRect(Source, SourceSizeX, SourceSizeY, DestSizeX, DestSizeY, FIntRect(0, Y, DestSizeX, Y + 1), Dest + Y * DestSizeX, DestSizeX);
+	});
+}
+
+void FVolumetricCloudsWeatherSolver::ResampleRect(const float* Source, int32 SourceSizeX, int32 SourceSizeY, int32 DestSizeX, int32 DestSizeY, const FIntRect& DestRect, float* Dest, int32 DestStride)
+{
+	using namespace VolumetricCloudsWeatherSolver;
+
+	const float ScaleX = float(SourceSizeX) / DestSizeX;
+	const float ScaleY = float(SourceSizeY) / DestSizeY;
+
+	for (int32 Y = DestRect.Min.Y; Y < DestRect.Max.Y; Y++)
+	{
+		const float SourceY = (Y + 0.5f) * ScaleY - 0.5f;
+		const int32 Y0 = FMath::FloorToInt(SourceY);
+		const float FracY = SourceY - Y0;
+		const float* Top = Source + Wrap(Y0, SourceSizeY) * SourceSizeX;
+		const float* Bottom = Source + Wrap(Y0 + 1, SourceSizeY) * SourceSizeX;
+		float* Row = Dest + (Y - DestRect.Min.Y) * DestStride - DestRect.Min.X;
+
+		for (int32 X = DestRect.Min.X; X < DestRect.Max.X; X++)
+		{
+			const float SourceX = (X + 0.5f) * ScaleX - 0.5f;
+			const int32 X0 = FMath::FloorToInt(SourceX);
+			const float FracX = SourceX - X0;
+			const int32 Left = Wrap(X0, SourceSizeX);
+			const int32 Right = Wrap(X0 + 1, SourceSizeX);
+
+			Row[X] = FMath::Lerp(FMath::Lerp(Top[Left], Top[Right], FracX), FMath::Lerp(Bottom[Left], Bottom[Right], FracX), FracY);
+		}
+	}
+}
@@ -0,0 +1,88 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** What a brush stroke does to the active layer. */
+enum class EVolumetricCloudsBrushTool : uint8
+{
+	/** Paint brush color. */
+	Paint,
+	/** Gaussian blur of the layer under the brush. */
+	Blur,
+	/** Drag layer texels along the stroke direction. */
+	Smudge,
+	/** Paint brush color modulated by tileable fractal noise. */
+	Noise,
+
+	Count
+};
+
+/** Radial weather map brush, same parameters the painter exposes in its toolkit. */
+struct FVolumetricCloudsBrush
+{
+	/** Brush radius in a UV (0-1) coordinates divided by 2. */
+	float Radius = 0.1f;
+
+	/** Brush falloff, 0 is a hard edge and 1 fades over the whole radius. */
+	float Falloff = 1.0f;
+
+	/** Brush opacity. Painter scales it by 0.1 per stamp. */
+	float Opacity = 0.25f;
+
+	/** Brush color. */
+	FLinearColor Color = FLinearColor(1.0f, 1.0f, 1.0f, 1.0f);
+
+	/** 1 for channels that are painted, 0 for locked ones. */
+	FLinearColor ChannelMask = FLinearColor(1.0f, 1.0f, 0.0f, 0.0f);
+
+	/** Add to a weather map if true, subtract if false. */
+	bool bAdditive = true;
+
+	/** Stroke type. */
+	EVolumetricCloudsBrushTool Tool = EVolumetricCloudsBrushTool::Paint;
+
+	/** Blur kernel size relative to the brush radius. */
+	float BlurSize = 0.25f;
+
+	/** Noise cells across the whole weather map. */
+	int32 NoiseFrequency = 16;
+
+	/** Number of noise octaves, every octave doubles the frequency. */
+	int32 NoiseOctaves = 4;
+
+	/** Noise pattern seed. */
+	int32 NoiseSeed = 0;
+
+	/** Stamp strength applied at the brush center. */
+	float GetStrength() const
+	{
+		return Opacity * 0.1f;
+	}
+
+	/** How much filter brushes move a texel towards its filtered value per stamp. */
+	float GetFilterStrength() const
+	{
+		return FMath::Clamp(Opacity, 0.0f, 1.0f);
+	}
+
+	/** Radial brush mask.
+	* @param NormalizedDistance - distance to the brush center divided by the brush radius.
+	*/
+	float GetMask(float NormalizedDistance) const
+	{
+		if (NormalizedDistance >= 1.0f)
+		{
+			return 0.0f;
+		}
+
+		return 1.0f - FMath::SmoothStep(1.0f - FMath::Clamp(Falloff, 0.0f, 1.0f), 1.0f, NormalizedDistance);
+	}
+
+	/** Brush radius in texels of a map of given size. */
+	FVector2D GetTexelRadius(int32 SizeX, int32 SizeY) const
+	{
+		return FVector2D(Radius * 0.5f * SizeX, Radius * 0.5f * SizeY);
+	}
+};
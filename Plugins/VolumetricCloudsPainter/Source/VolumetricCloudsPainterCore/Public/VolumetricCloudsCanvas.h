@@ -0,0 +1,238 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/BitArray.h"
+#include "Math/Float16Color.h"
+#include "VolumetricCloudsTiledImage.h"
+#include "VolumetricCloudsBrush.h"
+#include "VolumetricCloudsMapOperation.h"
+
+/** How a paint layer is combined with everything below it. */
+enum class EVolumetricCloudsBlendMode : uint8
+{
+	Normal,
+	Add,
+	Subtract,
+	Multiply,
+	Max,
+	Min,
+
+	Count
+};
+
+/** Display name of a blend mode. */
+VOLUMETRICCLOUDSPAINTERCORE_API const TCHAR* GetVolumetricCloudsBlendModeName(EVolumetricCloudsBlendMode BlendMode);
+
+/** Single paint layer. Only tiles touched by a brush are allocated. */
+struct VOLUMETRICCLOUDSPAINTERCORE_API FVolumetricCloudsLayer
+{
+	/** Id unique within the canvas that survives layer moves and removals, 0 for the base layer. */
+	int32 Id = 0;
+
+	/** Layer name shown in the toolkit. */
+	FString Name;
+
+	/** Blend mode used to combine the layer with layers below. */
+	EVolumetricCloudsBlendMode BlendMode = EVolumetricCloudsBlendMode::Normal;
+
+	/** Layer opacity. */
+	float Opacity = 1.0f;
+
+	/** Is layer used in the composite. */
+	bool bVisible = true;
+
+	/** Painted layer values. */
+	FVolumetricCloudsTiledImage Values;
+
+	/** Per channel coverage of the painted values. Allocated together with Values, unused by the base layer. */
+	FVolumetricCloudsTiledImage Coverage;
+
+	friend VOLUMETRICCLOUDSPAINTERCORE_API FArchive& operator<<(FArchive& Ar, FVolumetricCloudsLayer& Layer);
+};
+
+/**
+* Layered weather map. Layer 0 is the dense base layer, every other layer is sparse and blended on top of it.
+* The flattened composite is only recomputed for tiles that were dirtied by a stroke or a layer property change.
+*/
+class VOLUMETRICCLOUDSPAINTERCORE_API FVolumetricCloudsCanvas
+{
+public:
+	/** Setup canvas with a single base layer.
+	* @param SizeX - weather map width.
+	* @param SizeY - weather map height.
+	* @param BaseTexels - SizeX * SizeY texels of the base layer.
+	*/
+	void Init(int32 SizeX, int32 SizeY, const FLinearColor* BaseTexels);
+	void Init(int32 SizeX, int32 SizeY, const FFloat16Color* BaseTexels);
+
+	/** Drop all layers. */
+	void Reset();
+
+	/** Is canvas initialized. */
+	bool IsValid() const { return Layers.Num() > 0; }
+
+	int32 GetSizeX() const { return Composite.GetSizeX(); }
+	int32 GetSizeY() const { return Composite.GetSizeY(); }
+
+	/** Replace base layer texels and hide all paint layers, used when the weather map was changed outside of the painter. */
+	void ResetBaseLayer(const FLinearColor* BaseTexels);
+
+	/** Replace a single channel of the base layer, paint layers stay as they are. Only tiles that changed by more than
+	* Threshold are written and dirtied, tiles are compared in parallel.
+	* @param Channel - channel index, 0 is red.
+	* @param Values - SizeX * SizeY channel values.
+	* @param Threshold - largest change of a tile that is skipped, it's written once the difference grows beyond it.
+	* @return number of written tiles.
+	*/
+	int32 SetBaseLayerChannel(int32 Channel, const float* Values, float Threshold = 0.0f);
+
+	/** Replace a single channel of whole base layer tiles, e.g. with tiles resampled on a worker thread.
+	* @param Channel - channel index, 0 is red.
+	* @param TileIndices - tiles to replace.
+	* @param Values - TileTexels channel values per tile with a TileSize stride, in TileIndices order.
+	*/
+	void SetBaseLayerChannelTiles(int32 Channel, const TArray<int32>& TileIndices, const TArray<float>& Values);
+
+	/** Replace whole tiles of the base layer, e.g. with saved runtime changes. Tiles are converted in parallel.
+	* @param TileIndices - tiles to replace.
+	* @param Texels - TileTexels half precision texels per tile with a TileSize stride, in TileIndices order.
+	*/
+	void SetBaseLayerTiles(const TArray<int32>& TileIndices, const TArray<FFloat16Color>& Texels);
+
+	int32 GetNumLayers() const { return Layers.Num(); }
+	const FVolumetricCloudsLayer& GetLayer(int32 LayerIndex) const { return Layers[LayerIndex]; }
+
+	/** Index of the layer with the given id, INDEX_NONE if the layer was removed. */
+	int32 FindLayerIndex(int32 LayerId) const;
+
+	/** Add a new empty layer on top of the stack.
+	* @param Name - layer name.
+	* @return index of the new layer.
+	*/
+	int32 AddLayer(const FString& Name);
+
+	/** Remove a paint layer. Base layer can't be removed. */
+	void RemoveLayer(int32 LayerIndex);
+
+	/** Move layer one step up or down in the stack. Base layer stays at the bottom. */
+	void MoveLayer(int32 LayerIndex, int32 Direction);
+
+	void SetLayerName(int32 LayerIndex, const FString& Name);
+	void SetLayerVisible(int32 LayerIndex, bool bVisible);
+	void SetLayerOpacity(int32 LayerIndex, float Opacity);
+	void SetLayerBlendMode(int32 LayerIndex, EVolumetricCloudsBlendMode BlendMode);
+
+	/** Layer that receives brush strokes. */
+	int32 GetActiveLayer() const { return ActiveLayer; }
+	void SetActiveLayer(int32 LayerIndex);
+
+	/** Stamp radial brush into the active layer. Footprint wraps around the map edges.
+	* @param Brush - brush parameters.
+	* @param UV - brush center in a weather map UV space.
+	*/
+	void Stamp(const FVolumetricCloudsBrush& Brush, const FVector2D& UV);
+
+	/** Texel rectangle touched by a brush at UV, in unwrapped texel coordinates. */
+	FIntRect GetBrushRect(const FVolumetricCloudsBrush& Brush, const FVector2D& UV) const;
+
+	/** Read active layer texels of a rectangle, wrapping around the map edges.
+	* Paint layer values are premultiplied by coverage, base layer coverage reads as 1.
+	* @param Rect - rectangle in unwrapped texel coordinates.
+	* @param OutValues - row major values of the rectangle.
+	* @param OutCoverage - row major coverage of the rectangle.
+	*/
+	void ReadLayerRegion(const FIntRect& Rect, TArray<FLinearColor>& OutValues, TArray<FLinearColor>& OutCoverage) const;
+
+	/** Blend filtered texels into the active layer, weighted by the brush mask, filter strength and channel mask.
+	* @param Brush - brush parameters.
+	* @param UV - brush center in a weather map UV space.
+	* @param Rect - rectangle of the filtered texels, usually GetBrushRect.
+	* @param Values - row major filtered values, premultiplied like ReadLayerRegion returns them.
+	* @param Coverage - row major filtered coverage.
+	*/
+	void BlendBrushRegion(const FVolumetricCloudsBrush& Brush, const FVector2D& UV, const FIntRect& Rect, const TArray<FLinearColor>& Values, const TArray<FLinearColor>& Coverage);
+
+	/** Apply an operation to every texel of the active layer, tiles are processed in parallel.
+	* Fill covers the whole map on paint layers, other operations only change painted tiles.
+	* @param Operation - operation parameters.
+	* @param ChannelMask - 1 for channels that are modified, 0 for locked ones.
+	*/
+	void ApplyMapOperation(const FVolumetricCloudsMapOperation& Operation, const FLinearColor& ChannelMask);
+
+	/** Collect tiles of the active layer an operation would change, a Fill on a paint layer covers the whole map. */
+	void GetMapOperationTiles(const FVolumetricCloudsMapOperation& Operation, TArray<int32>& OutTileIndices) const;
+
+	/** Exchange texels of a few layer tiles with external tiles, used to undo and redo layer edits.
+	* Empty external tiles free the layer tile.
+	* @param LayerIndex - layer index.
+	* @param TileIndices - tiles to exchange.
+	* @param Values - values swapped with the layer values, one entry per tile.
+	* @param Coverage - coverage swapped with the layer coverage, one entry per tile. Ignored for the base layer.
+	*/
+	void SwapLayerTiles(int32 LayerIndex, const TArray<int32>& TileIndices, TArray<TArray<FFloat16Color>>& Values, TArray<TArray<FFloat16Color>>& Coverage);
+
+	/** Mark composite tile for recomposition. */
+	void MarkTileDirty(int32 TileIndex);
+
+	/** Mark all painted tiles of a layer for recomposition. */
+	void MarkLayerDirty(int32 LayerIndex);
+
+	/** Mark whole composite for recomposition. */
+	void MarkAllDirty();
+
+	/** Are there tiles waiting for recomposition. */
+	bool HasDirtyTiles() const { return DirtyTiles.Num() > 0; }
+
+	/** Tiles waiting for recomposition, in the order they were dirtied. */
+	const TArray<int32>& GetDirtyTiles() const { return DirtyTiles; }
+
+	/** Recompose all dirty tiles.
+	* @param OutResolvedTiles - optional list that receives indices of the recomposed tiles.
+	*/
+	void Resolve(TArray<int32>* OutResolvedTiles = nullptr);
+
+	/** Flattened layers. Only valid for tiles that are not dirty. */
+	const FVolumetricCloudsTiledImage& GetComposite() const { return Composite; }
+
+	/** Resolve and write the flattened layers to a linear SizeX * SizeY texel array. */
+	void Flatten(TArray<FLinearColor>& OutTexels);
+
+	/** Memory used by all layers and the composite in bytes. */
+	SIZE_T GetAllocatedSize() const;
+
+	friend VOLUMETRICCLOUDSPAINTERCORE_API FArchive& operator<<(FArchive& Ar, FVolumetricCloudsCanvas& Canvas);
+
+private:
+	/** Setup canvas with a single empty base layer, returns the base layer values to fill. */
+	FVolumetricCloudsTiledImage& InitBaseLayer(int32 SizeX, int32 SizeY);
+
+	/** Recompose a single composite tile from all visible layers. */
+	void ComposeTile(int32 TileIndex);
+
+	/** Call Function(Values, Coverage, UnwrappedTexel, Mask) for every active layer texel under the brush and mark touched tiles dirty.
+	* Values and Coverage point to full precision copies of the stored texel, Coverage is nullptr for the base layer.
+	* @param bAllocate - allocate paint layer tiles that were not painted yet.
+	*/
+	template<typename FunctionType>
+	void ForEachBrushTexel(const FVolumetricCloudsBrush& Brush, const FVector2D& UV, bool bAllocate, FunctionType Function);
+
+	/** Layer stack, index 0 is the base layer. */
+	TArray<FVolumetricCloudsLayer> Layers;
+
+	/** Layer that receives brush strokes. */
+	int32 ActiveLayer = 0;
+
+	/** Id given to the next added layer, ids of removed layers are never reused. */
+	int32 NextLayerId = 1;
+
+	/** Flattened layers. */
+	FVolumetricCloudsTiledImage Composite;
+
+	/** Dirty flag per composite tile. */
+	TBitArray<> DirtyTileMask;
+
+	/** Dirty composite tiles in the order they were dirtied. */
+	TArray<int32> DirtyTiles;
+};
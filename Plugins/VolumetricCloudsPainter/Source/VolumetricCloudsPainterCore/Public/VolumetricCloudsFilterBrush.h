@@ -0,0 +1,52 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VolumetricCloudsBrush.h"
+
+class FVolumetricCloudsCanvas;
+
+/**
+* Blur, smudge and noise brushes. Each stamp reads the active layer under the brush footprint,
+* filters it into scratch buffers and blends the result back weighted by the brush mask.
+*/
+class VOLUMETRICCLOUDSPAINTERCORE_API FVolumetricCloudsFilterBrush
+{
+public:
+	/** Apply a filter stamp to the active canvas layer. Paint brushes are ignored.
+	* @param Canvas - canvas to modify.
+	* @param Brush - brush parameters, Tool selects the filter.
+	* @param UV - brush center in a weather map UV space.
+	* @param PreviousUV - brush center of the previous stamp in a stroke, used by smudge.
+	*/
+	void Apply(FVolumetricCloudsCanvas& Canvas, const FVolumetricCloudsBrush& Brush, const FVector2D& UV, const FVector2D& PreviousUV);
+
+	/** Normalized gaussian weights from -KernelRadius to KernelRadius, cached per radius. */
+	const TArray<float>& GetGaussianKernel(int32 KernelRadius);
+
+	/** Tileable fractal value noise in 0-1 range.
+	* @param X - texel X in a map of SizeX width.
+	* @param Y - texel Y in a map of SizeY height.
+	*/
+	static float GetNoise(int32 X, int32 Y, int32 SizeX, int32 SizeY, int32 Frequency, int32 Octaves, int32 Seed);
+
+	/** Release cached kernels and scratch buffers. */
+	void Empty();
+
+private:
+	void ApplyBlur(FVolumetricCloudsCanvas& Canvas, const FVolumetricCloudsBrush& Brush, const FVector2D& UV);
+	void ApplySmudge(FVolumetricCloudsCanvas& Canvas, const FVolumetricCloudsBrush& Brush, const FVector2D& UV, const FVector2D& PreviousUV);
+	void ApplyNoise(FVolumetricCloudsCanvas& Canvas, const FVolumetricCloudsBrush& Brush, const FVector2D& UV);
+
+	/** Gaussian kernels by kernel radius. */
+	TMap<int32, TArray<float>> GaussianKernels;
+
+	/** Scratch buffers reused between stamps. */
+	TArray<FLinearColor> SourceValues;
+	TArray<FLinearColor> SourceCoverage;
+	TArray<FLinearColor> TempValues;
+	TArray<FLinearColor> TempCoverage;
+	TArray<FLinearColor> FilteredValues;
+	TArray<FLinearColor> FilteredCoverage;
+};
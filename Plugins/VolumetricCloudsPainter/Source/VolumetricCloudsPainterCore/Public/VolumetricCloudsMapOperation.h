@@ -0,0 +1,58 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Edit applied to every texel of a layer. */
+enum class EVolumetricCloudsMapOperation : uint8
+{
+	/** Remap input range to output range with a gamma curve. */
+	Levels,
+	/** Copy or swap channels. */
+	Swizzle,
+	/** One minus value. */
+	Invert,
+	/** Constant value. */
+	Fill,
+	/** 1 above threshold, 0 below. */
+	Threshold,
+
+	Count
+};
+
+/** Display name of a map operation. */
+VOLUMETRICCLOUDSPAINTERCORE_API const TCHAR* GetVolumetricCloudsMapOperationName(EVolumetricCloudsMapOperation Operation);
+
+/** Whole map operation parameters. Every parameter is per channel. */
+struct VOLUMETRICCLOUDSPAINTERCORE_API FVolumetricCloudsMapOperation
+{
+	EVolumetricCloudsMapOperation Type = EVolumetricCloudsMapOperation::Levels;
+
+	/** Levels input black and white points. */
+	FLinearColor InBlack = FLinearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	FLinearColor InWhite = FLinearColor(1.0f, 1.0f, 1.0f, 1.0f);
+
+	/** Levels gamma, values above 1 brighten midtones. */
+	FLinearColor Gamma = FLinearColor(1.0f, 1.0f, 1.0f, 1.0f);
+
+	/** Levels output black and white points. */
+	FLinearColor OutBlack = FLinearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	FLinearColor OutWhite = FLinearColor(1.0f, 1.0f, 1.0f, 1.0f);
+
+	/** Source channel (0-3) of every output channel, e.g. {0, 1, 0, 3} copies R into B. */
+	int32 Swizzle[4] = { 0, 1, 2, 3 };
+
+	/** Fill value. */
+	FLinearColor FillValue = FLinearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+	/** Threshold value. */
+	FLinearColor Threshold = FLinearColor(0.5f, 0.5f, 0.5f, 0.5f);
+
+	/** Apply operation to texels, channels with 0 in ChannelMask are kept.
+	* @param Texels - texels to modify.
+	* @param NumTexels - number of texels.
+	* @param ChannelMask - 1 for channels that are modified, 0 for locked ones.
+	*/
+	void Apply(FLinearColor* Texels, int32 NumTexels, const FLinearColor& ChannelMask) const;
+};
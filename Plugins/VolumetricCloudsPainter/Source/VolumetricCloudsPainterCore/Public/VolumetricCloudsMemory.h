@@ -0,0 +1,50 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+/** Environment systems with their own LLM tag and memory budget. */
+enum class EVolumetricCloudsMemorySystem : int32
+{
+	/** Painter preview render target. */
+	PainterRenderTarget,
+	/** Painter layer tiles, replaced the color and alpha blend render targets. */
+	PainterCanvas,
+	/** Weather map texture the painter writes to. */
+	PainterFinalTexture,
+	/** Runtime weather map render target and canvas. */
+	WeatherMap,
+	/** Volume textures and weather maps of the clouds material, LLM tracks its dynamic instance. */
+	CloudAssets,
+	/** Sky, sun, moon and galaxy actors, LLM tracks the sky and reflection recaptures. */
+	Sky,
+	/** Rain, snow and lightning actors, LLM tracks the effect pool and lightning bolt meshes. */
+	WeatherEffects,
+
+	Count
+};
+
+/** Display name of a memory system, also its budget name in the config. */
+VOLUMETRICCLOUDSPAINTERCORE_API const TCHAR* GetVolumetricCloudsMemorySystemName(EVolumetricCloudsMemorySystem System);
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+
+/** LLM project tag of a memory system. */
+FORCEINLINE ELLMTag GetVolumetricCloudsLLMTag(EVolumetricCloudsMemorySystem System)
+{
+	return (ELLMTag)((int32)ELLMTag::ProjectTagStart + (int32)System);
+}
+
+/** Register LLM project tags of all memory systems, done on core module startup. */
+VOLUMETRICCLOUDSPAINTERCORE_API void RegisterVolumetricCloudsLLMTags();
+
+/** Track allocations of the current scope under a memory system tag. */
+#define VOLUMETRIC_CLOUDS_LLM_SCOPE(System) LLM_SCOPE(GetVolumetricCloudsLLMTag(System))
+
+#else
+
+#define VOLUMETRIC_CLOUDS_LLM_SCOPE(System)
+
+#endif
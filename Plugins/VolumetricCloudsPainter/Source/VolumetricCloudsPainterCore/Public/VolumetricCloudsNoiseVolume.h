@@ -0,0 +1,69 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Noise generated into a volume channel. */
+enum class EVolumetricCloudsNoiseType : uint8
+{
+	/** Gradient noise. */
+	Perlin,
+	/** Distance to the closest cell feature point, inverted so cells are bright. */
+	Worley,
+	/** Perlin noise remapped by Worley noise, billowy cloud base shapes. */
+	PerlinWorley,
+
+	Count
+};
+
+/** Display name of a noise type. */
+VOLUMETRICCLOUDSPAINTERCORE_API const TCHAR* GetVolumetricCloudsNoiseTypeName(EVolumetricCloudsNoiseType Type);
+
+/** Noise settings of a single volume channel. */
+struct FVolumetricCloudsNoiseChannel
+{
+	EVolumetricCloudsNoiseType Type = EVolumetricCloudsNoiseType::Worley;
+
+	/** Lattice cells across the volume in the first octave, every octave doubles it. */
+	int32 Frequency = 4;
+
+	/** Number of octaves, 0 leaves the channel black. */
+	int32 Octaves = 3;
+
+	/** Amplitude of every octave relative to the previous one. */
+	float Persistence = 0.5f;
+};
+
+/** Tileable 3D noise volume settings. */
+struct VOLUMETRICCLOUDSPAINTERCORE_API FVolumetricCloudsNoiseVolumeSettings
+{
+	/** Volume width, height and depth in texels. */
+	int32 Size = 128;
+
+	/** Lattice seed, same settings and seed always produce the same texels. */
+	int32 Seed = 0;
+
+	/** R, G, B and A channel noise. */
+	FVolumetricCloudsNoiseChannel Channels[4];
+
+	/** Defaults match a cloud detail volume, Perlin-Worley in R and three Worley frequencies in G, B and A. */
+	FVolumetricCloudsNoiseVolumeSettings();
+};
+
+/**
+* CPU baker of tileable 3D noise volumes. Slices are generated in parallel and every row is evaluated
+* four texels at a time with vector registers.
+*/
+class VOLUMETRICCLOUDSPAINTERCORE_API FVolumetricCloudsNoiseVolume
+{
+public:
+	/** Largest lattice frequency of an octave, higher octaves are skipped. Keeps a lattice below 25 MB. */
+	static const int32 MaxFrequency = 128;
+
+	/** Generate Size^3 texels, slice by slice.
+	* @param Settings - noise settings.
+	* @param OutTexels - generated texels, X changes fastest and Z slowest.
+	*/
+	static void Generate(const FVolumetricCloudsNoiseVolumeSettings& Settings, TArray<FColor>& OutTexels);
+};
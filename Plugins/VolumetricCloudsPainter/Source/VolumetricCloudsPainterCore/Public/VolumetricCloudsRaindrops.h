@@ -0,0 +1,116 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Raindrop simulation and flipbook settings. Lengths are in a frame UV (0-1) space. */
+struct FVolumetricCloudsRaindropSettings
+{
+	/** Frame width and height in texels. */
+	int32 Size = 512;
+
+	/** Number of flipbook frames, 1 bakes a single tileable texture. */
+	int32 NumFrames = 1;
+
+	/** Simulation steps between two frames. */
+	int32 StepsPerFrame = 4;
+
+	/** Steps simulated before the first frame so the glass is already wet. */
+	int32 WarmupSteps = 400;
+
+	/** Same settings and seed always produce the same texels. */
+	int32 Seed = 0;
+
+	/** New droplets per step. */
+	float SpawnRate = 12.0f;
+
+	/** Radius range of new droplets. */
+	float MinRadius = 0.002f;
+	float MaxRadius = 0.008f;
+
+	/** Droplets above this radius start to slide down. */
+	float SlideRadius = 0.012f;
+
+	/** Sliding speed gained per step. */
+	float Gravity = 0.0004f;
+
+	/** Radius lost per step by evaporation. */
+	float Evaporation = 0.00001f;
+
+	/** Steps a trail stays visible. */
+	int32 TrailLifetime = 120;
+
+	/** Chance per step that a sliding droplet leaves a small droplet behind. */
+	float TrailDropletChance = 0.15f;
+
+	/** Slope scale of the droplet hemispheres, 1 is a physical hemisphere. */
+	float NormalStrength = 1.0f;
+};
+
+/** Single droplet or trail point. */
+struct FVolumetricCloudsRaindrop
+{
+	FVector2D Position;
+	float Radius;
+	/** Sliding speed for droplets, age in steps for trail points. */
+	float Speed;
+};
+
+/**
+* CPU raindrop baker. Droplets spawn, merge when they touch and slide down once they are heavy enough,
+* leaving trails and small droplets behind. The simulation wraps around the frame edges so every frame tiles.
+* Frames are simulated in order and rasterized in parallel.
+*
+* Normal flipbook is a tangent space normal map. Mask flipbook stores droplets in R and trails in G,
+* the layout MF_DrippingRain samples.
+*/
+class VOLUMETRICCLOUDSPAINTERCORE_API FVolumetricCloudsRaindrops
+{
+public:
+	/** Simulate and rasterize all frames. Frames are laid out left to right, top to bottom.
+	* @param Settings - simulation settings.
+	* @param OutNormals - normal flipbook texels.
+	* @param OutMasks - mask flipbook texels.
+	* @param OutSize - flipbook size in texels.
+	*/
+	static void Bake(const FVolumetricCloudsRaindropSettings& Settings, TArray<FColor>& OutNormals, TArray<FColor>& OutMasks, FIntPoint& OutSize);
+
+	/** Number of frame columns of a flipbook. */
+	static int32 GetNumFramesX(int32 NumFrames);
+
+	explicit FVolumetricCloudsRaindrops(const FVolumetricCloudsRaindropSettings& InSettings);
+
+	/** Advance simulation by a single step. */
+	void Step();
+
+	/** Rasterize droplets and trails into a frame. Const, so frames can be rasterized in parallel.
+	* @param InDroplets - droplets to rasterize.
+	* @param InTrails - trail points to rasterize.
+	* @param Scratch - height field and mask buffers.
+	* @param Normals - first texel of the frame in the normal flipbook.
+	* @param Masks - first texel of the frame in the mask flipbook.
+	* @param Stride - flipbook row pitch in texels.
+	*/
+	void Rasterize(const TArray<FVolumetricCloudsRaindrop>& InDroplets, const TArray<FVolumetricCloudsRaindrop>& InTrails, TArray<float>& Scratch, FColor* Normals, FColor* Masks, int32 Stride) const;
+
+	const TArray<FVolumetricCloudsRaindrop>& GetDroplets() const { return Droplets; }
+	const TArray<FVolumetricCloudsRaindrop>& GetTrails() const { return Trails; }
+
+private:
+	/** Merge all touching droplets, uses a grid of cells two largest radii wide. */
+	void MergeDroplets();
+
+	/** Shortest wrapped offset between two positions. */
+	static FVector2D GetWrappedDelta(const FVector2D& From, const FVector2D& To);
+
+	FVolumetricCloudsRaindropSettings Settings;
+	FRandomStream Random;
+
+	TArray<FVolumetricCloudsRaindrop> Droplets;
+	TArray<FVolumetricCloudsRaindrop> Trails;
+
+	/** Merge grid scratch buffers. */
+	TArray<int32> CellStart;
+	TArray<int32> CellDroplets;
+};
@@ -0,0 +1,95 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FVolumetricCloudsTiledImage;
+
+/**
+* Per channel statistics of a tiled image. Every tile keeps its own histogram, sum and range,
+* so map totals are updated by replacing only the tiles a stroke has touched.
+*/
+class VOLUMETRICCLOUDSPAINTERCORE_API FVolumetricCloudsStatistics
+{
+public:
+	/** Number of histogram bins per channel. */
+	static const int32 NumBins = 32;
+	/** Number of image channels. */
+	static const int32 NumChannels = 4;
+
+	/** Values above this threshold count as covered. */
+	static constexpr float CoverageThreshold = 1.0f / 255.0f;
+
+	FVolumetricCloudsStatistics() { Reset(); }
+
+	/** Recompute statistics of all tiles. */
+	void Init(const FVolumetricCloudsTiledImage& Image);
+
+	/** Drop all statistics. */
+	void Reset();
+
+	/** Replace statistics of changed tiles, initializes everything if the image size has changed.
+	* @param Image - image the statistics belong to.
+	* @param TileIndices - tiles that were modified since the last update.
+	* @return true if the map statistics have changed.
+	*/
+	bool UpdateTiles(const FVolumetricCloudsTiledImage& Image, const TArray<int32>& TileIndices);
+
+	bool IsValid() const { return NumTexels > 0; }
+
+	/** Fraction of texels above CoverageThreshold. */
+	float GetCoverage(int32 Channel) const;
+	float GetMean(int32 Channel) const;
+	float GetMin(int32 Channel) const;
+	float GetMax(int32 Channel) const;
+
+	/** Texel count of every histogram bin, NumBins entries. */
+	const uint64* GetHistogram(int32 Channel) const { return Histogram[Channel]; }
+
+	/** Largest bin count of a channel. */
+	uint64 GetMaxBinCount(int32 Channel) const;
+
+	/** Memory used by the per tile cache in bytes. */
+	SIZE_T GetAllocatedSize() const { return Tiles.GetAllocatedSize(); }
+
+private:
+	/** Statistics of a single tile, bins fit 16 bits since a tile has 4096 texels. */
+	struct FTileStatistics
+	{
+		uint16 Histogram[NumChannels][NumBins];
+		uint16 NumCovered[NumChannels];
+		float Sum[NumChannels];
+		float Min[NumChannels];
+		float Max[NumChannels];
+	};
+
+	/** Compute statistics of a tile. */
+	static void ComputeTile(const FVolumetricCloudsTiledImage& Image, int32 TileIndex, FTileStatistics& OutStatistics);
+
+	/** Add or remove tile statistics from the totals.
+	* @param Sign - 1 to add, -1 to remove.
+	*/
+	void Accumulate(const FTileStatistics& Tile, int32 Sign);
+
+	/** Recompute map range from the tile ranges if tiles changed since the last query. */
+	void UpdateRange() const;
+
+	/** Cached statistics per tile. */
+	TArray<FTileStatistics> Tiles;
+
+	/** Map totals. */
+	uint64 Histogram[NumChannels][NumBins];
+	uint64 NumCovered[NumChannels];
+	double Sum[NumChannels];
+
+	/** Map range, only valid when bRangeDirty is false. */
+	mutable float Min[NumChannels];
+	mutable float Max[NumChannels];
+	mutable bool bRangeDirty = true;
+
+	/** Texels in the image. */
+	int64 NumTexels = 0;
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+};
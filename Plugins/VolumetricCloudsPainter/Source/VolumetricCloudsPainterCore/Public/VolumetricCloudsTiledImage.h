@@ -0,0 +1,118 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* RGBA image split into square tiles which are allocated on demand.
+* Unallocated tiles read as DefaultValue, so sparse images only pay for the area that was painted.
+* Texels are stored in half precision, 8 bytes per texel, and converted to FLinearColor at the texel accessors.
+*/
+class VOLUMETRICCLOUDSPAINTERCORE_API FVolumetricCloudsTiledImage
+{
+public:
+	/** Tile edge length in texels. */
+	static const int32 TileSize = 64;
+	/** Number of texels stored per tile. Edge tiles are always allocated at full size. */
+	static const int32 TileTexels = TileSize * TileSize;
+
+	/** Setup image size and drop all tiles.
+	* @param InSizeX - image width in texels.
+	* @param InSizeY - image height in texels.
+	* @param InDefaultValue - value of texels in tiles that are not allocated.
+	*/
+	void Init(int32 InSizeX, int32 InSizeY, const FLinearColor& InDefaultValue = FLinearColor(0.0f, 0.0f, 0.0f, 0.0f));
+
+	/** Free all tiles and reset size to zero. */
+	void Reset();
+
+	int32 GetSizeX() const { return SizeX; }
+	int32 GetSizeY() const { return SizeY; }
+	int32 GetNumTilesX() const { return NumTilesX; }
+	int32 GetNumTilesY() const { return NumTilesY; }
+	int32 GetNumTiles() const { return Tiles.Num(); }
+	const FLinearColor& GetDefaultValue() const { return DefaultValue; }
+
+	/** Index of the tile that contains texel. */
+	int32 GetTileIndex(int32 X, int32 Y) const { return (Y / TileSize) * NumTilesX + (X / TileSize); }
+
+	/** Texel rectangle covered by the tile, clipped to the image size. */
+	FIntRect GetTileRect(int32 TileIndex) const;
+
+	bool IsTileAllocated(int32 TileIndex) const { return Tiles[TileIndex].Num() > 0; }
+
+	/** Tile texels with a TileSize stride, or nullptr if the tile is not allocated. */
+	FFloat16Color* GetTileData(int32 TileIndex) { return Tiles[TileIndex].Num() > 0 ? Tiles[TileIndex].GetData() : nullptr; }
+	const FFloat16Color* GetTileData(int32 TileIndex) const { return Tiles[TileIndex].Num() > 0 ? Tiles[TileIndex].GetData() : nullptr; }
+
+	/** Allocate tile filled with the default value if needed and return its texels. */
+	FFloat16Color* FindOrAllocateTile(int32 TileIndex);
+
+	/** Release tile memory. Tile will read as default value afterwards. */
+	void FreeTile(int32 TileIndex);
+
+	/** Exchange tile texels with an external array, an empty array frees the tile.
+	* @param Texels - TileTexels texels or empty, receives the previous tile texels.
+	*/
+	void SwapTile(int32 TileIndex, TArray<FFloat16Color>& Texels);
+
+	/** Allocate all tiles. */
+	void AllocateAllTiles();
+
+	/** Number of allocated tiles. */
+	int32 GetNumAllocatedTiles() const;
+
+	/** Collect indices of all allocated tiles in ascending order. */
+	void GetAllocatedTiles(TArray<int32>& OutTileIndices) const;
+
+	/** Read a single texel. */
+	FLinearColor GetTexel(int32 X, int32 Y) const;
+
+	/** Write a single texel, allocating its tile if needed. */
+	void SetTexel(int32 X, int32 Y, const FLinearColor& Value);
+
+	/** Fill whole image from a linear SizeX * SizeY texel array. All tiles are allocated. */
+	void Import(const FLinearColor* Texels);
+	void Import(const FFloat16Color* Texels);
+
+	/** Write whole image to a linear SizeX * SizeY texel array. */
+	void Export(FLinearColor* OutTexels) const;
+
+	/** Memory used by allocated tiles in bytes. */
+	SIZE_T GetAllocatedSize() const;
+
+	/** Serialize image size and allocated tiles. */
+	friend VOLUMETRICCLOUDSPAINTERCORE_API FArchive& operator<<(FArchive& Ar, FVolumetricCloudsTiledImage& Image);
+
+	/** Load an image saved with FLinearColor tiles, before tiles were stored in half precision. */
+	void LoadFullPrecision(FArchive& Ar);
+
+	/** Convert a run of stored texels to full precision for processing. */
+	static void UnpackTexels(const FFloat16Color* Texels, FLinearColor* OutTexels, int32 NumTexels);
+
+	/** Convert a run of full precision texels back to storage precision. */
+	static void PackTexels(const FLinearColor* Texels, FFloat16Color* OutTexels, int32 NumTexels);
+
+	/** Split a rectangle that may lie outside of the image into rectangles inside the image, wrapping on both axes.
+	* @param Rect - rectangle in unwrapped texel coordinates.
+	* @param OutRects - wrapped rectangles inside the image.
+	* @param OutOffsets - offset that has to be added to a wrapped texel coordinate to get back the unwrapped one.
+	*/
+	void SplitWrappedRect(const FIntRect& Rect, TArray<FIntRect, TInlineAllocator<4>>& OutRects, TArray<FIntPoint, TInlineAllocator<4>>& OutOffsets) const;
+
+private:
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	int32 NumTilesX = 0;
+	int32 NumTilesY = 0;
+
+	/** Value of texels in unallocated tiles. */
+	FLinearColor DefaultValue = FLinearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+	/** Serialize image header and allocated tile list, returns the tiles to read or write. */
+	void SerializeHeader(FArchive& Ar, TArray<int32>& AllocatedTiles);
+
+	/** Tile texels, empty array for unallocated tiles. */
+	TArray<TArray<FFloat16Color>> Tiles;
+};
@@ -0,0 +1,139 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Wind and moisture solver settings. Speeds are in grid cells per second. */
+struct FVolumetricCloudsWeatherSolverSettings
+{
+	/** Moisture grid width and height, rounded up to a power of two. */
+	int32 Size = 512;
+
+	/** Wind grid width and height, rounded up to a power of two and at most Size. */
+	int32 WindSize = 64;
+
+	/** Seconds simulated by a single step. */
+	float TimeStep = 1.0f / 20.0f;
+
+	/** Wind shared by the whole grid. */
+	FVector2D PrevailingWind = FVector2D(4.0f, 1.0f);
+
+	/** Speed of the swirls added to the prevailing wind. */
+	float Turbulence = 6.0f;
+
+	/** Fraction of the wind pulled back to its undisturbed field per step, keeps swirls from fading out. */
+	float WindRelax = 0.02f;
+
+	/** Fraction of the neighbour difference exchanged per step, at most 0.25. */
+	float Diffusion = 0.05f;
+
+	/** Fraction of the moisture pulled back to the source map per step, keeps the authored weather recognizable. */
+	float SourceRelax = 0.002f;
+
+	/** Same settings, seed and input always produce the same grids. */
+	int32 Seed = 0;
+};
+
+/**
+* Semi-Lagrangian wind and moisture solver on a wrapping 2D grid. Wind lives on a coarse grid and advects itself,
+* moisture is advected by the upsampled wind, diffused and relaxed towards its source map.
+*
+* Rows are stepped in parallel and four cells at a time with vector registers. Every row only reads the previous
+* grids, so results don't depend on scheduling and a fixed step is deterministic for replays.
+*/
+class VOLUMETRICCLOUDSPAINTERCORE_API FVolumetricCloudsWeatherSolver
+{
+public:
+	/** Largest moisture grid, keeps the per row wind buffers on the stack. */
+	static const int32 MaxSize = 1024;
+
+	/** Setup grids and the undisturbed wind.
+	* @param InSettings - solver settings.
+	* @param InMoisture - Size * Size moisture values, also used as the source map. nullptr starts from zero.
+	*/
+	void Init(const FVolumetricCloudsWeatherSolverSettings& InSettings, const float* InMoisture);
+
+	/** Replace moisture and source map, keeps the wind. Used when the weather map was painted. */
+	void Reset(const float* InMoisture);
+
+	/** Change the prevailing wind, the swirls are kept and the wind relaxes towards the new field. */
+	void SetPrevailingWind(const FVector2D& Wind);
+
+	/** Advance simulation by a single fixed step. */
+	void Step() { Step(Settings.TimeStep); }
+
+	/** Advance simulation by a single step of any length, per step rates are scaled to it. Used to fast-forward,
+	* longer steps stay stable but lose detail.
+	*/
+	void Step(float DeltaTime);
+
+	/** Advance simulation by a span too long to advect, e.g. hours of a time warp. Moisture is only diffused and
+	* relaxed towards the source map and the wind towards its undisturbed field, the weather the span ends in.
+	*/
+	void Settle(float DeltaTime);
+
+	/** Longest step that moves moisture by at most CourantLimit cells with the current and undisturbed wind. */
+	float GetMaxStableTimeStep() const;
+
+	/** Cells a step may move moisture by before the semi-Lagrangian trace starts skipping over the weather. */
+	static constexpr float CourantLimit = 1.0f;
+
+	bool IsValid() const { return Moisture.Num() > 0; }
+
+	int32 GetSize() const { return Size; }
+
+	/** Steps simulated since Init. */
+	uint64 GetStepCount() const { return StepCount; }
+
+	/** Size * Size moisture values, row major. */
+	const TArray<float>& GetMoisture() const { return Moisture; }
+
+	/** Bilinear moisture at a wrapped grid UV. */
+	float SampleMoisture(const FVector2D& UV) const;
+
+	/** Bilinear resample of a wrapping grid.
+	* @param Source - SourceSizeX * SourceSizeY values.
+	* @param Dest - DestSizeX * DestSizeY values.
+	*/
+	static void Resample(const float* Source, int32 SourceSizeX, int32 SourceSizeY, float* Dest, int32 DestSizeX, int32 DestSizeY);
+
+	/** Bilinear resample of a rectangle of the destination grid, same filter as Resample.
+	* @param Source - SourceSizeX * SourceSizeY values.
+	* @param DestRect - resampled part of a DestSizeX * DestSizeY grid.
+	* @param Dest - DestRect values, rows are DestStride apart.
+	*/
+	static void ResampleRect(const float* Source, int32 SourceSizeX, int32 SourceSizeY, int32 DestSizeX, int32 DestSizeY, const FIntRect& DestRect, float* Dest, int32 DestStride);
+
+private:
+	/** Self advect the coarse wind and pull it back to the undisturbed field. */
+	void StepWind(float DeltaTime);
+
+	/** Advect Moisture into Scratch. */
+	void AdvectMoisture(float DeltaTime);
+
+	/** Diffuse Scratch and relax it towards the source into Moisture. */
+	void DiffuseMoisture(float DeltaTime);
+
+	/** Per step fraction of the settings scaled from a TimeStep long step to a DeltaTime long one. */
+	float ScaleFraction(float Fraction, float DeltaTime) const;
+
+	FVolumetricCloudsWeatherSolverSettings Settings;
+
+	int32 Size = 0;
+	int32 WindSize = 0;
+
+	TArray<float> Moisture;
+	TArray<float> Scratch;
+	TArray<float> Source;
+
+	/** Coarse wind in moisture cells per second, current, previous and undisturbed. */
+	TArray<float> WindU;
+	TArray<float> WindV;
+	TArray<float> PreviousWindU;
+	TArray<float> PreviousWindV;
+	TArray<float> TargetWindU;
+	TArray<float> TargetWindV;
+
+	uint64 StepCount = 0;
+};
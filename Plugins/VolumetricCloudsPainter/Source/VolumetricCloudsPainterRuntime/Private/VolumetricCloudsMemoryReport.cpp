@@ -0,0 +1,192 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsMemoryReport.h"
+#include "VolumetricCloudsWeatherMap.h"
+#include "Engine/World.h"
+#include "Engine/Texture.h"
+#include "Components/PrimitiveComponent.h"
+#include "GameFramework/Actor.h"
+#include "SceneTypes.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVolumetricCloudsMemory, Log, All);
+
+namespace VolumetricCloudsMemoryReport
+{
+	FORCEINLINE double ToMB(int64 Bytes)
+	{
+		return Bytes / (1024.0 * 1024.0);
+	}
+
+	void PrintReport(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		FVolumetricCloudsMemoryReport Report;
+		Report.Collect(World);
+		Report.Print(Ar);
+	}
+
+	FAutoConsoleCommandWithWorldArgsAndOutputDevice MemoryReportCommand(
+		TEXT("VolumetricClouds.MemoryReport"),
+		TEXT("Print memory of the environment systems and log an error for every system over its budget."),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&PrintReport));
+}
+
+UVolumetricCloudsMemorySettings::UVolumetricCloudsMemorySettings()
+{
+	static const float DefaultBudgetsMB[] = { 64.0f, 256.0f, 64.0f, 128.0f, 256.0f, 128.0f, 64.0f };
+	static_assert(ARRAY_COUNT(DefaultBudgetsMB) == (int32)EVolumetricCloudsMemorySystem::Count, "Every memory system needs a default budget.");
+
+	for (int32 System = 0; System < (int32)EVolumetricCloudsMemorySystem::Count; System++)
+	{
+		FVolumetricCloudsMemoryBudget Budget;
+		Budget.System = GetVolumetricCloudsMemorySystemName((EVolumetricCloudsMemorySystem)System);
+		Budget.BudgetMB = DefaultBudgetsMB[System];
+		Budgets.Add(Budget);
+	}
+
+	CloudClasses.Add(TEXT("VolumetricClouds_C"));
+
+	SkyClasses.Add(TEXT("Sky_C"));
+	SkyClasses.Add(TEXT("Sun_C"));
+	SkyClasses.Add(TEXT("Moon1_C"));
+	SkyClasses.Add(TEXT("Galaxy_C"));
+
+	WeatherEffectClasses.Add(TEXT("Rain_C"));
+	WeatherEffectClasses.Add(TEXT("Snow_C"));
+	WeatherEffectClasses.Add(TEXT("Lightning_C"));
+	WeatherEffectClasses.Add(TEXT("Thunder_C"));
+}
+
+int64 UVolumetricCloudsMemorySettings::GetBudget(EVolumetricCloudsMemorySystem System) const
+{
+	const FName SystemName = GetVolumetricCloudsMemorySystemName(System);
+
+	for (const FVolumetricCloudsMemoryBudget& Budget : Budgets)
+	{
+		if (Budget.System == SystemName)
+		{
+			return int64(Budget.BudgetMB * 1024.0 * 1024.0);
+		}
+	}
+
+	return 0;
+}
+
+FVolumetricCloudsMemoryReport::FOnCollect FVolumetricCloudsMemoryReport::OnCollect;
+
+void FVolumetricCloudsMemoryReport::Collect(UWorld* World)
+{
+	if (World == nullptr)
+	{
+		return;
+	}
+
+	OnCollect.Broadcast(World, *this);
+
+	//Weather map render target is used by the clouds material as well, it has to be counted first.
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (const UVolumetricCloudsWeatherMap* WeatherMap = Cast<UVolumetricCloudsWeatherMap>(Object))
+		{
+			WeatherMap->CollectMemory(*this);
+		}
+	}
+
+	const UVolumetricCloudsMemorySettings* Settings = GetDefault<UVolumetricCloudsMemorySettings>();
+
+	AddActors(EVolumetricCloudsMemorySystem::CloudAssets, World, Settings->CloudClasses);
+	AddActors(EVolumetricCloudsMemorySystem::Sky, World, Settings->SkyClasses);
+	AddActors(EVolumetricCloudsMemorySystem::WeatherEffects, World, Settings->WeatherEffectClasses);
+}
+
+void FVolumetricCloudsMemoryReport::AddBytes(EVolumetricCloudsMemorySystem System, int64 InBytes)
+{
+	Bytes[(int32)System] += InBytes;
+}
+
+void FVolumetricCloudsMemoryReport::AddTexture(EVolumetricCloudsMemorySystem System, UTexture* Texture)
+{
+	bool bAlreadyCounted = false;
+
+	if (Texture == nullptr)
+	{
+		return;
+	}
+
+	CountedTextures.Add(Texture, &bAlreadyCounted);
+
+	if (!bAlreadyCounted)
+	{
+		AddBytes(System, Texture->CalcTextureMemorySizeEnum(TMC_ResidentMips));
+	}
+}
+
+void FVolumetricCloudsMemoryReport::AddActor(EVolumetricCloudsMemorySystem System, AActor* Actor)
+{
+	TInlineComponentArray<UPrimitiveComponent*> Components(Actor);
+	TArray<UTexture*> Textures;
+
+	for (UPrimitiveComponent* Component : Components)
+	{
+		AddBytes(System, Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive));
+
+		Textures.Reset();
+		Component->GetUsedTextures(Textures, EMaterialQualityLevel::Num);
+
+		for (UTexture* Texture : Textures)
+		{
+			AddTexture(System, Texture);
+		}
+	}
+}
+
+void FVolumetricCloudsMemoryReport::AddActors(EVolumetricCloudsMemorySystem System, UWorld* World, const TArray<FName>& ClassNames)
+{
+	for (TActorIterator<AActor> ActorItr(World); ActorItr; ++ActorItr)
+	{
+		if (ClassNames.Contains(ActorItr->GetClass()->GetFName()))
+		{
+			AddActor(System, *ActorItr);
+		}
+	}
+}
+
+int32 FVolumetricCloudsMemoryReport::Print(FOutputDevice& Ar) const
+{
+	using namespace VolumetricCloudsMemoryReport;
+
+	const UVolumetricCloudsMemorySettings* Settings = GetDefault<UVolumetricCloudsMemorySettings>();
+	int64 TotalBytes = 0;
+	int32 NumOverruns = 0;
+
+	Ar.Logf(TEXT("%-24s %12s %12s"), TEXT("System"), TEXT("MB"), TEXT("Budget MB"));
+
+	for (int32 System = 0; System < (int32)EVolumetricCloudsMemorySystem::Count; System++)
+	{
+		const TCHAR* SystemName = GetVolumetricCloudsMemorySystemName((EVolumetricCloudsMemorySystem)System);
+		const int64 Budget = Settings->GetBudget((EVolumetricCloudsMemorySystem)System);
+
+		TotalBytes += Bytes[System];
+
+		if (Budget > 0)
+		{
+			Ar.Logf(TEXT("%-24s %12.2f %12.2f"), SystemName, ToMB(Bytes[System]), ToMB(Budget));
+		}
+		else
+		{
+			Ar.Logf(TEXT("%-24s %12.2f %12s"), SystemName, ToMB(Bytes[System]), TEXT("-"));
+		}
+
+		//Logged as errors so automated runs fail on overruns.
+		if (Budget > 0 && Bytes[System] > Budget)
+		{
+			UE_LOG(LogVolumetricCloudsMemory, Error, TEXT("%s is over budget, %.2f MB of %.2f MB."), SystemName, ToMB(Bytes[System]), ToMB(Budget));
+			NumOverruns++;
+		}
+	}
+
+	Ar.Logf(TEXT("%-24s %12.2f"), TEXT("Total"), ToMB(TotalBytes));
+
+	return NumOverruns;
+}
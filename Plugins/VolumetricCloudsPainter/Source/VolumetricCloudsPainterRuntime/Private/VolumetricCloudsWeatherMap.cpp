@@ -0,0 +1,784 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsWeatherMap.h"
+#include "VolumetricCloudsCanvas.h"
+#include "VolumetricCloudsFilterBrush.h"
+#include "VolumetricCloudsWeatherSolver.h"
+#include "VolumetricCloudsMemoryReport.h"
+#include "Engine/World.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/Texture2D.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Components/StaticMeshComponent.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "EngineUtils.h"
+#include "CanvasTypes.h"
+#include "TextureResource.h"
+#include "RenderingThread.h"
+#include "RHI.h"
+#include "Async/ParallelFor.h"
+#include "Async/Async.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVolumetricCloudsWeatherMap, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Weather Map Apply"), STAT_VolumetricCloudsWeatherMapApply, STATGROUP_Game);
+
+/** Resolved tiles packed for a single render target update. */
+struct FVolumetricCloudsTileUpload
+{
+	/** Adjacent tiles of a tile row share a region. */
+	TArray<FUpdateTextureRegion2D> Regions;
+
+	/** First texel of every region in Texels. */
+	TArray<int32> Offsets;
+
+	/** Region texels, rows are tightly packed. */
+	TArray<FFloat16Color> Texels;
+};
+
+/** Channel write resampled to weather map tiles on a worker thread. */
+struct FVolumetricCloudsChannelWrite
+{
+	int32 Channel = 0;
+	float Threshold = 0.0f;
+
+	/** Written values and their size. */
+	TArray<float> Values;
+	FIntPoint Size = FIntPoint::ZeroValue;
+
+	/** Size of the weather map. */
+	FIntPoint MapSize = FIntPoint::ZeroValue;
+
+	/** Weather map size values of the previous writes of the channel, empty if every tile has to be written. */
+	TSharedPtr<TArray<float>, ESPMode::ThreadSafe> Written;
+
+	/** Tiles that changed by more than Threshold since they were last written. */
+	TArray<int32> TileIndices;
+
+	/** FVolumetricCloudsTiledImage::TileTexels values per changed tile with a TileSize stride, in TileIndices order. */
+	TArray<float> TileValues;
+};
+
+namespace VolumetricCloudsWeatherMap
+{
+	/** Resample a channel write tile by tile, only tiles that changed since they were last written are kept.
+	* Runs on a worker thread, the write owns everything it touches.
+	*/
+	void ResampleChangedTiles(FVolumetricCloudsChannelWrite& Write)
+	{
+		const int32 TileSize = FVolumetricCloudsTiledImage::TileSize;
+		const int32 TileTexels = FVolumetricCloudsTiledImage::TileTexels;
+		const FIntPoint MapSize = Write.MapSize;
+		const int32 NumTilesX = FMath::DivideAndRoundUp(MapSize.X, TileSize);
+		const int32 NumTiles = NumTilesX * FMath::DivideAndRoundUp(MapSize.Y, TileSize);
+
+		TArray<float>& Written = *Write.Written;
+		const bool bWriteAll = Written.Num() != MapSize.X * MapSize.Y;
+
+		if (bWriteAll)
+		{
+			Written.SetNumUninitialized(MapSize.X * MapSize.Y);
+		}
+
+		TArray<float> Resampled;
+		Resampled.SetNumUninitialized(NumTiles * TileTexels);
+
+		TArray<bool> ChangedTiles;
+		ChangedTiles.SetNumZeroed(NumTiles);
+
+		ParallelFor(NumTiles, [&](int32 TileIndex)
+		{
+			const FIntPoint Min((TileIndex % NumTilesX) * TileSize, (TileIndex / NumTilesX) * TileSize);
+			const FIntRect Rect(Min, FIntPoint(FMath::Min(Min.X + TileSize, MapSize.X), FMath::Min(Min.Y + TileSize, MapSize.Y)));
+			float* TileValues = &Resampled[TileIndex * TileTexels];
+
+			FVolumetricCloudsWeatherSolver::ResampleRect(Write.Values.GetData(), Write.Size.X, Write.Size.Y, MapSize.X, MapSize.Y, Rect, TileValues, TileSize);
+
+			//Compared with the last written values rather than the canvas, the canvas belongs to the game thread.
+			float MaxDifference = 0.0f;
+
+			for (int32 Y = 0; Y < Rect.Height() && !bWriteAll && MaxDifference <= Write.Threshold; Y++)
+			{
+				const float* WrittenRow = &Written[(Rect.Min.Y + Y) * MapSize.X + Rect.Min.X];
+
+				for (int32 X = 0; X < Rect.Width(); X++)
+				{
+					MaxDifference = FMath::Max(MaxDifference, FMath::Abs(TileValues[Y * TileSize + X] - WrittenRow[X]));
+				}
+			}
+
+			if (!bWriteAll && MaxDifference <= Write.Threshold)
+			{
+				return;
+			}
+
+			for (int32 Y = 0; Y < Rect.Height(); Y++)
+			{
+				FMemory::Memcpy(&Written[(Rect.Min.Y + Y) * MapSize.X + Rect.Min.X], TileValues + Y * TileSize, Rect.Width() * sizeof(float));
+			}
+
+			ChangedTiles[TileIndex] = true;
+		});
+
+		for (int32 TileIndex = 0; TileIndex < NumTiles; TileIndex++)
+		{
+			if (ChangedTiles[TileIndex])
+			{
+				Write.TileIndices.Add(TileIndex);
+				Write.TileValues.Append(&Resampled[TileIndex * TileTexels], TileTexels);
+			}
+		}
+	}
+
+	/** Channel of a wrapped weather map texel. */
+	FORCEINLINE float GetChannel(const FVolumetricCloudsTiledImage& Image, int32 Channel, int32 X, int32 Y)
+	{
+		X = ((X % Image.GetSizeX()) + Image.GetSizeX()) % Image.GetSizeX();
+		Y = ((Y % Image.GetSizeY()) + Image.GetSizeY()) % Image.GetSizeY();
+
+		const FFloat16Color* TileData = Image.GetTileData(Image.GetTileIndex(X, Y));
+		const FFloat16Color& Texel = TileData[(Y % FVolumetricCloudsTiledImage::TileSize) * FVolumetricCloudsTiledImage::TileSize + X % FVolumetricCloudsTiledImage::TileSize];
+
+		return (&Texel.R)[Channel].GetFloat();
+	}
+}
+
+/**
+* Weather map state, owned by the game thread. The render thread only receives packed tile uploads.
+*/
+class FVolumetricCloudsWeatherMapState
+{
+public:
+	/** Stamps waiting for the next apply. */
+	TArray<FVolumetricCloudsStamp> PendingStamps;
+
+	/** Copy of the queued stamps for a game thread consumer, only filled while bLogStamps is set. */
+	TArray<FVolumetricCloudsStamp> StampLog;
+	bool bLogStamps = false;
+
+	/** Weather map texels. */
+	FVolumetricCloudsCanvas Canvas;
+
+	/** Filter brushes with their scratch buffers. */
+	FVolumetricCloudsFilterBrush FilterBrush;
+
+	/** Tiles resolved since the weather map was created, they differ from the cooked weather map. */
+	TBitArray<> ModifiedTiles;
+
+	/** Cooked texels of the modified tiles, captured before their first change so they can be reverted. */
+	TMap<int32, TArray<FFloat16Color>> CookedTiles;
+
+	/** Render target the canvas is uploaded to. */
+	FTextureRenderTargetResource* RenderTargetResource = nullptr;
+
+	/** Channel write resampling on a worker thread, its tiles are applied by the first tick after it finished. */
+	TFuture<TSharedPtr<FVolumetricCloudsChannelWrite, ESPMode::ThreadSafe>> PendingWrite;
+
+	/** Values of the last write per channel, the next write of a channel only sends tiles that differ from them. */
+	TSharedPtr<TArray<float>, ESPMode::ThreadSafe> WrittenChannels[4];
+
+	/** Apply the tiles of the pending channel write, waits for the worker if it's still running. */
+	void FinishPendingWrite();
+
+	/** Forget the written channels after tiles were replaced, the next write of every channel writes every tile. */
+	void ResetWrittenChannels();
+
+	/** Apply all queued stamps, then resolve and upload every dirty tile. */
+	void ApplyPendingStamps();
+
+	/** Revert modified tiles to the cooked weather map and upload them.
+	* @param KeepTiles - modified tiles that stay as they are, they're about to be replaced anyway.
+	*/
+	void RevertModifiedTiles(const TArray<int32>& KeepTiles);
+
+	/** Canvas and cooked tile memory in bytes. */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** Resolve the dirty tiles and send them to the render target in one render command.
+	* @param bRuntimeChange - resolved tiles differ from the cooked weather map.
+	*/
+	void UploadDirtyTiles(bool bRuntimeChange);
+};
+
+void FVolumetricCloudsWeatherMapState::ApplyPendingStamps()
+{
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::WeatherMap);
+	SCOPE_CYCLE_COUNTER(STAT_VolumetricCloudsWeatherMapApply);
+
+	for (const FVolumetricCloudsStamp& Stamp : PendingStamps)
+	{
+		if (Stamp.Brush.Tool == EVolumetricCloudsBrushTool::Paint)
+		{
+			Canvas.Stamp(Stamp.Brush, Stamp.UV);
+		}
+		else
+		{
+			FilterBrush.Apply(Canvas, Stamp.Brush, Stamp.UV, Stamp.PreviousUV);
+		}
+	}
+
+	PendingStamps.Reset();
+
+	UploadDirtyTiles(true);
+}
+
+void FVolumetricCloudsWeatherMapState::FinishPendingWrite()
+{
+	if (!PendingWrite.IsValid())
+	{
+		return;
+	}
+
+	TSharedPtr<FVolumetricCloudsChannelWrite, ESPMode::ThreadSafe> Write = PendingWrite.Get();
+	PendingWrite.Reset();
+
+	//Changed tiles are uploaded together with the stamps of the frame.
+	Canvas.SetBaseLayerChannelTiles(Write->Channel, Write->TileIndices, Write->TileValues);
+}
+
+void FVolumetricCloudsWeatherMapState::ResetWrittenChannels()
+{
+	for (TSharedPtr<TArray<float>, ESPMode::ThreadSafe>& Written : WrittenChannels)
+	{
+		Written.Reset();
+	}
+}
+
+void FVolumetricCloudsWeatherMapState::RevertModifiedTiles(const TArray<int32>& KeepTiles)
+{
+	//Stamps and writes made earlier are uploaded as runtime changes first.
+	ApplyPendingStamps();
+
+	TBitArray<> KeepTileMask(false, ModifiedTiles.Num());
+
+	for (int32 TileIndex : KeepTiles)
+	{
+		KeepTileMask[TileIndex] = true;
+	}
+
+	TArray<int32> TileIndices;
+	TArray<FFloat16Color> Texels;
+
+	for (TConstSetBitIterator<> TileItr(ModifiedTiles); TileItr; ++TileItr)
+	{
+		const int32 TileIndex = TileItr.GetIndex();
+
+		if (!KeepTileMask[TileIndex])
+		{
+			TileIndices.Add(TileIndex);
+			Texels.Append(CookedTiles.FindChecked(TileIndex));
+		}
+	}
+
+	if (TileIndices.Num() == 0)
+	{
+		return;
+	}
+
+	Canvas.SetBaseLayerTiles(TileIndices, Texels);
+	UploadDirtyTiles(false);
+
+	for (int32 TileIndex : TileIndices)
+	{
+		ModifiedTiles[TileIndex] = false;
+		CookedTiles.Remove(TileIndex);
+	}
+}
+
+void FVolumetricCloudsWeatherMapState::UploadDirtyTiles(bool bRuntimeChange)
+{
+	if (!Canvas.HasDirtyTiles())
+	{
+		return;
+	}
+
+	const FVolumetricCloudsTiledImage& Composite = Canvas.GetComposite();
+
+	if (bRuntimeChange)
+	{
+		//Composite of a tile that was never modified still holds the cooked texels until it's resolved.
+		for (int32 TileIndex : Canvas.GetDirtyTiles())
+		{
+			if (!ModifiedTiles[TileIndex])
+			{
+				CookedTiles.Add(TileIndex).Append(Composite.GetTileData(TileIndex), FVolumetricCloudsTiledImage::TileTexels);
+
+				ModifiedTiles[TileIndex] = true;
+			}
+		}
+	}
+
+	TArray<int32> ResolvedTiles;
+	Canvas.Resolve(&ResolvedTiles);
+
+	if (RenderTargetResource == nullptr)
+	{
+		return;
+	}
+
+	//Composite is stored in the render target format, tiles are only packed into rows.
+	ResolvedTiles.Sort();
+
+	FVolumetricCloudsTileUpload Upload;
+	int32 First = 0;
+
+	while (First < ResolvedTiles.Num())
+	{
+		int32 Last = First;
+
+		while (Last + 1 < ResolvedTiles.Num() && ResolvedTiles[Last + 1] == ResolvedTiles[Last] + 1 && ResolvedTiles[Last + 1] % Composite.GetNumTilesX() != 0)
+		{
+			Last++;
+		}
+
+		const FIntRect Rect(Composite.GetTileRect(ResolvedTiles[First]).Min, Composite.GetTileRect(ResolvedTiles[Last]).Max);
+		const int32 Offset = Upload.Texels.AddUninitialized(Rect.Area());
+
+		Upload.Regions.Add(FUpdateTextureRegion2D(Rect.Min.X, Rect.Min.Y, 0, 0, Rect.Width(), Rect.Height()));
+		Upload.Offsets.Add(Offset);
+
+		for (int32 Index = First; Index <= Last; Index++)
+		{
+			const FIntRect TileRect = Composite.GetTileRect(ResolvedTiles[Index]);
+			const FFloat16Color* TileData = Composite.GetTileData(ResolvedTiles[Index]);
+
+			for (int32 Y = 0; Y < TileRect.Height(); Y++)
+			{
+				FMemory::Memcpy(&Upload.Texels[Offset + Y * Rect.Width() + TileRect.Min.X - Rect.Min.X], TileData + Y * FVolumetricCloudsTiledImage::TileSize, TileRect.Width() * sizeof(FFloat16Color));
+			}
+		}
+
+		First = Last + 1;
+	}
+
+	//Uploads are enqueued before the render target can be released, it's destroyed together with the weather map.
+	ENQUEUE_RENDER_COMMAND(VolumetricCloudsUploadTiles)(
+		[Resource = RenderTargetResource, Upload = MoveTemp(Upload)](FRHICommandListImmediate& RHICmdList)
+	{
+		FTexture2DRHIRef Texture = Resource->GetRenderTargetTexture();
+
+		if (!Texture.IsValid())
+		{
+			return;
+		}
+
+		for (int32 Index = 0; Index < Upload.Regions.Num(); Index++)
+		{
+			const FUpdateTextureRegion2D& Region = Upload.Regions[Index];
+			RHIUpdateTexture2D(Texture, 0, Region, Region.Width * sizeof(FFloat16Color), (const uint8*)&Upload.Texels[Upload.Offsets[Index]]);
+		}
+	});
+}
+
+SIZE_T FVolumetricCloudsWeatherMapState::GetAllocatedSize() const
+{
+	SIZE_T Size = Canvas.GetAllocatedSize() + CookedTiles.Num() * FVolumetricCloudsTiledImage::TileTexels * sizeof(FFloat16Color);
+
+	//Written values may be resized by a running write, each one holds a weather map size channel once it was written.
+	for (const TSharedPtr<TArray<float>, ESPMode::ThreadSafe>& Written : WrittenChannels)
+	{
+		Size += Written.IsValid() ? Canvas.GetSizeX() * Canvas.GetSizeY() * sizeof(float) : 0;
+	}
+
+	return Size;
+}
+
+UVolumetricCloudsWeatherMap* UVolumetricCloudsWeatherMap::Get(UWorld* World)
+{
+	check(IsInGameThread());
+
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (UVolumetricCloudsWeatherMap* WeatherMap = Cast<UVolumetricCloudsWeatherMap>(Object))
+		{
+			return WeatherMap->IsValid() ? WeatherMap : nullptr;
+		}
+	}
+
+	//Weather map is cached even if there are no clouds, so the world is only searched once.
+	UVolumetricCloudsWeatherMap* WeatherMap = NewObject<UVolumetricCloudsWeatherMap>(World);
+	World->PerModuleDataObjects.Add(WeatherMap);
+
+	for (TActorIterator<AStaticMeshActor> StaticMeshItr(World); StaticMeshItr; ++StaticMeshItr)
+	{
+		if (StaticMeshItr->GetClass()->GetFName() == "VolumetricClouds_C")
+		{
+			return WeatherMap->Init(*StaticMeshItr) ? WeatherMap : nullptr;
+		}
+	}
+
+	return nullptr;
+}
+
+UVolumetricCloudsWeatherMap* UVolumetricCloudsWeatherMap::Find(UWorld* World)
+{
+	check(IsInGameThread());
+
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (UVolumetricCloudsWeatherMap* WeatherMap = Cast<UVolumetricCloudsWeatherMap>(Object))
+		{
+			return WeatherMap->IsValid() ? WeatherMap : nullptr;
+		}
+	}
+
+	return nullptr;
+}
+
+bool UVolumetricCloudsWeatherMap::Init(AStaticMeshActor* CloudsActor)
+{
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::WeatherMap);
+
+	UStaticMeshComponent* MeshComponent = CloudsActor->GetStaticMeshComponent();
+	UMaterialInterface* CloudsMaterial = MeshComponent != nullptr ? MeshComponent->GetMaterial(0) : nullptr;
+	UTexture* TempTexturePointer = nullptr;
+
+	if (CloudsMaterial == nullptr || !CloudsMaterial->GetTextureParameterValue(FMaterialParameterInfo("WeatherMap"), TempTexturePointer))
+	{
+		UE_LOG(LogVolumetricCloudsWeatherMap, Warning, TEXT("%s has no weather map, runtime stamps are ignored."), *CloudsActor->GetName());
+		return false;
+	}
+
+	UTexture2D* WeatherMapTexture = Cast<UTexture2D>(TempTexturePointer);
+
+	if (WeatherMapTexture == nullptr || WeatherMapTexture->Resource == nullptr)
+	{
+		UE_LOG(LogVolumetricCloudsWeatherMap, Warning, TEXT("Weather map of %s is not a loaded 2D texture, runtime stamps are ignored."), *CloudsActor->GetName());
+		return false;
+	}
+
+	//Same mapping the painter uses, weather map repeats every WeatherMapSize * 1000000 units.
+	float WeatherMapSize = 0.0f;
+	CloudsMaterial->GetScalarParameterValue(FMaterialParameterInfo("WeatherMapSize"), WeatherMapSize);
+	RepeatSize = FMath::Max(WeatherMapSize * 1000000.0f, 1.0f);
+
+	const int32 SizeX = WeatherMapTexture->GetSizeX();
+	const int32 SizeY = WeatherMapTexture->GetSizeY();
+
+	RenderTarget = NewObject<UTextureRenderTarget2D>(this);
+	RenderTarget->InitCustomFormat(SizeX, SizeY, PF_FloatRGBA, true);
+
+	FTextureRenderTargetResource* RenderTargetResource = RenderTarget->GameThread_GetRenderTargetResource();
+	UWorld* World = CloudsActor->GetWorld();
+
+	//Cooked weather map is compressed and has no source data, drawing it to the render target is the only way to read it.
+	FCanvas Canvas(RenderTargetResource, nullptr, World, World->FeatureLevel);
+	Canvas.DrawTile(0.0f, 0.0f, SizeX, SizeY, 0.0f, 0.0f, 1.0f, 1.0f, FLinearColor::White, WeatherMapTexture->Resource, false);
+	Canvas.Flush_GameThread(true);
+
+	TArray<FFloat16Color> Texels;
+
+	if (!RenderTargetResource->ReadFloat16Pixels(Texels) || Texels.Num() != SizeX * SizeY)
+	{
+		UE_LOG(LogVolumetricCloudsWeatherMap, Warning, TEXT("Failed to read weather map %s, runtime stamps are ignored."), *WeatherMapTexture->GetName());
+		return false;
+	}
+
+	State = MakeShared<FVolumetricCloudsWeatherMapState>();
+	State->Canvas.Init(SizeX, SizeY, Texels.GetData());
+
+	//Render target already shows the cooked weather map, so every later resolve is a runtime change.
+	State->Canvas.Resolve();
+	State->ModifiedTiles.Init(false, State->Canvas.GetComposite().GetNumTiles());
+	State->RenderTargetResource = RenderTargetResource;
+
+	Material = MeshComponent->CreateDynamicMaterialInstance(0);
+	Material->SetTextureParameterValue(FName("WeatherMap"), RenderTarget);
+
+	return true;
+}
+
+void UVolumetricCloudsWeatherMap::Stamp(const FVolumetricCloudsBrush& Brush, const FVector2D& UV, const FVector2D& PreviousUV)
+{
+	check(IsInGameThread());
+
+	if (!State.IsValid())
+	{
+		return;
+	}
+
+	FVolumetricCloudsStamp NewStamp;
+	NewStamp.Brush = Brush;
+	NewStamp.UV = UV;
+	NewStamp.PreviousUV = PreviousUV;
+
+	State->PendingStamps.Add(NewStamp);
+
+	if (State->bLogStamps)
+	{
+		State->StampLog.Add(NewStamp);
+	}
+}
+
+void UVolumetricCloudsWeatherMap::SetStampLogEnabled(bool bEnabled)
+{
+	check(IsInGameThread());
+
+	if (State.IsValid())
+	{
+		State->bLogStamps = bEnabled;
+
+		if (!bEnabled)
+		{
+			State->StampLog.Empty();
+		}
+	}
+}
+
+void UVolumetricCloudsWeatherMap::TakeStampLog(TArray<FVolumetricCloudsStamp>& OutStamps)
+{
+	check(IsInGameThread());
+
+	OutStamps.Reset();
+
+	if (State.IsValid())
+	{
+		Swap(OutStamps, State->StampLog);
+	}
+}
+
+void UVolumetricCloudsWeatherMap::WriteChannel(int32 Channel, TArray<float>&& Values, int32 SizeX, int32 SizeY, float Threshold)
+{
+	check(IsInGameThread());
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::WeatherMap);
+
+	if (!State.IsValid() || Channel < 0 || Channel >= 4 || Values.Num() != SizeX * SizeY)
+	{
+		return;
+	}
+
+	//Readers of the revision have to refresh just like after stamps.
+	Revision++;
+	WriteRevision++;
+
+	//Writes land in order, a write interval shorter than the resample only waits for the previous one.
+	State->FinishPendingWrite();
+
+	TSharedPtr<TArray<float>, ESPMode::ThreadSafe>& Written = State->WrittenChannels[Channel];
+
+	if (!Written.IsValid())
+	{
+		Written = MakeShared<TArray<float>, ESPMode::ThreadSafe>();
+	}
+
+	TSharedPtr<FVolumetricCloudsChannelWrite, ESPMode::ThreadSafe> Write = MakeShared<FVolumetricCloudsChannelWrite, ESPMode::ThreadSafe>();
+	Write->Channel = Channel;
+	Write->Threshold = Threshold;
+	Write->Values = MoveTemp(Values);
+	Write->Size = FIntPoint(SizeX, SizeY);
+	Write->MapSize = FIntPoint(State->Canvas.GetSizeX(), State->Canvas.GetSizeY());
+	Write->Written = Written;
+
+	//Resampling and comparing the whole weather map stays off the game thread, only changed tiles come back.
+	State->PendingWrite = Async(EAsyncExecution::ThreadPool, [Write]()
+	{
+		VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::WeatherMap);
+
+		VolumetricCloudsWeatherMap::ResampleChangedTiles(*Write);
+		return Write;
+	});
+}
+
+bool UVolumetricCloudsWeatherMap::ReadChannel(int32 Channel, TArray<float>& OutValues, int32 SizeX, int32 SizeY)
+{
+	check(IsInGameThread());
+
+	if (!State.IsValid() || Channel < 0 || Channel >= 4 || SizeX <= 0 || SizeY <= 0)
+	{
+		return false;
+	}
+
+	//Applying first uploads the dirty tiles, so reading the composite doesn't resolve them behind the upload's back.
+	State->FinishPendingWrite();
+	State->ApplyPendingStamps();
+
+	const FVolumetricCloudsTiledImage& Composite = State->Canvas.GetComposite();
+	const float ScaleX = float(Composite.GetSizeX()) / SizeX;
+	const float ScaleY = float(Composite.GetSizeY()) / SizeY;
+
+	OutValues.SetNumUninitialized(SizeX * SizeY);
+
+	//Composite is sampled at the requested size directly, same filter as FVolumetricCloudsWeatherSolver::Resample.
+	ParallelFor(SizeY, [&](int32 Y)
+	{
+		const float SourceY = (Y + 0.5f) * ScaleY - 0.5f;
+		const int32 Y0 = FMath::FloorToInt(SourceY);
+		const float FracY = SourceY - Y0;
+
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			const float SourceX = (X + 0.5f) * ScaleX - 0.5f;
+			const int32 X0 = FMath::FloorToInt(SourceX);
+			const float FracX = SourceX - X0;
+
+			const float Top = FMath::Lerp(VolumetricCloudsWeatherMap::GetChannel(Composite, Channel, X0, Y0), VolumetricCloudsWeatherMap::GetChannel(Composite, Channel, X0 + 1, Y0), FracX);
+			const float Bottom = FMath::Lerp(VolumetricCloudsWeatherMap::GetChannel(Composite, Channel, X0, Y0 + 1), VolumetricCloudsWeatherMap::GetChannel(Composite, Channel, X0 + 1, Y0 + 1), FracX);
+
+			OutValues[Y * SizeX + X] = FMath::Lerp(Top, Bottom, FracY);
+		}
+	});
+
+	return true;
+}
+
+bool UVolumetricCloudsWeatherMap::ReadModifiedTiles(FVolumetricCloudsWeatherMapTiles& OutTiles)
+{
+	check(IsInGameThread());
+
+	if (!State.IsValid())
+	{
+		return false;
+	}
+
+	State->FinishPendingWrite();
+	State->ApplyPendingStamps();
+
+	const FVolumetricCloudsTiledImage& Composite = State->Canvas.GetComposite();
+
+	OutTiles.Size = FIntPoint(Composite.GetSizeX(), Composite.GetSizeY());
+	OutTiles.TileIndices.Reset();
+
+	for (TConstSetBitIterator<> TileItr(State->ModifiedTiles); TileItr; ++TileItr)
+	{
+		OutTiles.TileIndices.Add(TileItr.GetIndex());
+	}
+
+	OutTiles.Texels.SetNumUninitialized(OutTiles.TileIndices.Num() * FVolumetricCloudsTiledImage::TileTexels);
+
+	for (int32 Index = 0; Index < OutTiles.TileIndices.Num(); Index++)
+	{
+		FMemory::Memcpy(&OutTiles.Texels[Index * FVolumetricCloudsTiledImage::TileTexels], Composite.GetTileData(OutTiles.TileIndices[Index]), FVolumetricCloudsTiledImage::TileTexels * sizeof(FFloat16Color));
+	}
+
+	return true;
+}
+
+bool UVolumetricCloudsWeatherMap::WriteTiles(FVolumetricCloudsWeatherMapTiles&& Tiles, bool bRevertOtherTiles)
+{
+	check(IsInGameThread());
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::WeatherMap);
+
+	if (!State.IsValid() || Tiles.Size != FIntPoint(State->Canvas.GetSizeX(), State->Canvas.GetSizeY())
+		|| Tiles.Texels.Num() != Tiles.TileIndices.Num() * FVolumetricCloudsTiledImage::TileTexels)
+	{
+		return false;
+	}
+
+	const int32 NumTiles = State->Canvas.GetComposite().GetNumTiles();
+
+	for (int32 TileIndex : Tiles.TileIndices)
+	{
+		if (TileIndex < 0 || TileIndex >= NumTiles)
+		{
+			return false;
+		}
+	}
+
+	//Readers of the revision, e.g. the weather simulation, pick the tiles up like painted stamps.
+	Revision++;
+	WriteRevision++;
+
+	//A write still resampling would land on top of the new tiles.
+	State->FinishPendingWrite();
+
+	if (bRevertOtherTiles)
+	{
+		State->RevertModifiedTiles(Tiles.TileIndices);
+	}
+
+	State->Canvas.SetBaseLayerTiles(Tiles.TileIndices, Tiles.Texels);
+	State->ResetWrittenChannels();
+
+	return true;
+}
+
+void UVolumetricCloudsWeatherMap::RevertModifiedTiles()
+{
+	check(IsInGameThread());
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::WeatherMap);
+
+	if (!State.IsValid())
+	{
+		return;
+	}
+
+	Revision++;
+	WriteRevision++;
+
+	State->FinishPendingWrite();
+	State->RevertModifiedTiles(TArray<int32>());
+	State->ResetWrittenChannels();
+}
+
+void UVolumetricCloudsWeatherMap::CollectMemory(FVolumetricCloudsMemoryReport& Report) const
+{
+	if (State.IsValid())
+	{
+		Report.AddTexture(EVolumetricCloudsMemorySystem::WeatherMap, RenderTarget);
+		Report.AddBytes(EVolumetricCloudsMemorySystem::WeatherMap, State->GetAllocatedSize());
+	}
+}
+
+FVector2D UVolumetricCloudsWeatherMap::GetUV(const FVector& Location) const
+{
+	const FVector2D UV = (FVector2D(Location.X, Location.Y) + RepeatSize / 2.0f) / RepeatSize;
+
+	return FVector2D(FMath::Frac(UV.X), FMath::Frac(UV.Y));
+}
+
+float UVolumetricCloudsWeatherMap::GetBrushRadius(float WorldRadius) const
+{
+	//Brush radius is a UV radius divided by 2.
+	return 2.0f * WorldRadius / RepeatSize;
+}
+
+void UVolumetricCloudsWeatherMap::Tick(float DeltaTime)
+{
+	if (State->PendingWrite.IsReady())
+	{
+		State->FinishPendingWrite();
+	}
+
+	if (State->PendingStamps.Num() == 0 && !State->Canvas.HasDirtyTiles())
+	{
+		return;
+	}
+
+	//Writes already counted, stamps are counted when they're applied.
+	if (State->PendingStamps.Num() > 0)
+	{
+		Revision++;
+	}
+
+	//Stamps and writes of a frame are applied together and sent to the render target in a single upload.
+	State->ApplyPendingStamps();
+}
+
+bool UVolumetricCloudsWeatherMap::IsTickable() const
+{
+	return State.IsValid() && !IsTemplate();
+}
+
+TStatId UVolumetricCloudsWeatherMap::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UVolumetricCloudsWeatherMap, STATGROUP_Tickables);
+}
+
+void UVolumetricCloudsWeatherMap::BeginDestroy()
+{
+	//State is only used on the game thread, enqueued uploads own their texels and a running write owns its values.
+	State.Reset();
+
+	Super::BeginDestroy();
+}
@@ -0,0 +1,27 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsWeatherMapLibrary.h"
+#include "VolumetricCloudsWeatherMap.h"
+#include "Engine/Engine.h"
+
+void UVolumetricCloudsWeatherMapLibrary::StampWeatherMap(const UObject* WorldContextObject, FVector Location, float Radius, float Falloff, float Strength, FLinearColor Color, FLinearColor ChannelMask, bool bAdditive)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	UVolumetricCloudsWeatherMap* WeatherMap = UVolumetricCloudsWeatherMap::Get(World);
+
+	if (WeatherMap == nullptr)
+	{
+		return;
+	}
+
+	FVolumetricCloudsBrush Brush;
+	Brush.Radius = WeatherMap->GetBrushRadius(Radius);
+	Brush.Falloff = Falloff;
+	//Painter scales opacity per stamp, gameplay stamps are single events.
+	Brush.Opacity = Strength * 10.0f;
+	Brush.Color = Color;
+	Brush.ChannelMask = ChannelMask;
+	Brush.bAdditive = bAdditive;
+
+	WeatherMap->Stamp(Brush, WeatherMap->GetUV(Location));
+}
@@ -0,0 +1,285 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "VolumetricCloudsWeatherSimulation.h"
+#include "VolumetricCloudsWeatherMap.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Weather Simulation Step"), STAT_VolumetricCloudsWeatherStep, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("Weather Simulation Stamp Replay"), STAT_VolumetricCloudsWeatherReplay, STATGROUP_Game);
+DECLARE_CYCLE_STAT(TEXT("Weather Simulation Write"), STAT_VolumetricCloudsWeatherWrite, STATGROUP_Game);
+
+UVolumetricCloudsWeatherSimulation::UVolumetricCloudsWeatherSimulation()
+	: bEnabled(false)
+	, Channel(0)
+	, InitialCoverage(0.5f)
+	, WriteInterval(0.25f)
+	, WriteThreshold(1.0f / 255.0f)
+	, MaxStepsPerFrame(4)
+	, WeatherMap(nullptr)
+	, WrittenRevision(0)
+	, PendingTime(0.0f)
+	, TimeSinceWrite(0.0f)
+	, bInitialized(false)
+{
+	const FVolumetricCloudsWeatherSolverSettings Defaults;
+	Size = Defaults.Size;
+	WindSize = Defaults.WindSize;
+	TimeStep = Defaults.TimeStep;
+	PrevailingWind = Defaults.PrevailingWind;
+	Turbulence = Defaults.Turbulence;
+	WindRelax = Defaults.WindRelax;
+	Diffusion = Defaults.Diffusion;
+	SourceRelax = Defaults.SourceRelax;
+	Seed = Defaults.Seed;
+}
+
+UVolumetricCloudsWeatherSimulation* UVolumetricCloudsWeatherSimulation::Get(UWorld* World)
+{
+	check(IsInGameThread());
+
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (UVolumetricCloudsWeatherSimulation* Simulation = Cast<UVolumetricCloudsWeatherSimulation>(Object))
+		{
+			return Simulation;
+		}
+	}
+
+	UVolumetricCloudsWeatherSimulation* Simulation = NewObject<UVolumetricCloudsWeatherSimulation>(World);
+	World->PerModuleDataObjects.Add(Simulation);
+
+	return Simulation;
+}
+
+void UVolumetricCloudsWeatherSimulation::Init()
+{
+	bInitialized = true;
+
+	FVolumetricCloudsWeatherSolverSettings Settings;
+	Settings.Size = Size;
+	Settings.WindSize = WindSize;
+	Settings.TimeStep = FMath::Max(TimeStep, KINDA_SMALL_NUMBER);
+	Settings.PrevailingWind = PrevailingWind;
+	Settings.Turbulence = Turbulence;
+	Settings.WindRelax = WindRelax;
+	Settings.Diffusion = Diffusion;
+	Settings.SourceRelax = SourceRelax;
+	Settings.Seed = Seed;
+
+	Solver.Init(Settings, nullptr);
+
+	WeatherMap = UVolumetricCloudsWeatherMap::Get(GetWorld());
+
+	if (WeatherMap != nullptr)
+	{
+		WeatherMap->SetStampLogEnabled(true);
+	}
+
+	TArray<float> Values;
+
+	if (!ReadWeatherMap(Values))
+	{
+		Values.Init(InitialCoverage, Solver.GetSize() * Solver.GetSize());
+	}
+
+	Solver.Reset(Values.GetData());
+}
+
+void UVolumetricCloudsWeatherSimulation::SetPrevailingWind(const FVector2D& Wind)
+{
+	PrevailingWind = Wind;
+
+	if (bInitialized)
+	{
+		Solver.SetPrevailingWind(Wind);
+	}
+}
+
+bool UVolumetricCloudsWeatherSimulation::ReadWeatherMap(TArray<float>& OutValues)
+{
+	if (WeatherMap == nullptr)
+	{
+		return false;
+	}
+
+	//Stamps logged so far are part of the read.
+	TArray<FVolumetricCloudsStamp> Stamps;
+	WeatherMap->TakeStampLog(Stamps);
+
+	//Sampled at the solver size, the full size channel is never copied out.
+	if (!WeatherMap->ReadChannel(Channel, OutValues, Solver.GetSize(), Solver.GetSize()))
+	{
+		return false;
+	}
+
+	WrittenRevision = WeatherMap->GetWriteRevision();
+
+	return true;
+}
+
+void UVolumetricCloudsWeatherSimulation::Tick(float DeltaTime)
+{
+	if (!bInitialized)
+	{
+		Init();
+	}
+
+	//Fixed steps of game time, replaying the same frame times gives the same weather.
+	const float Step = FMath::Max(TimeStep, KINDA_SMALL_NUMBER);
+	PendingTime = FMath::Min(PendingTime + DeltaTime, Step * MaxStepsPerFrame);
+
+	bool bStepped = false;
+
+	while (PendingTime >= Step)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_VolumetricCloudsWeatherStep);
+
+		Solver.Step();
+		PendingTime -= Step;
+		bStepped = true;
+	}
+
+	TimeSinceWrite += DeltaTime;
+
+	if (WeatherMap == nullptr || !WeatherMap->IsValid() || !bStepped || TimeSinceWrite < WriteInterval)
+	{
+		return;
+	}
+
+	TimeSinceWrite = 0.0f;
+	WriteWeatherMap();
+}
+
+void UVolumetricCloudsWeatherSimulation::WriteWeatherMap()
+{
+	//Stamps painted since the last write become the new source, otherwise the write would erase them.
+	if (WeatherMap->GetWriteRevision() != WrittenRevision)
+	{
+		//Tiles were loaded or reverted, only reading the weather map back picks them up.
+		TArray<float> Values;
+
+		if (ReadWeatherMap(Values))
+		{
+			Solver.Reset(Values.GetData());
+		}
+	}
+	else
+	{
+		TArray<FVolumetricCloudsStamp> Stamps;
+		WeatherMap->TakeStampLog(Stamps);
+
+		if (Stamps.Num() > 0)
+		{
+			ReplayStamps(Stamps);
+		}
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_VolumetricCloudsWeatherWrite);
+
+	TArray<float> Values = Solver.GetMoisture();
+	WeatherMap->WriteChannel(Channel, MoveTemp(Values), Solver.GetSize(), Solver.GetSize(), WriteThreshold);
+	WrittenRevision = WeatherMap->GetWriteRevision();
+}
+
+void UVolumetricCloudsWeatherSimulation::ReplayStamps(const TArray<FVolumetricCloudsStamp>& Stamps)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VolumetricCloudsWeatherReplay);
+
+	const int32 SolverSize = Solver.GetSize();
+	TArray<float> Values = Solver.GetMoisture();
+
+	if (!StampCanvas.IsValid() || StampCanvas.GetSizeX() != SolverSize)
+	{
+		TArray<FLinearColor> Texels;
+		Texels.Init(FLinearColor(0.0f, 0.0f, 0.0f, 0.0f), SolverSize * SolverSize);
+		StampCanvas.Init(SolverSize, SolverSize, Texels.GetData());
+	}
+
+	//Brush radius is in UV space, so stamps cover the same area on the solver grid as on the weather map.
+	StampCanvas.SetBaseLayerChannel(Channel, Values.GetData());
+	StampCanvas.Resolve();
+
+	for (const FVolumetricCloudsStamp& Stamp : Stamps)
+	{
+		if (Stamp.Brush.Tool == EVolumetricCloudsBrushTool::Paint)
+		{
+			StampCanvas.Stamp(Stamp.Brush, Stamp.UV);
+		}
+		else
+		{
+			FilterBrush.Apply(StampCanvas, Stamp.Brush, Stamp.UV, Stamp.PreviousUV);
+		}
+	}
+
+	//Only tiles under the stamps changed.
+	const FVolumetricCloudsTiledImage& Base = StampCanvas.GetLayer(0).Values;
+
+	for (int32 TileIndex : StampCanvas.GetDirtyTiles())
+	{
+		const FIntRect Rect = Base.GetTileRect(TileIndex);
+		const FFloat16Color* TileData = Base.GetTileData(TileIndex);
+
+		for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+		{
+			for (int32 X = Rect.Min.X; X < Rect.Max.X; X++)
+			{
+				Values[Y * SolverSize + X] = (&TileData[(Y - Rect.Min.Y) * FVolumetricCloudsTiledImage::TileSize + (X - Rect.Min.X)].R)[Channel].GetFloat();
+			}
+		}
+	}
+
+	StampCanvas.Resolve();
+	Solver.Reset(Values.GetData());
+}
+
+void UVolumetricCloudsWeatherSimulation::Advance(float Seconds, int32 MaxSteps)
+{
+	if (!bEnabled || Seconds <= 0.0f)
+	{
+		return;
+	}
+
+	if (!bInitialized)
+	{
+		Init();
+	}
+
+	//Steps are as long as the wind allows, a semi-Lagrangian step of hours would sample the weather at random.
+	const float NumStableSteps = FMath::CeilToFloat(Seconds / FMath::Max(Solver.GetMaxStableTimeStep(), KINDA_SMALL_NUMBER));
+
+	if (NumStableSteps > FMath::Max(MaxSteps, 1))
+	{
+		//Wind would carry the weather around the map many times over, only the climate it relaxes to is left.
+		SCOPE_CYCLE_COUNTER(STAT_VolumetricCloudsWeatherStep);
+
+		Solver.Settle(Seconds);
+	}
+	else
+	{
+		const int32 NumSteps = FMath::Max(int32(NumStableSteps), 1);
+
+		for (int32 StepIndex = 0; StepIndex < NumSteps; StepIndex++)
+		{
+			SCOPE_CYCLE_COUNTER(STAT_VolumetricCloudsWeatherStep);
+
+			Solver.Step(Seconds / NumSteps);
+		}
+	}
+
+	TimeSinceWrite = WriteInterval;
+}
+
+bool UVolumetricCloudsWeatherSimulation::IsTickable() const
+{
+	return bEnabled && !IsTemplate() && GetWorld() != nullptr && GetWorld()->IsGameWorld();
+}
+
+TStatId UVolumetricCloudsWeatherSimulation::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UVolumetricCloudsWeatherSimulation, STATGROUP_Tickables);
+}
@@ -0,0 +1,105 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "VolumetricCloudsMemory.h"
+
+#include "VolumetricCloudsMemoryReport.generated.h"
+
+class AActor;
+class UTexture;
+
+/** Memory budget of a single system. */
+USTRUCT()
+struct FVolumetricCloudsMemoryBudget
+{
+	GENERATED_BODY()
+
+	/** System name, see GetVolumetricCloudsMemorySystemName. */
+	UPROPERTY(Config)
+	FName System;
+
+	/** Budget in megabytes. */
+	UPROPERTY(Config)
+	float BudgetMB = 0.0f;
+};
+
+/**
+* Budgets and actor classes of the environment memory report, [/Script/VolumetricCloudsPainterRuntime.VolumetricCloudsMemorySettings] in Game.ini.
+*/
+UCLASS(Config = Game)
+class VOLUMETRICCLOUDSPAINTERRUNTIME_API UVolumetricCloudsMemorySettings : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UVolumetricCloudsMemorySettings();
+
+	/** Per system budgets, systems without a budget are reported only. */
+	UPROPERTY(Config)
+	TArray<FVolumetricCloudsMemoryBudget> Budgets;
+
+	/** Actor class names of the clouds. */
+	UPROPERTY(Config)
+	TArray<FName> CloudClasses;
+
+	/** Actor class names of the sky. */
+	UPROPERTY(Config)
+	TArray<FName> SkyClasses;
+
+	/** Actor class names of the weather effects. */
+	UPROPERTY(Config)
+	TArray<FName> WeatherEffectClasses;
+
+	/** Budget of a system in bytes, 0 if it has none. */
+	int64 GetBudget(EVolumetricCloudsMemorySystem System) const;
+};
+
+/**
+* Per system memory of a world. Textures are counted by their resident size, so the report works in -nullrhi runs
+* where no GPU memory is allocated, and every texture is counted once, by the first system that adds it.
+*
+* VolumetricClouds.MemoryReport prints the report and logs an error for every system over budget.
+*/
+class VOLUMETRICCLOUDSPAINTERRUNTIME_API FVolumetricCloudsMemoryReport
+{
+public:
+	DECLARE_MULTICAST_DELEGATE_TwoParams(FOnCollect, UWorld*, FVolumetricCloudsMemoryReport&);
+
+	/** Collectors of systems outside of this module, called before the runtime systems are collected. */
+	static FOnCollect OnCollect;
+
+	/** Collect every system of a world.
+	* @param World - world to collect actors and weather map of.
+	*/
+	void Collect(UWorld* World);
+
+	/** Add CPU memory of a system. */
+	void AddBytes(EVolumetricCloudsMemorySystem System, int64 Bytes);
+
+	/** Add resident memory of a texture unless it was counted already. */
+	void AddTexture(EVolumetricCloudsMemorySystem System, UTexture* Texture);
+
+	/** Add components and textures used by the primitives of an actor. */
+	void AddActor(EVolumetricCloudsMemorySystem System, AActor* Actor);
+
+	/** Collected bytes of a system. */
+	int64 GetBytes(EVolumetricCloudsMemorySystem System) const { return Bytes[(int32)System]; }
+
+	/** Print the report and log errors for overruns.
+	* @param Ar - device the report is printed to.
+	* @return number of systems over budget.
+	*/
+	int32 Print(FOutputDevice& Ar) const;
+
+private:
+	/** Add actors whose class name is in a list. */
+	void AddActors(EVolumetricCloudsMemorySystem System, UWorld* World, const TArray<FName>& ClassNames);
+
+	int64 Bytes[(int32)EVolumetricCloudsMemorySystem::Count] = {};
+
+	/** Textures counted so far. */
+	TSet<const UTexture*> CountedTextures;
+};
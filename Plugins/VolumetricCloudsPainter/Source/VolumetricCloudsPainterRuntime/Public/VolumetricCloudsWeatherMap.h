@@ -0,0 +1,176 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Tickable.h"
+#include "Math/Float16Color.h"
+#include "VolumetricCloudsBrush.h"
+
+#include "VolumetricCloudsWeatherMap.generated.h"
+
+class AStaticMeshActor;
+class UMaterialInstanceDynamic;
+class UTextureRenderTarget2D;
+class FVolumetricCloudsWeatherMapState;
+class FVolumetricCloudsMemoryReport;
+
+/** Brush stamp waiting to be applied to the weather map. */
+struct FVolumetricCloudsStamp
+{
+	/** Brush parameters, same as the painter brush. */
+	FVolumetricCloudsBrush Brush;
+
+	/** Brush center in a weather map UV space. */
+	FVector2D UV;
+
+	/** Previous brush center, gives smudge stamps their direction. */
+	FVector2D PreviousUV;
+};
+
+/** Tiles of a weather map, e.g. the runtime changes of a saved game. */
+struct FVolumetricCloudsWeatherMapTiles
+{
+	/** Size of the weather map the tiles belong to. */
+	FIntPoint Size = FIntPoint::ZeroValue;
+
+	TArray<int32> TileIndices;
+
+	/** FVolumetricCloudsTiledImage::TileTexels half precision texels per tile, in TileIndices order. */
+	TArray<FFloat16Color> Texels;
+};
+
+/**
+* Runtime weather map of the volumetric clouds actor. The clouds material is switched to a render target that starts
+* as a copy of its weather map. The canvas lives on the game thread, stamps and writes are applied once per frame and
+* the changed tiles are sent to the render target in a single upload. All methods are game thread only unless noted.
+*/
+UCLASS(Transient)
+class VOLUMETRICCLOUDSPAINTERRUNTIME_API UVolumetricCloudsWeatherMap : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Find or create the weather map of a world. Game thread only.
+	* @param World - world with a volumetric clouds actor.
+	* @return weather map or nullptr if the world has no volumetric clouds actor.
+	*/
+	static UVolumetricCloudsWeatherMap* Get(UWorld* World);
+
+	/** Weather map of a world if it was already created by Get. Game thread only.
+	* @param World - world to search.
+	* @return initialized weather map or nullptr.
+	*/
+	static UVolumetricCloudsWeatherMap* Find(UWorld* World);
+
+	/** Queue a brush stamp, it's applied on the next tick. Game thread only.
+	* @param Brush - brush parameters.
+	* @param UV - brush center in a weather map UV space.
+	* @param PreviousUV - previous brush center of a smudge stroke.
+	*/
+	void Stamp(const FVolumetricCloudsBrush& Brush, const FVector2D& UV, const FVector2D& PreviousUV);
+	void Stamp(const FVolumetricCloudsBrush& Brush, const FVector2D& UV) { Stamp(Brush, UV, UV); }
+
+	/** Replace a channel of the weather map, e.g. with a weather simulation. Values are resampled and compared with
+	* the previous write of the channel on a worker thread, only tiles that changed by more than Threshold are written
+	* and uploaded by the first tick after it finished. Game thread only.
+	* @param Channel - channel index, 0 is red.
+	* @param Values - SizeX * SizeY values, resampled to the weather map size.
+	* @param SizeX - width of the values.
+	* @param SizeY - height of the values.
+	* @param Threshold - largest change of a tile that isn't written yet.
+	*/
+	void WriteChannel(int32 Channel, TArray<float>&& Values, int32 SizeX, int32 SizeY, float Threshold = 0.0f);
+
+	/** Read a channel of the weather map with all queued stamps and writes applied, bilinearly sampled at any size.
+	* Doesn't wait for the render thread, game thread only.
+	* @param Channel - channel index, 0 is red.
+	* @param OutValues - SizeX * SizeY values.
+	* @param SizeX - width of the values.
+	* @param SizeY - height of the values.
+	* @return false if the weather map isn't initialized.
+	*/
+	bool ReadChannel(int32 Channel, TArray<float>& OutValues, int32 SizeX, int32 SizeY);
+
+	/** Read every tile that changed since the weather map was created. Doesn't wait for the render thread, game thread only.
+	* @param OutTiles - changed tiles, the same precision the render target stores.
+	* @return false if the weather map isn't initialized.
+	*/
+	bool ReadModifiedTiles(FVolumetricCloudsWeatherMapTiles& OutTiles);
+
+	/** Replace tiles, only the replaced tiles are composed and uploaded. The next channel write writes every tile. Game thread only.
+	* @param Tiles - tiles of a weather map of the same size.
+	* @param bRevertOtherTiles - revert every other modified tile to the cooked weather map, e.g. when loading a save.
+	* @return false if the weather map isn't initialized or has a different size.
+	*/
+	bool WriteTiles(FVolumetricCloudsWeatherMapTiles&& Tiles, bool bRevertOtherTiles = false);
+
+	/** Revert every modified tile to the cooked weather map. Game thread only. */
+	void RevertModifiedTiles();
+
+	/** Weather map UV of a world location, safe to call from any thread. */
+	FVector2D GetUV(const FVector& Location) const;
+
+	/** Brush radius that covers a world space radius, safe to call from any thread. */
+	float GetBrushRadius(float WorldRadius) const;
+
+	/** Is weather map initialized. */
+	bool IsValid() const { return State.IsValid(); }
+
+	/** Incremented on the game thread whenever queued stamps are applied or channels and tiles are written. */
+	uint32 GetRevision() const { return Revision; }
+
+	/** Incremented on the game thread whenever channels or tiles are written or reverted, stamps don't count. */
+	uint32 GetWriteRevision() const { return WriteRevision; }
+
+	/** Keep a copy of every queued stamp for a game thread consumer, e.g. the weather simulation. */
+	void SetStampLogEnabled(bool bEnabled);
+
+	/** Take the stamps logged since the last call. Game thread only.
+	* @param OutStamps - stamps in the order they were queued.
+	*/
+	void TakeStampLog(TArray<FVolumetricCloudsStamp>& OutStamps);
+
+	/** Weather map used by the clouds material, nullptr if not initialized. */
+	UTextureRenderTarget2D* GetRenderTarget() const { return RenderTarget; }
+
+	/** Add render target and canvas memory to a report. */
+	void CollectMemory(FVolumetricCloudsMemoryReport& Report) const;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	// UObject interface
+	virtual void BeginDestroy() override;
+	// End of UObject interface
+
+private:
+	/** Copy weather map of a clouds actor to a render target and switch the clouds material to it.
+	* @param CloudsActor - volumetric clouds actor.
+	*/
+	bool Init(AStaticMeshActor* CloudsActor);
+
+	/** Dynamic instance of the clouds material. */
+	UPROPERTY()
+	UMaterialInstanceDynamic* Material = nullptr;
+
+	/** Weather map used by the clouds material. */
+	UPROPERTY()
+	UTextureRenderTarget2D* RenderTarget = nullptr;
+
+	/** Number of applies enqueued so far. */
+	uint32 Revision = 0;
+
+	/** Number of channel and tile writes enqueued so far. */
+	uint32 WriteRevision = 0;
+
+	/** Weather map repeats every RepeatSize units. */
+	float RepeatSize = 1.0f;
+
+	/** Stamp queue and canvas, game thread only. */
+	TSharedPtr<FVolumetricCloudsWeatherMapState> State;
+};
@@ -0,0 +1,31 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+
+#include "VolumetricCloudsWeatherMapLibrary.generated.h"
+
+/**
+* Blueprint access to the runtime weather map.
+*/
+UCLASS()
+class VOLUMETRICCLOUDSPAINTERRUNTIME_API UVolumetricCloudsWeatherMapLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	/** Queue a painter brush stamp at a world location. Stamps are applied to the clouds weather map at the end of the frame.
+	* @param Location - brush center, only X and Y are used.
+	* @param Radius - brush radius in world units.
+	* @param Falloff - 0 is a hard edge and 1 fades over the whole radius.
+	* @param Strength - value added or removed at the brush center.
+	* @param Color - brush color.
+	* @param ChannelMask - 1 for channels that are painted, 0 for locked ones.
+	* @param bAdditive - add brush color if true, subtract it if false.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Volumetric Clouds", meta = (WorldContext = "WorldContextObject"))
+	static void StampWeatherMap(const UObject* WorldContextObject, FVector Location, float Radius, float Falloff = 1.0f, float Strength = 1.0f,
+		FLinearColor Color = FLinearColor(1.0f, 1.0f, 1.0f, 1.0f), FLinearColor ChannelMask = FLinearColor(1.0f, 0.0f, 0.0f, 0.0f), bool bAdditive = true);
+};
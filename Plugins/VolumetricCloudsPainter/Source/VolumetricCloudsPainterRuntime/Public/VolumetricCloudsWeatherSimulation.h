@@ -0,0 +1,134 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Tickable.h"
+#include "VolumetricCloudsWeatherSolver.h"
+#include "VolumetricCloudsCanvas.h"
+#include "VolumetricCloudsFilterBrush.h"
+
+#include "VolumetricCloudsWeatherSimulation.generated.h"
+
+class UVolumetricCloudsWeatherMap;
+struct FVolumetricCloudsStamp;
+
+/**
+* Runs the CPU wind and moisture solver on the coverage channel of the weather map. The solver steps on a fixed
+* game time step and its moisture is written back to the weather map at WriteInterval. The weather map resamples the
+* write on a worker thread and only tiles that changed by more than WriteThreshold are uploaded. Painted stamps are logged by the weather map and replayed into the solver
+* before the next write, so the weather map is never read back for them. Worlds without a weather map, e.g. on a
+* server without a GPU, simulate from InitialCoverage so gameplay can still query the weather.
+*
+* Step, stamp replay and write costs show up in stat game.
+*/
+UCLASS(Config = Game)
+class VOLUMETRICCLOUDSPAINTERRUNTIME_API UVolumetricCloudsWeatherSimulation : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UVolumetricCloudsWeatherSimulation();
+
+	/** Simulation of a world, created on the first call. Game thread only. */
+	static UVolumetricCloudsWeatherSimulation* Get(UWorld* World);
+
+	/** Simulated coverage at a weather map UV, 0 before the first step. */
+	float GetCoverage(const FVector2D& UV) const { return Solver.SampleMoisture(UV); }
+
+	/** Fast-forward a long span in as few steps as the wind allows without moving moisture by more than a cell
+	* per step. Spans that would need more than MaxSteps aren't advected at all, the moisture only settles towards
+	* its source map. The weather map is written on the next tick, so a warp made of many spans writes it once.
+	* @param Seconds - game seconds to simulate.
+	* @param MaxSteps - most solver steps spent on the span.
+	*/
+	void Advance(float Seconds, int32 MaxSteps);
+
+	/** Change the prevailing wind of a running simulation, e.g. to the wind replicated by the server. */
+	void SetPrevailingWind(const FVector2D& Wind);
+
+	/** Steps simulated since the simulation started. */
+	uint64 GetStepCount() const { return Solver.GetStepCount(); }
+
+	UPROPERTY(Config)
+	bool bEnabled;
+
+	/** Weather map channel that is simulated, 0 is red. */
+	UPROPERTY(Config)
+	int32 Channel;
+
+	/** Coverage of a world without a weather map. */
+	UPROPERTY(Config)
+	float InitialCoverage;
+
+	/** Game seconds between two weather map writes, 0 writes every frame that stepped. */
+	UPROPERTY(Config)
+	float WriteInterval;
+
+	/** Largest moisture change of a weather map tile that isn't uploaded yet. */
+	UPROPERTY(Config)
+	float WriteThreshold;
+
+	/** Most steps per frame, time beyond it is dropped so a hitch doesn't cause a longer one. */
+	UPROPERTY(Config)
+	int32 MaxStepsPerFrame;
+
+	UPROPERTY(Config)
+	int32 Size;
+	UPROPERTY(Config)
+	int32 WindSize;
+	UPROPERTY(Config)
+	float TimeStep;
+	UPROPERTY(Config)
+	FVector2D PrevailingWind;
+	UPROPERTY(Config)
+	float Turbulence;
+	UPROPERTY(Config)
+	float WindRelax;
+	UPROPERTY(Config)
+	float Diffusion;
+	UPROPERTY(Config)
+	float SourceRelax;
+	UPROPERTY(Config)
+	int32 Seed;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Setup the solver from the weather map or from InitialCoverage. */
+	void Init();
+
+	/** Write the solver moisture to the weather map, picks up painted stamps first. */
+	void WriteWeatherMap();
+
+	/** Read the weather map channel sampled at the solver size, only needed after tiles were loaded or reverted. */
+	bool ReadWeatherMap(TArray<float>& OutValues);
+
+	/** Apply stamps painted on the weather map to the solver moisture. */
+	void ReplayStamps(const TArray<FVolumetricCloudsStamp>& Stamps);
+
+	FVolumetricCloudsWeatherSolver Solver;
+
+	/** Solver size copy of the simulated channel that stamps are replayed on. */
+	FVolumetricCloudsCanvas StampCanvas;
+	FVolumetricCloudsFilterBrush FilterBrush;
+
+	UPROPERTY()
+	UVolumetricCloudsWeatherMap* WeatherMap;
+
+	/** Weather map write revision after the last write, anything newer was loaded or reverted. */
+	uint32 WrittenRevision;
+
+	/** Game time not simulated yet. */
+	float PendingTime;
+
+	/** Game time since the last write. */
+	float TimeSinceWrite;
+
+	bool bInitialized;
+};
@@ -0,0 +1,29 @@
+// 2015 - Community based open project
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+public class FullEnvironmentBenchmarkTarget : TargetRules
+{
+	public FullEnvironmentBenchmarkTarget(TargetInfo Target) : base(Target)
+	{
+		DefaultBuildSettings = BuildSettingsVersion.V2;
+		Type = TargetType.Program;
+		LinkType = TargetLinkType.Monolithic;
+		LaunchModuleName = "FullEnvironmentBenchmark";
+
+		//Core and the Core only kernel modules, no engine, no UObjects, no UI.
+		bCompileAgainstEngine = false;
+		bCompileAgainstCoreUObject = false;
+		bBuildWithEditorOnlyData = false;
+		bBuildDeveloperTools = false;
+		bCompileICU = false;
+		bUsesSlate = false;
+		bIsBuildingConsoleApplication = true;
+
+		//Results are printed in every configuration.
+		bUseLoggingInShipping = true;
+
+		EnablePlugins.Add("VolumetricCloudsPainter");
+	}
+}
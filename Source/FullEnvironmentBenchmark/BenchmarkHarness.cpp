@@ -0,0 +1,248 @@
+// 2015 - Community based open project
+
+#include "BenchmarkHarness.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+
+#if PLATFORM_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+DEFINE_LOG_CATEGORY_STATIC(LogBenchmark, Log, All);
+
+volatile float GBenchmarkSink = 0.0f;
+
+namespace BenchmarkHarness
+{
+	/** Nearest rank percentile of sorted values. */
+	double GetPercentile(const TArray<double>& SortedValues, double Percentile)
+	{
+		const int32 Rank = FMath::CeilToInt(SortedValues.Num() * Percentile) - 1;
+
+		return SortedValues[FMath::Clamp(Rank, 0, SortedValues.Num() - 1)];
+	}
+
+	/** Min, percentiles and mean of values scaled by a factor. */
+	TSharedRef<FJsonObject> MakeDistribution(const TArray<double>& SortedValues, double Scale)
+	{
+		double Sum = 0.0;
+
+		for (double Value : SortedValues)
+		{
+			Sum += Value;
+		}
+
+		TSharedRef<FJsonObject> Distribution = MakeShared<FJsonObject>();
+		Distribution->SetNumberField(TEXT("Min"), SortedValues[0] * Scale);
+		Distribution->SetNumberField(TEXT("P10"), GetPercentile(SortedValues, 0.1) * Scale);
+		Distribution->SetNumberField(TEXT("Median"), GetPercentile(SortedValues, 0.5) * Scale);
+		Distribution->SetNumberField(TEXT("P90"), GetPercentile(SortedValues, 0.9) * Scale);
+		Distribution->SetNumberField(TEXT("P99"), GetPercentile(SortedValues, 0.99) * Scale);
+		Distribution->SetNumberField(TEXT("Mean"), Sum / SortedValues.Num() * Scale);
+
+		return Distribution;
+	}
+
+#if PLATFORM_LINUX
+	/** Open a user space hardware counter of the calling thread, disabled until its group is enabled. */
+	int32 OpenCounter(uint64 Config, int32 GroupFd)
+	{
+		perf_event_attr Attributes;
+		FMemory::Memzero(Attributes);
+		Attributes.type = PERF_TYPE_HARDWARE;
+		Attributes.size = sizeof(Attributes);
+		Attributes.config = Config;
+		Attributes.disabled = GroupFd < 0 ? 1 : 0;
+		Attributes.exclude_kernel = 1;
+		Attributes.exclude_hv = 1;
+		Attributes.read_format = PERF_FORMAT_GROUP;
+
+		return (int32)syscall(__NR_perf_event_open, &Attributes, 0, -1, GroupFd, 0);
+	}
+#endif
+}
+
+FBenchmarkCounters::FBenchmarkCounters()
+{
+#if PLATFORM_LINUX
+	using namespace BenchmarkHarness;
+
+	CyclesFd = OpenCounter(PERF_COUNT_HW_CPU_CYCLES, -1);
+
+	if (CyclesFd >= 0)
+	{
+		InstructionsFd = OpenCounter(PERF_COUNT_HW_INSTRUCTIONS, CyclesFd);
+
+		if (InstructionsFd < 0)
+		{
+			close(CyclesFd);
+			CyclesFd = -1;
+		}
+	}
+#endif
+}
+
+FBenchmarkCounters::~FBenchmarkCounters()
+{
+#if PLATFORM_LINUX
+	if (IsAvailable())
+	{
+		close(InstructionsFd);
+		close(CyclesFd);
+	}
+#endif
+}
+
+void FBenchmarkCounters::Start()
+{
+#if PLATFORM_LINUX
+	if (IsAvailable())
+	{
+		ioctl(CyclesFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(CyclesFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+#endif
+}
+
+void FBenchmarkCounters::Stop()
+{
+#if PLATFORM_LINUX
+	if (IsAvailable())
+	{
+		ioctl(CyclesFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+		//Group read: number of counters followed by the values in opening order.
+		uint64 Values[3] = { 0, 0, 0 };
+
+		if (read(CyclesFd, Values, sizeof(Values)) == sizeof(Values) && Values[0] == 2)
+		{
+			Cycles += Values[1];
+			Instructions += Values[2];
+		}
+	}
+#endif
+}
+
+void FBenchmarkCounters::Reset()
+{
+	Cycles = 0;
+	Instructions = 0;
+}
+
+void FBenchmarkHarness::Add(const TCHAR* Name, const TCHAR* Unit, TFunction<void(FBenchmarkContext&)>&& Setup)
+{
+	FCase& Case = Cases.AddDefaulted_GetRef();
+	Case.Name = Name;
+	Case.Unit = Unit;
+	Case.Setup = MoveTemp(Setup);
+}
+
+void FBenchmarkHarness::GetNames(TArray<FString>& OutNames) const
+{
+	for (const FCase& Case : Cases)
+	{
+		OutNames.Add(Case.Name);
+	}
+}
+
+FString FBenchmarkHarness::Run(const FBenchmarkSettings& Settings) const
+{
+	using namespace BenchmarkHarness;
+
+	FBenchmarkCounters Counters;
+	TArray<TSharedPtr<FJsonValue>> Results;
+
+	const int32 Iterations = FMath::Max(Settings.Iterations, 1);
+
+	for (const FCase& Case : Cases)
+	{
+		if (Settings.Filters.Num() > 0 && !Settings.Filters.ContainsByPredicate([&Case](const FString& Filter) { return Case.Name.Contains(Filter); }))
+		{
+			continue;
+		}
+
+		FBenchmarkContext Context;
+		Case.Setup(Context);
+
+		if (!Context.Run || Context.ItemsPerIteration <= 0)
+		{
+			UE_LOG(LogBenchmark, Warning, TEXT("%s has nothing to run."), *Case.Name);
+			continue;
+		}
+
+		for (int32 Index = 0; Index < Settings.WarmupIterations; Index++)
+		{
+			Context.Run(Index);
+		}
+
+		TArray<double> Times;
+		Times.Reserve(Iterations);
+		Counters.Reset();
+
+		for (int32 Index = 0; Index < Iterations; Index++)
+		{
+			Counters.Start();
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+
+			Context.Run(Settings.WarmupIterations + Index);
+
+			const uint64 EndCycles = FPlatformTime::Cycles64();
+			Counters.Stop();
+
+			Times.Add(FPlatformTime::ToMilliseconds64(EndCycles - StartCycles));
+		}
+
+		//Inputs are released before the next case allocates its own.
+		Context.Run = nullptr;
+
+		Times.Sort();
+
+		const double TotalItems = double(Context.ItemsPerIteration) * Iterations;
+
+		TSharedRef<FJsonObject> Result = MakeShared<FJsonObject>();
+		Result->SetStringField(TEXT("Name"), Case.Name);
+		Result->SetStringField(TEXT("Unit"), Case.Unit);
+		Result->SetNumberField(TEXT("ItemsPerIteration"), double(Context.ItemsPerIteration));
+		Result->SetNumberField(TEXT("Warmup"), Settings.WarmupIterations);
+		Result->SetNumberField(TEXT("Iterations"), Iterations);
+		Result->SetObjectField(TEXT("NsPerItem"), MakeDistribution(Times, 1000000.0 / Context.ItemsPerIteration));
+		Result->SetObjectField(TEXT("IterationMs"), MakeDistribution(Times, 1.0));
+
+		if (Counters.IsAvailable())
+		{
+			Result->SetNumberField(TEXT("CyclesPerItem"), Counters.GetCycles() / TotalItems);
+			Result->SetNumberField(TEXT("InstructionsPerItem"), Counters.GetInstructions() / TotalItems);
+		}
+
+		UE_LOG(LogBenchmark, Display, TEXT("%-32s %10.3f ns/%s median, %10.3f p90, %10.3f p99"), *Case.Name,
+			GetPercentile(Times, 0.5) * 1000000.0 / Context.ItemsPerIteration, *Case.Unit,
+			GetPercentile(Times, 0.9) * 1000000.0 / Context.ItemsPerIteration,
+			GetPercentile(Times, 0.99) * 1000000.0 / Context.ItemsPerIteration);
+
+		Results.Add(MakeShared<FJsonValueObject>(Result));
+	}
+
+	TSharedRef<FJsonObject> Machine = MakeShared<FJsonObject>();
+	Machine->SetStringField(TEXT("CPU"), FPlatformMisc::GetCPUBrand().TrimStartAndEnd());
+	Machine->SetNumberField(TEXT("Cores"), FPlatformMisc::NumberOfCores());
+	Machine->SetNumberField(TEXT("LogicalCores"), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+	Machine->SetBoolField(TEXT("Threading"), FPlatformProcess::SupportsMultithreading());
+
+	TSharedRef<FJsonObject> Document = MakeShared<FJsonObject>();
+	Document->SetStringField(TEXT("Commit"), Settings.Commit);
+	Document->SetStringField(TEXT("Date"), FDateTime::UtcNow().ToIso8601());
+	Document->SetStringField(TEXT("Configuration"), LexToString(FApp::GetBuildConfiguration()));
+	Document->SetObjectField(TEXT("Machine"), Machine);
+	Document->SetStringField(TEXT("Counters"), Counters.IsAvailable() ? TEXT("perf_event, calling thread") : TEXT("unavailable"));
+	Document->SetArrayField(TEXT("Cases"), Results);
+
+	FString Text;
+	FJsonSerializer::Serialize(Document, TJsonWriterFactory<>::Create(&Text));
+
+	return Text;
+}
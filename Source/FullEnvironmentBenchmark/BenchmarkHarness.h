@@ -0,0 +1,102 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Timed part of a benchmark case, prepared by its setup. */
+struct FBenchmarkContext
+{
+	/** Items one Run call processes, results are reported per item. */
+	int64 ItemsPerIteration = 1;
+
+	/** One iteration, called with the iteration index. Inputs captured by it are released after the case. */
+	TFunction<void(int32)> Run;
+};
+
+/** Harness settings, all of them can be set on the command line. */
+struct FBenchmarkSettings
+{
+	/** Untimed iterations before the timed ones, -Warmup=. */
+	int32 WarmupIterations = 5;
+
+	/** Timed iterations, -Iterations=. */
+	int32 Iterations = 50;
+
+	/** Only run cases whose name contains one of these, -Filter=Canvas+Solver. */
+	TArray<FString> Filters;
+
+	/** Revision the results belong to, -Commit=. */
+	FString Commit;
+};
+
+/**
+* Hardware counters of the calling thread, read with perf_event_open on Linux. Unavailable on other platforms
+* and when kernel.perf_event_paranoid forbids user space counting.
+*/
+class FBenchmarkCounters
+{
+public:
+	FBenchmarkCounters();
+	~FBenchmarkCounters();
+
+	bool IsAvailable() const { return CyclesFd >= 0; }
+
+	/** Reset and start counting. */
+	void Start();
+
+	/** Stop counting and add the counts to the totals. */
+	void Stop();
+
+	uint64 GetCycles() const { return Cycles; }
+	uint64 GetInstructions() const { return Instructions; }
+
+	/** Reset the totals. */
+	void Reset();
+
+private:
+	int32 CyclesFd = -1;
+	int32 InstructionsFd = -1;
+
+	uint64 Cycles = 0;
+	uint64 Instructions = 0;
+};
+
+/**
+* Microbenchmark runner. Every case is set up, warmed up and timed iteration by iteration; results are written as a
+* single JSON document with per item percentiles, so runners can track ns/texel and ns/query per commit.
+*/
+class FBenchmarkHarness
+{
+public:
+	/** Register a case.
+	* @param Name - case name, Group.Kernel.
+	* @param Unit - what an item is, e.g. texel or query.
+	* @param Setup - prepare inputs, not timed.
+	*/
+	void Add(const TCHAR* Name, const TCHAR* Unit, TFunction<void(FBenchmarkContext&)>&& Setup);
+
+	/** Names of all registered cases. */
+	void GetNames(TArray<FString>& OutNames) const;
+
+	/** Run every case matching the filters.
+	* @return JSON results.
+	*/
+	FString Run(const FBenchmarkSettings& Settings) const;
+
+private:
+	struct FCase
+	{
+		FString Name;
+		FString Unit;
+		TFunction<void(FBenchmarkContext&)> Setup;
+	};
+
+	TArray<FCase> Cases;
+};
+
+/** Register the environment kernels, see BenchmarkKernels.cpp. */
+void RegisterKernelBenchmarks(FBenchmarkHarness& Harness);
+
+/** Keeps a query result alive, so the compiler can't drop the queries. */
+extern volatile float GBenchmarkSink;
@@ -0,0 +1,295 @@
+// 2015 - Community based open project
+
+#include "BenchmarkHarness.h"
+#include "Math/RandomStream.h"
+#include "VolumetricCloudsCanvas.h"
+#include "VolumetricCloudsFilterBrush.h"
+#include "VolumetricCloudsMapOperation.h"
+#include "VolumetricCloudsNoiseVolume.h"
+#include "VolumetricCloudsWeatherSolver.h"
+
+namespace BenchmarkKernels
+{
+	/** Weather map size of the project. */
+	const int32 MapSize = 2048;
+
+	/** Point queries per iteration. */
+	const int32 NumQueries = 65536;
+
+	/** Smooth weather map with clouds of a few hundred texels, close to a painted one. */
+	void MakeWeatherMap(int32 Size, TArray<FLinearColor>& OutTexels)
+	{
+		OutTexels.SetNumUninitialized(Size * Size);
+
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			for (int32 X = 0; X < Size; X++)
+			{
+				const float U = X * (2.0f * PI / Size);
+				const float V = Y * (2.0f * PI / Size);
+				const float Clouds = 0.5f + 0.25f * FMath::Sin(U * 5.0f) * FMath::Cos(V * 7.0f) + 0.15f * FMath::Sin((U + V) * 13.0f);
+
+				OutTexels[Y * Size + X] = FLinearColor(Clouds, Clouds * 0.8f, 0.5f, 1.0f);
+			}
+		}
+	}
+
+	/** Uniform query UVs from a fixed seed. */
+	void MakeQueries(TArray<FVector2D>& OutUVs)
+	{
+		FRandomStream Stream(1234);
+		OutUVs.SetNumUninitialized(NumQueries);
+
+		for (FVector2D& UV : OutUVs)
+		{
+			UV = FVector2D(Stream.GetFraction(), Stream.GetFraction());
+		}
+	}
+
+	/** Golden ratio sequence of stamp positions, spreads stamps evenly over the map. */
+	FVector2D GetStampUV(int32 Index)
+	{
+		return FVector2D(FMath::Frac(Index * 0.618034f + 0.1f), FMath::Frac(Index * 0.754877f + 0.3f));
+	}
+
+	/** Canvas with the weather map as its base layer and a painted layer on top. */
+	struct FCanvasState
+	{
+		FVolumetricCloudsCanvas Canvas;
+		FVolumetricCloudsFilterBrush FilterBrush;
+		FVolumetricCloudsBrush Brush;
+
+		FCanvasState()
+		{
+			TArray<FLinearColor> Texels;
+			MakeWeatherMap(MapSize, Texels);
+			Canvas.Init(MapSize, MapSize, Texels.GetData());
+
+			//Radius of a typical painter stroke.
+			Brush.Radius = 0.05f;
+			Brush.ChannelMask = FLinearColor(1.0f, 1.0f, 1.0f, 1.0f);
+		}
+
+		/** Add a paint layer covering the whole map and make it active. */
+		void AddPaintLayer()
+		{
+			FVolumetricCloudsMapOperation Fill;
+			Fill.Type = EVolumetricCloudsMapOperation::Fill;
+			Fill.FillValue = FLinearColor(0.3f, 0.3f, 0.3f, 0.3f);
+
+			Canvas.SetActiveLayer(Canvas.AddLayer(TEXT("Benchmark")));
+			Canvas.ApplyMapOperation(Fill, FLinearColor(1.0f, 1.0f, 1.0f, 1.0f));
+			Canvas.SetLayerBlendMode(1, EVolumetricCloudsBlendMode::Multiply);
+			Canvas.SetLayerOpacity(1, 0.5f);
+			Canvas.Resolve();
+		}
+
+		/** Texels a stamp visits. */
+		int64 GetStampTexels() const
+		{
+			return Canvas.GetBrushRect(Brush, FVector2D(0.5f, 0.5f)).Area();
+		}
+	};
+
+	/** Stamp a brush tool, items are texels under the brush rectangle. */
+	void SetupStamp(FBenchmarkContext& Context, EVolumetricCloudsBrushTool Tool, bool bPaintLayer)
+	{
+		TSharedRef<FCanvasState> State = MakeShared<FCanvasState>();
+		State->Brush.Tool = Tool;
+
+		if (bPaintLayer)
+		{
+			State->AddPaintLayer();
+		}
+
+		Context.ItemsPerIteration = State->GetStampTexels();
+		Context.Run = [State](int32 Iteration)
+		{
+			const FVector2D UV = GetStampUV(Iteration);
+
+			if (State->Brush.Tool == EVolumetricCloudsBrushTool::Paint)
+			{
+				State->Canvas.Stamp(State->Brush, UV);
+			}
+			else
+			{
+				State->FilterBrush.Apply(State->Canvas, State->Brush, UV, GetStampUV(Iteration - 1));
+			}
+
+			//Stamps only dirty tiles, recomposition is measured on its own.
+			State->Canvas.Resolve();
+		};
+	}
+}
+
+void RegisterKernelBenchmarks(FBenchmarkHarness& Harness)
+{
+	using namespace BenchmarkKernels;
+
+	//Brush blending.
+	Harness.Add(TEXT("Canvas.StampBaseLayer"), TEXT("texel"), [](FBenchmarkContext& Context)
+	{
+		SetupStamp(Context, EVolumetricCloudsBrushTool::Paint, false);
+	});
+
+	Harness.Add(TEXT("Canvas.StampPaintLayer"), TEXT("texel"), [](FBenchmarkContext& Context)
+	{
+		SetupStamp(Context, EVolumetricCloudsBrushTool::Paint, true);
+	});
+
+	Harness.Add(TEXT("Canvas.Resolve"), TEXT("texel"), [](FBenchmarkContext& Context)
+	{
+		TSharedRef<FCanvasState> State = MakeShared<FCanvasState>();
+		State->AddPaintLayer();
+
+		Context.ItemsPerIteration = int64(MapSize) * MapSize;
+		Context.Run = [State](int32 Iteration)
+		{
+			State->Canvas.MarkAllDirty();
+			State->Canvas.Resolve();
+		};
+	});
+
+	Harness.Add(TEXT("FilterBrush.Blur"), TEXT("texel"), [](FBenchmarkContext& Context)
+	{
+		SetupStamp(Context, EVolumetricCloudsBrushTool::Blur, false);
+	});
+
+	Harness.Add(TEXT("FilterBrush.Smudge"), TEXT("texel"), [](FBenchmarkContext& Context)
+	{
+		SetupStamp(Context, EVolumetricCloudsBrushTool::Smudge, false);
+	});
+
+	Harness.Add(TEXT("MapOperation.Levels"), TEXT("texel"), [](FBenchmarkContext& Context)
+	{
+		TSharedRef<TArray<FLinearColor>> Texels = MakeShared<TArray<FLinearColor>>();
+		MakeWeatherMap(MapSize / 2, *Texels);
+
+		FVolumetricCloudsMapOperation Levels;
+		Levels.Type = EVolumetricCloudsMapOperation::Levels;
+		Levels.Gamma = FLinearColor(1.2f, 0.9f, 1.0f, 1.0f);
+		Levels.OutWhite = FLinearColor(0.95f, 0.95f, 0.95f, 0.95f);
+
+		Context.ItemsPerIteration = Texels->Num();
+		Context.Run = [Texels, Levels](int32 Iteration)
+		{
+			Levels.Apply(Texels->GetData(), Texels->Num(), FLinearColor(1.0f, 1.0f, 0.0f, 0.0f));
+		};
+	});
+
+	//Noise generation.
+	Harness.Add(TEXT("FilterBrush.Noise"), TEXT("texel"), [](FBenchmarkContext& Context)
+	{
+		SetupStamp(Context, EVolumetricCloudsBrushTool::Noise, false);
+	});
+
+	Harness.Add(TEXT("NoiseVolume.Generate"), TEXT("texel"), [](FBenchmarkContext& Context)
+	{
+		FVolumetricCloudsNoiseVolumeSettings Settings;
+		Settings.Size = 64;
+
+		TSharedRef<TArray<FColor>> Texels = MakeShared<TArray<FColor>>();
+
+		Context.ItemsPerIteration = int64(Settings.Size) * Settings.Size * Settings.Size;
+		Context.Run = [Settings, Texels](int32 Iteration)
+		{
+			FVolumetricCloudsNoiseVolume::Generate(Settings, *Texels);
+		};
+	});
+
+	//Weather map sampling.
+	Harness.Add(TEXT("TiledImage.GetTexel"), TEXT("query"), [](FBenchmarkContext& Context)
+	{
+		TSharedRef<FCanvasState> State = MakeShared<FCanvasState>();
+		State->Canvas.Resolve();
+
+		TSharedRef<TArray<FVector2D>> UVs = MakeShared<TArray<FVector2D>>();
+		MakeQueries(*UVs);
+
+		Context.ItemsPerIteration = NumQueries;
+		Context.Run = [State, UVs](int32 Iteration)
+		{
+			const FVolumetricCloudsTiledImage& Composite = State->Canvas.GetComposite();
+			float Sum = 0.0f;
+
+			for (const FVector2D& UV : *UVs)
+			{
+				Sum += Composite.GetTexel(int32(UV.X * MapSize), int32(UV.Y * MapSize)).R;
+			}
+
+			GBenchmarkSink = Sum;
+		};
+	});
+
+	Harness.Add(TEXT("WeatherSolver.SampleMoisture"), TEXT("query"), [](FBenchmarkContext& Context)
+	{
+		FVolumetricCloudsWeatherSolverSettings Settings;
+		TSharedRef<FVolumetricCloudsWeatherSolver> Solver = MakeShared<FVolumetricCloudsWeatherSolver>();
+		Solver->Init(Settings, nullptr);
+		Solver->Step();
+
+		TSharedRef<TArray<FVector2D>> UVs = MakeShared<TArray<FVector2D>>();
+		MakeQueries(*UVs);
+
+		Context.ItemsPerIteration = NumQueries;
+		Context.Run = [Solver, UVs](int32 Iteration)
+		{
+			float Sum = 0.0f;
+
+			for (const FVector2D& UV : *UVs)
+			{
+				Sum += Solver->SampleMoisture(UV);
+			}
+
+			GBenchmarkSink = Sum;
+		};
+	});
+
+	//Weather interpolation over time and between grid resolutions.
+	Harness.Add(TEXT("WeatherSolver.Step"), TEXT("cell"), [](FBenchmarkContext& Context)
+	{
+		FVolumetricCloudsWeatherSolverSettings Settings;
+		TArray<FLinearColor> Texels;
+		MakeWeatherMap(Settings.Size, Texels);
+
+		TArray<float> Moisture;
+		Moisture.SetNumUninitialized(Texels.Num());
+
+		for (int32 Index = 0; Index < Texels.Num(); Index++)
+		{
+			Moisture[Index] = Texels[Index].R;
+		}
+
+		TSharedRef<FVolumetricCloudsWeatherSolver> Solver = MakeShared<FVolumetricCloudsWeatherSolver>();
+		Solver->Init(Settings, Moisture.GetData());
+
+		Context.ItemsPerIteration = int64(Solver->GetSize()) * Solver->GetSize();
+		Context.Run = [Solver](int32 Iteration)
+		{
+			Solver->Step();
+		};
+	});
+
+	Harness.Add(TEXT("WeatherSolver.Resample"), TEXT("texel"), [](FBenchmarkContext& Context)
+	{
+		const int32 DestSize = 512;
+		TSharedRef<TArray<float>> Source = MakeShared<TArray<float>>();
+		TSharedRef<TArray<float>> Dest = MakeShared<TArray<float>>();
+
+		TArray<FLinearColor> Texels;
+		MakeWeatherMap(MapSize, Texels);
+		Source->SetNumUninitialized(Texels.Num());
+		Dest->SetNumUninitialized(DestSize * DestSize);
+
+		for (int32 Index = 0; Index < Texels.Num(); Index++)
+		{
+			(*Source)[Index] = Texels[Index].R;
+		}
+
+		Context.ItemsPerIteration = DestSize * DestSize;
+		Context.Run = [Source, Dest, DestSize](int32 Iteration)
+		{
+			FVolumetricCloudsWeatherSolver::Resample(Source->GetData(), MapSize, MapSize, Dest->GetData(), DestSize, DestSize);
+		};
+	});
+}
@@ -0,0 +1,18 @@
+// 2015 - Community based open project
+
+using System.IO;
+using UnrealBuildTool;
+
+public class FullEnvironmentBenchmark : ModuleRules
+{
+	public FullEnvironmentBenchmark(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		//RequiredProgramMainCPPInclude.h
+		PublicIncludePaths.Add(Path.Combine(EngineDirectory, "Source/Runtime/Launch/Public"));
+		PrivateIncludePaths.Add(Path.Combine(EngineDirectory, "Source/Runtime/Launch/Private"));
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Core", "Projects", "Json", "VolumetricCloudsPainterCore" });
+	}
+}
@@ -0,0 +1,79 @@
+// 2015 - Community based open project
+
+#include "BenchmarkHarness.h"
+#include "RequiredProgramMainCPPInclude.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogFullEnvironmentBenchmark, Log, All);
+
+IMPLEMENT_APPLICATION(FullEnvironmentBenchmark, "FullEnvironmentBenchmark");
+
+/**
+* Microbenchmarks of the environment CPU kernels without the editor:
+* FullEnvironmentBenchmark [-Filter=Canvas+Solver] [-Warmup=5] [-Iterations=50] [-Commit=<sha>] [-Output=<file>] [-List] [-nothreading]
+*
+* JSON results only go to the output file, Saved/Benchmark/<timestamp>.json by default, so log lines never end up in
+* them. Counters only cover the calling thread, -nothreading runs the parallel kernels on it as well.
+*/
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+	GEngineLoop.PreInit(ArgC, ArgV);
+
+	FBenchmarkHarness Harness;
+	RegisterKernelBenchmarks(Harness);
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+
+	if (FParse::Param(CommandLine, TEXT("List")))
+	{
+		TArray<FString> Names;
+		Harness.GetNames(Names);
+
+		for (const FString& Name : Names)
+		{
+			UE_LOG(LogFullEnvironmentBenchmark, Display, TEXT("%s"), *Name);
+		}
+	}
+	else
+	{
+		FBenchmarkSettings Settings;
+		FParse::Value(CommandLine, TEXT("Warmup="), Settings.WarmupIterations);
+		FParse::Value(CommandLine, TEXT("Iterations="), Settings.Iterations);
+		FParse::Value(CommandLine, TEXT("Commit="), Settings.Commit);
+
+		FString Filter;
+
+		if (FParse::Value(CommandLine, TEXT("Filter="), Filter))
+		{
+			Filter.ParseIntoArray(Settings.Filters, TEXT("+"));
+		}
+
+		const FString Results = Harness.Run(Settings);
+
+		FString OutputPath;
+
+		//Logs share stdout with the results, a file keeps the JSON parseable.
+		if (!FParse::Value(CommandLine, TEXT("Output="), OutputPath))
+		{
+			OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmark") / FDateTime::Now().ToString() + TEXT(".json");
+		}
+
+		if (FFileHelper::SaveStringToFile(Results, *OutputPath))
+		{
+			UE_LOG(LogFullEnvironmentBenchmark, Display, TEXT("Results written to %s."), *FPaths::ConvertRelativePathToFull(OutputPath));
+		}
+		else
+		{
+			UE_LOG(LogFullEnvironmentBenchmark, Error, TEXT("Failed to write %s."), *OutputPath);
+		}
+	}
+
+	FEngineLoop::AppPreExit();
+	FEngineLoop::AppExit();
+
+	return 0;
+}
@@ -0,0 +1,145 @@
+// 2015 - Community based open project
+
+#include "CloudQualityController.h"
+#include "Engine/World.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/StaticMeshComponent.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "EngineUtils.h"
+#include "Misc/App.h"
+#include "RHI.h"
+#include "VolumetricCloudsMemory.h"
+
+UCloudQualityController::UCloudQualityController()
+	: bEnabled(true)
+	, TargetFrameMs(16.6f)
+	, NumLevels(5)
+	, MinShadowUpdateInterval(0.0f)
+	, MaxShadowUpdateInterval(0.5f)
+	, Material(nullptr)
+	, LastSearchTime(-BIG_NUMBER)
+{
+	static const FName DefaultParameters[] = { TEXT("SamplesMin"), TEXT("SamplesMax"), TEXT("ShadowSamples"), TEXT("MipDistance") };
+
+	for (const FName& ParameterName : DefaultParameters)
+	{
+		FCloudQualityParameter Parameter;
+		Parameter.Name = ParameterName;
+		Parameters.Add(Parameter);
+	}
+}
+
+UCloudQualityController* UCloudQualityController::Get(UWorld* World)
+{
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (UCloudQualityController* Controller = Cast<UCloudQualityController>(Object))
+		{
+			return Controller;
+		}
+	}
+
+	UCloudQualityController* Controller = NewObject<UCloudQualityController>(World);
+	World->PerModuleDataObjects.Add(Controller);
+
+	FCloudQualityGovernorSettings Settings;
+	Settings.TargetFrameMs = Controller->TargetFrameMs;
+	Settings.NumLevels = Controller->NumLevels;
+	Controller->Governor.SetSettings(Settings);
+	Controller->Governor.Reset();
+
+	return Controller;
+}
+
+float UCloudQualityController::GetShadowUpdateInterval() const
+{
+	return FMath::Lerp(MaxShadowUpdateInterval, MinShadowUpdateInterval, Governor.GetQuality());
+}
+
+bool UCloudQualityController::InitMaterial()
+{
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::CloudAssets);
+
+	for (TActorIterator<AStaticMeshActor> StaticMeshItr(GetWorld()); StaticMeshItr; ++StaticMeshItr)
+	{
+		if (StaticMeshItr->GetClass()->GetFName() != "VolumetricClouds_C")
+		{
+			continue;
+		}
+
+		UStaticMeshComponent* MeshComponent = StaticMeshItr->GetStaticMeshComponent();
+
+		if (MeshComponent == nullptr || MeshComponent->GetMaterial(0) == nullptr)
+		{
+			return false;
+		}
+
+		//Reuses the dynamic instance of the runtime weather map if it already made one.
+		Material = MeshComponent->CreateDynamicMaterialInstance(0);
+		AuthoredValues.SetNum(Parameters.Num());
+
+		for (int32 Index = 0; Index < Parameters.Num(); Index++)
+		{
+			AuthoredValues[Index] = 0.0f;
+			Material->GetScalarParameterValue(FMaterialParameterInfo(Parameters[Index].Name), AuthoredValues[Index]);
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+void UCloudQualityController::ApplyQuality()
+{
+	const float Quality = Governor.GetQuality();
+
+	for (int32 Index = 0; Index < Parameters.Num(); Index++)
+	{
+		Material->SetScalarParameterValue(Parameters[Index].Name, AuthoredValues[Index] * FMath::Lerp(Parameters[Index].LowScale, 1.0f, Quality));
+	}
+}
+
+void UCloudQualityController::Tick(float DeltaTime)
+{
+	if (Material == nullptr)
+	{
+		//Clouds may be streamed in later, search once per second.
+		const float RealTime = GetWorld()->GetRealTimeSeconds();
+
+		if (RealTime - LastSearchTime < 1.0f)
+		{
+			return;
+		}
+
+		LastSearchTime = RealTime;
+
+		if (!InitMaterial())
+		{
+			return;
+		}
+	}
+
+	const float FrameMs = FApp::GetDeltaTime() * 1000.0f;
+	const float GpuMs = FPlatformTime::ToMilliseconds(GGPUFrameTime);
+
+	if (Governor.Update(FrameMs, GpuMs, FApp::GetDeltaTime()))
+	{
+		ApplyQuality();
+	}
+}
+
+bool UCloudQualityController::IsTickable() const
+{
+	return bEnabled && !IsTemplate() && GetWorld() != nullptr && GetWorld()->IsGameWorld();
+}
+
+TStatId UCloudQualityController::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCloudQualityController, STATGROUP_Tickables);
+}
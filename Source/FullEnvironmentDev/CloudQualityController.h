@@ -0,0 +1,95 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Tickable.h"
+#include "CloudQualityGovernor.h"
+
+#include "CloudQualityController.generated.h"
+
+class UMaterialInstanceDynamic;
+
+/** Clouds material parameter scaled by the cloud quality. */
+USTRUCT()
+struct FCloudQualityParameter
+{
+	GENERATED_BODY()
+
+	/** Scalar parameter of the clouds material. */
+	UPROPERTY(Config)
+	FName Name;
+
+	/** Scale of the authored value at the lowest quality, the highest quality keeps the authored value. */
+	UPROPERTY(Config)
+	float LowScale = 0.5f;
+};
+
+/**
+* Applies the cloud quality governor to the volumetric clouds of a world. Authored values of the quality parameters
+* are read from the clouds material once and scaled through a dynamic material instance whenever the level changes.
+*/
+UCLASS(Config = Game)
+class FULLENVIRONMENTDEV_API UCloudQualityController : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UCloudQualityController();
+
+	/** Controller of a world, created on the first call. */
+	static UCloudQualityController* Get(UWorld* World);
+
+	/** Seconds between two cloud shadow updates at the current quality. */
+	float GetShadowUpdateInterval() const;
+
+	/** Current quality from 0 to 1. */
+	float GetQuality() const { return Governor.GetQuality(); }
+
+	/** Is quality adapted to the frame time. */
+	UPROPERTY(Config)
+	bool bEnabled;
+
+	/** Frame time budget in milliseconds. */
+	UPROPERTY(Config)
+	float TargetFrameMs;
+
+	/** Number of quality levels between the lowest and the authored quality. */
+	UPROPERTY(Config)
+	int32 NumLevels;
+
+	/** Ray march sample counts and detail noise parameters scaled by quality. */
+	UPROPERTY(Config)
+	TArray<FCloudQualityParameter> Parameters;
+
+	/** Shadow update interval at the highest and the lowest quality. */
+	UPROPERTY(Config)
+	float MinShadowUpdateInterval;
+	UPROPERTY(Config)
+	float MaxShadowUpdateInterval;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Find the clouds actor and read authored parameter values, false if the world has no clouds yet. */
+	bool InitMaterial();
+
+	/** Push the current quality to the clouds material. */
+	void ApplyQuality();
+
+	FCloudQualityGovernor Governor;
+
+	UPROPERTY()
+	UMaterialInstanceDynamic* Material;
+
+	/** Authored values of Parameters. */
+	TArray<float> AuthoredValues;
+
+	/** Real time of the last clouds actor search. */
+	float LastSearchTime;
+};
@@ -0,0 +1,111 @@
+// 2015 - Community based open project
+
+#include "CloudQualityGovernor.h"
+
+FCloudQualityGovernor::FCloudQualityGovernor(const FCloudQualityGovernorSettings& InSettings)
+	: Settings(InSettings)
+{
+	Reset();
+}
+
+void FCloudQualityGovernor::SetSettings(const FCloudQualityGovernorSettings& InSettings)
+{
+	Settings = InSettings;
+	Settings.NumLevels = FMath::Max(Settings.NumLevels, 1);
+
+	UpscaleBackoff.SetNum(Settings.NumLevels);
+
+	for (float& Backoff : UpscaleBackoff)
+	{
+		Backoff = FMath::Max(Backoff, 1.0f);
+	}
+
+	Level = FMath::Min(Level, Settings.NumLevels - 1);
+}
+
+void FCloudQualityGovernor::Reset()
+{
+	Settings.NumLevels = FMath::Max(Settings.NumLevels, 1);
+
+	Level = Settings.NumLevels - 1;
+	SmoothedMs = 0.0f;
+	OverBudgetTime = 0.0f;
+	UnderBudgetTime = 0.0f;
+	TimeSinceUpscale = BIG_NUMBER;
+
+	UpscaleBackoff.Reset();
+	UpscaleBackoff.Init(1.0f, Settings.NumLevels);
+}
+
+float FCloudQualityGovernor::GetQuality() const
+{
+	return Settings.NumLevels > 1 ? float(Level) / (Settings.NumLevels - 1) : 1.0f;
+}
+
+bool FCloudQualityGovernor::Update(float FrameMs, float GpuMs, float DeltaSeconds)
+{
+	const float SampleMs = GpuMs > 0.0f ? GpuMs : FrameMs;
+
+	if (DeltaSeconds <= 0.0f || SampleMs <= 0.0f)
+	{
+		return false;
+	}
+
+	//Exponential smoothing by time, so the response doesn't depend on the frame rate.
+	if (SmoothedMs <= 0.0f)
+	{
+		SmoothedMs = SampleMs;
+	}
+	else
+	{
+		const float Alpha = 1.0f - FMath::Exp(-DeltaSeconds / FMath::Max(Settings.SmoothingTime, KINDA_SMALL_NUMBER));
+		SmoothedMs += (SampleMs - SmoothedMs) * Alpha;
+	}
+
+	TimeSinceUpscale += DeltaSeconds;
+
+	//Between the two thresholds nothing changes, that band is the hysteresis.
+	if (SmoothedMs > Settings.TargetFrameMs * Settings.DownscaleRatio)
+	{
+		OverBudgetTime += DeltaSeconds;
+		UnderBudgetTime = 0.0f;
+	}
+	else if (SmoothedMs < Settings.TargetFrameMs * Settings.UpscaleRatio)
+	{
+		UnderBudgetTime += DeltaSeconds;
+		OverBudgetTime = 0.0f;
+	}
+	else
+	{
+		OverBudgetTime = 0.0f;
+		UnderBudgetTime = 0.0f;
+	}
+
+	if (OverBudgetTime >= Settings.DownscaleDelay && Level > 0)
+	{
+		//Level that was just reached could not hold the budget, wait longer before trying it again.
+		if (TimeSinceUpscale < Settings.FailedUpscaleWindow)
+		{
+			UpscaleBackoff[Level] = FMath::Min(UpscaleBackoff[Level] * 2.0f, Settings.MaxUpscaleBackoff);
+		}
+
+		Level--;
+		OverBudgetTime = 0.0f;
+		UnderBudgetTime = 0.0f;
+		TimeSinceUpscale = BIG_NUMBER;
+
+		return true;
+	}
+
+	if (Level < Settings.NumLevels - 1 && UnderBudgetTime >= Settings.UpscaleDelay * UpscaleBackoff[Level + 1])
+	{
+		Level++;
+		OverBudgetTime = 0.0f;
+		UnderBudgetTime = 0.0f;
+		TimeSinceUpscale = 0.0f;
+
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,88 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Frame budget and hysteresis of the cloud quality governor. */
+struct FCloudQualityGovernorSettings
+{
+	/** Frame time the governor steers towards, in milliseconds. */
+	float TargetFrameMs = 16.6f;
+
+	/** Quality is lowered while the smoothed frame time is above TargetFrameMs * DownscaleRatio. */
+	float DownscaleRatio = 1.05f;
+
+	/** Quality is raised while the smoothed frame time is below TargetFrameMs * UpscaleRatio. */
+	float UpscaleRatio = 0.8f;
+
+	/** Seconds frame time has to stay over budget before quality is lowered. */
+	float DownscaleDelay = 0.5f;
+
+	/** Seconds frame time has to stay under budget before quality is raised. */
+	float UpscaleDelay = 3.0f;
+
+	/** Time constant of the frame time smoothing in seconds. */
+	float SmoothingTime = 0.25f;
+
+	/** Lowering quality this soon after raising it doubles the upscale delay of that level. */
+	float FailedUpscaleWindow = 5.0f;
+
+	/** Largest upscale delay multiplier of repeatedly failed upscales. */
+	float MaxUpscaleBackoff = 16.0f;
+
+	/** Number of quality levels, the highest one is the authored quality. */
+	int32 NumLevels = 5;
+};
+
+/**
+* Picks a cloud quality level from measured frame times. Plain C++ without engine dependencies, so it can be fed
+* synthetic frame time traces. Quality drops quickly when over budget and rises slowly when under it; a level that
+* had to be dropped again right after it was reached waits exponentially longer before it is tried again.
+*/
+class FULLENVIRONMENTDEV_API FCloudQualityGovernor
+{
+public:
+	explicit FCloudQualityGovernor(const FCloudQualityGovernorSettings& InSettings = FCloudQualityGovernorSettings());
+
+	/** Feed one frame.
+	* @param FrameMs - frame time in milliseconds.
+	* @param GpuMs - GPU time in milliseconds, 0 if unknown. Clouds are GPU bound, so GPU time is preferred.
+	* @param DeltaSeconds - seconds since the previous update.
+	* @return true if the quality level changed.
+	*/
+	bool Update(float FrameMs, float GpuMs, float DeltaSeconds);
+
+	/** Current quality level, 0 is the lowest. */
+	int32 GetLevel() const { return Level; }
+
+	/** Current quality from 0 (lowest level) to 1 (authored quality). */
+	float GetQuality() const;
+
+	/** Smoothed frame time the decisions are based on. */
+	float GetSmoothedMs() const { return SmoothedMs; }
+
+	/** Change settings, keeps the level clamped to the new level count. */
+	void SetSettings(const FCloudQualityGovernorSettings& InSettings);
+
+	const FCloudQualityGovernorSettings& GetSettings() const { return Settings; }
+
+	/** Restart at the highest level with no history. */
+	void Reset();
+
+private:
+	FCloudQualityGovernorSettings Settings;
+
+	int32 Level;
+	float SmoothedMs;
+
+	/** Seconds the smoothed time has been over or under budget. */
+	float OverBudgetTime;
+	float UnderBudgetTime;
+
+	/** Seconds since the last upscale. */
+	float TimeSinceUpscale;
+
+	/** Upscale delay multiplier per level. */
+	TArray<float> UpscaleBackoff;
+};
@@ -0,0 +1,305 @@
+// 2015 - Community based open project
+
+#include "CloudShadowScheduler.h"
+#include "CloudQualityController.h"
+#include "VolumetricCloudsWeatherMap.h"
+#include "Engine/World.h"
+#include "Engine/Canvas.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/DirectionalLight.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/DirectionalLightComponent.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Kismet/KismetRenderingLibrary.h"
+#include "EngineUtils.h"
+
+UCloudShadowScheduler::UCloudShadowScheduler()
+	: bEnabled(false)
+	, SunAngleThreshold(0.25f)
+	, NumTiles(4)
+	, TilesPerFrame(2)
+	, ShadowMaterialPath(TEXT("/Game/VolumetricClouds/Materials/GroundShadows/Base/MI_CloudsShadow.MI_CloudsShadow"))
+	, BlurMaterialPath(TEXT("/Game/VolumetricClouds/Materials/GroundShadows/MI_ShadowBlur.MI_ShadowBlur"))
+	, ShadowTargetPath(TEXT("/Game/VolumetricClouds/Textures/RenderTargets/RT_Shadows.RT_Shadows"))
+	, BlurTargetPath(TEXT("/Game/VolumetricClouds/Textures/RenderTargets/RT_Shadows_Blur.RT_Shadows_Blur"))
+	, CloudsComponent(nullptr)
+	, ShadowMaterial(nullptr)
+	, BlurMaterial(nullptr)
+	, ShadowTarget(nullptr)
+	, BlurTarget(nullptr)
+	, SunLight(nullptr)
+	, SunDirection(FVector::ZeroVector)
+	, WeatherMapRevision(0)
+	, NextTile(INDEX_NONE)
+	, bUpdateRequested(true)
+	, UpdateTime(-BIG_NUMBER)
+	, LastSearchTime(-BIG_NUMBER)
+{
+	//Offsets are in weather map and noise UV space, thresholds are about a texel.
+	static const TPair<const TCHAR*, float> DefaultParameters[] =
+	{
+		{ TEXT("WeatherMapOffsetX"), 1.0f / 512.0f },
+		{ TEXT("WeatherMapOffsetY"), 1.0f / 512.0f },
+		{ TEXT("NoiseOffsetX"), 1.0f / 128.0f },
+		{ TEXT("NoiseOffsetY"), 1.0f / 128.0f },
+		{ TEXT("NoiseOffsetZ"), 1.0f / 128.0f },
+		{ TEXT("DetailNoiseOffsetScale"), 0.01f },
+	};
+
+	for (const TPair<const TCHAR*, float>& DefaultParameter : DefaultParameters)
+	{
+		FCloudShadowParameter Parameter;
+		Parameter.Name = DefaultParameter.Key;
+		Parameter.Threshold = DefaultParameter.Value;
+		ScalarParameters.Add(Parameter);
+	}
+
+	TextureParameters.Add(TEXT("WeatherMap"));
+}
+
+UCloudShadowScheduler* UCloudShadowScheduler::Get(UWorld* World)
+{
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (UCloudShadowScheduler* Scheduler = Cast<UCloudShadowScheduler>(Object))
+		{
+			return Scheduler;
+		}
+	}
+
+	UCloudShadowScheduler* Scheduler = NewObject<UCloudShadowScheduler>(World);
+	World->PerModuleDataObjects.Add(Scheduler);
+
+	return Scheduler;
+}
+
+bool UCloudShadowScheduler::Init()
+{
+	UWorld* World = GetWorld();
+
+	if (ShadowTarget == nullptr)
+	{
+		UMaterialInterface* ShadowMaterialParent = Cast<UMaterialInterface>(ShadowMaterialPath.TryLoad());
+		BlurMaterial = Cast<UMaterialInterface>(BlurMaterialPath.TryLoad());
+		ShadowTarget = Cast<UTextureRenderTarget2D>(ShadowTargetPath.TryLoad());
+		BlurTarget = Cast<UTextureRenderTarget2D>(BlurTargetPath.TryLoad());
+
+		if (ShadowMaterialParent == nullptr || BlurMaterial == nullptr || ShadowTarget == nullptr || BlurTarget == nullptr)
+		{
+			bEnabled = false;
+			return false;
+		}
+
+		ShadowMaterial = UMaterialInstanceDynamic::Create(ShadowMaterialParent, this);
+	}
+
+	for (TActorIterator<AStaticMeshActor> StaticMeshItr(World); StaticMeshItr; ++StaticMeshItr)
+	{
+		if (StaticMeshItr->GetClass()->GetFName() == "VolumetricClouds_C" && StaticMeshItr->GetStaticMeshComponent() != nullptr)
+		{
+			CloudsComponent = StaticMeshItr->GetStaticMeshComponent();
+			break;
+		}
+	}
+
+	for (TActorIterator<ADirectionalLight> LightItr(World); LightItr; ++LightItr)
+	{
+		UDirectionalLightComponent* LightComponent = Cast<UDirectionalLightComponent>(LightItr->GetLightComponent());
+
+		if (LightComponent != nullptr && LightComponent->IsUsedAsAtmosphereSunLight())
+		{
+			SunLight = LightComponent;
+			break;
+		}
+	}
+
+	return CloudsComponent != nullptr && CloudsComponent->GetMaterial(0) != nullptr;
+}
+
+bool UCloudShadowScheduler::NeedsUpdate()
+{
+	UMaterialInterface* CloudsMaterial = CloudsComponent->GetMaterial(0);
+
+	if (bUpdateRequested)
+	{
+		return true;
+	}
+
+	//Shadow material reads the atmosphere sun direction.
+	if (SunLight != nullptr && FVector::DotProduct(SunLight->GetDirection(), SunDirection) < FMath::Cos(FMath::DegreesToRadians(SunAngleThreshold)))
+	{
+		return true;
+	}
+
+	if (UVolumetricCloudsWeatherMap* WeatherMap = UVolumetricCloudsWeatherMap::Find(GetWorld()))
+	{
+		if (WeatherMap->GetRevision() != WeatherMapRevision)
+		{
+			return true;
+		}
+	}
+
+	for (int32 Index = 0; Index < ScalarParameters.Num(); Index++)
+	{
+		float Value = 0.0f;
+		CloudsMaterial->GetScalarParameterValue(FMaterialParameterInfo(ScalarParameters[Index].Name), Value);
+
+		if (FMath::Abs(Value - ScalarValues[Index]) >= ScalarParameters[Index].Threshold)
+		{
+			return true;
+		}
+	}
+
+	for (int32 Index = 0; Index < TextureParameters.Num(); Index++)
+	{
+		UTexture* Value = nullptr;
+		CloudsMaterial->GetTextureParameterValue(FMaterialParameterInfo(TextureParameters[Index]), Value);
+
+		if (Value != TextureValues[Index])
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UCloudShadowScheduler::BeginUpdate()
+{
+	UMaterialInterface* CloudsMaterial = CloudsComponent->GetMaterial(0);
+
+	//Parameters stay fixed until the update is done, every tile sees the same clouds.
+	ScalarValues.SetNum(ScalarParameters.Num());
+	TextureValues.SetNum(TextureParameters.Num());
+
+	for (int32 Index = 0; Index < ScalarParameters.Num(); Index++)
+	{
+		ScalarValues[Index] = 0.0f;
+		CloudsMaterial->GetScalarParameterValue(FMaterialParameterInfo(ScalarParameters[Index].Name), ScalarValues[Index]);
+		ShadowMaterial->SetScalarParameterValue(ScalarParameters[Index].Name, ScalarValues[Index]);
+	}
+
+	for (int32 Index = 0; Index < TextureParameters.Num(); Index++)
+	{
+		TextureValues[Index] = nullptr;
+		CloudsMaterial->GetTextureParameterValue(FMaterialParameterInfo(TextureParameters[Index]), TextureValues[Index]);
+		ShadowMaterial->SetTextureParameterValue(TextureParameters[Index], TextureValues[Index]);
+	}
+
+	if (UVolumetricCloudsWeatherMap* WeatherMap = UVolumetricCloudsWeatherMap::Find(GetWorld()))
+	{
+		WeatherMapRevision = WeatherMap->GetRevision();
+	}
+
+	SunDirection = SunLight != nullptr ? SunLight->GetDirection() : FVector::ZeroVector;
+	bUpdateRequested = false;
+	NextTile = 0;
+}
+
+void UCloudShadowScheduler::DrawTiles(UMaterialInterface* Material, UTextureRenderTarget2D* Target, int32 FirstTile, int32 NumTilesToDraw)
+{
+	UCanvas* Canvas = nullptr;
+	FVector2D Size;
+	FDrawToRenderTargetContext Context;
+
+	UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(this, Target, Canvas, Size, Context);
+
+	const int32 TilesPerSide = GetNumTiles();
+	const FVector2D TileSize = Size / TilesPerSide;
+	const FVector2D TileUVSize(1.0f / TilesPerSide, 1.0f / TilesPerSide);
+
+	for (int32 Tile = FirstTile; Tile < FirstTile + NumTilesToDraw; Tile++)
+	{
+		const FVector2D TileCoordinates(Tile % TilesPerSide, Tile / TilesPerSide);
+		Canvas->K2_DrawMaterial(Material, TileCoordinates * TileSize, TileSize, TileCoordinates * TileUVSize, TileUVSize);
+	}
+
+	UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(this, Context);
+}
+
+void UCloudShadowScheduler::Tick(float DeltaTime)
+{
+	const float RealTime = GetWorld()->GetRealTimeSeconds();
+
+	if (CloudsComponent == nullptr || CloudsComponent->GetMaterial(0) == nullptr)
+	{
+		//Clouds may be streamed in later, search once per second.
+		if (RealTime - LastSearchTime < 1.0f)
+		{
+			return;
+		}
+
+		LastSearchTime = RealTime;
+
+		if (!Init())
+		{
+			return;
+		}
+	}
+
+	const int32 NumTargetTiles = GetNumTiles() * GetNumTiles();
+
+	if (NextTile == INDEX_NONE)
+	{
+		//Cloud quality governor stretches the time between updates on slow machines.
+		const UCloudQualityController* QualityController = UCloudQualityController::Get(GetWorld());
+		const float MinInterval = QualityController != nullptr ? QualityController->GetShadowUpdateInterval() : 0.0f;
+
+		if (RealTime - UpdateTime < MinInterval || !NeedsUpdate())
+		{
+			return;
+		}
+
+		//First update has nothing to show meanwhile, it is drawn at once.
+		const bool bFirstUpdate = UpdateTime < 0.0f;
+
+		UpdateTime = RealTime;
+		BeginUpdate();
+
+		if (bFirstUpdate)
+		{
+			NextTile = 2 * NumTargetTiles;
+			DrawTiles(ShadowMaterial, ShadowTarget, 0, NumTargetTiles);
+			DrawTiles(BlurMaterial, BlurTarget, 0, NumTargetTiles);
+		}
+	}
+
+	int32 TilesLeft = FMath::Max(TilesPerFrame, 1);
+
+	//Shadow tiles first, the blur reads neighbor texels so it has to wait for the whole shadow target.
+	if (NextTile < NumTargetTiles)
+	{
+		const int32 NumTilesToDraw = FMath::Min(TilesLeft, NumTargetTiles - NextTile);
+		DrawTiles(ShadowMaterial, ShadowTarget, NextTile, NumTilesToDraw);
+		NextTile += NumTilesToDraw;
+		TilesLeft -= NumTilesToDraw;
+	}
+
+	if (TilesLeft > 0 && NextTile >= NumTargetTiles && NextTile < 2 * NumTargetTiles)
+	{
+		const int32 NumTilesToDraw = FMath::Min(TilesLeft, 2 * NumTargetTiles - NextTile);
+		DrawTiles(BlurMaterial, BlurTarget, NextTile - NumTargetTiles, NumTilesToDraw);
+		NextTile += NumTilesToDraw;
+	}
+
+	if (NextTile >= 2 * NumTargetTiles)
+	{
+		NextTile = INDEX_NONE;
+	}
+}
+
+bool UCloudShadowScheduler::IsTickable() const
+{
+	return bEnabled && !IsTemplate() && GetWorld() != nullptr && GetWorld()->IsGameWorld();
+}
+
+TStatId UCloudShadowScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCloudShadowScheduler, STATGROUP_Tickables);
+}
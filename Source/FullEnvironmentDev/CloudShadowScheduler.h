@@ -0,0 +1,143 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Tickable.h"
+
+#include "CloudShadowScheduler.generated.h"
+
+class UMaterialInterface;
+class UMaterialInstanceDynamic;
+class UTextureRenderTarget2D;
+class UDirectionalLightComponent;
+class UStaticMeshComponent;
+
+/** Clouds material parameter copied to the shadow material. */
+USTRUCT()
+struct FCloudShadowParameter
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+	FName Name;
+
+	/** Smallest change that needs a shadow update, about a texel for scroll offsets. */
+	UPROPERTY(Config)
+	float Threshold = 0.001f;
+};
+
+/**
+* Redraws RT_Shadows and RT_Shadows_Blur only when the cloud shadows change: the sun moves past an angle,
+* the weather map is stamped or replaced, or a scroll offset moves past its threshold.
+* An update draws the shadow material in tiles over a few frames with parameters captured at its start,
+* then blurs tile by tile once the whole shadow target is consistent. The blur target isn't double buffered, so
+* while it's being blurred it shows old and new tiles side by side for a few frames; the edges between them are
+* faint since an update only starts after a small change.
+*
+* Off by default, the clouds blueprint draws the shadow targets itself unless it's told not to.
+*/
+UCLASS(Config = Game)
+class FULLENVIRONMENTDEV_API UCloudShadowScheduler : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UCloudShadowScheduler();
+
+	/** Scheduler of a world, created on the first call. */
+	static UCloudShadowScheduler* Get(UWorld* World);
+
+	/** Start a new update on the next tick. */
+	void RequestUpdate() { bUpdateRequested = true; }
+
+	/** Is the shadow scheduled natively, the clouds blueprint shouldn't draw the shadow targets then. */
+	UPROPERTY(Config)
+	bool bEnabled;
+
+	/** Sun direction change in degrees that needs an update. */
+	UPROPERTY(Config)
+	float SunAngleThreshold;
+
+	/** Tiles per side of a shadow target, at least 1. */
+	UPROPERTY(Config)
+	int32 NumTiles;
+
+	/** Tiles drawn per frame. */
+	UPROPERTY(Config)
+	int32 TilesPerFrame;
+
+	UPROPERTY(Config)
+	FSoftObjectPath ShadowMaterialPath;
+	UPROPERTY(Config)
+	FSoftObjectPath BlurMaterialPath;
+	UPROPERTY(Config)
+	FSoftObjectPath ShadowTargetPath;
+	UPROPERTY(Config)
+	FSoftObjectPath BlurTargetPath;
+
+	/** Scalar parameters copied from the clouds material. */
+	UPROPERTY(Config)
+	TArray<FCloudShadowParameter> ScalarParameters;
+
+	/** Texture parameters copied from the clouds material, any change needs an update. */
+	UPROPERTY(Config)
+	TArray<FName> TextureParameters;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Load materials and targets and find the clouds material, false until the clouds exist. */
+	bool Init();
+
+	/** Does the current state differ from the state of the last update. */
+	bool NeedsUpdate();
+
+	/** Capture clouds parameters and sun direction and start drawing tiles. */
+	void BeginUpdate();
+
+	/** Tiles per side of a shadow target, NumTiles clamped to a usable value. */
+	int32 GetNumTiles() const { return FMath::Max(NumTiles, 1); }
+
+	/** Draw a range of tiles of a material into a target. */
+	void DrawTiles(UMaterialInterface* Material, UTextureRenderTarget2D* Target, int32 FirstTile, int32 NumTilesToDraw);
+
+	/** Clouds mesh, its material is read every time as it may be replaced by a dynamic instance. */
+	UPROPERTY()
+	UStaticMeshComponent* CloudsComponent;
+
+	UPROPERTY()
+	UMaterialInstanceDynamic* ShadowMaterial;
+
+	UPROPERTY()
+	UMaterialInterface* BlurMaterial;
+
+	UPROPERTY()
+	UTextureRenderTarget2D* ShadowTarget;
+
+	UPROPERTY()
+	UTextureRenderTarget2D* BlurTarget;
+
+	UPROPERTY()
+	UDirectionalLightComponent* SunLight;
+
+	/** State of the last update. */
+	FVector SunDirection;
+	TArray<float> ScalarValues;
+	TArray<UTexture*> TextureValues;
+	uint32 WeatherMapRevision;
+
+	/** Next tile to draw, shadow tiles come first and blur tiles second. INDEX_NONE while idle. */
+	int32 NextTile;
+
+	bool bUpdateRequested;
+
+	/** Real time of the last update start and of the last clouds search. */
+	float UpdateTime;
+	float LastSearchTime;
+};
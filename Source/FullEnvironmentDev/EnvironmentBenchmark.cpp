@@ -0,0 +1,692 @@
+// 2015 - Community based open project
+
+#include "EnvironmentBenchmark.h"
+#include "EnvironmentViewModel.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PawnMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/UObjectGlobals.h"
+
+#if STATS
+#include "Stats/StatsData.h"
+#endif
+
+DEFINE_LOG_CATEGORY_STATIC(LogEnvironmentBenchmark, Log, All);
+
+/**
+* Summary rows of one category. Stat names are mapped to their row the first time they show up, later frames only
+* look up an FName and add to arrays that keep their allocation.
+*/
+struct FEnvironmentBenchmarkCostTable
+{
+	/** Row of every stat seen so far, several stats may share a row. */
+	TMap<FName, int32> StatRows;
+
+	/** Row names and their costs, each frame a row showed up in. */
+	TArray<FString> Names;
+	TArray<FEnvironmentBenchmarkCost> Costs;
+
+	/** Cost of the frame being gathered per row, and the rows it touched. */
+	TArray<double> FrameCosts;
+	TArray<bool> FrameTouched;
+	TArray<int32> FrameRows;
+
+	/** Row of a stat, the row name is only built when the stat is new.
+	* @param StatName - short name of the stat.
+	* @param MakeRowName - row name of a new stat.
+	*/
+	template<typename FunctionType>
+	int32 FindOrAddRow(FName StatName, FunctionType&& MakeRowName)
+	{
+		if (const int32* Row = StatRows.Find(StatName))
+		{
+			return *Row;
+		}
+
+		const FString RowName = MakeRowName(StatName);
+		int32 Row = Names.Find(RowName);
+
+		if (Row == INDEX_NONE)
+		{
+			Row = Names.Add(RowName);
+			Costs.AddDefaulted();
+			FrameCosts.Add(0.0);
+			FrameTouched.Add(false);
+		}
+
+		StatRows.Add(StatName, Row);
+
+		return Row;
+	}
+
+	void AddFrameCost(int32 Row, double Value)
+	{
+		if (!FrameTouched[Row])
+		{
+			FrameTouched[Row] = true;
+			FrameRows.Add(Row);
+		}
+
+		FrameCosts[Row] += Value;
+	}
+
+	/** Add the gathered frame to the costs of the rows it touched. */
+	void EndFrame()
+	{
+		for (int32 Row : FrameRows)
+		{
+			Costs[Row].Add(FrameCosts[Row]);
+			FrameCosts[Row] = 0.0;
+			FrameTouched[Row] = false;
+		}
+
+		FrameRows.Reset();
+	}
+};
+
+/** Costs gathered on the stats thread, read on the game thread once collection stopped. */
+struct FEnvironmentBenchmarkStats : public TSharedFromThis<FEnvironmentBenchmarkStats, ESPMode::ThreadSafe>
+{
+	/** Tick cost per class in ms, each frame a class ticked in. */
+	FEnvironmentBenchmarkCostTable Ticks;
+
+	/** Native tickables in ms, the environment systems of this module among them. */
+	FEnvironmentBenchmarkCostTable Tickables;
+
+	/** Allocator calls per frame. */
+	FEnvironmentBenchmarkCostTable Allocations;
+
+	FEnvironmentBenchmarkCost BlueprintTime;
+
+	/** Stats frames received. */
+	int32 Frames = 0;
+
+	FDelegateHandle NewFrameHandle;
+	FCriticalSection CriticalSection;
+
+#if STATS
+	/** Non stack stats of a frame, reused every frame. */
+	TArray<FStatMessage> NonStackStats;
+
+	void OnNewFrame(int64 TargetFrame);
+
+	/** Sum tick and Blueprint VM time of a stack. Scopes nested in one already counted are part of its cost. */
+	void Accumulate(const FRawStatStackNode& Node, bool bInObject, bool bInBlueprint, double& OutBlueprintTime);
+#endif
+};
+
+namespace EnvironmentBenchmark
+{
+	/** Points of the circuit flown without a recorded path. */
+	const int32 NumCircuitPoints = 8;
+
+#if STATS
+	static const FName UObjectsGroup(TEXT("STATGROUP_UObjects"));
+	static const FName TickablesGroup(TEXT("STATGROUP_Tickables"));
+	static const FName BlueprintTimeName(TEXT("STAT_BlueprintTime"));
+	static const FName MallocCallsName(TEXT("STAT_MallocCalls"));
+	static const FName ReallocCallsName(TEXT("STAT_ReallocCalls"));
+	static const FName FreeCallsName(TEXT("STAT_FreeCalls"));
+
+	/** Actors and components tick in a scope named by their full name, class then path. */
+	FString GetTickRowName(FName StatName)
+	{
+		FString ClassName = StatName.ToString();
+		int32 Space;
+
+		if (ClassName.FindChar(TEXT(' '), Space))
+		{
+			ClassName.LeftInline(Space);
+		}
+
+		return ClassName;
+	}
+
+	/** Run a function on the stats thread and wait for it, the stats state belongs to that thread. */
+	void RunOnStatsThread(TFunction<void()>&& Function)
+	{
+		FGraphEventRef CompleteHandle = FFunctionGraphTask::CreateAndDispatchWhenReady(MoveTemp(Function), TStatId(), nullptr,
+			FPlatformProcess::SupportsMultithreading() ? ENamedThreads::StatsThread : ENamedThreads::GameThread_Local);
+
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(CompleteHandle);
+	}
+#endif
+
+	/** Add a summary row, Mean is Total over Count. Growth is only written for rows that measure it. */
+	void AddRow(FString& Csv, const TCHAR* Category, const FString& Name, int32 Count, double Total, double Max, const TCHAR* Unit, const double* Growth = nullptr)
+	{
+		Csv += FString::Printf(TEXT("%s,%s,%d,%.3f,%.4f,%.3f,%s,%s\n"), Category, *Name, Count, Total, Count > 0 ? Total / Count : 0.0, Max, Unit,
+			Growth != nullptr ? *FString::Printf(TEXT("%.3f"), *Growth) : TEXT(""));
+	}
+
+	/** Add a row per entry, most expensive first. */
+	void AddRows(FString& Csv, const TCHAR* Category, const FEnvironmentBenchmarkCostTable& Table, int32 Frames, const TCHAR* Unit)
+	{
+		TArray<int32> Rows;
+
+		for (int32 Row = 0; Row < Table.Costs.Num(); Row++)
+		{
+			Rows.Add(Row);
+		}
+
+		Rows.Sort([&](int32 A, int32 B) { return Table.Costs[A].Total > Table.Costs[B].Total; });
+
+		for (int32 Row : Rows)
+		{
+			AddRow(Csv, Category, Table.Names[Row], Frames, Table.Costs[Row].Total, Table.Costs[Row].Max, Unit);
+		}
+	}
+
+	void Benchmark(const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumFrames = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 0;
+		UEnvironmentBenchmark* Benchmark = UEnvironmentBenchmark::Get(World);
+
+		if (Benchmark != nullptr && !Benchmark->Start(NumFrames, false))
+		{
+			UE_LOG(LogEnvironmentBenchmark, Warning, TEXT("A benchmark or a recording is already running."));
+		}
+	}
+
+	void RecordFlythrough(UWorld* World)
+	{
+		if (UEnvironmentBenchmark* Benchmark = UEnvironmentBenchmark::Get(World))
+		{
+			Benchmark->ToggleRecording();
+		}
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs BenchmarkCommand(
+		TEXT("Environment.Benchmark"),
+		TEXT("Fly the benchmark path and write a game-thread cost summary. Arguments: [Frames]."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Benchmark));
+
+	FAutoConsoleCommandWithWorld RecordFlythroughCommand(
+		TEXT("Environment.RecordFlythrough"),
+		TEXT("Start or stop recording the benchmark path from the player's view."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&RecordFlythrough));
+}
+
+#if STATS
+void FEnvironmentBenchmarkStats::Accumulate(const FRawStatStackNode& Node, bool bInObject, bool bInBlueprint, double& OutBlueprintTime)
+{
+	using namespace EnvironmentBenchmark;
+
+	for (const TPair<FName, FRawStatStackNode*>& Child : Node.Children)
+	{
+		const FStatNameAndInfo& NameAndInfo = Child.Value->Meta.NameAndInfo;
+		const double Milliseconds = FPlatformTime::ToMilliseconds(FromPackedCallCountDuration_Duration(Child.Value->Meta.GetValue_int64()));
+		const FName GroupName = NameAndInfo.GetGroupName();
+		const FName ShortName = NameAndInfo.GetShortName();
+
+		bool bObject = bInObject;
+		bool bBlueprint = bInBlueprint;
+
+		if (!bInObject && GroupName == UObjectsGroup)
+		{
+			Ticks.AddFrameCost(Ticks.FindOrAddRow(ShortName, &GetTickRowName), Milliseconds);
+			bObject = true;
+		}
+		else if (GroupName == TickablesGroup)
+		{
+			Tickables.AddFrameCost(Tickables.FindOrAddRow(ShortName, [](FName StatName) { return StatName.ToString(); }), Milliseconds);
+		}
+
+		if (!bInBlueprint && ShortName == BlueprintTimeName)
+		{
+			OutBlueprintTime += Milliseconds;
+			bBlueprint = true;
+		}
+
+		Accumulate(*Child.Value, bObject, bBlueprint, OutBlueprintTime);
+	}
+}
+
+void FEnvironmentBenchmarkStats::OnNewFrame(int64 TargetFrame)
+{
+	using namespace EnvironmentBenchmark;
+
+	const FStatsThreadState& State = FStatsThreadState::GetLocalState();
+
+	FRawStatStackNode Root;
+	NonStackStats.Reset();
+	State.UncondenseStackStats(TargetFrame, Root, nullptr, &NonStackStats);
+
+	//Rows are only read by the game thread once collection stopped, the lock is held for the whole frame.
+	FScopeLock Lock(&CriticalSection);
+
+	double FrameBlueprintTime = 0.0;
+	Accumulate(Root, false, false, FrameBlueprintTime);
+
+	//Allocator calls of the frame are published as counters by FMalloc::UpdateStats.
+	for (const FStatMessage& Stat : NonStackStats)
+	{
+		const FName Name = Stat.NameAndInfo.GetShortName();
+
+		if (Name == MallocCallsName || Name == ReallocCallsName || Name == FreeCallsName)
+		{
+			Allocations.AddFrameCost(Allocations.FindOrAddRow(Name, [](FName StatName) { return StatName.ToString().RightChop(5); }), double(Stat.GetValue_int64()));
+		}
+	}
+
+	Frames++;
+	BlueprintTime.Add(FrameBlueprintTime);
+	Ticks.EndFrame();
+	Tickables.EndFrame();
+	Allocations.EndFrame();
+}
+#endif
+
+UEnvironmentBenchmark::UEnvironmentBenchmark()
+	: Frames(900)
+	, WarmupFrames(60)
+	, FixedFrameRate(15.0f)
+	, StartHour(5.0f)
+	, Hours(24.0f)
+	, RecordInterval(1.0f)
+	, DefaultPathRadius(20000.0f)
+	, LastFrameSeconds(0.0)
+	, GarbageCollectStartSeconds(0.0)
+	, UsedPhysicalAtStart(0)
+	, bSavedUseFixedTimeStep(false)
+	, SavedFixedDeltaTime(0.0)
+	, RunFrames(0)
+	, Frame(0)
+	, RecordSeconds(0.0f)
+	, State(EState::Idle)
+	, bExitWhenFinished(false)
+	, bRecording(false)
+	, bCheckedCommandLine(false)
+{
+}
+
+UEnvironmentBenchmark* UEnvironmentBenchmark::Get(UWorld* World)
+{
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (UEnvironmentBenchmark* Benchmark = Cast<UEnvironmentBenchmark>(Object))
+		{
+			return Benchmark;
+		}
+	}
+
+	UEnvironmentBenchmark* Benchmark = NewObject<UEnvironmentBenchmark>(World);
+	World->PerModuleDataObjects.Add(Benchmark);
+
+	return Benchmark;
+}
+
+bool UEnvironmentBenchmark::Start(int32 NumFrames, bool bExit)
+{
+	if (IsRunning() || bRecording)
+	{
+		return false;
+	}
+
+	RunFrames = NumFrames > 0 ? NumFrames : FMath::Max(Frames, 1);
+	bExitWhenFinished = bExit;
+	State = EState::WaitingForPawn;
+
+	return true;
+}
+
+void UEnvironmentBenchmark::ToggleRecording()
+{
+	if (IsRunning())
+	{
+		return;
+	}
+
+	bRecording = !bRecording;
+
+	if (bRecording)
+	{
+		FlythroughPath.Reset();
+
+		//First control point on the next tick.
+		RecordSeconds = RecordInterval;
+		UE_LOG(LogEnvironmentBenchmark, Display, TEXT("Recording the benchmark path, run Environment.RecordFlythrough again to stop."));
+	}
+	else
+	{
+		SaveConfig();
+		UE_LOG(LogEnvironmentBenchmark, Display, TEXT("Recorded %d control points to %s, copy them to DefaultGame.ini to share them."), FlythroughPath.Num(), *GetClass()->GetConfigName());
+	}
+}
+
+void UEnvironmentBenchmark::RecordSample(float DeltaTime)
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	APawn* Pawn = PlayerController != nullptr ? PlayerController->GetPawn() : nullptr;
+
+	RecordSeconds += DeltaTime;
+
+	if (Pawn == nullptr || RecordSeconds < RecordInterval)
+	{
+		return;
+	}
+
+	RecordSeconds = 0.0f;
+	FlythroughPath.Add(FTransform(PlayerController->GetControlRotation(), Pawn->GetActorLocation()));
+}
+
+void UEnvironmentBenchmark::BeginRun(APawn* Pawn)
+{
+	using namespace EnvironmentBenchmark;
+
+	TArray<FTransform> Path = FlythroughPath;
+
+	//Without a recorded path the pawn circles its start, looking along the circuit.
+	if (Path.Num() == 0)
+	{
+		const FVector Center = Pawn->GetActorLocation();
+
+		for (int32 Index = 0; Index <= NumCircuitPoints; Index++)
+		{
+			const float Angle = Index * 360.0f / NumCircuitPoints;
+			const FVector Direction = FRotator(0.0f, Angle, 0.0f).Vector();
+
+			Path.Add(FTransform(FRotator(0.0f, Angle + 90.0f, 0.0f), Center + Direction * DefaultPathRadius));
+		}
+	}
+
+	PathPositions.Reset();
+	PathRotations.Reset();
+
+	for (int32 Index = 0; Index < Path.Num(); Index++)
+	{
+		PathPositions.Points[PathPositions.AddPoint(Index, Path[Index].GetLocation())].InterpMode = CIM_CurveAuto;
+		PathRotations.Points[PathRotations.AddPoint(Index, Path[Index].GetRotation())].InterpMode = CIM_CurveAuto;
+	}
+
+	PathPositions.AutoSetTangents();
+	PathRotations.AutoSetTangents();
+
+	const UEnvironmentViewModel* ViewModel = UEnvironmentViewModel::Get(GetWorld());
+	StartTime = (ViewModel != nullptr ? ViewModel->GetLocalTime().GetDate() : FDateTime::Now().GetDate()) + FTimespan::FromHours(StartHour);
+
+	//Fixed steps without frame rate limiting, the run is as fast as the machine and simulates the same every time.
+	bSavedUseFixedTimeStep = FApp::UseFixedTimeStep();
+	SavedFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(1.0 / FMath::Max(FixedFrameRate, 1.0f));
+
+	Frame = 0;
+	State = EState::Warmup;
+
+	UE_LOG(LogEnvironmentBenchmark, Log, TEXT("Benchmark of %d frames after %d warmup frames along %d control points from %s."),
+		RunFrames, WarmupFrames, Path.Num(), *StartTime.ToString());
+}
+
+void UEnvironmentBenchmark::Fly(APawn* Pawn, float Alpha)
+{
+	const float Key = Alpha * (PathPositions.Points.Num() - 1);
+	const FVector Location = PathPositions.Eval(Key, FVector::ZeroVector);
+	const FRotator Rotation = PathRotations.Eval(Key, FQuat::Identity).Rotator();
+
+	Pawn->SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+
+	if (AController* Controller = Pawn->GetController())
+	{
+		Controller->SetControlRotation(Rotation);
+	}
+
+	if (UPawnMovementComponent* Movement = Pawn->GetMovementComponent())
+	{
+		Movement->StopMovementImmediately();
+	}
+
+	if (UEnvironmentViewModel* ViewModel = UEnvironmentViewModel::Get(GetWorld()))
+	{
+		ViewModel->SetLocalTime(StartTime + FTimespan::FromHours(Hours * Alpha));
+	}
+}
+
+void UEnvironmentBenchmark::BeginMeasuring()
+{
+	FrameTimes = FEnvironmentBenchmarkCost();
+	GarbageCollections = FEnvironmentBenchmarkCost();
+	UsedMemory = FEnvironmentBenchmarkCost();
+
+	PreGarbageCollectHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UEnvironmentBenchmark::OnPreGarbageCollect);
+	PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UEnvironmentBenchmark::OnPostGarbageCollect);
+
+	Stats = MakeShared<FEnvironmentBenchmarkStats, ESPMode::ThreadSafe>();
+
+#if STATS
+	using namespace EnvironmentBenchmark;
+
+	//Per object scopes are only emitted while their group is enabled.
+	StatsMasterEnableAdd();
+	IStatGroupEnableManager::Get().StatGroupEnableManagerCommand(TEXT("enable UObjects"));
+
+	TSharedRef<FEnvironmentBenchmarkStats, ESPMode::ThreadSafe> StatsRef = Stats.ToSharedRef();
+	RunOnStatsThread([StatsRef]()
+	{
+		StatsRef->NewFrameHandle = FStatsThreadState::GetLocalState().NewFrameDelegate.AddThreadSafeSP(StatsRef, &FEnvironmentBenchmarkStats::OnNewFrame);
+	});
+#else
+	UE_LOG(LogEnvironmentBenchmark, Warning, TEXT("Built without stats, tick, Blueprint and allocation costs aren't measured."));
+#endif
+
+	UsedPhysicalAtStart = FPlatformMemory::GetStats().UsedPhysical;
+	LastFrameSeconds = FPlatformTime::Seconds();
+	State = EState::Measuring;
+}
+
+void UEnvironmentBenchmark::MeasureFrame()
+{
+	const double Seconds = FPlatformTime::Seconds();
+
+	FrameTimes.Add((Seconds - LastFrameSeconds) * 1000.0);
+	UsedMemory.Add(FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0));
+	LastFrameSeconds = Seconds;
+}
+
+void UEnvironmentBenchmark::OnPreGarbageCollect()
+{
+	GarbageCollectStartSeconds = FPlatformTime::Seconds();
+}
+
+void UEnvironmentBenchmark::OnPostGarbageCollect()
+{
+	GarbageCollections.Add((FPlatformTime::Seconds() - GarbageCollectStartSeconds) * 1000.0);
+}
+
+void UEnvironmentBenchmark::StopCollecting()
+{
+#if STATS
+	if (Stats.IsValid() && Stats->NewFrameHandle.IsValid())
+	{
+		using namespace EnvironmentBenchmark;
+
+		TSharedRef<FEnvironmentBenchmarkStats, ESPMode::ThreadSafe> StatsRef = Stats.ToSharedRef();
+		RunOnStatsThread([StatsRef]()
+		{
+			FStatsThreadState::GetLocalState().NewFrameDelegate.Remove(StatsRef->NewFrameHandle);
+			StatsRef->NewFrameHandle.Reset();
+		});
+
+		IStatGroupEnableManager::Get().StatGroupEnableManagerCommand(TEXT("disable UObjects"));
+		StatsMasterEnableSubtract();
+	}
+#endif
+
+	if (PreGarbageCollectHandle.IsValid())
+	{
+		FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGarbageCollectHandle);
+		FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+		PreGarbageCollectHandle.Reset();
+		PostGarbageCollectHandle.Reset();
+	}
+
+	if (State == EState::Warmup || State == EState::Measuring)
+	{
+		FApp::SetUseFixedTimeStep(bSavedUseFixedTimeStep);
+		FApp::SetFixedDeltaTime(SavedFixedDeltaTime);
+	}
+}
+
+void UEnvironmentBenchmark::Finish()
+{
+	StopCollecting();
+
+	if (State == EState::Measuring)
+	{
+		const FString SummaryPath = WriteSummary();
+
+		UE_LOG(LogEnvironmentBenchmark, Log, TEXT("Benchmark finished, %d frames at %.3f ms mean, %.3f ms max, summary written to %s."),
+			FrameTimes.Count, FrameTimes.Count > 0 ? FrameTimes.Total / FrameTimes.Count : 0.0, FrameTimes.Max, *SummaryPath);
+	}
+
+	Stats.Reset();
+	State = EState::Idle;
+
+	if (bExitWhenFinished)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+FString UEnvironmentBenchmark::WriteSummary() const
+{
+	using namespace EnvironmentBenchmark;
+
+	FString Csv = TEXT("Category,Name,Count,Total,Mean,Max,Unit,Growth\n");
+
+	AddRow(Csv, TEXT("Frame"), TEXT("FrameTime"), FrameTimes.Count, FrameTimes.Total, FrameTimes.Max, TEXT("ms"));
+	AddRow(Csv, TEXT("GC"), TEXT("CollectGarbage"), GarbageCollections.Count, GarbageCollections.Total, GarbageCollections.Max, TEXT("ms"));
+
+	//Growth is the peak over the measured frames minus the memory used when they started.
+	const double UsedPhysicalGrowth = UsedMemory.Count > 0 ? UsedMemory.Max - UsedPhysicalAtStart / (1024.0 * 1024.0) : 0.0;
+	AddRow(Csv, TEXT("Memory"), TEXT("UsedPhysical"), UsedMemory.Count, UsedMemory.Total, UsedMemory.Max, TEXT("MB"), &UsedPhysicalGrowth);
+
+	if (Stats.IsValid())
+	{
+		FScopeLock Lock(&Stats->CriticalSection);
+
+		AddRows(Csv, TEXT("Memory"), Stats->Allocations, Stats->Frames, TEXT("calls"));
+		AddRow(Csv, TEXT("Blueprint"), TEXT("BlueprintVM"), Stats->Frames, Stats->BlueprintTime.Total, Stats->BlueprintTime.Max, TEXT("ms"));
+		AddRows(Csv, TEXT("Tickable"), Stats->Tickables, Stats->Frames, TEXT("ms"));
+		AddRows(Csv, TEXT("Tick"), Stats->Ticks, Stats->Frames, TEXT("ms"));
+	}
+
+	const FString SummaryPath = !OutputPath.IsEmpty() ? OutputPath : FPaths::ProjectSavedDir() / TEXT("Benchmarks") /
+		FString::Printf(TEXT("Environment-%s-%s.csv"), *GetWorld()->GetMapName(), *FDateTime::Now().ToString());
+
+	if (!FFileHelper::SaveStringToFile(Csv, *SummaryPath))
+	{
+		UE_LOG(LogEnvironmentBenchmark, Error, TEXT("Failed to write %s."), *SummaryPath);
+	}
+
+	return SummaryPath;
+}
+
+void UEnvironmentBenchmark::CheckCommandLine()
+{
+	bCheckedCommandLine = true;
+
+	int32 NumFrames = 0;
+
+	if (!FParse::Value(FCommandLine::Get(), TEXT("EnvironmentBenchmark="), NumFrames) && !FParse::Param(FCommandLine::Get(), TEXT("EnvironmentBenchmark")))
+	{
+		return;
+	}
+
+	FParse::Value(FCommandLine::Get(), TEXT("EnvironmentBenchmarkOutput="), OutputPath);
+
+	Start(NumFrames, true);
+}
+
+void UEnvironmentBenchmark::BeginDestroy()
+{
+	StopCollecting();
+	State = EState::Idle;
+
+	Super::BeginDestroy();
+}
+
+void UEnvironmentBenchmark::Tick(float DeltaTime)
+{
+	if (!bCheckedCommandLine)
+	{
+		CheckCommandLine();
+	}
+
+	if (bRecording)
+	{
+		RecordSample(DeltaTime);
+	}
+
+	if (State == EState::Idle)
+	{
+		return;
+	}
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	APawn* Pawn = PlayerController != nullptr ? PlayerController->GetPawn() : nullptr;
+
+	if (Pawn == nullptr)
+	{
+		if (State != EState::WaitingForPawn)
+		{
+			UE_LOG(LogEnvironmentBenchmark, Warning, TEXT("The player lost its pawn, the benchmark stops after %d frames."), Frame);
+			Finish();
+		}
+
+		return;
+	}
+
+	if (State == EState::WaitingForPawn)
+	{
+		BeginRun(Pawn);
+	}
+	else if (State == EState::Measuring)
+	{
+		//The frame flown on the last tick is over.
+		MeasureFrame();
+	}
+
+	const int32 Warmup = FMath::Max(WarmupFrames, 0);
+	const int32 TotalFrames = Warmup + RunFrames;
+
+	if (Frame >= TotalFrames)
+	{
+		Finish();
+		return;
+	}
+
+	if (Frame == Warmup)
+	{
+		BeginMeasuring();
+	}
+
+	Fly(Pawn, TotalFrames > 1 ? float(Frame) / (TotalFrames - 1) : 0.0f);
+	Frame++;
+}
+
+bool UEnvironmentBenchmark::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != nullptr && GetWorld()->IsGameWorld() && GetWorld()->HasBegunPlay();
+}
+
+TStatId UEnvironmentBenchmark::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnvironmentBenchmark, STATGROUP_Tickables);
+}
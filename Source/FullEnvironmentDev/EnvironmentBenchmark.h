@@ -0,0 +1,183 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Tickable.h"
+#include "Math/InterpCurve.h"
+
+#include "EnvironmentBenchmark.generated.h"
+
+class APawn;
+struct FEnvironmentBenchmarkStats;
+
+/** Accumulated cost of one row of the benchmark summary. */
+struct FEnvironmentBenchmarkCost
+{
+	/** Frames or events that contributed. */
+	int32 Count = 0;
+
+	double Total = 0.0;
+	double Max = 0.0;
+
+	void Add(double Value)
+	{
+		Count++;
+		Total += Value;
+		Max = FMath::Max(Max, Value);
+	}
+};
+
+/**
+* Repeatable game-thread benchmark of the environment. The player pawn flies along a recorded spline for a fixed
+* number of frames at a fixed time step while the local time advances from StartHour by Hours, so the sky, clouds,
+* solar bodies and weather effects see the same frames every run. Per-actor-class tick cost, Blueprint VM time and
+* allocator calls come from the stats system and need a build with stats; frame time, GC and memory are measured
+* natively. The summary is written as CSV to Saved/Benchmarks with the columns
+* Category,Name,Count,Total,Mean,Max,Unit,Growth, per-frame rows are averaged over the measured frames and Growth is
+* only set on the UsedPhysical row, the peak over the measured frames minus the memory used when they started.
+*
+* Runs without a GPU: UE4Editor FullEnvironmentDev -game -nullrhi -EnvironmentBenchmark[=<frames>] [-EnvironmentBenchmarkOutput=<file>]
+* exits when the summary is written. Record a path with the Environment.RecordFlythrough console command,
+* run in game with Environment.Benchmark.
+*/
+UCLASS(Config = Game)
+class FULLENVIRONMENTDEV_API UEnvironmentBenchmark : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UEnvironmentBenchmark();
+
+	/** Benchmark of a world, created on the first call. */
+	static UEnvironmentBenchmark* Get(UWorld* World);
+
+	/** Start a run once the player has a pawn.
+	* @param NumFrames - measured frames, zero uses Frames.
+	* @param bExit - request exit when the summary is written.
+	* @return false if a run or a recording is in progress.
+	*/
+	bool Start(int32 NumFrames, bool bExit);
+
+	/** Start or stop sampling the player's view into FlythroughPath, saved to config when stopped. */
+	void ToggleRecording();
+
+	bool IsRunning() const { return State != EState::Idle; }
+
+	/** Measured frames. */
+	UPROPERTY(Config)
+	int32 Frames;
+
+	/** Frames flown before measuring, pools and streaming settle during them. */
+	UPROPERTY(Config)
+	int32 WarmupFrames;
+
+	/** Fixed frame rate of the run, the simulated content doesn't depend on the machine. */
+	UPROPERTY(Config)
+	float FixedFrameRate;
+
+	/** Local hour at the first frame. */
+	UPROPERTY(Config)
+	float StartHour;
+
+	/** Game hours the local time advances over the run, warmup included. */
+	UPROPERTY(Config)
+	float Hours;
+
+	/** Recorded flythrough, control points of a spline flown once per run. */
+	UPROPERTY(Config)
+	TArray<FTransform> FlythroughPath;
+
+	/** Seconds between two recorded control points. */
+	UPROPERTY(Config)
+	float RecordInterval;
+
+	/** Radius of the circuit around the pawn start flown without a recorded path. */
+	UPROPERTY(Config)
+	float DefaultPathRadius;
+
+	// UObject interface
+	virtual void BeginDestroy() override;
+	// End of UObject interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	enum class EState : uint8
+	{
+		Idle,
+		WaitingForPawn,
+		Warmup,
+		Measuring
+	};
+
+	/** Build the spline, fix the time step and start the warmup. */
+	void BeginRun(APawn* Pawn);
+
+	/** Move the pawn and the local time to a point of the run.
+	* @param Alpha - 0 at the first frame, 1 at the last.
+	*/
+	void Fly(APawn* Pawn, float Alpha);
+
+	void BeginMeasuring();
+
+	/** Sample a frame of game-thread cost. */
+	void MeasureFrame();
+
+	/** Stop collecting, write the summary and restore the time step. */
+	void Finish();
+
+	/** Unbind the stats and GC listeners and restore the time step. */
+	void StopCollecting();
+
+	/** Write the summary CSV.
+	* @return path written to.
+	*/
+	FString WriteSummary() const;
+
+	void RecordSample(float DeltaTime);
+
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+
+	/** Start a run requested on the command line. */
+	void CheckCommandLine();
+
+	FInterpCurveVector PathPositions;
+	FInterpCurveQuat PathRotations;
+
+	FDateTime StartTime;
+
+	/** Stats thread side of the run, shared so late frames never touch a collected object. */
+	TSharedPtr<FEnvironmentBenchmarkStats, ESPMode::ThreadSafe> Stats;
+
+	FEnvironmentBenchmarkCost FrameTimes;
+	FEnvironmentBenchmarkCost GarbageCollections;
+	FEnvironmentBenchmarkCost UsedMemory;
+
+	FDelegateHandle PreGarbageCollectHandle;
+	FDelegateHandle PostGarbageCollectHandle;
+
+	double LastFrameSeconds;
+	double GarbageCollectStartSeconds;
+	uint64 UsedPhysicalAtStart;
+
+	bool bSavedUseFixedTimeStep;
+	double SavedFixedDeltaTime;
+
+	FString OutputPath;
+
+	int32 RunFrames;
+	int32 Frame;
+	float RecordSeconds;
+
+	EState State;
+	bool bExitWhenFinished;
+	bool bRecording;
+	bool bCheckedCommandLine;
+};
@@ -0,0 +1,663 @@
+// 2015 - Community based open project
+
+#include "EnvironmentClock.h"
+#include "EnvironmentViewModel.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogEnvironmentClock, Log, All);
+
+namespace EnvironmentClock
+{
+	double ToSeconds(const FDateTime& Time)
+	{
+		return double(Time.GetTicks()) / ETimespan::TicksPerSecond;
+	}
+
+	FDateTime ToDateTime(double Seconds)
+	{
+		return FDateTime(int64(FMath::FloorToDouble(Seconds * ETimespan::TicksPerSecond + 0.5)));
+	}
+
+	void TimeDilation(const TArray<FString>& Args, UWorld* World)
+	{
+		UEnvironmentClock* Clock = UEnvironmentClock::Get(World);
+
+		if (Clock == nullptr)
+		{
+			return;
+		}
+
+		if (Args.Num() > 0)
+		{
+			Clock->SetTimeDilation(FCString::Atof(*Args[0]));
+		}
+
+		UE_LOG(LogEnvironmentClock, Display, TEXT("%s, time dilation %.2f%s."), *Clock->GetLocalTime().ToString(), Clock->GetTimeDilation(),
+			Clock->bDriveLocalTime ? TEXT("") : TEXT(", following the view-model"));
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs TimeDilationCommand(
+		TEXT("Environment.TimeDilation"),
+		TEXT("Show the environment clock, or set its time dilation. Arguments: [Dilation]."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&TimeDilation));
+}
+
+UEnvironmentClock::UEnvironmentClock()
+	: bDriveLocalTime(false)
+	, TimeDilation(60.0f)
+	, Resolution(1.0f)
+	, Seconds(0.0)
+	, CurrentTick(0)
+	, NextSerial(0)
+	, JumpDepth(0)
+	, bHasTime(false)
+	, bDispatching(false)
+{
+	FMemory::Memset(Heads, 0xff, sizeof(Heads));
+	FMemory::Memset(Tails, 0xff, sizeof(Tails));
+	FMemory::Memzero(Occupied, sizeof(Occupied));
+}
+
+UEnvironmentClock* UEnvironmentClock::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (UEnvironmentClock* Clock = Cast<UEnvironmentClock>(Object))
+		{
+			return Clock;
+		}
+	}
+
+	UEnvironmentClock* Clock = NewObject<UEnvironmentClock>(World);
+	World->PerModuleDataObjects.Add(Clock);
+
+	return Clock;
+}
+
+FDateTime UEnvironmentClock::GetLocalTime() const
+{
+	return EnvironmentClock::ToDateTime(Seconds);
+}
+
+void UEnvironmentClock::AdvanceTo(const FDateTime& LocalTime)
+{
+	Advance(EnvironmentClock::ToSeconds(LocalTime));
+}
+
+void UEnvironmentClock::Advance(double Target)
+{
+	if (bDispatching)
+	{
+		UE_LOG(LogEnvironmentClock, Warning, TEXT("The clock can't be moved from inside a clock event."));
+		return;
+	}
+
+	if (!bHasTime || Target < Seconds)
+	{
+		Rebase(Target);
+		return;
+	}
+
+	const int64 TargetTick = GetTick(Target);
+
+	bDispatching = true;
+	JumpDepth++;
+
+	for (;;)
+	{
+		DispatchDue(Target);
+
+		//Lower levels always expire before higher ones, the lowest occupied slot holds the next timers.
+		int32 Level = 0;
+
+		while (Level < NumLevels && Occupied[Level] == 0)
+		{
+			Level++;
+		}
+
+		if (Level == NumLevels)
+		{
+			if (Heads[OverflowList] == INDEX_NONE)
+			{
+				break;
+			}
+
+			//Overflow expires after anything in the wheel, it's only looked at once the wheel is empty.
+			int64 OverflowTick = MAX_int64;
+
+			for (int32 Index = Heads[OverflowList]; Index != INDEX_NONE; Index = Timers[Index].Next)
+			{
+				OverflowTick = FMath::Min(OverflowTick, Timers[Index].Expiry);
+			}
+
+			if (OverflowTick > TargetTick)
+			{
+				break;
+			}
+
+			//Overflow lies in a later block, moving there relinks it.
+			SetCurrentTick(OverflowTick);
+			continue;
+		}
+
+		const int32 Slot = int32(FMath::CountTrailingZeros64(Occupied[Level]));
+		const int32 Shift = Level * SlotBits;
+		const int64 SlotTick = ((CurrentTick >> (Shift + SlotBits)) << (Shift + SlotBits)) | (int64(Slot) << Shift);
+
+		if (SlotTick > TargetTick)
+		{
+			break;
+		}
+
+		SetCurrentTick(SlotTick);
+		Cascade(Level, Slot);
+	}
+
+	SetCurrentTick(TargetTick);
+	Seconds = Target;
+
+	JumpDepth--;
+	bDispatching = false;
+
+	if (JumpDepth == 0)
+	{
+		FlushCoalesced();
+	}
+}
+
+void UEnvironmentClock::EndJump()
+{
+	JumpDepth = FMath::Max(JumpDepth - 1, 0);
+
+	if (JumpDepth == 0 && !bDispatching)
+	{
+		FlushCoalesced();
+	}
+}
+
+FEnvironmentClockHandle UEnvironmentClock::ScheduleAt(const FDateTime& Time, FEnvironmentClockCallback&& Callback, EEnvironmentClockCatchUp CatchUp, const UObject* Owner)
+{
+	FTimer Timer;
+	Timer.Callback = MoveTemp(Callback);
+	Timer.Owner = Owner;
+	Timer.bHasOwner = Owner != nullptr;
+	Timer.CatchUp = CatchUp;
+	Timer.Time = EnvironmentClock::ToSeconds(Time);
+
+	return AddTimer(MoveTemp(Timer));
+}
+
+FEnvironmentClockHandle UEnvironmentClock::ScheduleEvery(const FTimespan& Interval, const FTimespan& Offset, FEnvironmentClockCallback&& Callback, EEnvironmentClockCatchUp CatchUp, const UObject* Owner)
+{
+	FTimer Timer;
+	Timer.Callback = MoveTemp(Callback);
+	Timer.Owner = Owner;
+	Timer.bHasOwner = Owner != nullptr;
+	Timer.CatchUp = CatchUp;
+	Timer.Repeat = ERepeat::Interval;
+	Timer.Period = FMath::Max(Interval.GetTotalSeconds(), double(FMath::Max(Resolution, KINDA_SMALL_NUMBER)));
+	Timer.Offset = Offset.GetTotalSeconds();
+	SetNextOccurrence(Timer);
+
+	return AddTimer(MoveTemp(Timer));
+}
+
+FEnvironmentClockHandle UEnvironmentClock::ScheduleMonthly(int32 Months, const FTimespan& Offset, FEnvironmentClockCallback&& Callback, EEnvironmentClockCatchUp CatchUp, const UObject* Owner)
+{
+	FTimer Timer;
+	Timer.Callback = MoveTemp(Callback);
+	Timer.Owner = Owner;
+	Timer.bHasOwner = Owner != nullptr;
+	Timer.CatchUp = CatchUp;
+	Timer.Repeat = ERepeat::Months;
+	Timer.Period = FMath::Max(Months, 1);
+	Timer.Offset = Offset.GetTotalSeconds();
+	SetNextOccurrence(Timer);
+
+	return AddTimer(MoveTemp(Timer));
+}
+
+FEnvironmentClockHandle UEnvironmentClock::ScheduleEventAt(FDateTime Time, FOnEnvironmentClockEvent Event, EEnvironmentClockCatchUp CatchUp)
+{
+	if (!Event.IsBound())
+	{
+		return FEnvironmentClockHandle();
+	}
+
+	return ScheduleAt(Time, [Event](const FDateTime& EventTime, int32 Occurrences) { Event.ExecuteIfBound(EventTime, Occurrences); }, CatchUp, Event.GetUObject());
+}
+
+FEnvironmentClockHandle UEnvironmentClock::ScheduleEventEvery(FTimespan Interval, FTimespan Offset, FOnEnvironmentClockEvent Event, EEnvironmentClockCatchUp CatchUp)
+{
+	if (!Event.IsBound())
+	{
+		return FEnvironmentClockHandle();
+	}
+
+	return ScheduleEvery(Interval, Offset, [Event](const FDateTime& EventTime, int32 Occurrences) { Event.ExecuteIfBound(EventTime, Occurrences); }, CatchUp, Event.GetUObject());
+}
+
+FEnvironmentClockHandle UEnvironmentClock::ScheduleEventMonthly(int32 Months, FTimespan Offset, FOnEnvironmentClockEvent Event, EEnvironmentClockCatchUp CatchUp)
+{
+	if (!Event.IsBound())
+	{
+		return FEnvironmentClockHandle();
+	}
+
+	return ScheduleMonthly(Months, Offset, [Event](const FDateTime& EventTime, int32 Occurrences) { Event.ExecuteIfBound(EventTime, Occurrences); }, CatchUp, Event.GetUObject());
+}
+
+void UEnvironmentClock::Cancel(FEnvironmentClockHandle& Handle)
+{
+	if (IsScheduled(Handle))
+	{
+		RemoveTimer(Handle.Index);
+	}
+
+	Handle = FEnvironmentClockHandle();
+}
+
+bool UEnvironmentClock::IsScheduled(const FEnvironmentClockHandle& Handle) const
+{
+	return Handle.IsValid() && Timers.IsAllocated(Handle.Index) && Timers[Handle.Index].Serial == Handle.Serial;
+}
+
+FEnvironmentClockHandle UEnvironmentClock::AddTimer(FTimer&& Timer)
+{
+	//Serials tell a reused index apart from the timer a handle was made for.
+	Timer.Serial = ++NextSerial;
+
+	FEnvironmentClockHandle Handle;
+	Handle.Serial = Timer.Serial;
+	Handle.Index = Timers.Add(MoveTemp(Timer));
+
+	Insert(Handle.Index);
+
+	return Handle;
+}
+
+int64 UEnvironmentClock::GetOccurrenceIndex(const FTimer& Timer, double Time) const
+{
+	const double GridTime = FMath::Max(Time - Timer.Offset, 0.0);
+
+	if (Timer.Repeat == ERepeat::Months)
+	{
+		const FDateTime Date = EnvironmentClock::ToDateTime(GridTime);
+		const int64 Month = int64(Date.GetYear()) * 12 + Date.GetMonth() - 1;
+
+		return Month / int64(Timer.Period);
+	}
+
+	return int64(FMath::FloorToDouble(GridTime / Timer.Period));
+}
+
+double UEnvironmentClock::GetOccurrenceTime(const FTimer& Timer, int64 Occurrence) const
+{
+	if (Timer.Repeat == ERepeat::Months)
+	{
+		const int64 Month = Occurrence * int64(Timer.Period);
+
+		return EnvironmentClock::ToSeconds(FDateTime(int32(Month / 12), int32(Month % 12) + 1, 1)) + Timer.Offset;
+	}
+
+	return Timer.Offset + Occurrence * Timer.Period;
+}
+
+void UEnvironmentClock::SetNextOccurrence(FTimer& Timer) const
+{
+	Timer.Occurrence = GetOccurrenceIndex(Timer, Seconds) + 1;
+	Timer.Time = GetOccurrenceTime(Timer, Timer.Occurrence);
+}
+
+int64 UEnvironmentClock::GetTick(double Time) const
+{
+	return int64(FMath::FloorToDouble(Time / FMath::Max(Resolution, KINDA_SMALL_NUMBER)));
+}
+
+void UEnvironmentClock::Insert(int32 Index)
+{
+	FTimer& Timer = Timers[Index];
+
+	//Rounded up, a timer never fires before its time.
+	Timer.Expiry = int64(FMath::CeilToDouble(Timer.Time / FMath::Max(Resolution, KINDA_SMALL_NUMBER)));
+
+	if (Timer.Expiry <= CurrentTick)
+	{
+		Link(Index, DueList);
+		return;
+	}
+
+	//The highest digit the expiry differs from the current tick in picks the level.
+	const int32 Level = int32(FMath::FloorLog2_64(uint64(Timer.Expiry ^ CurrentTick))) / SlotBits;
+
+	if (Level >= NumLevels)
+	{
+		Link(Index, OverflowList);
+		return;
+	}
+
+	const int32 Slot = int32(Timer.Expiry >> (Level * SlotBits)) & (NumSlots - 1);
+
+	Link(Index, Level * NumSlots + Slot);
+	Occupied[Level] |= uint64(1) << Slot;
+}
+
+void UEnvironmentClock::Link(int32 Index, int32 List)
+{
+	FTimer& Timer = Timers[Index];
+	Timer.List = List;
+	Timer.Prev = Tails[List];
+	Timer.Next = INDEX_NONE;
+
+	if (Tails[List] != INDEX_NONE)
+	{
+		Timers[Tails[List]].Next = Index;
+	}
+	else
+	{
+		Heads[List] = Index;
+	}
+
+	Tails[List] = Index;
+}
+
+void UEnvironmentClock::Unlink(int32 Index)
+{
+	FTimer& Timer = Timers[Index];
+	const int32 List = Timer.List;
+
+	if (List == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (Timer.Prev != INDEX_NONE)
+	{
+		Timers[Timer.Prev].Next = Timer.Next;
+	}
+	else
+	{
+		Heads[List] = Timer.Next;
+	}
+
+	if (Timer.Next != INDEX_NONE)
+	{
+		Timers[Timer.Next].Prev = Timer.Prev;
+	}
+	else
+	{
+		Tails[List] = Timer.Prev;
+	}
+
+	if (List < DueList && Heads[List] == INDEX_NONE)
+	{
+		Occupied[List / NumSlots] &= ~(uint64(1) << (List % NumSlots));
+	}
+
+	Timer.List = INDEX_NONE;
+	Timer.Prev = INDEX_NONE;
+	Timer.Next = INDEX_NONE;
+}
+
+void UEnvironmentClock::DispatchDue(double Target)
+{
+	while (Heads[DueList] != INDEX_NONE)
+	{
+		const int32 Index = Heads[DueList];
+		Unlink(Index);
+
+		FTimer& Timer = Timers[Index];
+
+		if (Timer.bHasOwner && !Timer.Owner.IsValid())
+		{
+			RemoveTimer(Index);
+			continue;
+		}
+
+		const double Time = Timer.Time;
+
+		if (Timer.CatchUp == EEnvironmentClockCatchUp::Coalesce)
+		{
+			int64 Occurrences = 1;
+			Timer.PendingTime = Time;
+
+			//Every occurrence up to the target is counted at once, the next one lies beyond it.
+			if (Timer.Repeat != ERepeat::Once)
+			{
+				const int64 LastOccurrence = FMath::Max(GetOccurrenceIndex(Timer, Target), Timer.Occurrence);
+
+				Occurrences += LastOccurrence - Timer.Occurrence;
+				Timer.PendingTime = GetOccurrenceTime(Timer, LastOccurrence);
+				Timer.Occurrence = LastOccurrence + 1;
+				Timer.Time = GetOccurrenceTime(Timer, Timer.Occurrence);
+				Insert(Index);
+			}
+
+			if (Timer.PendingOccurrences == 0)
+			{
+				Coalesced.Emplace(Index, Timer.Serial);
+			}
+
+			Timer.PendingOccurrences = int32(FMath::Min<int64>(Timer.PendingOccurrences + Occurrences, MAX_int32));
+			continue;
+		}
+
+		const bool bRepeat = Timer.Repeat != ERepeat::Once;
+
+		//Rescheduled before the call, so the event can cancel itself.
+		if (bRepeat)
+		{
+			Timer.Occurrence++;
+			Timer.Time = GetOccurrenceTime(Timer, Timer.Occurrence);
+			Insert(Index);
+		}
+
+		//Events see the clock at their own time.
+		Seconds = FMath::Max(Seconds, Time);
+
+		if (Fire(Index, Time, 1) && !bRepeat)
+		{
+			RemoveTimer(Index);
+		}
+	}
+}
+
+void UEnvironmentClock::Cascade(int32 Level, int32 Slot)
+{
+	const int32 List = Level * NumSlots + Slot;
+	int32 Index = Heads[List];
+
+	Heads[List] = INDEX_NONE;
+	Tails[List] = INDEX_NONE;
+	Occupied[Level] &= ~(uint64(1) << Slot);
+
+	//The current tick entered the slot, its timers move down a level or become due in order.
+	while (Index != INDEX_NONE)
+	{
+		const int32 Next = Timers[Index].Next;
+		Insert(Index);
+		Index = Next;
+	}
+}
+
+void UEnvironmentClock::SetCurrentTick(int64 Tick)
+{
+	const bool bNewBlock = (Tick >> (NumLevels * SlotBits)) != (CurrentTick >> (NumLevels * SlotBits));
+
+	CurrentTick = Tick;
+
+	//Overflow timers were placed from an earlier block, the ones in the new block belong into the wheel now.
+	if (bNewBlock)
+	{
+		CascadeOverflow();
+	}
+}
+
+void UEnvironmentClock::CascadeOverflow()
+{
+	int32 Index = Heads[OverflowList];
+
+	Heads[OverflowList] = INDEX_NONE;
+	Tails[OverflowList] = INDEX_NONE;
+
+	while (Index != INDEX_NONE)
+	{
+		const int32 Next = Timers[Index].Next;
+		Insert(Index);
+		Index = Next;
+	}
+}
+
+void UEnvironmentClock::Rebase(double Time)
+{
+	Seconds = Time;
+	CurrentTick = GetTick(Time);
+	bHasTime = true;
+
+	FMemory::Memset(Heads, 0xff, sizeof(Heads));
+	FMemory::Memset(Tails, 0xff, sizeof(Tails));
+	FMemory::Memzero(Occupied, sizeof(Occupied));
+
+	//Held back timers aren't linked and stay held back, everything else is placed again.
+	for (int32 Index = 0; Index < Timers.GetMaxIndex(); Index++)
+	{
+		if (!Timers.IsAllocated(Index) || Timers[Index].List == INDEX_NONE)
+		{
+			continue;
+		}
+
+		FTimer& Timer = Timers[Index];
+
+		if (Timer.Repeat != ERepeat::Once)
+		{
+			SetNextOccurrence(Timer);
+		}
+
+		Insert(Index);
+	}
+}
+
+void UEnvironmentClock::FlushCoalesced()
+{
+	if (Coalesced.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<TPair<int32, int32>> Pending = MoveTemp(Coalesced);
+	Coalesced.Reset();
+
+	Pending.RemoveAll([this](const TPair<int32, int32>& Entry) { return !Timers.IsAllocated(Entry.Key) || Timers[Entry.Key].Serial != Entry.Value; });
+	Pending.StableSort([this](const TPair<int32, int32>& A, const TPair<int32, int32>& B) { return Timers[A.Key].PendingTime < Timers[B.Key].PendingTime; });
+
+	bDispatching = true;
+
+	for (const TPair<int32, int32>& Entry : Pending)
+	{
+		//Earlier events may have cancelled this one.
+		if (!Timers.IsAllocated(Entry.Key) || Timers[Entry.Key].Serial != Entry.Value)
+		{
+			continue;
+		}
+
+		FTimer& Timer = Timers[Entry.Key];
+		const double Time = Timer.PendingTime;
+		const int32 Occurrences = Timer.PendingOccurrences;
+		const bool bRepeat = Timer.Repeat != ERepeat::Once;
+
+		Timer.PendingOccurrences = 0;
+
+		if (Timer.bHasOwner && !Timer.Owner.IsValid())
+		{
+			RemoveTimer(Entry.Key);
+			continue;
+		}
+
+		if (Fire(Entry.Key, Time, Occurrences) && !bRepeat)
+		{
+			RemoveTimer(Entry.Key);
+		}
+	}
+
+	bDispatching = false;
+}
+
+bool UEnvironmentClock::Fire(int32 Index, double Time, int32 Occurrences)
+{
+	//The callback is moved out, timers added meanwhile may reallocate the array.
+	const int32 Serial = Timers[Index].Serial;
+	FEnvironmentClockCallback Callback = MoveTemp(Timers[Index].Callback);
+
+	if (Callback)
+	{
+		Callback(EnvironmentClock::ToDateTime(Time), Occurrences);
+	}
+
+	if (!Timers.IsAllocated(Index) || Timers[Index].Serial != Serial)
+	{
+		return false;
+	}
+
+	Timers[Index].Callback = MoveTemp(Callback);
+
+	return true;
+}
+
+void UEnvironmentClock::RemoveTimer(int32 Index)
+{
+	Unlink(Index);
+	Timers.RemoveAt(Index);
+}
+
+void UEnvironmentClock::Tick(float DeltaTime)
+{
+	using namespace EnvironmentClock;
+
+	UEnvironmentViewModel* ViewModel = UEnvironmentViewModel::Get(GetWorld());
+
+	if (ViewModel == nullptr)
+	{
+		return;
+	}
+
+	//Local time set from elsewhere wins, the sky blueprint, a time warp, the replicator or a loaded state.
+	const FDateTime ViewTime = ViewModel->GetLocalTime();
+
+	if (ViewTime != LastViewTime && ViewTime != FDateTime())
+	{
+		AdvanceTo(ViewTime);
+	}
+
+	//A running time warp moves the clock itself.
+	if (bDriveLocalTime && JumpDepth == 0)
+	{
+		if (!bHasTime)
+		{
+			Rebase(ToSeconds(FDateTime::Now()));
+		}
+
+		Advance(Seconds + double(DeltaTime) * TimeDilation);
+		ViewModel->SetLocalTime(GetLocalTime());
+	}
+
+	LastViewTime = ViewModel->GetLocalTime();
+}
+
+bool UEnvironmentClock::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != nullptr && GetWorld()->IsGameWorld() && GetWorld()->HasBegunPlay();
+}
+
+TStatId UEnvironmentClock::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnvironmentClock, STATGROUP_Tickables);
+}
@@ -0,0 +1,261 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+#include "Containers/SparseArray.h"
+#include "Tickable.h"
+
+#include "EnvironmentClock.generated.h"
+
+/** What a subscriber gets when an advance skips over several occurrences of its event. */
+UENUM(BlueprintType)
+enum class EEnvironmentClockCatchUp : uint8
+{
+	/** Fire every occurrence in order, one call each. */
+	EveryOccurrence,
+
+	/** Fire once with the latest occurrence and their count, after the advance or the whole time warp. */
+	Coalesce
+};
+
+/** Scheduled clock event, cancel it with UEnvironmentClock::Cancel. */
+USTRUCT(BlueprintType)
+struct FEnvironmentClockHandle
+{
+	GENERATED_BODY()
+
+	int32 Index = INDEX_NONE;
+	int32 Serial = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+};
+
+/** Clock event, Time is the occurrence in local time, Occurrences more than one when coalesced. */
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FOnEnvironmentClockEvent, const FDateTime&, Time, int32, Occurrences);
+
+typedef TFunction<void(const FDateTime& Time, int32 Occurrences)> FEnvironmentClockCallback;
+
+/**
+* Native game calendar clock. Local time is kept in double-precision game seconds and either follows the view-model
+* (set by the sky blueprint, the replicator, a loaded state) or, with bDriveLocalTime, advances by TimeDilation game
+* seconds per second and drives the view-model itself.
+*
+* Scheduled events live in a hierarchical timer wheel of Resolution long ticks with occupancy masks per level, so an
+* advance costs the same for any number of subscribers and only visits the slots that hold due events. Repeating
+* events are aligned to the calendar: every hour, every day at 18:00, every new month. Events fire at most a
+* Resolution late and never early. When time moves backwards every event is rescheduled from the new time without
+* firing. A time warp wraps its steps in BeginJump and EndJump, so coalescing subscribers hear about it once.
+*/
+UCLASS(Config = Game, BlueprintType)
+class FULLENVIRONMENTDEV_API UEnvironmentClock : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UEnvironmentClock();
+
+	/** Clock of a world, created on the first call. */
+	UFUNCTION(BlueprintPure, Category = "Environment", meta = (WorldContext = "WorldContextObject"))
+	static UEnvironmentClock* Get(const UObject* WorldContextObject);
+
+	UFUNCTION(BlueprintPure, Category = "Environment")
+	FDateTime GetLocalTime() const;
+
+	/** Game seconds since 0001-01-01. */
+	double GetSeconds() const { return Seconds; }
+
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	void SetTimeDilation(float InTimeDilation) { TimeDilation = FMath::Max(InTimeDilation, 0.0f); }
+
+	UFUNCTION(BlueprintPure, Category = "Environment")
+	float GetTimeDilation() const { return TimeDilation; }
+
+	/** Move the clock to a local time, firing every event on the way. Earlier times reschedule events instead. */
+	void AdvanceTo(const FDateTime& LocalTime);
+
+	/** Start a jump, events to coalesce are held back until the matching EndJump. */
+	void BeginJump() { JumpDepth++; }
+
+	/** End a jump and fire the events held back. */
+	void EndJump();
+
+	/** Schedule an event at a local time.
+	* @param Owner - the event is dropped once it's gone, optional.
+	*/
+	FEnvironmentClockHandle ScheduleAt(const FDateTime& Time, FEnvironmentClockCallback&& Callback, EEnvironmentClockCatchUp CatchUp = EEnvironmentClockCatchUp::EveryOccurrence, const UObject* Owner = nullptr);
+
+	/** Schedule an event repeating on a grid aligned to the calendar.
+	* @param Interval - time between occurrences, at least Resolution.
+	* @param Offset - grid offset from midnight, 18 hours with a day interval fires at 18:00.
+	* @param Owner - the event is dropped once it's gone, optional.
+	*/
+	FEnvironmentClockHandle ScheduleEvery(const FTimespan& Interval, const FTimespan& Offset, FEnvironmentClockCallback&& Callback, EEnvironmentClockCatchUp CatchUp = EEnvironmentClockCatchUp::EveryOccurrence, const UObject* Owner = nullptr);
+
+	/** Schedule an event repeating every few months, aligned to January.
+	* @param Months - months between occurrences, 1 for every new month, 12 for every new year.
+	* @param Offset - offset from the start of the month.
+	* @param Owner - the event is dropped once it's gone, optional.
+	*/
+	FEnvironmentClockHandle ScheduleMonthly(int32 Months, const FTimespan& Offset, FEnvironmentClockCallback&& Callback, EEnvironmentClockCatchUp CatchUp = EEnvironmentClockCatchUp::EveryOccurrence, const UObject* Owner = nullptr);
+
+	UFUNCTION(BlueprintCallable, Category = "Environment", meta = (DisplayName = "Schedule Clock Event At"))
+	FEnvironmentClockHandle ScheduleEventAt(FDateTime Time, FOnEnvironmentClockEvent Event, EEnvironmentClockCatchUp CatchUp);
+
+	UFUNCTION(BlueprintCallable, Category = "Environment", meta = (DisplayName = "Schedule Clock Event Every"))
+	FEnvironmentClockHandle ScheduleEventEvery(FTimespan Interval, FTimespan Offset, FOnEnvironmentClockEvent Event, EEnvironmentClockCatchUp CatchUp);
+
+	UFUNCTION(BlueprintCallable, Category = "Environment", meta = (DisplayName = "Schedule Clock Event Monthly"))
+	FEnvironmentClockHandle ScheduleEventMonthly(int32 Months, FTimespan Offset, FOnEnvironmentClockEvent Event, EEnvironmentClockCatchUp CatchUp);
+
+	/** Cancel an event, the handle is reset. Safe from inside any event. */
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	void Cancel(UPARAM(ref) FEnvironmentClockHandle& Handle);
+
+	UFUNCTION(BlueprintPure, Category = "Environment")
+	bool IsScheduled(const FEnvironmentClockHandle& Handle) const;
+
+	/** Advance local time natively and drive the view-model, instead of following it. */
+	UPROPERTY(Config)
+	bool bDriveLocalTime;
+
+	/** Game seconds per second when driving local time. */
+	UPROPERTY(Config)
+	float TimeDilation;
+
+	/** Game seconds per wheel tick, events fire at most this late. */
+	UPROPERTY(Config)
+	float Resolution;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	enum class ERepeat : uint8
+	{
+		Once,
+		Interval,
+		Months
+	};
+
+	struct FTimer
+	{
+		FEnvironmentClockCallback Callback;
+		TWeakObjectPtr<const UObject> Owner;
+
+		/** Next occurrence in game seconds. */
+		double Time = 0.0;
+
+		/** Interval in game seconds or months between occurrences, and the grid offset in game seconds. */
+		double Period = 0.0;
+		double Offset = 0.0;
+
+		/** Grid index of the next occurrence of a repeating timer. */
+		int64 Occurrence = 0;
+
+		/** Wheel tick of the next occurrence. */
+		int64 Expiry = 0;
+
+		/** Latest held back occurrence and their count while coalescing. */
+		double PendingTime = 0.0;
+		int32 PendingOccurrences = 0;
+
+		int32 Serial = 0;
+
+		/** Wheel list the timer is linked into, INDEX_NONE while firing or held back. */
+		int32 List = INDEX_NONE;
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+
+		ERepeat Repeat = ERepeat::Once;
+		EEnvironmentClockCatchUp CatchUp = EEnvironmentClockCatchUp::EveryOccurrence;
+		bool bHasOwner = false;
+	};
+
+	/** Wheel levels and slots per level, 5 levels of 64 one second ticks cover 34 years. */
+	static const int32 SlotBits = 6;
+	static const int32 NumSlots = 1 << SlotBits;
+	static const int32 NumLevels = 5;
+
+	/** Lists after the wheel slots: timers due at the current tick, and timers beyond the wheel. */
+	static const int32 DueList = NumLevels * NumSlots;
+	static const int32 OverflowList = DueList + 1;
+	static const int32 NumLists = OverflowList + 1;
+
+	FEnvironmentClockHandle AddTimer(FTimer&& Timer);
+
+	/** Grid index of the latest occurrence of a repeating timer at or before a time in game seconds. */
+	int64 GetOccurrenceIndex(const FTimer& Timer, double Time) const;
+
+	/** Time of an occurrence of a repeating timer in game seconds. */
+	double GetOccurrenceTime(const FTimer& Timer, int64 Occurrence) const;
+
+	/** Schedule a repeating timer's next occurrence after the current time. */
+	void SetNextOccurrence(FTimer& Timer) const;
+
+	/** Wheel tick a time in game seconds falls into. */
+	int64 GetTick(double Time) const;
+
+	/** Move the clock to a time in game seconds. */
+	void Advance(double Target);
+
+	/** Link a timer into the list of its expiry relative to the current tick. */
+	void Insert(int32 Index);
+	void Link(int32 Index, int32 List);
+	void Unlink(int32 Index);
+
+	/** Fire every due timer, coalescing timers skip ahead past Target. */
+	void DispatchDue(double Target);
+
+	/** Relink the timers of a wheel slot after the current tick entered its range. */
+	void Cascade(int32 Level, int32 Slot);
+
+	/** Move the current tick forward, the overflow is relinked whenever the tick enters a new block of the wheel's range. */
+	void SetCurrentTick(int64 Tick);
+
+	/** Relink the overflow relative to the current tick. */
+	void CascadeOverflow();
+
+	/** Move to an earlier or first time, every timer is rescheduled from it without firing. */
+	void Rebase(double Time);
+
+	/** Fire the timers held back during a jump. */
+	void FlushCoalesced();
+
+	/** Call a timer's callback, it may schedule or cancel anything meanwhile.
+	* @return false if the timer was cancelled during the call.
+	*/
+	bool Fire(int32 Index, double Time, int32 Occurrences);
+
+	void RemoveTimer(int32 Index);
+
+	TSparseArray<FTimer> Timers;
+
+	int32 Heads[NumLists];
+	int32 Tails[NumLists];
+
+	/** Slots holding timers, bit per slot and level. */
+	uint64 Occupied[NumLevels];
+
+	/** Timers held back for the end of the jump, index and serial. */
+	TArray<TPair<int32, int32>> Coalesced;
+
+	/** Game seconds since 0001-01-01 and the wheel tick they fall into. */
+	double Seconds;
+	int64 CurrentTick;
+
+	/** View-model time after the last tick, any other value was set from elsewhere. */
+	FDateTime LastViewTime;
+
+	int32 NextSerial;
+	int32 JumpDepth;
+	bool bHasTime;
+
+	/** Events are firing, the clock can't be moved from inside one. */
+	bool bDispatching;
+};
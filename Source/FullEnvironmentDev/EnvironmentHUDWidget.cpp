@@ -0,0 +1,42 @@
+// 2015 - Community based open project
+
+#include "EnvironmentHUDWidget.h"
+#include "EnvironmentViewModel.h"
+
+void UEnvironmentHUDWidget::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	ViewModel = UEnvironmentViewModel::Get(this);
+
+	if (ViewModel == nullptr)
+	{
+		return;
+	}
+
+	ViewModel->OnTimeChanged.AddDynamic(this, &UEnvironmentHUDWidget::OnTimeChanged);
+	ViewModel->OnWeatherChanged.AddDynamic(this, &UEnvironmentHUDWidget::OnWeatherChanged);
+	ViewModel->OnTemperatureChanged.AddDynamic(this, &UEnvironmentHUDWidget::OnTemperatureChanged);
+	ViewModel->OnSunChanged.AddDynamic(this, &UEnvironmentHUDWidget::OnSunChanged);
+	ViewModel->OnMoonChanged.AddDynamic(this, &UEnvironmentHUDWidget::OnMoonChanged);
+	ViewModel->OnHeadingChanged.AddDynamic(this, &UEnvironmentHUDWidget::OnHeadingChanged);
+
+	//New widget has no texts yet.
+	ViewModel->RequestRefresh();
+}
+
+void UEnvironmentHUDWidget::NativeDestruct()
+{
+	if (ViewModel != nullptr)
+	{
+		ViewModel->OnTimeChanged.RemoveAll(this);
+		ViewModel->OnWeatherChanged.RemoveAll(this);
+		ViewModel->OnTemperatureChanged.RemoveAll(this);
+		ViewModel->OnSunChanged.RemoveAll(this);
+		ViewModel->OnMoonChanged.RemoveAll(this);
+		ViewModel->OnHeadingChanged.RemoveAll(this);
+		ViewModel = nullptr;
+	}
+
+	Super::NativeDestruct();
+}
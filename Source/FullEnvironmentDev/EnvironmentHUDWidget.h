@@ -0,0 +1,53 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+
+#include "EnvironmentHUDWidget.generated.h"
+
+class UEnvironmentViewModel;
+
+/**
+* Base of the sky HUD and compass widgets. Binds to the environment view-model while constructed and
+* forwards its events, so texts are set when a value changes instead of through per-frame bindings.
+* Wrap changing texts in an invalidation box, the rest of the widget is then only painted once.
+*/
+UCLASS(Abstract)
+class FULLENVIRONMENTDEV_API UEnvironmentHUDWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintPure, Category = "Environment")
+	UEnvironmentViewModel* GetViewModel() const { return ViewModel; }
+
+protected:
+	// UUserWidget interface
+	virtual void NativeConstruct() override;
+	virtual void NativeDestruct() override;
+	// End of UUserWidget interface
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Environment")
+	void OnTimeChanged(const FDateTime& LocalTime);
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Environment")
+	void OnWeatherChanged(FName Weather, float Cloudiness, float Precipitation);
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Environment")
+	void OnTemperatureChanged(float Temperature);
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Environment")
+	void OnSunChanged(float Altitude, float Azimuth);
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Environment")
+	void OnMoonChanged(float Altitude, float Azimuth);
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Environment")
+	void OnHeadingChanged(float Heading);
+
+private:
+	UPROPERTY(Transient)
+	UEnvironmentViewModel* ViewModel;
+};
@@ -0,0 +1,397 @@
+// 2015 - Community based open project
+
+#include "EnvironmentNetState.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogEnvironmentNetState, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("EnvironmentNet"), STATGROUP_EnvironmentNet, STATCAT_Advanced);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Updates written"), STAT_EnvironmentNet_Updates, STATGROUP_EnvironmentNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Payload bits written"), STAT_EnvironmentNet_PayloadBits, STATGROUP_EnvironmentNet);
+
+namespace EnvironmentNetState
+{
+	const int32 NumFields = 5;
+
+	/** Storm cells beyond it are dropped. */
+	const int32 MaxStormCells = 8;
+
+	/** Network units per value unit. */
+	const float TimeScaleUnits = 256.0f;
+	const float AnchorUnits = 100.0f;
+	const float BlendEndUnits = 10.0f;
+	const float AlphaUnits = 255.0f;
+	const float WindUnits = 16.0f;
+	const float StormCellSize = 1000.0f;
+	const float WeatherMapOffsetUnits = 4096.0f;
+	const float WeatherMapVelocityUnits = 65536.0f;
+
+	/** Payload bits and updates written since startup, for Environment.NetStats. Property and bunch headers
+	* added by the net driver aren't included, stat net shows them.
+	*/
+	uint64 PayloadBitsWritten = 0;
+	uint64 UpdatesWritten = 0;
+	double FirstWriteTime = 0.0;
+
+	/** Quantized state a connection acknowledged. */
+	class FBaseState : public INetDeltaBaseState
+	{
+	public:
+		explicit FBaseState(const FEnvironmentNetQuantizedState& InState)
+			: State(InState)
+		{
+		}
+
+		virtual bool IsStateEqual(INetDeltaBaseState* OtherState) override;
+
+		FEnvironmentNetQuantizedState State;
+	};
+
+	/** EEnvironmentNetField flags of the fields that differ. */
+	uint8 GetDirtyFields(const FEnvironmentNetQuantizedState& A, const FEnvironmentNetQuantizedState& B)
+	{
+		uint8 Fields = 0;
+
+		if (A.LocalTime != B.LocalTime || A.TimeScale != B.TimeScale || A.TimeAnchor != B.TimeAnchor)
+		{
+			Fields |= (uint8)EEnvironmentNetField::Time;
+		}
+
+		if (A.FromPreset != B.FromPreset || A.ToPreset != B.ToPreset || A.BlendAlpha != B.BlendAlpha || A.BlendEndTime != B.BlendEndTime)
+		{
+			Fields |= (uint8)EEnvironmentNetField::Blend;
+		}
+
+		if (A.WindX != B.WindX || A.WindY != B.WindY)
+		{
+			Fields |= (uint8)EEnvironmentNetField::Wind;
+		}
+
+		if (A.StormCells != B.StormCells)
+		{
+			Fields |= (uint8)EEnvironmentNetField::StormCells;
+		}
+
+		if (A.WeatherMapOffsetX != B.WeatherMapOffsetX || A.WeatherMapOffsetY != B.WeatherMapOffsetY
+			|| A.WeatherMapVelocityX != B.WeatherMapVelocityX || A.WeatherMapVelocityY != B.WeatherMapVelocityY
+			|| A.WeatherMapAnchor != B.WeatherMapAnchor)
+		{
+			Fields |= (uint8)EEnvironmentNetField::WeatherMap;
+		}
+
+		return Fields;
+	}
+
+	bool FBaseState::IsStateEqual(INetDeltaBaseState* OtherState)
+	{
+		return GetDirtyFields(State, static_cast<FBaseState*>(OtherState)->State) == 0;
+	}
+
+	/** Unsigned integer in 7 bit groups, small values take a byte. */
+	void SerializePacked(FArchive& Ar, uint64& Value)
+	{
+		if (Ar.IsLoading())
+		{
+			Value = 0;
+
+			for (int32 Shift = 0; Shift < 64; Shift += 7)
+			{
+				uint8 Byte = 0;
+				Ar << Byte;
+				Value |= uint64(Byte & 0x7f) << Shift;
+
+				if ((Byte & 0x80) == 0)
+				{
+					break;
+				}
+			}
+
+			return;
+		}
+
+		uint64 Remaining = Value;
+
+		do
+		{
+			uint8 Byte = uint8(Remaining & 0x7f);
+			Remaining >>= 7;
+
+			if (Remaining != 0)
+			{
+				Byte |= 0x80;
+			}
+
+			Ar << Byte;
+		}
+		while (Remaining != 0);
+	}
+
+	/** Signed integer, zigzag encoded so small negative values stay small. */
+	template<typename T>
+	void SerializeSigned(FArchive& Ar, T& Value)
+	{
+		const int64 Signed = int64(Value);
+		uint64 Encoded = (uint64(Signed) << 1) ^ uint64(Signed >> 63);
+
+		SerializePacked(Ar, Encoded);
+
+		if (Ar.IsLoading())
+		{
+			Value = T(int64(Encoded >> 1) ^ -int64(Encoded & 1));
+		}
+	}
+
+	/**
+	* Write or read the flagged fields of a state. Values are written whole, an update may arrive on top of a state
+	* that differs from the one it was chosen against, until the engine resends from the acknowledged state.
+	*/
+	void SerializeFields(FArchive& Ar, uint8 Fields, FEnvironmentNetQuantizedState& State)
+	{
+		if (Fields & (uint8)EEnvironmentNetField::Time)
+		{
+			SerializeSigned(Ar, State.LocalTime);
+			SerializeSigned(Ar, State.TimeScale);
+			SerializeSigned(Ar, State.TimeAnchor);
+		}
+
+		if (Fields & (uint8)EEnvironmentNetField::Blend)
+		{
+			SerializeSigned(Ar, State.FromPreset);
+			SerializeSigned(Ar, State.ToPreset);
+			SerializeSigned(Ar, State.BlendAlpha);
+			SerializeSigned(Ar, State.BlendEndTime);
+		}
+
+		if (Fields & (uint8)EEnvironmentNetField::Wind)
+		{
+			SerializeSigned(Ar, State.WindX);
+			SerializeSigned(Ar, State.WindY);
+		}
+
+		if (Fields & (uint8)EEnvironmentNetField::StormCells)
+		{
+			int32 NumCells = State.StormCells.Num();
+			SerializeSigned(Ar, NumCells);
+
+			if (Ar.IsLoading())
+			{
+				if (NumCells < 0 || NumCells > MaxStormCells)
+				{
+					Ar.SetError();
+					return;
+				}
+
+				State.StormCells.SetNum(NumCells);
+			}
+
+			for (int32 CellIndex = 0; CellIndex < NumCells; CellIndex++)
+			{
+				FEnvironmentNetQuantizedState::FStormCell& Cell = State.StormCells[CellIndex];
+
+				SerializeSigned(Ar, Cell.X);
+				SerializeSigned(Ar, Cell.Y);
+				SerializeSigned(Ar, Cell.Radius);
+				SerializeSigned(Ar, Cell.Intensity);
+			}
+		}
+
+		if (Fields & (uint8)EEnvironmentNetField::WeatherMap)
+		{
+			SerializeSigned(Ar, State.WeatherMapOffsetX);
+			SerializeSigned(Ar, State.WeatherMapOffsetY);
+			SerializeSigned(Ar, State.WeatherMapVelocityX);
+			SerializeSigned(Ar, State.WeatherMapVelocityY);
+			SerializeSigned(Ar, State.WeatherMapAnchor);
+		}
+	}
+
+	void NetStats(UWorld* World)
+	{
+		const double Elapsed = FirstWriteTime > 0.0 ? FPlatformTime::Seconds() - FirstWriteTime : 0.0;
+		const UNetDriver* NetDriver = World != nullptr ? World->GetNetDriver() : nullptr;
+		const int32 NumClients = NetDriver != nullptr ? NetDriver->ClientConnections.Num() : 0;
+		const double Bytes = PayloadBitsWritten / 8.0;
+
+		UE_LOG(LogEnvironmentNetState, Display, TEXT("Environment state: %llu updates, %.0f payload bytes in %.1f seconds, %d clients, %.2f payload bytes/s per client."),
+			UpdatesWritten, Bytes, Elapsed, NumClients, Elapsed > 0.0 && NumClients > 0 ? Bytes / Elapsed / NumClients : 0.0);
+	}
+
+	FAutoConsoleCommandWithWorld NetStatsCommand(
+		TEXT("Environment.NetStats"),
+		TEXT("Log environment state payload bytes written by this server, without property and bunch headers."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&NetStats));
+}
+
+void FEnvironmentNetState::Quantize()
+{
+	using namespace EnvironmentNetState;
+
+	Quantized.LocalTime = (LocalTime.GetTicks() + ETimespan::TicksPerSecond / 2) / ETimespan::TicksPerSecond;
+	Quantized.TimeScale = FMath::RoundToInt(TimeScale * TimeScaleUnits);
+	Quantized.TimeAnchor = FMath::RoundToInt(TimeAnchor * AnchorUnits);
+
+	Quantized.FromPreset = FMath::Max(FromPreset, (int32)INDEX_NONE) + 1;
+	Quantized.ToPreset = FMath::Max(ToPreset, (int32)INDEX_NONE) + 1;
+	Quantized.BlendAlpha = FMath::RoundToInt(FMath::Clamp(BlendAlpha, 0.0f, 1.0f) * AlphaUnits);
+	Quantized.BlendEndTime = FMath::RoundToInt(BlendEndTime * BlendEndUnits);
+
+	Quantized.WindX = FMath::RoundToInt(Wind.X * WindUnits);
+	Quantized.WindY = FMath::RoundToInt(Wind.Y * WindUnits);
+
+	Quantized.StormCells.SetNum(FMath::Min(StormCells.Num(), MaxStormCells));
+
+	for (int32 CellIndex = 0; CellIndex < Quantized.StormCells.Num(); CellIndex++)
+	{
+		const FEnvironmentStormCell& Cell = StormCells[CellIndex];
+		FEnvironmentNetQuantizedState::FStormCell& QuantizedCell = Quantized.StormCells[CellIndex];
+
+		QuantizedCell.X = FMath::RoundToInt(Cell.Center.X / StormCellSize);
+		QuantizedCell.Y = FMath::RoundToInt(Cell.Center.Y / StormCellSize);
+		QuantizedCell.Radius = FMath::Max(FMath::RoundToInt(Cell.Radius / StormCellSize), 0);
+		QuantizedCell.Intensity = FMath::RoundToInt(FMath::Clamp(Cell.Intensity, 0.0f, 1.0f) * AlphaUnits);
+	}
+
+	//Offset wraps, so it fits 12 bits.
+	const int32 OffsetMask = int32(WeatherMapOffsetUnits) - 1;
+	Quantized.WeatherMapOffsetX = FMath::RoundToInt(FMath::Frac(WeatherMapOffset.X) * WeatherMapOffsetUnits) & OffsetMask;
+	Quantized.WeatherMapOffsetY = FMath::RoundToInt(FMath::Frac(WeatherMapOffset.Y) * WeatherMapOffsetUnits) & OffsetMask;
+	Quantized.WeatherMapVelocityX = FMath::RoundToInt(WeatherMapVelocity.X * WeatherMapVelocityUnits);
+	Quantized.WeatherMapVelocityY = FMath::RoundToInt(WeatherMapVelocity.Y * WeatherMapVelocityUnits);
+	Quantized.WeatherMapAnchor = FMath::RoundToInt(WeatherMapAnchor * AnchorUnits);
+
+	Dequantize();
+}
+
+void FEnvironmentNetState::Dequantize()
+{
+	using namespace EnvironmentNetState;
+
+	LocalTime = FDateTime(Quantized.LocalTime * ETimespan::TicksPerSecond);
+	TimeScale = Quantized.TimeScale / TimeScaleUnits;
+	TimeAnchor = Quantized.TimeAnchor / AnchorUnits;
+
+	FromPreset = Quantized.FromPreset - 1;
+	ToPreset = Quantized.ToPreset - 1;
+	BlendAlpha = Quantized.BlendAlpha / AlphaUnits;
+	BlendEndTime = Quantized.BlendEndTime / BlendEndUnits;
+
+	Wind = FVector2D(Quantized.WindX, Quantized.WindY) / WindUnits;
+
+	StormCells.SetNum(Quantized.StormCells.Num());
+
+	for (int32 CellIndex = 0; CellIndex < StormCells.Num(); CellIndex++)
+	{
+		const FEnvironmentNetQuantizedState::FStormCell& QuantizedCell = Quantized.StormCells[CellIndex];
+		FEnvironmentStormCell& Cell = StormCells[CellIndex];
+
+		Cell.Center = FVector2D(QuantizedCell.X, QuantizedCell.Y) * StormCellSize;
+		Cell.Radius = QuantizedCell.Radius * StormCellSize;
+		Cell.Intensity = QuantizedCell.Intensity / AlphaUnits;
+	}
+
+	WeatherMapOffset = FVector2D(Quantized.WeatherMapOffsetX, Quantized.WeatherMapOffsetY) / WeatherMapOffsetUnits;
+	WeatherMapVelocity = FVector2D(Quantized.WeatherMapVelocityX, Quantized.WeatherMapVelocityY) / WeatherMapVelocityUnits;
+	WeatherMapAnchor = Quantized.WeatherMapAnchor / AnchorUnits;
+}
+
+FDateTime FEnvironmentNetState::GetLocalTime(float ServerTime) const
+{
+	return LocalTime + FTimespan::FromSeconds(double(ServerTime - TimeAnchor) * TimeScale);
+}
+
+FVector2D FEnvironmentNetState::GetWeatherMapOffset(float ServerTime) const
+{
+	const FVector2D Offset = WeatherMapOffset + WeatherMapVelocity * (ServerTime - WeatherMapAnchor);
+
+	return FVector2D(FMath::Frac(Offset.X), FMath::Frac(Offset.Y));
+}
+
+float FEnvironmentNetState::GetStormIntensity(const FVector& Location) const
+{
+	float Intensity = 0.0f;
+
+	for (const FEnvironmentStormCell& Cell : StormCells)
+	{
+		if (Cell.Radius > 0.0f)
+		{
+			const float Distance = FVector2D::Distance(FVector2D(Location), Cell.Center);
+			Intensity = FMath::Max(Intensity, Cell.Intensity * FMath::Clamp(1.0f - Distance / Cell.Radius, 0.0f, 1.0f));
+		}
+	}
+
+	return Intensity;
+}
+
+bool FEnvironmentNetState::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+	using namespace EnvironmentNetState;
+
+	if (DeltaParms.Writer != nullptr)
+	{
+		//Without a base the client holds a default state.
+		static const FEnvironmentNetQuantizedState DefaultState;
+		const FBaseState* OldState = static_cast<const FBaseState*>(DeltaParms.OldState);
+		const FEnvironmentNetQuantizedState& Base = OldState != nullptr ? OldState->State : DefaultState;
+
+		uint8 Fields = GetDirtyFields(Quantized, Base);
+
+		if (Fields == 0)
+		{
+			return false;
+		}
+
+		FBitWriter& Writer = *DeltaParms.Writer;
+		const int64 StartBits = Writer.GetNumBits();
+
+		FEnvironmentNetQuantizedState State = Quantized;
+		Writer.SerializeBits(&Fields, NumFields);
+		SerializeFields(Writer, Fields, State);
+
+		*DeltaParms.NewState = MakeShared<FBaseState>(Quantized);
+
+		const int64 NumBits = Writer.GetNumBits() - StartBits;
+		PayloadBitsWritten += NumBits;
+		UpdatesWritten++;
+
+		if (FirstWriteTime == 0.0)
+		{
+			FirstWriteTime = FPlatformTime::Seconds();
+		}
+
+		INC_DWORD_STAT(STAT_EnvironmentNet_Updates);
+		INC_DWORD_STAT_BY(STAT_EnvironmentNet_PayloadBits, NumBits);
+
+		UE_LOG(LogEnvironmentNetState, Verbose, TEXT("Wrote fields %x in %lld bits."), Fields, NumBits);
+
+		return true;
+	}
+
+	if (DeltaParms.Reader != nullptr)
+	{
+		FBitReader& Reader = *DeltaParms.Reader;
+		uint8 Fields = 0;
+
+		Reader.SerializeBits(&Fields, NumFields);
+
+		//Fields that weren't sent keep their last received values.
+		FEnvironmentNetQuantizedState Received = Quantized;
+		SerializeFields(Reader, Fields, Received);
+
+		if (Reader.IsError())
+		{
+			UE_LOG(LogEnvironmentNetState, Warning, TEXT("Malformed environment state update."));
+			return false;
+		}
+
+		Quantized = MoveTemp(Received);
+		ReceivedFields = Fields;
+		Dequantize();
+	}
+
+	return true;
+}
@@ -0,0 +1,166 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+
+#include "EnvironmentNetState.generated.h"
+
+/** Storm area that raises the lightning rate around its center. */
+USTRUCT(BlueprintType)
+struct FEnvironmentStormCell
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weather")
+	FVector2D Center = FVector2D::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weather")
+	float Radius = 0.0f;
+
+	/** Storm intensity at the center, falls off to 0 at the radius. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weather")
+	float Intensity = 0.0f;
+};
+
+/** Environment state in its network units, see FEnvironmentNetState for the precision of every field. */
+struct FEnvironmentNetQuantizedState
+{
+	struct FStormCell
+	{
+		int32 X = 0;
+		int32 Y = 0;
+		int32 Radius = 0;
+		int32 Intensity = 0;
+
+		bool operator==(const FStormCell& Other) const
+		{
+			return X == Other.X && Y == Other.Y && Radius == Other.Radius && Intensity == Other.Intensity;
+		}
+	};
+
+	int64 LocalTime = 0;
+	int32 TimeScale = 0;
+	int32 TimeAnchor = 0;
+
+	/** Preset table index plus one, 0 is none. */
+	int32 FromPreset = 0;
+	int32 ToPreset = 0;
+	int32 BlendAlpha = 0;
+	int32 BlendEndTime = 0;
+
+	int32 WindX = 0;
+	int32 WindY = 0;
+
+	TArray<FStormCell, TInlineAllocator<4>> StormCells;
+
+	int32 WeatherMapOffsetX = 0;
+	int32 WeatherMapOffsetY = 0;
+	int32 WeatherMapVelocityX = 0;
+	int32 WeatherMapVelocityY = 0;
+	int32 WeatherMapAnchor = 0;
+};
+
+/** Fields of the environment state that are sent together. */
+enum class EEnvironmentNetField : uint8
+{
+	Time = 1 << 0,
+	Blend = 1 << 1,
+	Wind = 1 << 2,
+	StormCells = 1 << 3,
+	WeatherMap = 1 << 4,
+};
+
+/**
+* Environment state the server replicates to every client, so their sky and weather blueprints don't drift apart.
+* Values are quantized to what is still visible: game time to a second, blend alpha to 1/255, wind to 1/16 cell per
+* second, storm cells to 10 meters and the weather map offset to 1/4096. Time and weather map scroll are anchors
+* clients extrapolate from, so steady weather sends nothing.
+*
+* Custom delta serializer: only fields that differ from the last acknowledged state of a connection are written, as
+* variable length integers. Nothing is written while a connection is up to date, a lost update is resent by the engine
+* from the acknowledged state.
+*/
+USTRUCT(BlueprintType)
+struct FULLENVIRONMENTDEV_API FEnvironmentNetState
+{
+	GENERATED_BODY()
+
+	/** Local time at TimeAnchor. */
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	FDateTime LocalTime;
+
+	/** Game seconds per server second. */
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	float TimeScale = 0.0f;
+
+	/** Server world time LocalTime was sampled at. */
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	float TimeAnchor = 0.0f;
+
+	/** Preset table indices of a fixed blend, FromPreset is INDEX_NONE for a timed blend to ToPreset. */
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	int32 FromPreset = INDEX_NONE;
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	int32 ToPreset = INDEX_NONE;
+
+	/** Alpha of a fixed blend. */
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	float BlendAlpha = 0.0f;
+
+	/** Server world time a timed blend ends at. */
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	float BlendEndTime = 0.0f;
+
+	/** Prevailing wind of the weather simulation in weather cells per second. */
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	FVector2D Wind = FVector2D::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	TArray<FEnvironmentStormCell> StormCells;
+
+	/** Weather map UV offset at WeatherMapAnchor and its speed in UV per second. */
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	FVector2D WeatherMapOffset = FVector2D::ZeroVector;
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	FVector2D WeatherMapVelocity = FVector2D::ZeroVector;
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	float WeatherMapAnchor = 0.0f;
+
+	/** Snap the values to their network precision. The server calls it after every change, so its own
+	* extrapolation matches the clients'.
+	*/
+	void Quantize();
+
+	/** Local time extrapolated to a server world time. */
+	FDateTime GetLocalTime(float ServerTime) const;
+
+	/** Weather map offset extrapolated to a server world time, wrapped to 0-1. */
+	FVector2D GetWeatherMapOffset(float ServerTime) const;
+
+	/** Highest storm intensity of the cells at a location. */
+	float GetStormIntensity(const FVector& Location) const;
+
+	/** Fields changed by the last received update, EEnvironmentNetField flags. */
+	uint8 GetReceivedFields() const { return ReceivedFields; }
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+
+private:
+	/** Fill the values from the quantized state. */
+	void Dequantize();
+
+	FEnvironmentNetQuantizedState Quantized;
+
+	uint8 ReceivedFields = 0;
+};
+
+template<>
+struct TStructOpsTypeTraits<FEnvironmentNetState> : public TStructOpsTypeTraitsBase2<FEnvironmentNetState>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
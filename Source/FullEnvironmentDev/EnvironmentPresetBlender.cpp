@@ -0,0 +1,354 @@
+// 2015 - Community based open project
+
+#include "EnvironmentPresetBlender.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/DirectionalLight.h"
+#include "Engine/SkyLight.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/DirectionalLightComponent.h"
+#include "Components/SkyLightComponent.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Materials/MaterialParameterCollection.h"
+#include "Materials/MaterialParameterCollectionInstance.h"
+#include "EngineUtils.h"
+
+namespace EnvironmentPresetBlender
+{
+	/** Dynamic instance of the first material of an actor's static mesh components. */
+	UMaterialInstanceDynamic* GetDynamicMaterial(AActor* Actor)
+	{
+		TInlineComponentArray<UStaticMeshComponent*> Components(Actor);
+
+		for (UStaticMeshComponent* Component : Components)
+		{
+			if (Component->GetMaterial(0) != nullptr)
+			{
+				return Component->CreateDynamicMaterialInstance(0);
+			}
+		}
+
+		return nullptr;
+	}
+}
+
+UEnvironmentPresetBlender* UEnvironmentPresetBlender::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (UEnvironmentPresetBlender* Blender = Find(World))
+	{
+		return Blender;
+	}
+
+	UEnvironmentPresetBlender* Blender = NewObject<UEnvironmentPresetBlender>(World);
+	World->PerModuleDataObjects.Add(Blender);
+
+	return Blender;
+}
+
+UEnvironmentPresetBlender* UEnvironmentPresetBlender::Find(const UWorld* World)
+{
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (UEnvironmentPresetBlender* Blender = Cast<UEnvironmentPresetBlender>(Object))
+		{
+			return Blender;
+		}
+	}
+
+	return nullptr;
+}
+
+void UEnvironmentPresetBlender::SetTable(UEnvironmentPresetTable* InTable)
+{
+	Table = InTable;
+	bBlending = false;
+
+	if (Table == nullptr || Table->Presets.Num() == 0)
+	{
+		return;
+	}
+
+	BindTargets();
+
+	//Every parameter is pushed once, later frames only push changes.
+	CurrentValues = Table->Presets[0].Values;
+	FromPresetName = NAME_None;
+	ToPresetName = NAME_None;
+	TargetPresetName = Table->Presets[0].Name;
+
+	for (int32 ParameterIndex = 0; ParameterIndex < Table->Parameters.Num(); ParameterIndex++)
+	{
+		PushParameter(ParameterIndex);
+	}
+
+	Revision++;
+}
+
+void UEnvironmentPresetBlender::BindTargets()
+{
+	using namespace EnvironmentPresetBlender;
+
+	UWorld* World = GetWorld();
+
+	CloudsMaterial = nullptr;
+	SkyMaterial = nullptr;
+	SunLight = nullptr;
+	SkyLight = nullptr;
+
+	for (TActorIterator<AActor> ActorItr(World); ActorItr; ++ActorItr)
+	{
+		const FName ClassName = ActorItr->GetClass()->GetFName();
+
+		if (ClassName == "VolumetricClouds_C" && CloudsMaterial == nullptr)
+		{
+			CloudsMaterial = GetDynamicMaterial(*ActorItr);
+		}
+		else if ((ClassName == "Sky_C" || ClassName == "SunSky_C") && SkyMaterial == nullptr)
+		{
+			SkyMaterial = GetDynamicMaterial(*ActorItr);
+		}
+		else if (ADirectionalLight* DirectionalLight = Cast<ADirectionalLight>(*ActorItr))
+		{
+			//Atmosphere sun wins over any other directional light.
+			UDirectionalLightComponent* Light = Cast<UDirectionalLightComponent>(DirectionalLight->GetLightComponent());
+
+			if (Light != nullptr && (SunLight == nullptr || Light->IsUsedAsAtmosphereSunLight()))
+			{
+				SunLight = Light;
+			}
+		}
+		else if (ASkyLight* SkyLightActor = Cast<ASkyLight>(*ActorItr))
+		{
+			SkyLight = SkyLight == nullptr ? SkyLightActor->GetLightComponent() : SkyLight;
+		}
+	}
+
+	UMaterialParameterCollection* Collection = Table->ParameterCollection;
+	CollectionInstance = Collection != nullptr ? World->GetParameterCollectionInstance(Collection) : nullptr;
+
+	UsesCollection.Init(false, Table->Parameters.Num());
+
+	for (int32 ParameterIndex = 0; ParameterIndex < Table->Parameters.Num(); ParameterIndex++)
+	{
+		const FEnvironmentPresetParameter& Parameter = Table->Parameters[ParameterIndex];
+
+		if (CollectionInstance != nullptr)
+		{
+			UsesCollection[ParameterIndex] = Parameter.bVector ? Collection->GetVectorParameterByName(Parameter.Name) != nullptr : Collection->GetScalarParameterByName(Parameter.Name) != nullptr;
+		}
+	}
+}
+
+bool UEnvironmentPresetBlender::BlendTo(FName PresetName, float Duration)
+{
+	const FEnvironmentPreset* Preset = Table != nullptr ? Table->FindPreset(PresetName) : nullptr;
+
+	if (Preset == nullptr)
+	{
+		return false;
+	}
+
+	//Blend starts at the current look, so an interrupted blend continues smoothly.
+	FromPresetName = NAME_None;
+	ToPresetName = NAME_None;
+	TargetPresetName = PresetName;
+	BeginBlend(CurrentValues, *Preset);
+
+	BlendTime = 0.0f;
+	BlendDuration = Duration;
+	bBlending = Duration > 0.0f;
+
+	if (!bBlending)
+	{
+		ApplyBlend(1.0f);
+	}
+
+	return true;
+}
+
+bool UEnvironmentPresetBlender::SetBlend(FName InFromPresetName, FName InToPresetName, float Alpha)
+{
+	if (Table == nullptr)
+	{
+		return false;
+	}
+
+	//Difference of the same two presets is kept between calls.
+	if (InFromPresetName != FromPresetName || InToPresetName != ToPresetName)
+	{
+		const FEnvironmentPreset* FromPreset = Table->FindPreset(InFromPresetName);
+		const FEnvironmentPreset* ToPreset = Table->FindPreset(InToPresetName);
+
+		if (FromPreset == nullptr || ToPreset == nullptr)
+		{
+			return false;
+		}
+
+		BeginBlend(FromPreset->Values, *ToPreset);
+		FromPresetName = InFromPresetName;
+		ToPresetName = InToPresetName;
+	}
+
+	bBlending = false;
+	FixedAlpha = FMath::Clamp(Alpha, 0.0f, 1.0f);
+	ApplyBlend(FixedAlpha);
+
+	return true;
+}
+
+void UEnvironmentPresetBlender::GetBlendState(FName& OutFromPresetName, FName& OutToPresetName, float& OutAlpha, float& OutRemaining) const
+{
+	//A timed blend clears the fixed presets, so they are only set while a fixed blend is held.
+	if (FromPresetName != NAME_None)
+	{
+		OutFromPresetName = FromPresetName;
+		OutToPresetName = ToPresetName;
+		OutAlpha = FixedAlpha;
+		OutRemaining = 0.0f;
+		return;
+	}
+
+	OutFromPresetName = NAME_None;
+	OutToPresetName = TargetPresetName;
+	OutAlpha = bBlending ? FMath::Clamp(BlendTime / BlendDuration, 0.0f, 1.0f) : 1.0f;
+	OutRemaining = bBlending ? FMath::Max(BlendDuration - BlendTime, 0.0f) : 0.0f;
+}
+
+void UEnvironmentPresetBlender::BeginBlend(const TArray<float>& InFromValues, const FEnvironmentPreset& ToPreset)
+{
+	const int32 NumValues = Table->NumValues;
+
+	//Copy first, the start values may be CurrentValues.
+	FromValues = InFromValues;
+	DeltaValues.SetNumUninitialized(NumValues);
+
+	for (int32 Index = 0; Index < NumValues; Index++)
+	{
+		DeltaValues[Index] = ToPreset.Values[Index] - FromValues[Index];
+	}
+}
+
+void UEnvironmentPresetBlender::ApplyBlend(float Alpha)
+{
+	bool bAnyChanged = false;
+
+	for (int32 ParameterIndex = 0; ParameterIndex < Table->Parameters.Num(); ParameterIndex++)
+	{
+		const FEnvironmentPresetParameter& Parameter = Table->Parameters[ParameterIndex];
+		const int32 End = Parameter.Offset + (Parameter.bVector ? 4 : 1);
+		bool bChanged = false;
+
+		for (int32 Index = Parameter.Offset; Index < End; Index++)
+		{
+			const float Value = FromValues[Index] + DeltaValues[Index] * Alpha;
+
+			if (Value != CurrentValues[Index])
+			{
+				CurrentValues[Index] = Value;
+				bChanged = true;
+			}
+		}
+
+		if (bChanged)
+		{
+			PushParameter(ParameterIndex);
+			bAnyChanged = true;
+		}
+	}
+
+	if (bAnyChanged)
+	{
+		Revision++;
+	}
+}
+
+void UEnvironmentPresetBlender::PushParameter(int32 ParameterIndex)
+{
+	const FEnvironmentPresetParameter& Parameter = Table->Parameters[ParameterIndex];
+	const float* Values = &CurrentValues[Parameter.Offset];
+	const FLinearColor Color = Parameter.bVector ? FLinearColor(Values[0], Values[1], Values[2], Values[3]) : FLinearColor::Black;
+
+	if (UsesCollection[ParameterIndex])
+	{
+		if (Parameter.bVector)
+		{
+			CollectionInstance->SetVectorParameterValue(Parameter.Name, Color);
+		}
+		else
+		{
+			CollectionInstance->SetScalarParameterValue(Parameter.Name, Values[0]);
+		}
+
+		return;
+	}
+
+	switch (Parameter.Target)
+	{
+	case EEnvironmentPresetTarget::Clouds:
+	case EEnvironmentPresetTarget::Sky:
+		if (UMaterialInstanceDynamic* Material = Parameter.Target == EEnvironmentPresetTarget::Clouds ? CloudsMaterial : SkyMaterial)
+		{
+			if (Parameter.bVector)
+			{
+				Material->SetVectorParameterValue(Parameter.Name, Color);
+			}
+			else
+			{
+				Material->SetScalarParameterValue(Parameter.Name, Values[0]);
+			}
+		}
+		break;
+	case EEnvironmentPresetTarget::SunLight:
+		if (SunLight != nullptr && Parameter.bVector)
+		{
+			SunLight->SetLightColor(Color);
+		}
+		else if (SunLight != nullptr)
+		{
+			SunLight->SetIntensity(Values[0]);
+		}
+		break;
+	case EEnvironmentPresetTarget::SkyLight:
+		if (SkyLight != nullptr && Parameter.bVector)
+		{
+			SkyLight->SetLightColor(Color);
+		}
+		else if (SkyLight != nullptr)
+		{
+			SkyLight->SetIntensity(Values[0]);
+		}
+		break;
+	}
+}
+
+void UEnvironmentPresetBlender::Tick(float DeltaTime)
+{
+	BlendTime += DeltaTime;
+
+	const float Alpha = FMath::Clamp(BlendTime / BlendDuration, 0.0f, 1.0f);
+
+	ApplyBlend(FMath::SmoothStep(0.0f, 1.0f, Alpha));
+	bBlending = Alpha < 1.0f;
+}
+
+bool UEnvironmentPresetBlender::IsTickable() const
+{
+	return bBlending && Table != nullptr && !IsTemplate();
+}
+
+TStatId UEnvironmentPresetBlender::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnvironmentPresetBlender, STATGROUP_Tickables);
+}
@@ -0,0 +1,127 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Tickable.h"
+#include "EnvironmentPresetTable.h"
+
+#include "EnvironmentPresetBlender.generated.h"
+
+class UMaterialInstanceDynamic;
+class UMaterialParameterCollectionInstance;
+class ULightComponent;
+class USkyLightComponent;
+
+/**
+* Blends the sky, clouds and lights of a world between two presets of an environment preset table.
+* The difference of the two presets is computed once when a blend starts, a frame only does one multiply-add per value
+* and pushes the values that changed. Parameters of the table's collection go through a single collection instance,
+* which the engine uploads once at the end of the frame.
+*/
+UCLASS(BlueprintType)
+class FULLENVIRONMENTDEV_API UEnvironmentPresetBlender : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Blender of a world, created on the first call. */
+	UFUNCTION(BlueprintPure, Category = "Environment", meta = (WorldContext = "WorldContextObject"))
+	static UEnvironmentPresetBlender* Get(const UObject* WorldContextObject);
+
+	/** Blender of a world, nullptr if nothing created it yet. */
+	static UEnvironmentPresetBlender* Find(const UWorld* World);
+
+	/** Table presets are blended from, applies its first preset at once. */
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	void SetTable(UEnvironmentPresetTable* InTable);
+
+	/** Blend from the current look to a preset.
+	* @param PresetName - preset to blend to.
+	* @param Duration - blend time in seconds, 0 switches at once.
+	* @return false if the table has no such preset.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	bool BlendTo(FName PresetName, float Duration);
+
+	/** Hold a fixed blend of two presets, e.g. driven by the time of day.
+	* @return false if the table has no such presets.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	bool SetBlend(FName FromPresetName, FName ToPresetName, float Alpha);
+
+	/** Incremented whenever blended values are pushed. */
+	uint32 GetRevision() const { return Revision; }
+
+	UEnvironmentPresetTable* GetTable() const { return Table; }
+
+	/** Current blend, either a fixed blend of two presets or a timed blend from the previous look to a preset.
+	* @param OutFromPresetName - None for a timed blend.
+	* @param OutToPresetName - preset blended to, None before a table is set.
+	* @param OutAlpha - alpha of a fixed blend, progress of a timed one.
+	* @param OutRemaining - seconds left of a timed blend.
+	*/
+	void GetBlendState(FName& OutFromPresetName, FName& OutToPresetName, float& OutAlpha, float& OutRemaining) const;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Find the clouds, sky and lights of the world. */
+	void BindTargets();
+
+	/** Start a blend from a value vector to a preset. */
+	void BeginBlend(const TArray<float>& FromValues, const FEnvironmentPreset& ToPreset);
+
+	/** Compute the values at an alpha and push the changed ones. */
+	void ApplyBlend(float Alpha);
+
+	/** Push current values of a parameter to its target. */
+	void PushParameter(int32 ParameterIndex);
+
+	UPROPERTY()
+	UEnvironmentPresetTable* Table = nullptr;
+
+	UPROPERTY()
+	UMaterialInstanceDynamic* CloudsMaterial = nullptr;
+
+	UPROPERTY()
+	UMaterialInstanceDynamic* SkyMaterial = nullptr;
+
+	UPROPERTY()
+	ULightComponent* SunLight = nullptr;
+
+	UPROPERTY()
+	USkyLightComponent* SkyLight = nullptr;
+
+	UPROPERTY()
+	UMaterialParameterCollectionInstance* CollectionInstance = nullptr;
+
+	/** Per parameter, is it set on the collection instead of its target. */
+	TBitArray<> UsesCollection;
+
+	/** Blend start and difference to the blend end. */
+	TArray<float> FromValues;
+	TArray<float> DeltaValues;
+
+	/** Presets of the precomputed difference, None for a blend from the current values. */
+	FName FromPresetName;
+	FName ToPresetName;
+
+	/** Preset of the last timed blend and alpha of the last fixed blend. */
+	FName TargetPresetName;
+	float FixedAlpha = 0.0f;
+
+	/** Values last pushed to the targets. */
+	TArray<float> CurrentValues;
+
+	uint32 Revision = 0;
+
+	float BlendTime = 0.0f;
+	float BlendDuration = 0.0f;
+	bool bBlending = false;
+};
@@ -0,0 +1,266 @@
+// 2015 - Community based open project
+
+#include "EnvironmentPresetCommandlet.h"
+#include "EnvironmentPresetTable.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/DirectionalLight.h"
+#include "Engine/SkyLight.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/DirectionalLightComponent.h"
+#include "Components/SkyLightComponent.h"
+#include "Materials/MaterialInterface.h"
+#include "UObject/Package.h"
+#include "Misc/PackageName.h"
+#include "Misc/Parse.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogEnvironmentPreset, Log, All);
+
+namespace EnvironmentPresetCommandlet
+{
+	/** Values captured for a single preset. */
+	struct FCapture
+	{
+		UEnvironmentPresetTable* Table;
+		int32 PresetIndex;
+		TSet<int32>* CapturedParameters;
+
+		void SetScalar(EEnvironmentPresetTarget Target, FName Name, float Value)
+		{
+			const int32 ParameterIndex = Table->FindOrAddParameter(Target, Name, false);
+			Table->Presets[PresetIndex].Values[Table->Parameters[ParameterIndex].Offset] = Value;
+			CapturedParameters->Add(ParameterIndex);
+		}
+
+		void SetVector(EEnvironmentPresetTarget Target, FName Name, const FLinearColor& Value)
+		{
+			const int32 ParameterIndex = Table->FindOrAddParameter(Target, Name, true);
+			FMemory::Memcpy(&Table->Presets[PresetIndex].Values[Table->Parameters[ParameterIndex].Offset], &Value, sizeof(FLinearColor));
+			CapturedParameters->Add(ParameterIndex);
+		}
+
+		void AddMaterial(EEnvironmentPresetTarget Target, UMaterialInterface* Material)
+		{
+			TArray<FMaterialParameterInfo> ParameterInfos;
+			TArray<FGuid> ParameterIds;
+
+			Material->GetAllScalarParameterInfo(ParameterInfos, ParameterIds);
+
+			for (const FMaterialParameterInfo& ParameterInfo : ParameterInfos)
+			{
+				float Value = 0.0f;
+
+				if (Material->GetScalarParameterValue(ParameterInfo, Value))
+				{
+					SetScalar(Target, ParameterInfo.Name, Value);
+				}
+			}
+
+			ParameterInfos.Reset();
+			ParameterIds.Reset();
+			Material->GetAllVectorParameterInfo(ParameterInfos, ParameterIds);
+
+			for (const FMaterialParameterInfo& ParameterInfo : ParameterInfos)
+			{
+				FLinearColor Value = FLinearColor::Black;
+
+				if (Material->GetVectorParameterValue(ParameterInfo, Value))
+				{
+					SetVector(Target, ParameterInfo.Name, Value);
+				}
+			}
+		}
+
+		void AddLight(EEnvironmentPresetTarget Target, const ULightComponentBase* Light)
+		{
+			SetScalar(Target, TEXT("Intensity"), Light->Intensity);
+			SetVector(Target, TEXT("LightColor"), Light->GetLightColor());
+		}
+	};
+
+	/** First material of an actor's static mesh components. */
+	UMaterialInterface* GetMaterial(AActor* Actor)
+	{
+		TInlineComponentArray<UStaticMeshComponent*> Components(Actor);
+
+		for (UStaticMeshComponent* Component : Components)
+		{
+			if (UMaterialInterface* Material = Component->GetMaterial(0))
+			{
+				return Material;
+			}
+		}
+
+		return nullptr;
+	}
+
+	/** Capture clouds, sky and lights of a scene. */
+	bool CaptureScene(const FString& MapPackageName, FCapture& Capture)
+	{
+		UPackage* Package = LoadPackage(nullptr, *MapPackageName, LOAD_None);
+		UWorld* World = Package != nullptr ? UWorld::FindWorldInPackage(Package) : nullptr;
+
+		if (World == nullptr || World->PersistentLevel == nullptr)
+		{
+			return false;
+		}
+
+		bool bSunCaptured = false;
+
+		for (AActor* Actor : World->PersistentLevel->Actors)
+		{
+			if (Actor == nullptr)
+			{
+				continue;
+			}
+
+			const FName ClassName = Actor->GetClass()->GetFName();
+
+			if (ClassName == "VolumetricClouds_C")
+			{
+				if (UMaterialInterface* Material = GetMaterial(Actor))
+				{
+					Capture.AddMaterial(EEnvironmentPresetTarget::Clouds, Material);
+				}
+			}
+			else if (ClassName == "Sky_C" || ClassName == "SunSky_C")
+			{
+				if (UMaterialInterface* Material = GetMaterial(Actor))
+				{
+					Capture.AddMaterial(EEnvironmentPresetTarget::Sky, Material);
+				}
+			}
+			else if (ADirectionalLight* DirectionalLight = Cast<ADirectionalLight>(Actor))
+			{
+				//Atmosphere sun wins over any other directional light.
+				const UDirectionalLightComponent* Light = Cast<UDirectionalLightComponent>(DirectionalLight->GetLightComponent());
+
+				if (Light != nullptr && (!bSunCaptured || Light->IsUsedAsAtmosphereSunLight()))
+				{
+					Capture.AddLight(EEnvironmentPresetTarget::SunLight, Light);
+					bSunCaptured = true;
+				}
+			}
+			else if (ASkyLight* SkyLight = Cast<ASkyLight>(Actor))
+			{
+				if (SkyLight->GetLightComponent() != nullptr)
+				{
+					Capture.AddLight(EEnvironmentPresetTarget::SkyLight, SkyLight->GetLightComponent());
+				}
+			}
+		}
+
+		return true;
+	}
+}
+
+UEnvironmentPresetCommandlet::UEnvironmentPresetCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UEnvironmentPresetCommandlet::Main(const FString& Params)
+{
+	using namespace EnvironmentPresetCommandlet;
+
+	FString TablePackageName = TEXT("/Game/VolumetricClouds/DA_EnvironmentPresets");
+	FString PresetsParam = TEXT("Day:/Game/VolumetricClouds/Scenes/SC_Day,Night:/Game/VolumetricClouds/Scenes/SC_Night,")
+		TEXT("Sunset:/Game/VolumetricClouds/Scenes/SC_Sunset,BloodMoon:/Game/VolumetricClouds/Scenes/SC_BloodMoon");
+
+	FParse::Value(*Params, TEXT("Table="), TablePackageName);
+	FParse::Value(*Params, TEXT("Presets="), PresetsParam, false);
+
+	if (!FPackageName::IsValidLongPackageName(TablePackageName))
+	{
+		UE_LOG(LogEnvironmentPreset, Error, TEXT("-Table=/Game/Path/Table is not a valid package name."));
+		return 1;
+	}
+
+	UPackage* TablePackage = CreatePackage(nullptr, *TablePackageName);
+	TablePackage->FullyLoad();
+
+	const FString TableName = FPackageName::GetLongPackageAssetName(TablePackageName);
+	UEnvironmentPresetTable* Table = FindObject<UEnvironmentPresetTable>(TablePackage, *TableName);
+
+	if (Table == nullptr)
+	{
+		Table = NewObject<UEnvironmentPresetTable>(TablePackage, *TableName, RF_Public | RF_Standalone);
+	}
+
+	//Captured from scratch, only the collection is kept.
+	Table->Parameters.Reset();
+	Table->Presets.Reset();
+	Table->NumValues = 0;
+
+	TArray<FString> PresetEntries;
+	PresetsParam.ParseIntoArray(PresetEntries, TEXT(","));
+
+	TArray<TSet<int32>> CapturedParameters;
+	CapturedParameters.SetNum(PresetEntries.Num());
+
+	for (int32 PresetIndex = 0; PresetIndex < PresetEntries.Num(); PresetIndex++)
+	{
+		FString PresetName;
+		FString MapPackageName;
+
+		if (!PresetEntries[PresetIndex].Split(TEXT(":"), &PresetName, &MapPackageName))
+		{
+			UE_LOG(LogEnvironmentPreset, Error, TEXT("Invalid preset %s, expected Name:/Game/Path/Map."), *PresetEntries[PresetIndex]);
+			return 1;
+		}
+
+		if (Table->FindPreset(*PresetName) != nullptr)
+		{
+			UE_LOG(LogEnvironmentPreset, Error, TEXT("Preset %s is captured twice."), *PresetName);
+			return 1;
+		}
+
+		Table->FindOrAddPreset(*PresetName);
+
+		FCapture Capture;
+		Capture.Table = Table;
+		Capture.PresetIndex = PresetIndex;
+		Capture.CapturedParameters = &CapturedParameters[PresetIndex];
+
+		if (!CaptureScene(MapPackageName, Capture))
+		{
+			UE_LOG(LogEnvironmentPreset, Error, TEXT("Failed to load %s."), *MapPackageName);
+			return 1;
+		}
+
+		UE_LOG(LogEnvironmentPreset, Display, TEXT("Captured %d parameters of %s from %s."), CapturedParameters[PresetIndex].Num(), *PresetName, *MapPackageName);
+	}
+
+	//Scenes without a sky or a light borrow the values of the first scene that has them, blends stay continuous.
+	for (int32 ParameterIndex = 0; ParameterIndex < Table->Parameters.Num(); ParameterIndex++)
+	{
+		const int32 SourceIndex = CapturedParameters.IndexOfByPredicate([ParameterIndex](const TSet<int32>& Captured) { return Captured.Contains(ParameterIndex); });
+		const FEnvironmentPresetParameter& Parameter = Table->Parameters[ParameterIndex];
+		const int32 NumComponents = Parameter.bVector ? 4 : 1;
+
+		for (int32 PresetIndex = 0; PresetIndex < Table->Presets.Num(); PresetIndex++)
+		{
+			if (!CapturedParameters[PresetIndex].Contains(ParameterIndex))
+			{
+				FMemory::Memcpy(&Table->Presets[PresetIndex].Values[Parameter.Offset], &Table->Presets[SourceIndex].Values[Parameter.Offset], NumComponents * sizeof(float));
+			}
+		}
+	}
+
+	const FString Filename = FPackageName::LongPackageNameToFilename(TablePackageName, FPackageName::GetAssetPackageExtension());
+	TablePackage->MarkPackageDirty();
+
+	if (!UPackage::SavePackage(TablePackage, Table, RF_Public | RF_Standalone, *Filename, GError, nullptr, false, true, SAVE_NoError))
+	{
+		UE_LOG(LogEnvironmentPreset, Error, TEXT("Failed to save %s."), *TablePackageName);
+		return 1;
+	}
+
+	UE_LOG(LogEnvironmentPreset, Display, TEXT("Saved %d presets of %d values to %s."), Table->Presets.Num(), Table->NumValues, *TablePackageName);
+
+	return 0;
+}
@@ -0,0 +1,30 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "EnvironmentPresetCommandlet.generated.h"
+
+/**
+* Captures sky, cloud and light parameters of scenes into an environment preset table.
+*
+* UE4Editor-Cmd.exe FullEnvironmentDev.uproject -run=EnvironmentPreset
+*	[-Table=/Game/VolumetricClouds/DA_EnvironmentPresets]
+*	[-Presets=Day:/Game/VolumetricClouds/Scenes/SC_Day,Night:/Game/VolumetricClouds/Scenes/SC_Night,...]
+*
+* Parameters missing from a scene take the value of the first scene that has them.
+*/
+UCLASS()
+class UEnvironmentPresetCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UEnvironmentPresetCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End of UCommandlet interface
+};
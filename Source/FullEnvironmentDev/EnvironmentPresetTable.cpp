@@ -0,0 +1,52 @@
+// 2015 - Community based open project
+
+#include "EnvironmentPresetTable.h"
+
+const FEnvironmentPreset* UEnvironmentPresetTable::FindPreset(FName PresetName) const
+{
+	return Presets.FindByPredicate([PresetName](const FEnvironmentPreset& Preset) { return Preset.Name == PresetName; });
+}
+
+int32 UEnvironmentPresetTable::FindOrAddParameter(EEnvironmentPresetTarget Target, FName Name, bool bVector)
+{
+	const int32 ExistingIndex = Parameters.IndexOfByPredicate([Target, Name, bVector](const FEnvironmentPresetParameter& Parameter)
+	{
+		return Parameter.Target == Target && Parameter.Name == Name && Parameter.bVector == bVector;
+	});
+
+	if (ExistingIndex != INDEX_NONE)
+	{
+		return ExistingIndex;
+	}
+
+	FEnvironmentPresetParameter Parameter;
+	Parameter.Target = Target;
+	Parameter.Name = Name;
+	Parameter.bVector = bVector;
+	Parameter.Offset = NumValues;
+
+	NumValues += bVector ? 4 : 1;
+
+	for (FEnvironmentPreset& Preset : Presets)
+	{
+		Preset.Values.SetNumZeroed(NumValues);
+	}
+
+	return Parameters.Add(Parameter);
+}
+
+FEnvironmentPreset& UEnvironmentPresetTable::FindOrAddPreset(FName PresetName)
+{
+	FEnvironmentPreset* ExistingPreset = Presets.FindByPredicate([PresetName](const FEnvironmentPreset& Preset) { return Preset.Name == PresetName; });
+
+	if (ExistingPreset != nullptr)
+	{
+		return *ExistingPreset;
+	}
+
+	FEnvironmentPreset& Preset = Presets.AddDefaulted_GetRef();
+	Preset.Name = PresetName;
+	Preset.Values.SetNumZeroed(NumValues);
+
+	return Preset;
+}
@@ -0,0 +1,94 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+
+#include "EnvironmentPresetTable.generated.h"
+
+class UMaterialParameterCollection;
+
+/** Object a preset parameter is applied to. */
+UENUM()
+enum class EEnvironmentPresetTarget : uint8
+{
+	/** Volumetric clouds material. */
+	Clouds,
+	/** Sky sphere material. */
+	Sky,
+	/** Atmosphere sun directional light, Intensity and LightColor. */
+	SunLight,
+	/** Sky light, Intensity and LightColor. */
+	SkyLight,
+};
+
+/** Parameter stored by every preset. */
+USTRUCT()
+struct FEnvironmentPresetParameter
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, Category = "Preset")
+	EEnvironmentPresetTarget Target = EEnvironmentPresetTarget::Clouds;
+
+	UPROPERTY(VisibleAnywhere, Category = "Preset")
+	FName Name;
+
+	/** Vector parameters take four values, scalars one. */
+	UPROPERTY(VisibleAnywhere, Category = "Preset")
+	bool bVector = false;
+
+	/** First value of the parameter in a preset. */
+	UPROPERTY(VisibleAnywhere, Category = "Preset")
+	int32 Offset = 0;
+};
+
+/** Values of every table parameter, packed in parameter order. */
+USTRUCT()
+struct FEnvironmentPreset
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, Category = "Preset")
+	FName Name;
+
+	UPROPERTY(VisibleAnywhere, Category = "Preset")
+	TArray<float> Values;
+};
+
+/**
+* Sky, cloud and light looks captured from the SC_Day, SC_Night, SC_Sunset and SC_BloodMoon scenes by the
+* EnvironmentPreset commandlet. Every preset stores the same flat parameter vector, so two presets blend with one lerp.
+*/
+UCLASS(BlueprintType)
+class FULLENVIRONMENTDEV_API UEnvironmentPresetTable : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/** Optional collection, parameters it contains are set on it instead of on the material instances. */
+	UPROPERTY(EditAnywhere, Category = "Preset")
+	UMaterialParameterCollection* ParameterCollection = nullptr;
+
+	UPROPERTY(VisibleAnywhere, Category = "Preset")
+	TArray<FEnvironmentPresetParameter> Parameters;
+
+	/** Values per preset. */
+	UPROPERTY(VisibleAnywhere, Category = "Preset")
+	int32 NumValues = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Preset")
+	TArray<FEnvironmentPreset> Presets;
+
+	/** Preset by name, nullptr if there is none. */
+	const FEnvironmentPreset* FindPreset(FName PresetName) const;
+
+	/** Find a parameter or append it, existing presets get zeros for it.
+	* @return parameter index.
+	*/
+	int32 FindOrAddParameter(EEnvironmentPresetTarget Target, FName Name, bool bVector);
+
+	/** Find a preset or append one with zeros. */
+	FEnvironmentPreset& FindOrAddPreset(FName PresetName);
+};
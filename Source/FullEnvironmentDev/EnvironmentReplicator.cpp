@@ -0,0 +1,317 @@
+// 2015 - Community based open project
+
+#include "EnvironmentReplicator.h"
+#include "EnvironmentViewModel.h"
+#include "EnvironmentPresetBlender.h"
+#include "LightningStrikeScheduler.h"
+#include "VolumetricCloudsWeatherSimulation.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "Components/StaticMeshComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Net/UnrealNetwork.h"
+#include "EngineUtils.h"
+
+namespace EnvironmentReplicator
+{
+	/** Server blend end times closer than this are the same blend. */
+	const float BlendEndTolerance = 0.5f;
+
+	int32 FindPresetIndex(const UEnvironmentPresetTable* Table, FName PresetName)
+	{
+		return Table->Presets.IndexOfByPredicate([PresetName](const FEnvironmentPreset& Preset) { return Preset.Name == PresetName; });
+	}
+}
+
+AEnvironmentReplicator::AEnvironmentReplicator()
+	: UpdateInterval(0.25f)
+	, TimeTolerance(10.0f)
+	, ClientTimeTolerance(30.0f)
+	, MaxTimeScale(86400.0f)
+	, WeatherMapOffsetParameter(TEXT("WeatherMapOffset"))
+	, CloudsMaterial(nullptr)
+	, LastSampleTime(-1.0f)
+	, TimeSinceUpdate(0.0f)
+	, bReceivedTime(false)
+	, bDrivingStorm(false)
+	, bBoundClouds(false)
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	bReplicates = true;
+	bAlwaysRelevant = true;
+
+	//Changes leave within an update interval, unchanged updates write nothing.
+	NetUpdateFrequency = 4.0f;
+}
+
+AEnvironmentReplicator* AEnvironmentReplicator::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (TActorIterator<AEnvironmentReplicator> ReplicatorItr(World); ReplicatorItr; ++ReplicatorItr)
+	{
+		return *ReplicatorItr;
+	}
+
+	return nullptr;
+}
+
+void AEnvironmentReplicator::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AEnvironmentReplicator, State);
+}
+
+void AEnvironmentReplicator::SetStormCells(const TArray<FEnvironmentStormCell>& StormCells)
+{
+	State.StormCells = StormCells;
+	State.Quantize();
+}
+
+void AEnvironmentReplicator::SetWeatherMapScroll(FVector2D Velocity)
+{
+	const float ServerTime = GetServerTime();
+
+	State.WeatherMapOffset = State.GetWeatherMapOffset(ServerTime);
+	State.WeatherMapVelocity = Velocity;
+	State.WeatherMapAnchor = ServerTime;
+	State.Quantize();
+}
+
+void AEnvironmentReplicator::SetWeatherMapOffset(FVector2D Offset)
+{
+	State.WeatherMapOffset = Offset;
+	State.WeatherMapAnchor = GetServerTime();
+	State.Quantize();
+}
+
+float AEnvironmentReplicator::GetServerTime() const
+{
+	const UWorld* World = GetWorld();
+	const AGameStateBase* GameState = World->GetGameState();
+
+	return GameState != nullptr ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+void AEnvironmentReplicator::CaptureState(float ServerTime)
+{
+	using namespace EnvironmentReplicator;
+
+	UWorld* World = GetWorld();
+
+	if (const UEnvironmentViewModel* ViewModel = UEnvironmentViewModel::Get(World))
+	{
+		const FDateTime LocalTime = ViewModel->GetLocalTime();
+		const float SampleSeconds = ServerTime - LastSampleTime;
+
+		if (LastSampleTime >= 0.0f && SampleSeconds > 0.0f
+			&& FMath::Abs((LocalTime - State.GetLocalTime(ServerTime)).GetTotalSeconds()) > TimeTolerance)
+		{
+			const float TimeScale = float((LocalTime - LastLocalTime).GetTotalSeconds() / SampleSeconds);
+
+			State.LocalTime = LocalTime;
+			State.TimeAnchor = ServerTime;
+
+			if (FMath::Abs(TimeScale) <= MaxTimeScale)
+			{
+				State.TimeScale = TimeScale;
+			}
+		}
+
+		LastLocalTime = LocalTime;
+		LastSampleTime = ServerTime;
+	}
+
+	const UEnvironmentPresetBlender* Blender = UEnvironmentPresetBlender::Find(World);
+
+	if (Blender != nullptr && Blender->GetTable() != nullptr)
+	{
+		FName FromPresetName;
+		FName ToPresetName;
+		float Alpha;
+		float Remaining;
+		Blender->GetBlendState(FromPresetName, ToPresetName, Alpha, Remaining);
+
+		const int32 FromPreset = FindPresetIndex(Blender->GetTable(), FromPresetName);
+		const int32 ToPreset = FindPresetIndex(Blender->GetTable(), ToPresetName);
+
+		if (FromPreset != INDEX_NONE)
+		{
+			State.BlendAlpha = Alpha;
+			State.BlendEndTime = 0.0f;
+		}
+		else if (ToPreset != State.ToPreset || State.FromPreset != INDEX_NONE
+			|| (Remaining > 0.0f && FMath::Abs(ServerTime + Remaining - State.BlendEndTime) > BlendEndTolerance))
+		{
+			//End time of a running blend stays put and a finished blend keeps the last one, so a blend is sent once.
+			State.BlendAlpha = 0.0f;
+			State.BlendEndTime = ServerTime + Remaining;
+		}
+
+		State.FromPreset = FromPreset;
+		State.ToPreset = ToPreset;
+	}
+
+	if (const UVolumetricCloudsWeatherSimulation* Simulation = UVolumetricCloudsWeatherSimulation::Get(World))
+	{
+		State.Wind = Simulation->PrevailingWind;
+	}
+
+	State.Quantize();
+}
+
+void AEnvironmentReplicator::OnRep_State()
+{
+	const float ServerTime = GetServerTime();
+	const uint8 Fields = State.GetReceivedFields();
+
+	if (Fields & (uint8)EEnvironmentNetField::Time)
+	{
+		bReceivedTime = true;
+		CorrectTime(ServerTime);
+	}
+
+	if (Fields & (uint8)EEnvironmentNetField::Blend)
+	{
+		ApplyBlend(ServerTime);
+	}
+
+	if (Fields & (uint8)EEnvironmentNetField::Wind)
+	{
+		if (UVolumetricCloudsWeatherSimulation* Simulation = UVolumetricCloudsWeatherSimulation::Get(GetWorld()))
+		{
+			Simulation->SetPrevailingWind(State.Wind);
+		}
+	}
+}
+
+void AEnvironmentReplicator::CorrectTime(float ServerTime)
+{
+	UEnvironmentViewModel* ViewModel = UEnvironmentViewModel::Get(GetWorld());
+
+	if (ViewModel == nullptr || !bReceivedTime)
+	{
+		return;
+	}
+
+	const FDateTime ServerLocalTime = State.GetLocalTime(ServerTime);
+
+	if (FMath::Abs((ViewModel->GetLocalTime() - ServerLocalTime).GetTotalSeconds()) > ClientTimeTolerance)
+	{
+		ViewModel->SetLocalTime(ServerLocalTime);
+		OnTimeCorrected.Broadcast(ServerLocalTime);
+	}
+}
+
+void AEnvironmentReplicator::ApplyBlend(float ServerTime)
+{
+	UEnvironmentPresetBlender* Blender = UEnvironmentPresetBlender::Find(GetWorld());
+	const UEnvironmentPresetTable* Table = Blender != nullptr ? Blender->GetTable() : nullptr;
+
+	if (Table == nullptr || !Table->Presets.IsValidIndex(State.ToPreset))
+	{
+		return;
+	}
+
+	const FName ToPresetName = Table->Presets[State.ToPreset].Name;
+
+	if (Table->Presets.IsValidIndex(State.FromPreset))
+	{
+		Blender->SetBlend(Table->Presets[State.FromPreset].Name, ToPresetName, State.BlendAlpha);
+		return;
+	}
+
+	FName CurrentFromPresetName;
+	FName CurrentToPresetName;
+	float Alpha;
+	float Remaining;
+	Blender->GetBlendState(CurrentFromPresetName, CurrentToPresetName, Alpha, Remaining);
+
+	//A client that is already blending to the preset keeps its blend.
+	if (CurrentFromPresetName != NAME_None || CurrentToPresetName != ToPresetName)
+	{
+		Blender->BlendTo(ToPresetName, FMath::Max(State.BlendEndTime - ServerTime, 0.0f));
+	}
+}
+
+void AEnvironmentReplicator::UpdateTargets(float ServerTime)
+{
+	UWorld* World = GetWorld();
+
+	if (State.StormCells.Num() > 0 || bDrivingStorm)
+	{
+		APlayerController* PlayerController = World->GetFirstPlayerController();
+		ULightningStrikeScheduler* Scheduler = ULightningStrikeScheduler::Get(World);
+
+		if (Scheduler != nullptr && State.StormCells.Num() == 0)
+		{
+			Scheduler->SetStormIntensity(-1.0f);
+			bDrivingStorm = false;
+		}
+		else if (Scheduler != nullptr && PlayerController != nullptr)
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+			Scheduler->SetStormIntensity(State.GetStormIntensity(ViewLocation));
+			bDrivingStorm = true;
+		}
+	}
+
+	//Clouds material is only touched once the weather map scrolls.
+	if (!bBoundClouds && WeatherMapOffsetParameter != NAME_None && !State.WeatherMapVelocity.IsZero())
+	{
+		bBoundClouds = true;
+
+		for (TActorIterator<AStaticMeshActor> StaticMeshItr(World); StaticMeshItr; ++StaticMeshItr)
+		{
+			if (StaticMeshItr->GetClass()->GetFName() == "VolumetricClouds_C")
+			{
+				CloudsMaterial = StaticMeshItr->GetStaticMeshComponent()->CreateDynamicMaterialInstance(0);
+				break;
+			}
+		}
+	}
+
+	if (CloudsMaterial != nullptr)
+	{
+		const FVector2D Offset = State.GetWeatherMapOffset(ServerTime);
+		CloudsMaterial->SetVectorParameterValue(WeatherMapOffsetParameter, FLinearColor(Offset.X, Offset.Y, 0.0f, 0.0f));
+	}
+}
+
+void AEnvironmentReplicator::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	const float ServerTime = GetServerTime();
+
+	TimeSinceUpdate += DeltaSeconds;
+
+	if (TimeSinceUpdate >= UpdateInterval)
+	{
+		TimeSinceUpdate = 0.0f;
+
+		if (HasAuthority())
+		{
+			CaptureState(ServerTime);
+		}
+		else
+		{
+			CorrectTime(ServerTime);
+		}
+	}
+
+	UpdateTargets(ServerTime);
+}
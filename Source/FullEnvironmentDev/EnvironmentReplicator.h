@@ -0,0 +1,119 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "EnvironmentNetState.h"
+
+#include "EnvironmentReplicator.generated.h"
+
+class UMaterialInstanceDynamic;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnEnvironmentTimeCorrected, const FDateTime&, LocalTime);
+
+/**
+* Replicates the environment state of the server, spawned by the server of every game world. The server samples
+* the view-model time, the preset blender, the weather simulation wind, storm cells and the weather map scroll at
+* UpdateInterval. Time and scroll are only re-anchored once the clients' extrapolation would be off, so steady
+* weather costs no bandwidth.
+*
+* Clients adopt the blend and the wind when they arrive and correct their local time once it drifts beyond
+* ClientTimeTolerance; the sky blueprint listens to OnTimeCorrected. Storm cells drive the lightning scheduler and
+* the weather map offset is pushed to the clouds material every frame, on the server as well.
+*
+* Test on one machine with a listen server and a client, e.g. "Universe?listen -game" and "127.0.0.1 -game",
+* then run Environment.NetStats on the server.
+*/
+UCLASS(Config = Game, NotPlaceable)
+class FULLENVIRONMENTDEV_API AEnvironmentReplicator : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	AEnvironmentReplicator();
+
+	/** Replicator of a world, nullptr until it was spawned or replicated. */
+	UFUNCTION(BlueprintPure, Category = "Environment", meta = (WorldContext = "WorldContextObject"))
+	static AEnvironmentReplicator* Get(const UObject* WorldContextObject);
+
+	/** Last sampled or received state. */
+	UFUNCTION(BlueprintPure, Category = "Environment")
+	const FEnvironmentNetState& GetState() const { return State; }
+
+	/** Replace the storm cells, an empty array gives the lightning scheduler back to the precipitation. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Weather")
+	void SetStormCells(const TArray<FEnvironmentStormCell>& StormCells);
+
+	/** Scroll the weather map at a speed in UV per second, continues from the current offset. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Weather")
+	void SetWeatherMapScroll(FVector2D Velocity);
+
+	/** Move the weather map to an offset, scrolling continues from it. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Weather")
+	void SetWeatherMapOffset(FVector2D Offset);
+
+	/** Client local time was moved to the server's. */
+	UPROPERTY(BlueprintAssignable, Category = "Environment")
+	FOnEnvironmentTimeCorrected OnTimeCorrected;
+
+	/** Seconds between two samples on the server and two drift checks on clients. */
+	UPROPERTY(Config)
+	float UpdateInterval;
+
+	/** Game seconds the server time may differ from the replicated anchor before it is re-anchored. */
+	UPROPERTY(Config)
+	float TimeTolerance;
+
+	/** Game seconds a client time may drift from the server time before it is corrected. */
+	UPROPERTY(Config)
+	float ClientTimeTolerance;
+
+	/** Faster time changes are jumps, e.g. a fast-forward, they keep the previous time scale. */
+	UPROPERTY(Config)
+	float MaxTimeScale;
+
+	/** Vector parameter of the clouds material that receives the weather map offset in R and G. */
+	UPROPERTY(Config)
+	FName WeatherMapOffsetParameter;
+
+	// AActor interface
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	// End of AActor interface
+
+private:
+	/** Sample the environment of the server. */
+	void CaptureState(float ServerTime);
+
+	/** Correct the local time once it drifted from the server time. */
+	void CorrectTime(float ServerTime);
+
+	/** Adopt the preset blend of the server. */
+	void ApplyBlend(float ServerTime);
+
+	/** Push storm intensity and weather map offset. */
+	void UpdateTargets(float ServerTime);
+
+	/** Server world time both sides extrapolate from. */
+	float GetServerTime() const;
+
+	UFUNCTION()
+	void OnRep_State();
+
+	UPROPERTY(ReplicatedUsing = OnRep_State)
+	FEnvironmentNetState State;
+
+	UPROPERTY()
+	UMaterialInstanceDynamic* CloudsMaterial;
+
+	/** Server time and local time of the previous sample, measures the time scale. */
+	float LastSampleTime;
+	FDateTime LastLocalTime;
+
+	float TimeSinceUpdate;
+
+	bool bReceivedTime;
+	bool bDrivingStorm;
+	bool bBoundClouds;
+};
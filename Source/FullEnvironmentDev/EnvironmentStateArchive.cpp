@@ -0,0 +1,638 @@
+// 2015 - Community based open project
+
+#include "EnvironmentStateArchive.h"
+#include "EnvironmentViewModel.h"
+#include "EnvironmentPresetBlender.h"
+#include "EnvironmentReplicator.h"
+#include "WeatherEffectPool.h"
+#include "VolumetricCloudsTiledImage.h"
+#include "VolumetricCloudsWeatherMap.h"
+#include "VolumetricCloudsWeatherSimulation.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogEnvironmentStateArchive, Log, All);
+
+/** Environment of an archive, plain data so it can be decoded off the game thread. */
+struct FEnvironmentStateData
+{
+	struct FEffect
+	{
+		FString ClassPath;
+		FTransform Transform;
+		float Lifetime = 0.0f;
+	};
+
+	FDateTime LocalTime;
+	int32 Month = 0;
+
+	FName Weather;
+	float Cloudiness = 0.0f;
+	float Precipitation = 0.0f;
+	float Temperature = 0.0f;
+
+	/** Fixed blend of two presets, or a timed blend to ToPreset if FromPreset is None. */
+	FName FromPreset;
+	FName ToPreset;
+	float BlendAlpha = 0.0f;
+	float BlendRemaining = 0.0f;
+
+	FVector2D Wind = FVector2D::ZeroVector;
+
+	TArray<FEnvironmentStormCell> StormCells;
+	FVector2D WeatherMapOffset = FVector2D::ZeroVector;
+	FVector2D WeatherMapVelocity = FVector2D::ZeroVector;
+
+	TArray<FEffect> Effects;
+
+	/** Weather map tiles changed at runtime. Compressed in the archive, decompressed to Texels after a load. */
+	FIntPoint WeatherMapSize = FIntPoint::ZeroValue;
+	TArray<int32> TileIndices;
+	TArray<TArray<uint8>> CompressedTiles;
+	TArray<FFloat16Color> Texels;
+};
+
+namespace EnvironmentStateArchive
+{
+	/** "ENVS", tells an environment archive from any other file. */
+	const uint32 Magic = 0x53564E45;
+
+	/** Version of the archive data. */
+	enum EVersion
+	{
+		InitialVersion = 1,
+
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	const int32 TileTexels = FVolumetricCloudsTiledImage::TileTexels;
+	const int32 TileBytes = TileTexels * sizeof(FFloat16Color);
+
+	/**
+	* Split tile texels into one plane per byte and store every byte as the difference to the previous texel.
+	* Smooth fields turn into long runs of small values, which zlib compresses well. Stored raw if that is smaller.
+	*/
+	void CompressTile(const FFloat16Color* Texels, TArray<uint8>& OutData)
+	{
+		const uint8* Source = (const uint8*)Texels;
+		TArray<uint8> Planes;
+		Planes.SetNumUninitialized(TileBytes);
+
+		for (int32 Byte = 0; Byte < (int32)sizeof(FFloat16Color); Byte++)
+		{
+			uint8* Plane = &Planes[Byte * TileTexels];
+			uint8 Previous = 0;
+
+			for (int32 Texel = 0; Texel < TileTexels; Texel++)
+			{
+				const uint8 Value = Source[Texel * sizeof(FFloat16Color) + Byte];
+				Plane[Texel] = Value - Previous;
+				Previous = Value;
+			}
+		}
+
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, TileBytes);
+		OutData.SetNumUninitialized(CompressedSize);
+
+		if (!FCompression::CompressMemory(NAME_Zlib, OutData.GetData(), CompressedSize, Planes.GetData(), TileBytes, COMPRESS_BiasSpeed)
+			|| CompressedSize >= TileBytes)
+		{
+			OutData = MoveTemp(Planes);
+			return;
+		}
+
+		OutData.SetNum(CompressedSize, false);
+	}
+
+	/** Reverse CompressTile, TileBytes of data are raw planes. */
+	bool DecompressTile(const TArray<uint8>& Data, FFloat16Color* OutTexels)
+	{
+		TArray<uint8> Planes;
+
+		if (Data.Num() == TileBytes)
+		{
+			Planes = Data;
+		}
+		else
+		{
+			Planes.SetNumUninitialized(TileBytes);
+
+			if (!FCompression::UncompressMemory(NAME_Zlib, Planes.GetData(), TileBytes, Data.GetData(), Data.Num()))
+			{
+				return false;
+			}
+		}
+
+		uint8* Dest = (uint8*)OutTexels;
+
+		for (int32 Byte = 0; Byte < (int32)sizeof(FFloat16Color); Byte++)
+		{
+			const uint8* Plane = &Planes[Byte * TileTexels];
+			uint8 Value = 0;
+
+			for (int32 Texel = 0; Texel < TileTexels; Texel++)
+			{
+				Value += Plane[Texel];
+				Dest[Texel * sizeof(FFloat16Color) + Byte] = Value;
+			}
+		}
+
+		return true;
+	}
+
+	/** Write or read an archive, false if it is corrupt or newer than this build. */
+	bool SerializeData(FArchive& Ar, FEnvironmentStateData& Data)
+	{
+		uint32 FileMagic = Magic;
+		int32 Version = LatestVersion;
+		Ar << FileMagic;
+		Ar << Version;
+
+		if (FileMagic != Magic || Version < InitialVersion || Version > LatestVersion)
+		{
+			UE_LOG(LogEnvironmentStateArchive, Warning, TEXT("Not an environment archive or version %d is newer than %d."), Version, (int32)LatestVersion);
+			return false;
+		}
+
+		Ar << Data.LocalTime;
+		Ar << Data.Month;
+
+		Ar << Data.Weather;
+		Ar << Data.Cloudiness;
+		Ar << Data.Precipitation;
+		Ar << Data.Temperature;
+
+		Ar << Data.FromPreset;
+		Ar << Data.ToPreset;
+		Ar << Data.BlendAlpha;
+		Ar << Data.BlendRemaining;
+
+		Ar << Data.Wind;
+
+		int32 NumStormCells = Data.StormCells.Num();
+		Ar << NumStormCells;
+
+		if (Ar.IsLoading())
+		{
+			if (NumStormCells < 0 || NumStormCells > 1024)
+			{
+				return false;
+			}
+
+			Data.StormCells.SetNum(NumStormCells);
+		}
+
+		for (FEnvironmentStormCell& Cell : Data.StormCells)
+		{
+			Ar << Cell.Center;
+			Ar << Cell.Radius;
+			Ar << Cell.Intensity;
+		}
+
+		Ar << Data.WeatherMapOffset;
+		Ar << Data.WeatherMapVelocity;
+
+		int32 NumEffects = Data.Effects.Num();
+		Ar << NumEffects;
+
+		if (Ar.IsLoading())
+		{
+			if (NumEffects < 0 || NumEffects > 65536)
+			{
+				return false;
+			}
+
+			Data.Effects.SetNum(NumEffects);
+		}
+
+		for (FEnvironmentStateData::FEffect& Effect : Data.Effects)
+		{
+			Ar << Effect.ClassPath;
+			Ar << Effect.Transform;
+			Ar << Effect.Lifetime;
+		}
+
+		Ar << Data.WeatherMapSize;
+
+		const int32 MaxTiles = FMath::DivideAndRoundUp(FMath::Max(Data.WeatherMapSize.X, 0), FVolumetricCloudsTiledImage::TileSize)
+			* FMath::DivideAndRoundUp(FMath::Max(Data.WeatherMapSize.Y, 0), FVolumetricCloudsTiledImage::TileSize);
+		int32 NumTiles = Data.TileIndices.Num();
+		Ar << NumTiles;
+
+		if (Ar.IsLoading())
+		{
+			if (NumTiles < 0 || NumTiles > MaxTiles)
+			{
+				return false;
+			}
+
+			Data.TileIndices.SetNum(NumTiles);
+			Data.CompressedTiles.SetNum(NumTiles);
+		}
+
+		//Tile bytes go through in bulk, one serialize call per tile.
+		for (int32 Index = 0; Index < NumTiles && !Ar.IsError(); Index++)
+		{
+			TArray<uint8>& Tile = Data.CompressedTiles[Index];
+			int32 TileSize = Tile.Num();
+
+			Ar << Data.TileIndices[Index];
+			Ar << TileSize;
+
+			if (Ar.IsLoading())
+			{
+				if (TileSize <= 0 || TileSize > TileBytes)
+				{
+					return false;
+				}
+
+				Tile.SetNumUninitialized(TileSize);
+			}
+
+			Ar.Serialize(Tile.GetData(), TileSize);
+		}
+
+		return !Ar.IsError();
+	}
+
+	/** Read and decompress an archive, runs on the thread pool. */
+	TSharedPtr<FEnvironmentStateData, ESPMode::ThreadSafe> Decode(const TArray<uint8>& Bytes)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		TSharedPtr<FEnvironmentStateData, ESPMode::ThreadSafe> Data = MakeShared<FEnvironmentStateData, ESPMode::ThreadSafe>();
+
+		FMemoryReader Reader(Bytes);
+
+		if (!SerializeData(Reader, *Data))
+		{
+			return nullptr;
+		}
+
+		const int32 NumTiles = Data->TileIndices.Num();
+		FThreadSafeBool bCorrupt = false;
+
+		Data->Texels.SetNumUninitialized(NumTiles * TileTexels);
+
+		ParallelFor(NumTiles, [&](int32 Index)
+		{
+			if (!DecompressTile(Data->CompressedTiles[Index], &Data->Texels[Index * TileTexels]))
+			{
+				bCorrupt = true;
+			}
+		});
+
+		Data->CompressedTiles.Empty();
+
+		if (bCorrupt)
+		{
+			UE_LOG(LogEnvironmentStateArchive, Warning, TEXT("Environment archive has corrupt weather map tiles."));
+			return nullptr;
+		}
+
+		UE_LOG(LogEnvironmentStateArchive, Log, TEXT("Decoded %d bytes with %d weather map tiles in %.2f ms."),
+			Bytes.Num(), NumTiles, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+		return Data;
+	}
+
+	void SaveState(const TArray<FString>& Args, UWorld* World)
+	{
+		UEnvironmentStateArchive* Archive = UEnvironmentStateArchive::Get(World);
+		const UEnvironmentViewModel* ViewModel = UEnvironmentViewModel::Get(World);
+
+		if (Archive != nullptr)
+		{
+			const int32 Month = ViewModel != nullptr ? ViewModel->GetLocalTime().GetMonth() - 1 : 0;
+			Archive->SaveToSlot(Args.Num() > 0 ? Args[0] : TEXT("Default"), Month);
+		}
+	}
+
+	void LoadState(const TArray<FString>& Args, UWorld* World)
+	{
+		if (UEnvironmentStateArchive* Archive = UEnvironmentStateArchive::Get(World))
+		{
+			Archive->LoadFromSlotAsync(Args.Num() > 0 ? Args[0] : TEXT("Default"));
+		}
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs SaveStateCommand(
+		TEXT("Environment.SaveState"),
+		TEXT("Save the environment to a slot. Arguments: [Slot]."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SaveState));
+
+	FAutoConsoleCommandWithWorldAndArgs LoadStateCommand(
+		TEXT("Environment.LoadState"),
+		TEXT("Restore the environment from a slot. Arguments: [Slot]."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&LoadState));
+}
+
+UEnvironmentStateArchive* UEnvironmentStateArchive::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (UEnvironmentStateArchive* Archive = Cast<UEnvironmentStateArchive>(Object))
+		{
+			return Archive;
+		}
+	}
+
+	UEnvironmentStateArchive* Archive = NewObject<UEnvironmentStateArchive>(World);
+	World->PerModuleDataObjects.Add(Archive);
+
+	return Archive;
+}
+
+FString UEnvironmentStateArchive::GetSlotPath(const FString& SlotName)
+{
+	return FPaths::ProjectSavedDir() / TEXT("Environment") / SlotName + TEXT(".env");
+}
+
+void UEnvironmentStateArchive::Save(int32 Month, TArray<uint8>& OutData)
+{
+	using namespace EnvironmentStateArchive;
+
+	const double StartTime = FPlatformTime::Seconds();
+	UWorld* World = GetWorld();
+	FEnvironmentStateData Data;
+
+	Data.Month = Month;
+
+	if (const UEnvironmentViewModel* ViewModel = UEnvironmentViewModel::Get(World))
+	{
+		Data.LocalTime = ViewModel->GetLocalTime();
+		Data.Weather = ViewModel->GetWeather();
+		Data.Cloudiness = ViewModel->GetCloudiness();
+		Data.Precipitation = ViewModel->GetPrecipitation();
+		Data.Temperature = ViewModel->GetTemperature();
+	}
+
+	if (const UEnvironmentPresetBlender* Blender = UEnvironmentPresetBlender::Find(World))
+	{
+		Blender->GetBlendState(Data.FromPreset, Data.ToPreset, Data.BlendAlpha, Data.BlendRemaining);
+	}
+
+	if (const UVolumetricCloudsWeatherSimulation* Simulation = UVolumetricCloudsWeatherSimulation::Get(World))
+	{
+		Data.Wind = Simulation->PrevailingWind;
+	}
+
+	if (const AEnvironmentReplicator* Replicator = AEnvironmentReplicator::Get(World))
+	{
+		const FEnvironmentNetState& State = Replicator->GetState();
+		const AGameStateBase* GameState = World->GetGameState();
+
+		Data.StormCells = State.StormCells;
+		Data.WeatherMapOffset = State.GetWeatherMapOffset(GameState != nullptr ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds());
+		Data.WeatherMapVelocity = State.WeatherMapVelocity;
+	}
+
+	if (const UWeatherEffectPool* Pool = UWeatherEffectPool::Get(World))
+	{
+		TArray<FWeatherEffectPoolEntry> Effects;
+		Pool->GetActiveEffects(Effects);
+
+		for (const FWeatherEffectPoolEntry& Effect : Effects)
+		{
+			FEnvironmentStateData::FEffect& SavedEffect = Data.Effects.AddDefaulted_GetRef();
+			SavedEffect.ClassPath = Effect.Class->GetPathName();
+			SavedEffect.Transform = Effect.Transform;
+			SavedEffect.Lifetime = Effect.Lifetime;
+		}
+	}
+
+	if (UVolumetricCloudsWeatherMap* WeatherMap = UVolumetricCloudsWeatherMap::Find(World))
+	{
+		FVolumetricCloudsWeatherMapTiles Tiles;
+
+		//Copied from the weather map canvas on the game thread, neither the render thread nor the GPU is waited for.
+		if (WeatherMap->ReadModifiedTiles(Tiles))
+		{
+			Data.WeatherMapSize = Tiles.Size;
+			Data.TileIndices = MoveTemp(Tiles.TileIndices);
+			Data.CompressedTiles.SetNum(Data.TileIndices.Num());
+
+			ParallelFor(Data.TileIndices.Num(), [&](int32 Index)
+			{
+				CompressTile(&Tiles.Texels[Index * TileTexels], Data.CompressedTiles[Index]);
+			});
+		}
+	}
+
+	OutData.Reset();
+	FMemoryWriter Writer(OutData);
+	SerializeData(Writer, Data);
+
+	UE_LOG(LogEnvironmentStateArchive, Log, TEXT("Saved %d bytes with %d weather map tiles in %.2f ms."),
+		OutData.Num(), Data.TileIndices.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+bool UEnvironmentStateArchive::LoadAsync(TArray<uint8>&& Data)
+{
+	if (IsLoading())
+	{
+		return false;
+	}
+
+	PendingLoad = Async(EAsyncExecution::ThreadPool, [Bytes = MoveTemp(Data)]()
+	{
+		return EnvironmentStateArchive::Decode(Bytes);
+	});
+
+	return true;
+}
+
+bool UEnvironmentStateArchive::SaveToSlot(const FString& SlotName, int32 Month)
+{
+	TArray<uint8> Data;
+	Save(Month, Data);
+
+	const FString Path = GetSlotPath(SlotName);
+
+	if (!FFileHelper::SaveArrayToFile(Data, *Path))
+	{
+		UE_LOG(LogEnvironmentStateArchive, Warning, TEXT("Failed to write %s."), *Path);
+		return false;
+	}
+
+	return true;
+}
+
+bool UEnvironmentStateArchive::LoadFromSlotAsync(const FString& SlotName)
+{
+	if (IsLoading())
+	{
+		return false;
+	}
+
+	PendingLoad = Async(EAsyncExecution::ThreadPool, [Path = GetSlotPath(SlotName)]() -> TSharedPtr<FEnvironmentStateData, ESPMode::ThreadSafe>
+	{
+		TArray<uint8> Bytes;
+
+		if (!FFileHelper::LoadFileToArray(Bytes, *Path))
+		{
+			UE_LOG(LogEnvironmentStateArchive, Warning, TEXT("Failed to read %s."), *Path);
+			return nullptr;
+		}
+
+		return EnvironmentStateArchive::Decode(Bytes);
+	});
+
+	return true;
+}
+
+void UEnvironmentStateArchive::Apply(FEnvironmentStateData& Data)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	UWorld* World = GetWorld();
+
+	if (UEnvironmentViewModel* ViewModel = UEnvironmentViewModel::Get(World))
+	{
+		ViewModel->SetLocalTime(Data.LocalTime);
+		ViewModel->SetWeather(Data.Weather, Data.Cloudiness, Data.Precipitation);
+		ViewModel->SetTemperature(Data.Temperature);
+	}
+
+	if (UEnvironmentPresetBlender* Blender = UEnvironmentPresetBlender::Find(World))
+	{
+		if (Data.FromPreset != NAME_None)
+		{
+			Blender->SetBlend(Data.FromPreset, Data.ToPreset, Data.BlendAlpha);
+		}
+		else if (Data.ToPreset != NAME_None)
+		{
+			Blender->BlendTo(Data.ToPreset, Data.BlendRemaining);
+		}
+	}
+
+	if (UVolumetricCloudsWeatherSimulation* Simulation = UVolumetricCloudsWeatherSimulation::Get(World))
+	{
+		Simulation->SetPrevailingWind(Data.Wind);
+	}
+
+	//Clients follow the server's replicated state instead.
+	AEnvironmentReplicator* Replicator = AEnvironmentReplicator::Get(World);
+
+	if (Replicator != nullptr && Replicator->HasAuthority())
+	{
+		Replicator->SetStormCells(Data.StormCells);
+		Replicator->SetWeatherMapOffset(Data.WeatherMapOffset);
+		Replicator->SetWeatherMapScroll(Data.WeatherMapVelocity);
+	}
+
+	if (UWeatherEffectPool* Pool = UWeatherEffectPool::Get(World))
+	{
+		Pool->ReleaseAll();
+
+		for (const FEnvironmentStateData::FEffect& Effect : Data.Effects)
+		{
+			//Streamed in before the archive was applied, a class that failed to load is skipped.
+			UClass* Class = FSoftClassPath(Effect.ClassPath).ResolveClass();
+
+			if (Class != nullptr && Class->IsChildOf(AActor::StaticClass()))
+			{
+				Pool->Acquire(Class, Effect.Transform, Effect.Lifetime);
+			}
+		}
+	}
+
+	const int32 NumTiles = Data.TileIndices.Num();
+	UVolumetricCloudsWeatherMap* WeatherMap = UVolumetricCloudsWeatherMap::Find(World);
+
+	if (NumTiles > 0)
+	{
+		FVolumetricCloudsWeatherMapTiles Tiles;
+		Tiles.Size = Data.WeatherMapSize;
+		Tiles.TileIndices = MoveTemp(Data.TileIndices);
+		Tiles.Texels = MoveTemp(Data.Texels);
+
+		//Tiles changed this session but not in the save go back to the cooked weather map.
+		if (WeatherMap == nullptr || !WeatherMap->WriteTiles(MoveTemp(Tiles), true))
+		{
+			UE_LOG(LogEnvironmentStateArchive, Warning, TEXT("Weather map doesn't match the archive, %d saved tiles are skipped."), NumTiles);
+		}
+	}
+	else if (WeatherMap != nullptr)
+	{
+		//Weather map was saved unchanged.
+		WeatherMap->RevertModifiedTiles();
+	}
+
+	UE_LOG(LogEnvironmentStateArchive, Log, TEXT("Applied environment of %s with %d weather map tiles in %.2f ms."),
+		*Data.LocalTime.ToString(), NumTiles, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	OnLoaded.Broadcast(true, Data.LocalTime, Data.Month);
+}
+
+void UEnvironmentStateArchive::Tick(float DeltaTime)
+{
+	if (PendingLoad.IsReady())
+	{
+		TSharedPtr<FEnvironmentStateData, ESPMode::ThreadSafe> Data = PendingLoad.Get();
+		PendingLoad.Reset();
+
+		if (!Data.IsValid())
+		{
+			OnLoaded.Broadcast(false, FDateTime(), 0);
+			return;
+		}
+
+		TArray<FSoftObjectPath> ClassPaths;
+
+		for (const FEnvironmentStateData::FEffect& Effect : Data->Effects)
+		{
+			const FSoftClassPath ClassPath(Effect.ClassPath);
+
+			if (ClassPath.IsValid() && ClassPath.ResolveClass() == nullptr)
+			{
+				ClassPaths.AddUnique(ClassPath);
+			}
+		}
+
+		LoadedData = Data;
+
+		if (ClassPaths.Num() > 0)
+		{
+			ClassLoadHandle = StreamableManager.RequestAsyncLoad(ClassPaths);
+		}
+	}
+
+	if (!LoadedData.IsValid() || (ClassLoadHandle.IsValid() && ClassLoadHandle->IsLoadingInProgress()))
+	{
+		return;
+	}
+
+	TSharedPtr<FEnvironmentStateData, ESPMode::ThreadSafe> Data = MoveTemp(LoadedData);
+	Apply(*Data);
+
+	//Handle keeps the streamed classes referenced until the pool spawned its effects.
+	ClassLoadHandle.Reset();
+}
+
+bool UEnvironmentStateArchive::IsTickable() const
+{
+	return IsLoading() && !IsTemplate();
+}
+
+TStatId UEnvironmentStateArchive::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnvironmentStateArchive, STATGROUP_Tickables);
+}
@@ -0,0 +1,93 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Async/Future.h"
+#include "Engine/StreamableManager.h"
+#include "Tickable.h"
+
+#include "EnvironmentStateArchive.generated.h"
+
+struct FEnvironmentStateData;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnEnvironmentStateLoaded, bool, bSuccess, const FDateTime&, LocalTime, int32, Month);
+
+/**
+* Saves and restores the whole environment of a world as a versioned binary archive: local time, climate month,
+* weather, preset blend, wind, storm cells, weather map scroll, active pooled effects and the weather map tiles
+* changed at runtime. Everything is written with plain archive serialization, changed tiles are stored as half
+* precision texels split into byte planes and compressed one tile at a time.
+*
+* Loading reads, decompresses and converts on the thread pool, effect classes that aren't loaded yet are streamed in
+* asynchronously. Only applying the result runs on the game thread, and the weather map gets the changed tiles uploaded instead of being baked again, tiles changed since that aren't
+* in the archive are reverted to the cooked weather map. The sky blueprint listens to
+* OnLoaded to follow the restored time and month.
+*
+* Console: Environment.SaveState [Slot], Environment.LoadState [Slot], slots are files in Saved/Environment.
+*/
+UCLASS(BlueprintType)
+class FULLENVIRONMENTDEV_API UEnvironmentStateArchive : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Archive of a world, created on the first call. */
+	UFUNCTION(BlueprintPure, Category = "Environment", meta = (WorldContext = "WorldContextObject"))
+	static UEnvironmentStateArchive* Get(const UObject* WorldContextObject);
+
+	/** Write the current environment. Weather map tiles are copied from its game thread canvas, nothing waits for
+	* the render thread. Game thread only.
+	* @param Month - climate month in E_MonthOfYear order, the blueprint climate owns it.
+	* @param OutData - archive bytes.
+	*/
+	void Save(int32 Month, TArray<uint8>& OutData);
+
+	/** Start restoring an archive, OnLoaded fires once it is applied.
+	* @return false if a load is already running.
+	*/
+	bool LoadAsync(TArray<uint8>&& Data);
+
+	/** Save to a slot file in Saved/Environment.
+	* @return false if the file couldn't be written.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	bool SaveToSlot(const FString& SlotName, int32 Month);
+
+	/** Start restoring a slot file, the file is read on the thread pool as well.
+	* @return false if a load is already running.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	bool LoadFromSlotAsync(const FString& SlotName);
+
+	UFUNCTION(BlueprintPure, Category = "Environment")
+	bool IsLoading() const { return PendingLoad.IsValid() || LoadedData.IsValid(); }
+
+	/** Archive applied, bSuccess is false for a missing, corrupt or newer archive. */
+	UPROPERTY(BlueprintAssignable, Category = "Environment")
+	FOnEnvironmentStateLoaded OnLoaded;
+
+	/** File of a slot. */
+	static FString GetSlotPath(const FString& SlotName);
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Apply a decoded archive to the world. */
+	void Apply(FEnvironmentStateData& Data);
+
+	/** Decoded archive, nullptr if it couldn't be read. */
+	TFuture<TSharedPtr<FEnvironmentStateData, ESPMode::ThreadSafe>> PendingLoad;
+
+	/** Decoded archive waiting for its effect classes to stream in. */
+	TSharedPtr<FEnvironmentStateData, ESPMode::ThreadSafe> LoadedData;
+
+	/** Streams effect classes of a decoded archive, game thread loads would hitch on every missing class. */
+	FStreamableManager StreamableManager;
+	TSharedPtr<FStreamableHandle> ClassLoadHandle;
+};
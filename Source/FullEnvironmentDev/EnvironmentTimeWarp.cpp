@@ -0,0 +1,266 @@
+// 2015 - Community based open project
+
+#include "EnvironmentTimeWarp.h"
+#include "EnvironmentClock.h"
+#include "EnvironmentViewModel.h"
+#include "EnvironmentPresetBlender.h"
+#include "SurfaceWeatherGrid.h"
+#include "VolumetricCloudsWeatherSimulation.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UnrealClient.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogEnvironmentTimeWarp, Log, All);
+
+namespace EnvironmentTimeWarp
+{
+	void FastForward(const TArray<FString>& Args, UWorld* World)
+	{
+		if (Args.Num() < 1)
+		{
+			UE_LOG(LogEnvironmentTimeWarp, Display, TEXT("Usage: Environment.FastForward Days [SnapshotDays]"));
+			return;
+		}
+
+		const double Days = FCString::Atod(*Args[0]);
+		const double SnapshotDays = Args.Num() > 1 ? FCString::Atod(*Args[1]) : 0.0;
+
+		if (UEnvironmentTimeWarp* TimeWarp = UEnvironmentTimeWarp::Get(World))
+		{
+			TimeWarp->FastForward(FTimespan::FromDays(Days), FTimespan::FromDays(SnapshotDays));
+		}
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs FastForwardCommand(
+		TEXT("Environment.FastForward"),
+		TEXT("Fast-forward the environment. Arguments: Days [SnapshotDays]."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&FastForward));
+}
+
+UEnvironmentTimeWarp::UEnvironmentTimeWarp()
+	: StepHours(6.0f)
+	, MaxSolverStepsPerStep(16)
+	, bScreenshots(false)
+	, bWarping(false)
+	, bExitWhenFinished(false)
+	, bCheckedCommandLine(false)
+{
+}
+
+UEnvironmentTimeWarp* UEnvironmentTimeWarp::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (UEnvironmentTimeWarp* TimeWarp = Cast<UEnvironmentTimeWarp>(Object))
+		{
+			return TimeWarp;
+		}
+	}
+
+	UEnvironmentTimeWarp* TimeWarp = NewObject<UEnvironmentTimeWarp>(World);
+	World->PerModuleDataObjects.Add(TimeWarp);
+
+	return TimeWarp;
+}
+
+bool UEnvironmentTimeWarp::FastForward(FTimespan Span, FTimespan InSnapshotInterval)
+{
+	if (bWarping)
+	{
+		return false;
+	}
+
+	UEnvironmentViewModel* ViewModel = UEnvironmentViewModel::Get(GetWorld());
+
+	LocalTime = ViewModel != nullptr ? ViewModel->GetLocalTime() : FDateTime();
+	EndTime = LocalTime + FMath::Max(Span, FTimespan::Zero());
+	SnapshotInterval = InSnapshotInterval;
+	NextSnapshotTime = SnapshotInterval > FTimespan::Zero() ? FMath::Min(LocalTime + SnapshotInterval, EndTime) : EndTime;
+	bWarping = true;
+
+	Report = TEXT("LocalTime,Month,Temperature,Precipitation,Wetness,Snow,RealSeconds\n");
+
+	//Clock events to coalesce fire once, when the warp is over.
+	if (UEnvironmentClock* Clock = UEnvironmentClock::Get(GetWorld()))
+	{
+		Clock->BeginJump();
+	}
+
+	UE_LOG(LogEnvironmentTimeWarp, Log, TEXT("Fast-forwarding %s from %s."), *Span.ToString(), *LocalTime.ToString());
+
+	return true;
+}
+
+void UEnvironmentTimeWarp::Step(const FTimespan& StepSpan)
+{
+	UWorld* World = GetWorld();
+	const float Seconds = float(StepSpan.GetTotalSeconds());
+
+	LocalTime += StepSpan;
+
+	if (UEnvironmentViewModel* ViewModel = UEnvironmentViewModel::Get(World))
+	{
+		ViewModel->SetLocalTime(LocalTime);
+	}
+
+	//Clock events of the step fire in order, before the climate and the simulations see it.
+	if (UEnvironmentClock* Clock = UEnvironmentClock::Get(World))
+	{
+		Clock->AdvanceTo(LocalTime);
+	}
+
+	//Climate follows the calendar before the simulations integrate the step.
+	OnStep.Broadcast(LocalTime);
+
+	if (UEnvironmentPresetBlender* Blender = UEnvironmentPresetBlender::Find(World))
+	{
+		if (Blender->IsTickable())
+		{
+			Blender->Tick(Seconds);
+		}
+	}
+
+	if (USurfaceWeatherGrid* Grid = USurfaceWeatherGrid::Get(World))
+	{
+		Grid->Advance(Seconds);
+	}
+
+	if (UVolumetricCloudsWeatherSimulation* Simulation = UVolumetricCloudsWeatherSimulation::Get(World))
+	{
+		Simulation->Advance(Seconds, MaxSolverStepsPerStep);
+	}
+}
+
+void UEnvironmentTimeWarp::TakeSnapshot()
+{
+	FEnvironmentSnapshot Snapshot;
+	Snapshot.LocalTime = LocalTime;
+	Snapshot.Month = LocalTime.GetMonth() - 1;
+
+	if (const UEnvironmentViewModel* ViewModel = UEnvironmentViewModel::Get(GetWorld()))
+	{
+		Snapshot.Temperature = ViewModel->GetTemperature();
+		Snapshot.Precipitation = ViewModel->GetPrecipitation();
+	}
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	const USurfaceWeatherGrid* Grid = USurfaceWeatherGrid::Get(GetWorld());
+
+	if (PlayerController != nullptr && Grid != nullptr)
+	{
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		const FSurfaceWeather SurfaceWeather = Grid->GetSurfaceWeather(ViewLocation);
+		Snapshot.Wetness = SurfaceWeather.Wetness;
+		Snapshot.Snow = SurfaceWeather.Snow;
+	}
+
+	Report += FString::Printf(TEXT("%s,%d,%.2f,%.3f,%.3f,%.3f,%.3f\n"), *Snapshot.LocalTime.ToIso8601(), Snapshot.Month, Snapshot.Temperature, Snapshot.Precipitation,
+		Snapshot.Wetness, Snapshot.Snow, FPlatformTime::Seconds() - GStartTime);
+
+	OnSnapshot.Broadcast(Snapshot);
+
+	if (bScreenshots && FApp::CanEverRender())
+	{
+		//Captured at the end of the next rendered frame, the warp waits a frame after every snapshot.
+		FScreenshotRequest::RequestScreenshot(FString::Printf(TEXT("TimeWarp_%s.png"), *LocalTime.ToString(TEXT("%Y-%m-%d_%H"))), false, false);
+	}
+}
+
+void UEnvironmentTimeWarp::Finish()
+{
+	bWarping = false;
+
+	const FString ReportPath = FPaths::ProjectSavedDir() / TEXT("Environment") / FString::Printf(TEXT("TimeWarp-%s.csv"), *FDateTime::Now().ToString());
+	FFileHelper::SaveStringToFile(Report, *ReportPath);
+	Report.Empty();
+
+	UE_LOG(LogEnvironmentTimeWarp, Log, TEXT("Fast-forward finished at %s, snapshots written to %s."), *LocalTime.ToString(), *ReportPath);
+
+	if (UEnvironmentClock* Clock = UEnvironmentClock::Get(GetWorld()))
+	{
+		Clock->EndJump();
+	}
+
+	OnFinished.Broadcast(LocalTime);
+
+	if (bExitWhenFinished)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void UEnvironmentTimeWarp::CheckCommandLine()
+{
+	bCheckedCommandLine = true;
+
+	double Days = 0.0;
+
+	if (!FParse::Value(FCommandLine::Get(), TEXT("EnvironmentFastForward="), Days))
+	{
+		return;
+	}
+
+	double SnapshotDays = 0.0;
+	FParse::Value(FCommandLine::Get(), TEXT("EnvironmentSnapshotDays="), SnapshotDays);
+	bExitWhenFinished = FParse::Param(FCommandLine::Get(), TEXT("EnvironmentFastForwardExit"));
+
+	FastForward(FTimespan::FromDays(Days), FTimespan::FromDays(SnapshotDays));
+}
+
+void UEnvironmentTimeWarp::Tick(float DeltaTime)
+{
+	if (!bCheckedCommandLine)
+	{
+		CheckCommandLine();
+	}
+
+	if (!bWarping)
+	{
+		return;
+	}
+
+	const FTimespan StepSpan = FTimespan::FromHours(FMath::Max(StepHours, 0.01f));
+
+	//Batched steps up to the next snapshot, then a frame to render it.
+	while (LocalTime < NextSnapshotTime)
+	{
+		Step(FMath::Min(StepSpan, NextSnapshotTime - LocalTime));
+	}
+
+	TakeSnapshot();
+
+	if (LocalTime >= EndTime)
+	{
+		Finish();
+		return;
+	}
+
+	NextSnapshotTime = FMath::Min(NextSnapshotTime + SnapshotInterval, EndTime);
+}
+
+bool UEnvironmentTimeWarp::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != nullptr && GetWorld()->IsGameWorld() && GetWorld()->HasBegunPlay();
+}
+
+TStatId UEnvironmentTimeWarp::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnvironmentTimeWarp, STATGROUP_Tickables);
+}
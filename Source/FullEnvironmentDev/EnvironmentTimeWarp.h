@@ -0,0 +1,129 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Tickable.h"
+
+#include "EnvironmentTimeWarp.generated.h"
+
+/** Environment state sampled during a fast-forward. */
+USTRUCT(BlueprintType)
+struct FEnvironmentSnapshot
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	FDateTime LocalTime;
+
+	/** Month in E_MonthOfYear order, 0 is January. */
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	int32 Month = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	float Temperature = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	float Precipitation = 0.0f;
+
+	/** Surface wetness and snow under the view. */
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	float Wetness = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Environment")
+	float Snow = 0.0f;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnEnvironmentTimeWarpStep, const FDateTime&, LocalTime);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnEnvironmentTimeWarpSnapshot, const FEnvironmentSnapshot&, Snapshot);
+
+/**
+* Fast-forwards the environment by days or months. The span is advanced in StepHours long batched steps:
+* every step moves the local time, lets listeners of OnStep update the climate and integrates the native weather
+* simulations, the cloud solver settles towards the climate instead of advecting over hours. Visual updates are
+* skipped, only OnSnapshot and OnFinished fire a frame apart, so snapshots can be rendered and captured. Under -nullrhi a simulated year takes seconds.
+* Environment clock events fire step by step in order, coalescing subscribers hear once when the warp is over.
+*
+* Start from the command line with -EnvironmentFastForward=<days> [-EnvironmentSnapshotDays=<days>]
+* [-EnvironmentFastForwardExit], or with the Environment.FastForward console command.
+*/
+UCLASS(Config = Game, BlueprintType)
+class FULLENVIRONMENTDEV_API UEnvironmentTimeWarp : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UEnvironmentTimeWarp();
+
+	/** Time warp of a world, created on the first call. */
+	UFUNCTION(BlueprintPure, Category = "Environment", meta = (WorldContext = "WorldContextObject"))
+	static UEnvironmentTimeWarp* Get(const UObject* WorldContextObject);
+
+	/** Start a fast-forward from the view-model's local time.
+	* @param Span - game time to skip.
+	* @param SnapshotInterval - game time between two snapshots, zero only snapshots the final state.
+	* @return false if a fast-forward is already running.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	bool FastForward(FTimespan Span, FTimespan SnapshotInterval);
+
+	UFUNCTION(BlueprintPure, Category = "Environment")
+	bool IsWarping() const { return bWarping; }
+
+	/** Every batched step, bind climate updates that have to follow the calendar. */
+	UPROPERTY(BlueprintAssignable, Category = "Environment")
+	FOnEnvironmentTimeWarpStep OnStep;
+
+	UPROPERTY(BlueprintAssignable, Category = "Environment")
+	FOnEnvironmentTimeWarpSnapshot OnSnapshot;
+
+	/** Fast-forward is over, the sky should jump to the final local time. */
+	UPROPERTY(BlueprintAssignable, Category = "Environment")
+	FOnEnvironmentTimeWarpStep OnFinished;
+
+	/** Game hours advanced per batched step. */
+	UPROPERTY(Config)
+	float StepHours;
+
+	/** Most weather solver steps per batched step. Steps are bounded by the wind speed, a batched step that needs
+	* more skips advection and only lets the clouds settle towards the climate, which is always the case for hours.
+	*/
+	UPROPERTY(Config)
+	int32 MaxSolverStepsPerStep;
+
+	/** Request a screenshot of every snapshot when rendering. */
+	UPROPERTY(Config)
+	bool bScreenshots;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Advance every simulation by a single batched step. */
+	void Step(const FTimespan& StepSpan);
+
+	/** Sample, broadcast and record the current state. */
+	void TakeSnapshot();
+
+	/** Write the snapshot report and broadcast the final time. */
+	void Finish();
+
+	/** Start a fast-forward requested on the command line. */
+	void CheckCommandLine();
+
+	FDateTime LocalTime;
+	FDateTime EndTime;
+	FDateTime NextSnapshotTime;
+	FTimespan SnapshotInterval;
+
+	/** Snapshot report, one CSV line per snapshot. */
+	FString Report;
+
+	bool bWarping;
+	bool bExitWhenFinished;
+	bool bCheckedCommandLine;
+};
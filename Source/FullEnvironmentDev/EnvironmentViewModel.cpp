@@ -0,0 +1,211 @@
+// 2015 - Community based open project
+
+#include "EnvironmentViewModel.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+
+UEnvironmentViewModel::UEnvironmentViewModel()
+	: TimeInterval(1.0f)
+	, WeatherInterval(1.0f)
+	, TemperatureGameInterval(60.0f)
+	, CelestialBodyInterval(0.25f)
+	, HeadingInterval(0.0f)
+	, HeadingThreshold(0.5f)
+	, Cloudiness(0.0f)
+	, Precipitation(0.0f)
+	, Temperature(0.0f)
+	, Sun(FVector2D::ZeroVector)
+	, Moon(FVector2D::ZeroVector)
+	, Heading(0.0f)
+{
+}
+
+UEnvironmentViewModel* UEnvironmentViewModel::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (UEnvironmentViewModel* ViewModel = Cast<UEnvironmentViewModel>(Object))
+		{
+			return ViewModel;
+		}
+	}
+
+	UEnvironmentViewModel* ViewModel = NewObject<UEnvironmentViewModel>(World);
+	World->PerModuleDataObjects.Add(ViewModel);
+
+	return ViewModel;
+}
+
+void UEnvironmentViewModel::SetLocalTime(const FDateTime& InLocalTime)
+{
+	//Clock text shows seconds, sub second changes are not worth an update.
+	if (InLocalTime.GetTicks() / ETimespan::TicksPerSecond != LocalTime.GetTicks() / ETimespan::TicksPerSecond)
+	{
+		MarkDirty(EEnvironmentField::Time);
+	}
+
+	LocalTime = InLocalTime;
+}
+
+void UEnvironmentViewModel::SetWeather(FName InWeather, float InCloudiness, float InPrecipitation)
+{
+	if (InWeather != Weather || !FMath::IsNearlyEqual(InCloudiness, Cloudiness) || !FMath::IsNearlyEqual(InPrecipitation, Precipitation))
+	{
+		Weather = InWeather;
+		Cloudiness = InCloudiness;
+		Precipitation = InPrecipitation;
+		MarkDirty(EEnvironmentField::Weather);
+	}
+}
+
+void UEnvironmentViewModel::SetTemperature(float InTemperature)
+{
+	if (!FMath::IsNearlyEqual(InTemperature, Temperature))
+	{
+		Temperature = InTemperature;
+		MarkDirty(EEnvironmentField::Temperature);
+	}
+}
+
+void UEnvironmentViewModel::SetSun(float Altitude, float Azimuth)
+{
+	const FVector2D NewSun(Altitude, Azimuth);
+
+	if (!NewSun.Equals(Sun))
+	{
+		Sun = NewSun;
+		MarkDirty(EEnvironmentField::Sun);
+	}
+}
+
+void UEnvironmentViewModel::SetMoon(float Altitude, float Azimuth)
+{
+	const FVector2D NewMoon(Altitude, Azimuth);
+
+	if (!NewMoon.Equals(Moon))
+	{
+		Moon = NewMoon;
+		MarkDirty(EEnvironmentField::Moon);
+	}
+}
+
+void UEnvironmentViewModel::RequestRefresh()
+{
+	for (FFieldState& Field : Fields)
+	{
+		Field.bDirty = true;
+		Field.PublishTime = -BIG_NUMBER;
+	}
+
+	TemperatureTime = FDateTime();
+}
+
+bool UEnvironmentViewModel::ShouldPublish(EEnvironmentField Field, float RealTime) const
+{
+	const FFieldState& State = Fields[(int32)Field];
+
+	if (!State.bDirty)
+	{
+		return false;
+	}
+
+	switch (Field)
+	{
+	case EEnvironmentField::Time:
+		return RealTime - State.PublishTime >= TimeInterval;
+	case EEnvironmentField::Weather:
+		return RealTime - State.PublishTime >= WeatherInterval;
+	case EEnvironmentField::Temperature:
+		//Game time interval, time warps in both directions count.
+		return TemperatureTime == FDateTime() || FMath::Abs((LocalTime - TemperatureTime).GetTotalSeconds()) >= TemperatureGameInterval;
+	case EEnvironmentField::Sun:
+	case EEnvironmentField::Moon:
+		return RealTime - State.PublishTime >= CelestialBodyInterval;
+	case EEnvironmentField::Heading:
+		return RealTime - State.PublishTime >= HeadingInterval;
+	default:
+		return false;
+	}
+}
+
+void UEnvironmentViewModel::Publish(EEnvironmentField Field)
+{
+	switch (Field)
+	{
+	case EEnvironmentField::Time:
+		OnTimeChanged.Broadcast(LocalTime);
+		break;
+	case EEnvironmentField::Weather:
+		OnWeatherChanged.Broadcast(Weather, Cloudiness, Precipitation);
+		break;
+	case EEnvironmentField::Temperature:
+		TemperatureTime = LocalTime;
+		OnTemperatureChanged.Broadcast(Temperature);
+		break;
+	case EEnvironmentField::Sun:
+		OnSunChanged.Broadcast(Sun.X, Sun.Y);
+		break;
+	case EEnvironmentField::Moon:
+		OnMoonChanged.Broadcast(Moon.X, Moon.Y);
+		break;
+	case EEnvironmentField::Heading:
+		OnHeadingChanged.Broadcast(Heading);
+		break;
+	default:
+		break;
+	}
+}
+
+void UEnvironmentViewModel::UpdateHeading()
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+
+	if (PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr)
+	{
+		return;
+	}
+
+	const float NewHeading = FRotator::ClampAxis(PlayerController->PlayerCameraManager->GetCameraRotation().Yaw);
+
+	if (FMath::Abs(FMath::FindDeltaAngleDegrees(Heading, NewHeading)) >= HeadingThreshold)
+	{
+		Heading = NewHeading;
+		MarkDirty(EEnvironmentField::Heading);
+	}
+}
+
+void UEnvironmentViewModel::Tick(float DeltaTime)
+{
+	UpdateHeading();
+
+	const float RealTime = GetWorld()->GetRealTimeSeconds();
+
+	for (int32 Field = 0; Field < (int32)EEnvironmentField::Count; Field++)
+	{
+		if (ShouldPublish((EEnvironmentField)Field, RealTime))
+		{
+			Fields[Field].bDirty = false;
+			Fields[Field].PublishTime = RealTime;
+			Publish((EEnvironmentField)Field);
+		}
+	}
+}
+
+bool UEnvironmentViewModel::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != nullptr;
+}
+
+TStatId UEnvironmentViewModel::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnvironmentViewModel, STATGROUP_Tickables);
+}
@@ -0,0 +1,172 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Tickable.h"
+
+#include "EnvironmentViewModel.generated.h"
+
+/** Environment state published to the HUD. */
+UENUM(BlueprintType)
+enum class EEnvironmentField : uint8
+{
+	Time,
+	Weather,
+	Temperature,
+	Sun,
+	Moon,
+	Heading,
+
+	Count UMETA(Hidden)
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnEnvironmentTimeChanged, const FDateTime&, LocalTime);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnEnvironmentWeatherChanged, FName, Weather, float, Cloudiness, float, Precipitation);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnEnvironmentTemperatureChanged, float, Temperature);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnEnvironmentCelestialBodyChanged, float, Altitude, float, Azimuth);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnEnvironmentHeadingChanged, float, Heading);
+
+/**
+* Per world view-model of the sky and time state shown by the HUD.
+* The sky blueprint pushes its values whenever it updates them, setters only mark a field dirty.
+* Dirty fields are published once per tick at most, and not more often than their configured interval,
+* so widgets update from events instead of polling through per-frame bindings.
+*/
+UCLASS(Config = Game, BlueprintType)
+class FULLENVIRONMENTDEV_API UEnvironmentViewModel : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UEnvironmentViewModel();
+
+	/** View-model of a world, created on the first call. */
+	UFUNCTION(BlueprintPure, Category = "Environment", meta = (WorldContext = "WorldContextObject"))
+	static UEnvironmentViewModel* Get(const UObject* WorldContextObject);
+
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	void SetLocalTime(const FDateTime& InLocalTime);
+
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	void SetWeather(FName InWeather, float InCloudiness, float InPrecipitation);
+
+	/** Temperature in degrees Celsius. */
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	void SetTemperature(float InTemperature);
+
+	/** Sun altitude and azimuth in degrees. */
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	void SetSun(float Altitude, float Azimuth);
+
+	/** Moon altitude and azimuth in degrees. */
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	void SetMoon(float Altitude, float Azimuth);
+
+	/** Publish every field on the next tick regardless of intervals, widgets call it once they are bound. */
+	UFUNCTION(BlueprintCallable, Category = "Environment")
+	void RequestRefresh();
+
+	UFUNCTION(BlueprintPure, Category = "Environment")
+	const FDateTime& GetLocalTime() const { return LocalTime; }
+
+	UFUNCTION(BlueprintPure, Category = "Environment")
+	FName GetWeather() const { return Weather; }
+
+	UFUNCTION(BlueprintPure, Category = "Environment")
+	float GetCloudiness() const { return Cloudiness; }
+
+	/** Precipitation intensity, 0 is dry. */
+	UFUNCTION(BlueprintPure, Category = "Environment")
+	float GetPrecipitation() const { return Precipitation; }
+
+	/** Temperature in degrees Celsius. */
+	UFUNCTION(BlueprintPure, Category = "Environment")
+	float GetTemperature() const { return Temperature; }
+
+	UFUNCTION(BlueprintPure, Category = "Environment")
+	float GetHeading() const { return Heading; }
+
+	UPROPERTY(BlueprintAssignable, Category = "Environment")
+	FOnEnvironmentTimeChanged OnTimeChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "Environment")
+	FOnEnvironmentWeatherChanged OnWeatherChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "Environment")
+	FOnEnvironmentTemperatureChanged OnTemperatureChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "Environment")
+	FOnEnvironmentCelestialBodyChanged OnSunChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "Environment")
+	FOnEnvironmentCelestialBodyChanged OnMoonChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "Environment")
+	FOnEnvironmentHeadingChanged OnHeadingChanged;
+
+	/** Real seconds between two time updates. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Environment")
+	float TimeInterval;
+
+	/** Real seconds between two weather updates. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Environment")
+	float WeatherInterval;
+
+	/** Game seconds between two temperature updates. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Environment")
+	float TemperatureGameInterval;
+
+	/** Real seconds between two sun and moon updates. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Environment")
+	float CelestialBodyInterval;
+
+	/** Real seconds between two heading updates, 0 updates every frame. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Environment")
+	float HeadingInterval;
+
+	/** Smallest heading change in degrees that is published. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Environment")
+	float HeadingThreshold;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Mark a field dirty, it is published on a tick once its interval elapsed. */
+	void MarkDirty(EEnvironmentField Field) { Fields[(int32)Field].bDirty = true; }
+
+	/** Is a field dirty and is its interval over. */
+	bool ShouldPublish(EEnvironmentField Field, float RealTime) const;
+
+	/** Broadcast current value of a field. */
+	void Publish(EEnvironmentField Field);
+
+	/** Poll the heading of the first local player camera. */
+	void UpdateHeading();
+
+	struct FFieldState
+	{
+		/** Real time of the last publish. */
+		float PublishTime = -BIG_NUMBER;
+		bool bDirty = false;
+	};
+
+	FFieldState Fields[(int32)EEnvironmentField::Count];
+
+	FDateTime LocalTime;
+	FName Weather;
+	float Cloudiness;
+	float Precipitation;
+	float Temperature;
+	FVector2D Sun;
+	FVector2D Moon;
+	float Heading;
+
+	/** Game time temperature was last published at. */
+	FDateTime TemperatureTime;
+};
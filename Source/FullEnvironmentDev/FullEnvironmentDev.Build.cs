@@ -15,8 +15,8 @@ public class FullEnvironmentDev : ModuleRules
 		//Enable IWYU but keep our PrivatePCH in use
 		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "UMG" });
 
-		PrivateDependencyModuleNames.AddRange(new string[] {  });
+		PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore", "RHI", "ProceduralMeshComponent", "VolumetricCloudsPainterCore", "VolumetricCloudsPainterRuntime" });
 	}
 }
@@ -1,5 +1,70 @@
 // 2015 - Community based open project
 
 #include "FullEnvironmentDev.h"
+#include "CloudQualityController.h"
+#include "CloudShadowScheduler.h"
+#include "SkyCaptureScheduler.h"
+#include "WeatherEffectPool.h"
+#include "SurfaceWeatherGrid.h"
+#include "LightningStrikeScheduler.h"
+#include "EnvironmentTimeWarp.h"
+#include "EnvironmentBenchmark.h"
+#include "EnvironmentClock.h"
+#include "EnvironmentReplicator.h"
+#include "VolumetricCloudsWeatherSimulation.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, FullEnvironmentDev, "FullEnvironmentDev" );
+class FFullEnvironmentDevModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		PostWorldInitializationHandle = FWorldDelegates::OnPostWorldInitialization.AddStatic(&FFullEnvironmentDevModule::OnPostWorldInitialization);
+		WorldInitializedActorsHandle = FWorldDelegates::OnWorldInitializedActors.AddStatic(&FFullEnvironmentDevModule::OnWorldInitializedActors);
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FWorldDelegates::OnPostWorldInitialization.Remove(PostWorldInitializationHandle);
+		FWorldDelegates::OnWorldInitializedActors.Remove(WorldInitializedActorsHandle);
+	}
+
+private:
+	/**
+	* Every game world gets its environment systems up front, so schedulers start with the world, pools pre-warm
+	* before the first strike and the time warp and benchmark see their command line. The weather simulation stays off unless enabled in config.
+	*/
+	static void OnPostWorldInitialization(UWorld* World, const UWorld::InitializationValues IVS)
+	{
+		if (World->IsGameWorld())
+		{
+			UCloudQualityController::Get(World);
+			UCloudShadowScheduler::Get(World);
+			USkyCaptureScheduler::Get(World);
+			UWeatherEffectPool::Get(World);
+			USurfaceWeatherGrid::Get(World);
+			ULightningStrikeScheduler::Get(World);
+			UEnvironmentClock::Get(World);
+			UEnvironmentTimeWarp::Get(World);
+			UEnvironmentBenchmark::Get(World);
+			UVolumetricCloudsWeatherSimulation::Get(World);
+		}
+	}
+
+	/** Server spawns the environment replicator once the level actors exist, clients receive it. */
+	static void OnWorldInitializedActors(const UWorld::FActorsInitializedParams& Params)
+	{
+		UWorld* World = Params.World;
+
+		if (World->IsGameWorld() && World->GetNetMode() != NM_Client)
+		{
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.ObjectFlags |= RF_Transient;
+			World->SpawnActor<AEnvironmentReplicator>(SpawnParameters);
+		}
+	}
+
+	FDelegateHandle PostWorldInitializationHandle;
+	FDelegateHandle WorldInitializedActorsHandle;
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FFullEnvironmentDevModule, FullEnvironmentDev, "FullEnvironmentDev" );
@@ -0,0 +1,156 @@
+// 2015 - Community based open project
+
+#include "LightningBolt.h"
+#include "Math/RandomStream.h"
+
+namespace LightningBolt
+{
+	/** Unit vector perpendicular to a direction. */
+	FORCEINLINE FVector GetPerpendicular(const FVector& Direction)
+	{
+		const FVector Axis = FMath::Abs(Direction.Z) < 0.9f ? FVector::UpVector : FVector::ForwardVector;
+
+		return FVector::CrossProduct(Direction, Axis).GetSafeNormal();
+	}
+}
+
+FLightningBoltGenerator::FLightningBoltGenerator(const FLightningBoltSettings& InSettings)
+	: Settings(InSettings)
+{
+	Settings.MaxSegments = FMath::Max(Settings.MaxSegments, 1);
+
+	Segments.Reserve(Settings.MaxSegments);
+	NextSegments.Reserve(Settings.MaxSegments);
+}
+
+void FLightningBoltGenerator::Generate(int32 Seed, const FVector& Start, const FVector& End)
+{
+	using namespace LightningBolt;
+
+	FRandomStream Random(Seed);
+
+	Segments.Reset();
+	Segments.Add({ Start, End, Settings.Width, 1.0f, 0 });
+
+	for (int32 Pass = 0; Pass < Settings.Subdivisions; Pass++)
+	{
+		NextSegments.Reset();
+
+		for (int32 Index = 0; Index < Segments.Num(); Index++)
+		{
+			const FLightningSegment& Segment = Segments[Index];
+
+			//Segments that don't fit anymore are kept whole, the bolt just gets less detailed.
+			const int32 SegmentsLeft = Segments.Num() - Index - 1;
+
+			if (NextSegments.Num() + 2 + SegmentsLeft > Settings.MaxSegments)
+			{
+				NextSegments.Add(Segment);
+				continue;
+			}
+
+			const FVector Delta = Segment.End - Segment.Start;
+			const float Length = Delta.Size();
+			const FVector Direction = Length > KINDA_SMALL_NUMBER ? Delta / Length : FVector::UpVector;
+
+			//Random sideways offset in the plane perpendicular to the segment.
+			const FVector Side = GetPerpendicular(Direction).RotateAngleAxis(Random.FRandRange(0.0f, 360.0f), Direction);
+			const FVector Middle = (Segment.Start + Segment.End) * 0.5f + Side * Random.FRandRange(-1.0f, 1.0f) * Settings.Displacement * Length;
+
+			NextSegments.Add({ Segment.Start, Middle, Segment.Width, Segment.Brightness, Segment.Depth });
+			NextSegments.Add({ Middle, Segment.End, Segment.Width, Segment.Brightness, Segment.Depth });
+
+			if (Segment.Depth < Settings.MaxBranchDepth && Random.FRand() < Settings.BranchChance && NextSegments.Num() + 1 + SegmentsLeft <= Settings.MaxSegments)
+			{
+				//Branches leave in the direction of the second half, bent away by up to BranchAngle.
+				const FVector BranchDirection = (Segment.End - Middle).GetSafeNormal().RotateAngleAxis(Random.FRandRange(-Settings.BranchAngle, Settings.BranchAngle), Side);
+				const FVector BranchEnd = Middle + BranchDirection * Length * Settings.BranchLength;
+
+				NextSegments.Add({ Middle, BranchEnd, Segment.Width * Settings.BranchFalloff, Segment.Brightness * Settings.BranchFalloff, Segment.Depth + 1 });
+			}
+		}
+
+		Swap(Segments, NextSegments);
+	}
+}
+
+void FLightningBoltGenerator::BuildVertices(const TArray<FLightningSegment>& Segments, int32 MaxSegments, TArray<FVector>& Positions, TArray<FVector2D>& UVs, TArray<FColor>& Colors)
+{
+	using namespace LightningBolt;
+
+	const int32 NumVertices = MaxSegments * VerticesPerSegment;
+
+	//Same size every time, so buffers allocated for the first bolt are reused.
+	Positions.SetNumUninitialized(NumVertices, false);
+	UVs.SetNumUninitialized(NumVertices, false);
+	Colors.SetNumUninitialized(NumVertices, false);
+
+	for (int32 Index = 0; Index < MaxSegments; Index++)
+	{
+		FVector* SegmentPositions = Positions.GetData() + Index * VerticesPerSegment;
+		FVector2D* SegmentUVs = UVs.GetData() + Index * VerticesPerSegment;
+		FColor* SegmentColors = Colors.GetData() + Index * VerticesPerSegment;
+
+		if (Index >= Segments.Num())
+		{
+			for (int32 Vertex = 0; Vertex < VerticesPerSegment; Vertex++)
+			{
+				SegmentPositions[Vertex] = FVector::ZeroVector;
+				SegmentUVs[Vertex] = FVector2D::ZeroVector;
+				SegmentColors[Vertex] = FColor::Black;
+			}
+
+			continue;
+		}
+
+		const FLightningSegment& Segment = Segments[Index];
+		const FVector Direction = (Segment.End - Segment.Start).GetSafeNormal();
+		const FVector Sides[2] =
+		{
+			GetPerpendicular(Direction) * Segment.Width * 0.5f,
+			FVector::CrossProduct(Direction, GetPerpendicular(Direction)) * Segment.Width * 0.5f
+		};
+
+		const uint8 Brightness = uint8(FMath::RoundToInt(FMath::Clamp(Segment.Brightness, 0.0f, 1.0f) * 255.0f));
+		const FColor Color(Brightness, Brightness, Brightness, Brightness);
+
+		for (int32 Quad = 0; Quad < 2; Quad++)
+		{
+			FVector* QuadPositions = SegmentPositions + Quad * 4;
+			FVector2D* QuadUVs = SegmentUVs + Quad * 4;
+
+			QuadPositions[0] = Segment.Start - Sides[Quad];
+			QuadPositions[1] = Segment.Start + Sides[Quad];
+			QuadPositions[2] = Segment.End + Sides[Quad];
+			QuadPositions[3] = Segment.End - Sides[Quad];
+
+			QuadUVs[0] = FVector2D(0.0f, 0.0f);
+			QuadUVs[1] = FVector2D(1.0f, 0.0f);
+			QuadUVs[2] = FVector2D(1.0f, 1.0f);
+			QuadUVs[3] = FVector2D(0.0f, 1.0f);
+		}
+
+		for (int32 Vertex = 0; Vertex < VerticesPerSegment; Vertex++)
+		{
+			SegmentColors[Vertex] = Color;
+		}
+	}
+}
+
+void FLightningBoltGenerator::BuildIndices(int32 MaxSegments, TArray<int32>& Indices)
+{
+	Indices.SetNumUninitialized(MaxSegments * IndicesPerSegment);
+
+	for (int32 Quad = 0; Quad < MaxSegments * 2; Quad++)
+	{
+		const int32 First = Quad * 4;
+		int32* QuadIndices = Indices.GetData() + Quad * 6;
+
+		QuadIndices[0] = First;
+		QuadIndices[1] = First + 1;
+		QuadIndices[2] = First + 2;
+		QuadIndices[3] = First;
+		QuadIndices[4] = First + 2;
+		QuadIndices[5] = First + 3;
+	}
+}
@@ -0,0 +1,97 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Bolt shape settings. Lengths are relative to the length of the segment being split. */
+struct FLightningBoltSettings
+{
+	/** Most segments of a bolt including its branches, all buffers are sized for it. */
+	int32 MaxSegments = 256;
+
+	/** Number of times every segment is split in two. */
+	int32 Subdivisions = 6;
+
+	/** Largest sideways offset of a split point. */
+	float Displacement = 0.2f;
+
+	/** Chance that a split point starts a branch. */
+	float BranchChance = 0.3f;
+
+	/** Branch length relative to the split segment. */
+	float BranchLength = 0.7f;
+
+	/** Largest angle between a branch and its parent in degrees. */
+	float BranchAngle = 40.0f;
+
+	/** Branches of branches stop at this depth. */
+	int32 MaxBranchDepth = 2;
+
+	/** Width of the main channel in world units. */
+	float Width = 60.0f;
+
+	/** Width and brightness of a branch relative to its parent. */
+	float BranchFalloff = 0.5f;
+};
+
+/** Straight piece of a bolt. */
+struct FLightningSegment
+{
+	FVector Start;
+	FVector End;
+	float Width;
+
+	/** 1 on the main channel, lower on branches. */
+	float Brightness;
+
+	/** Branch depth, 0 on the main channel. */
+	int32 Depth;
+};
+
+/**
+* Branching lightning bolts by seeded midpoint displacement. Every pass splits each segment at a displaced midpoint
+* and may start a branch there. Buffers are sized for MaxSegments once, so generating a bolt never allocates, and
+* the same seed always gives the same bolt. Doesn't touch the renderer, bolts can be generated on any machine.
+*/
+class FULLENVIRONMENTDEV_API FLightningBoltGenerator
+{
+public:
+	/** Vertices and indices of a segment, two crossed quads. */
+	static const int32 VerticesPerSegment = 8;
+	static const int32 IndicesPerSegment = 12;
+
+	explicit FLightningBoltGenerator(const FLightningBoltSettings& InSettings = FLightningBoltSettings());
+
+	/** Generate a bolt.
+	* @param Seed - random seed of the bolt.
+	* @param Start - bolt start, usually at the cloud base.
+	* @param End - strike point.
+	*/
+	void Generate(int32 Seed, const FVector& Start, const FVector& End);
+
+	const FLightningBoltSettings& GetSettings() const { return Settings; }
+
+	/** Segments of the last bolt, at most MaxSegments. */
+	const TArray<FLightningSegment>& GetSegments() const { return Segments; }
+
+	/** Write MaxSegments * VerticesPerSegment vertices. Segments beyond the bolt collapse to a point,
+	* so a mesh section keeps its size and can be updated in place.
+	* @param Segments - bolt segments.
+	* @param MaxSegments - segments the buffers are sized for.
+	* @param Positions - vertex positions.
+	* @param UVs - across the quad in X, along the segment in Y.
+	* @param Colors - brightness in every channel.
+	*/
+	static void BuildVertices(const TArray<FLightningSegment>& Segments, int32 MaxSegments, TArray<FVector>& Positions, TArray<FVector2D>& UVs, TArray<FColor>& Colors);
+
+	/** Write MaxSegments * IndicesPerSegment indices, they never change. */
+	static void BuildIndices(int32 MaxSegments, TArray<int32>& Indices);
+
+private:
+	FLightningBoltSettings Settings;
+
+	/** Segments of the last bolt and the pass being split, swapped every pass. */
+	TArray<FLightningSegment> Segments;
+	TArray<FLightningSegment> NextSegments;
+};
@@ -0,0 +1,92 @@
+// 2015 - Community based open project
+
+#include "LightningBoltActor.h"
+#include "LightningBolt.h"
+#include "ProceduralMeshComponent.h"
+#include "Materials/MaterialInterface.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "VolumetricCloudsMemory.h"
+
+ALightningBoltActor::ALightningBoltActor()
+	: IntensityParameter(TEXT("Intensity"))
+	, Material(nullptr)
+	, SectionSegments(0)
+	, Age(0.0f)
+	, Lifetime(0.0f)
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	MeshComponent = CreateDefaultSubobject<UProceduralMeshComponent>(TEXT("Mesh"));
+	MeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	MeshComponent->CastShadow = false;
+	MeshComponent->bUseAsyncCooking = true;
+	RootComponent = MeshComponent;
+}
+
+void ALightningBoltActor::ShowBolt(const FLightningBoltGenerator& Generator, float InLifetime)
+{
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::WeatherEffects);
+
+	const int32 MaxSegments = Generator.GetSettings().MaxSegments;
+
+	//Vertices are in world space, the actor stays at the origin.
+	SetActorTransform(FTransform::Identity);
+
+	FLightningBoltGenerator::BuildVertices(Generator.GetSegments(), MaxSegments, Positions, UVs, Colors);
+
+	static const TArray<FVector> NoNormals;
+	static const TArray<FProcMeshTangent> NoTangents;
+
+	if (SectionSegments != MaxSegments)
+	{
+		SectionSegments = MaxSegments;
+
+		FLightningBoltGenerator::BuildIndices(MaxSegments, Indices);
+		MeshComponent->CreateMeshSection(0, Positions, Indices, NoNormals, UVs, Colors, NoTangents, false);
+
+		UMaterialInterface* BoltMaterial = Cast<UMaterialInterface>(BoltMaterialPath.TryLoad());
+
+		if (BoltMaterial != nullptr)
+		{
+			Material = MeshComponent->CreateDynamicMaterialInstance(0, BoltMaterial);
+		}
+	}
+	else
+	{
+		//Section buffers are reused, only the render thread update is allocated, see the class comment.
+		MeshComponent->UpdateMeshSection(0, Positions, NoNormals, UVs, Colors, NoTangents);
+	}
+
+	Age = 0.0f;
+	Lifetime = FMath::Max(InLifetime, KINDA_SMALL_NUMBER);
+
+	if (Material != nullptr)
+	{
+		Material->SetScalarParameterValue(IntensityParameter, 1.0f);
+	}
+}
+
+void ALightningBoltActor::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	Age += DeltaSeconds;
+
+	if (Material != nullptr)
+	{
+		//Return strokes make a bolt flicker before it fades.
+		const float Fade = 1.0f - FMath::Clamp(Age / Lifetime, 0.0f, 1.0f);
+		const float Flicker = FMath::Abs(FMath::Sin(Age * 40.0f)) * 0.5f + 0.5f;
+
+		Material->SetScalarParameterValue(IntensityParameter, Fade * Fade * Flicker);
+	}
+}
+
+void ALightningBoltActor::OnEffectDeactivated_Implementation()
+{
+	if (Material != nullptr)
+	{
+		Material->SetScalarParameterValue(IntensityParameter, 0.0f);
+	}
+}
@@ -0,0 +1,72 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "WeatherEffectPool.h"
+
+#include "LightningBoltActor.generated.h"
+
+class UProceduralMeshComponent;
+class UMaterialInterface;
+class UMaterialInstanceDynamic;
+class FLightningBoltGenerator;
+
+/**
+* Procedural lightning bolt. The mesh section is created once for the largest bolt, later strikes update
+* its vertices in place. Meant to be recycled by the weather effect pool, the flash fades out over the lifetime.
+*
+* Every strike is still one heap allocation: the procedural mesh copies the section into a render thread update of
+* MaxSegments * VerticesPerSegment vertices, about 150 KB at the default 256 segments. Strikes come seconds apart
+* at the scheduler's StrikesPerMinute, a bolt per frame would need its own dynamic vertex buffer instead.
+*/
+UCLASS(Config = Game)
+class FULLENVIRONMENTDEV_API ALightningBoltActor : public AActor, public IWeatherEffectPoolable
+{
+	GENERATED_BODY()
+
+public:
+	ALightningBoltActor();
+
+	/** Show a generated bolt.
+	* @param Generator - generator of the bolt, its MaxSegments sizes the mesh section.
+	* @param InLifetime - seconds until the bolt faded out.
+	*/
+	void ShowBolt(const FLightningBoltGenerator& Generator, float InLifetime);
+
+	/** Unlit additive material that multiplies its emissive by the vertex color and the Intensity parameter. */
+	UPROPERTY(Config)
+	FSoftObjectPath BoltMaterialPath;
+
+	/** Scalar parameter of the bolt material that fades the flash. */
+	UPROPERTY(Config)
+	FName IntensityParameter;
+
+	// AActor interface
+	virtual void Tick(float DeltaSeconds) override;
+	// End of AActor interface
+
+	// IWeatherEffectPoolable interface
+	virtual void OnEffectDeactivated_Implementation() override;
+	// End of IWeatherEffectPoolable interface
+
+private:
+	UPROPERTY(VisibleAnywhere, Category = "Lightning")
+	UProceduralMeshComponent* MeshComponent;
+
+	UPROPERTY()
+	UMaterialInstanceDynamic* Material;
+
+	/** Vertex buffers, sized once for MaxSegments. */
+	TArray<FVector> Positions;
+	TArray<FVector2D> UVs;
+	TArray<FColor> Colors;
+	TArray<int32> Indices;
+
+	/** Segments the mesh section was created for, 0 before the first bolt. */
+	int32 SectionSegments;
+
+	float Age;
+	float Lifetime;
+};
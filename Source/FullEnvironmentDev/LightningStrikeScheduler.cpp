@@ -0,0 +1,203 @@
+// 2015 - Community based open project
+
+#include "LightningStrikeScheduler.h"
+#include "LightningBoltActor.h"
+#include "WeatherEffectPool.h"
+#include "EnvironmentViewModel.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Lightning Strike"), STAT_LightningStrike, STATGROUP_Game);
+
+ULightningStrikeScheduler::ULightningStrikeScheduler()
+	: StrikesPerMinute(12.0f)
+	, PrecipitationThreshold(0.6f)
+	, MinDistance(50000.0f)
+	, MaxDistance(500000.0f)
+	, CloudBaseHeight(150000.0f)
+	, BoltLifetime(0.4f)
+	, SpeedOfSound(34300.0f)
+	, ThunderLifetime(15.0f)
+	, BoltClass(ALightningBoltActor::StaticClass())
+	, ThunderClass(TEXT("/Game/Universe/Sky/Weather/Effects/Thunder.Thunder_C"))
+	, Seed(0)
+	, LoadedBoltClass(nullptr)
+	, LoadedThunderClass(nullptr)
+	, Hazard(0.0f)
+	, StormIntensity(-1.0f)
+	, bInitialized(false)
+{
+	PendingThunders.Reserve(MaxPendingThunders);
+}
+
+ULightningStrikeScheduler* ULightningStrikeScheduler::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (ULightningStrikeScheduler* Scheduler = Cast<ULightningStrikeScheduler>(Object))
+		{
+			return Scheduler;
+		}
+	}
+
+	ULightningStrikeScheduler* Scheduler = NewObject<ULightningStrikeScheduler>(World);
+	World->PerModuleDataObjects.Add(Scheduler);
+
+	return Scheduler;
+}
+
+float ULightningStrikeScheduler::GetStormIntensity() const
+{
+	if (StormIntensity >= 0.0f)
+	{
+		return FMath::Min(StormIntensity, 1.0f);
+	}
+
+	const UEnvironmentViewModel* ViewModel = UEnvironmentViewModel::Get(GetWorld());
+	const float Precipitation = ViewModel != nullptr ? ViewModel->GetPrecipitation() : 0.0f;
+
+	return FMath::Clamp((Precipitation - PrecipitationThreshold) / FMath::Max(1.0f - PrecipitationThreshold, KINDA_SMALL_NUMBER), 0.0f, 1.0f);
+}
+
+bool ULightningStrikeScheduler::GetViewLocation(FVector& OutLocation) const
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+
+	if (PlayerController == nullptr)
+	{
+		return false;
+	}
+
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(OutLocation, ViewRotation);
+
+	return true;
+}
+
+void ULightningStrikeScheduler::Strike(const FVector& Location)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LightningStrike);
+
+	UWeatherEffectPool* Pool = UWeatherEffectPool::Get(GetWorld());
+
+	if (Pool == nullptr)
+	{
+		return;
+	}
+
+	if (!bInitialized)
+	{
+		Init();
+	}
+
+	const FVector Start = Location + FVector(Random.FRandRange(-0.2f, 0.2f) * CloudBaseHeight, Random.FRandRange(-0.2f, 0.2f) * CloudBaseHeight, CloudBaseHeight);
+	Generator.Generate(int32(Random.GetUnsignedInt()), Start, Location);
+
+	if (ALightningBoltActor* Bolt = Cast<ALightningBoltActor>(Pool->Acquire(LoadedBoltClass, FTransform::Identity, BoltLifetime)))
+	{
+		Bolt->ShowBolt(Generator, BoltLifetime);
+	}
+
+	FVector ViewLocation;
+	const float Distance = GetViewLocation(ViewLocation) ? FVector::Dist(ViewLocation, Location) : 0.0f;
+
+	if (LoadedThunderClass != nullptr && PendingThunders.Num() < MaxPendingThunders)
+	{
+		PendingThunders.Add({ Location, GetWorld()->GetTimeSeconds() + Distance / FMath::Max(SpeedOfSound, 1.0f) });
+	}
+
+	OnStrike.Broadcast(Location, Distance);
+}
+
+void ULightningStrikeScheduler::Init()
+{
+	bInitialized = true;
+
+	Random.Initialize(Seed);
+	LoadedBoltClass = BoltClass.TryLoadClass<ALightningBoltActor>();
+	LoadedThunderClass = ThunderClass.TryLoadClass<AActor>();
+}
+
+void ULightningStrikeScheduler::Tick(float DeltaTime)
+{
+	if (!bInitialized)
+	{
+		Init();
+	}
+
+	const float Time = GetWorld()->GetTimeSeconds();
+
+	//Backwards, played thunders are swapped in from the end.
+	for (int32 Index = PendingThunders.Num() - 1; Index >= 0; Index--)
+	{
+		if (Time >= PendingThunders[Index].Time)
+		{
+			if (UWeatherEffectPool* Pool = UWeatherEffectPool::Get(GetWorld()))
+			{
+				Pool->Acquire(LoadedThunderClass, FTransform(PendingThunders[Index].Location), ThunderLifetime);
+			}
+
+			PendingThunders.RemoveAtSwap(Index, 1, false);
+		}
+	}
+
+	const float Rate = GetStormIntensity() * StrikesPerMinute / 60.0f;
+
+	if (Rate <= 0.0f)
+	{
+		return;
+	}
+
+	if (Hazard <= 0.0f)
+	{
+		Hazard = -FMath::Loge(FMath::Max(Random.FRand(), SMALL_NUMBER));
+	}
+
+	//Inhomogeneous Poisson process, the integrated rate is compared against an exponential draw.
+	Hazard -= Rate * DeltaTime;
+
+	if (Hazard > 0.0f)
+	{
+		return;
+	}
+
+	Hazard = 0.0f;
+
+	FVector ViewLocation;
+
+	if (!GetViewLocation(ViewLocation))
+	{
+		return;
+	}
+
+	//Uniform over the ring area, not over its radius.
+	const float Angle = Random.FRandRange(0.0f, 2.0f * PI);
+	const float Distance = FMath::Sqrt(Random.FRandRange(FMath::Square(MinDistance), FMath::Square(MaxDistance)));
+	const FVector Ground = ViewLocation + FVector(FMath::Cos(Angle) * Distance, FMath::Sin(Angle) * Distance, 0.0f);
+
+	//Strike the terrain below the ring point, or the view height if nothing is there.
+	FHitResult Hit;
+	const FVector TraceStart = Ground + FVector(0.0f, 0.0f, CloudBaseHeight);
+	const FVector TraceEnd = Ground - FVector(0.0f, 0.0f, CloudBaseHeight);
+	const bool bHit = GetWorld()->LineTraceSingleByChannel(Hit, TraceStart, TraceEnd, ECC_Visibility, FCollisionQueryParams(SCENE_QUERY_STAT(LightningStrike), false));
+
+	Strike(bHit ? Hit.ImpactPoint : Ground);
+}
+
+bool ULightningStrikeScheduler::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != nullptr && GetWorld()->IsGameWorld() && GetWorld()->HasBegunPlay();
+}
+
+TStatId ULightningStrikeScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULightningStrikeScheduler, STATGROUP_Tickables);
+}
@@ -0,0 +1,124 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Tickable.h"
+#include "LightningBolt.h"
+
+#include "LightningStrikeScheduler.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnLightningStrike, FVector, Location, float, Distance);
+
+/**
+* Places lightning strikes around the view as a Poisson process whose rate follows the storm intensity.
+* Bolts are generated into a single reused generator and shown on pooled bolt actors, thunder is played
+* from the weather effect pool once sound had time to travel from the strike.
+*/
+UCLASS(Config = Game)
+class FULLENVIRONMENTDEV_API ULightningStrikeScheduler : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	ULightningStrikeScheduler();
+
+	/** Scheduler of a world, created on the first call. */
+	UFUNCTION(BlueprintPure, Category = "Weather", meta = (WorldContext = "WorldContextObject"))
+	static ULightningStrikeScheduler* Get(const UObject* WorldContextObject);
+
+	/** Storm intensity from 0 to 1, negative follows the precipitation of the environment view-model. */
+	UFUNCTION(BlueprintCallable, Category = "Weather")
+	void SetStormIntensity(float InStormIntensity) { StormIntensity = InStormIntensity; }
+
+	/** Current storm intensity. */
+	UFUNCTION(BlueprintPure, Category = "Weather")
+	float GetStormIntensity() const;
+
+	/** Strike at a location now. */
+	UFUNCTION(BlueprintCallable, Category = "Weather")
+	void Strike(const FVector& Location);
+
+	/** Broadcast for every strike, e.g. to flash the sky. */
+	UPROPERTY(BlueprintAssignable, Category = "Weather")
+	FOnLightningStrike OnStrike;
+
+	/** Strikes per minute at full intensity. */
+	UPROPERTY(Config)
+	float StrikesPerMinute;
+
+	/** Precipitation a storm starts at when the intensity follows the view-model. */
+	UPROPERTY(Config)
+	float PrecipitationThreshold;
+
+	/** Strikes are placed between these distances from the view. */
+	UPROPERTY(Config)
+	float MinDistance;
+	UPROPERTY(Config)
+	float MaxDistance;
+
+	/** Height of the bolt start above the strike point. */
+	UPROPERTY(Config)
+	float CloudBaseHeight;
+
+	/** Seconds a bolt is visible. */
+	UPROPERTY(Config)
+	float BoltLifetime;
+
+	/** Thunder delay per world unit, sound travels 343 m/s. */
+	UPROPERTY(Config)
+	float SpeedOfSound;
+
+	/** Seconds a thunder actor is kept before it returns to the pool. */
+	UPROPERTY(Config)
+	float ThunderLifetime;
+
+	UPROPERTY(Config)
+	FSoftClassPath BoltClass;
+
+	UPROPERTY(Config)
+	FSoftClassPath ThunderClass;
+
+	/** Seed of strike placement and bolt shapes. */
+	UPROPERTY(Config)
+	int32 Seed;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Most thunders waiting at once, further strikes are silent. */
+	static const int32 MaxPendingThunders = 16;
+
+	struct FPendingThunder
+	{
+		FVector Location;
+		float Time;
+	};
+
+	/** Seed the random stream and load the effect classes. */
+	void Init();
+
+	bool GetViewLocation(FVector& OutLocation) const;
+
+	FLightningBoltGenerator Generator;
+	FRandomStream Random;
+
+	UPROPERTY()
+	UClass* LoadedBoltClass;
+
+	UPROPERTY()
+	UClass* LoadedThunderClass;
+
+	TArray<FPendingThunder> PendingThunders;
+
+	/** Integrated rate left until the next strike, drawn from an exponential distribution after each strike. */
+	float Hazard;
+
+	float StormIntensity;
+	bool bInitialized;
+};
@@ -0,0 +1,217 @@
+// 2015 - Community based open project
+
+#include "SkyCaptureScheduler.h"
+#include "EnvironmentPresetBlender.h"
+#include "Engine/World.h"
+#include "Engine/SkyLight.h"
+#include "Engine/DirectionalLight.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/ReflectionCapture.h"
+#include "Components/SkyLightComponent.h"
+#include "Components/DirectionalLightComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/ReflectionCaptureComponent.h"
+#include "Materials/MaterialInterface.h"
+#include "EngineUtils.h"
+#include "VolumetricCloudsMemory.h"
+
+USkyCaptureScheduler::USkyCaptureScheduler()
+	: bEnabled(true)
+	, SunElevationThreshold(2.0f)
+	, CoverageThreshold(0.05f)
+	, DebounceTime(0.5f)
+	, MaxDelay(5.0f)
+	, ReflectionCapturesPerFrame(1)
+	, SkyLight(nullptr)
+	, SunLight(nullptr)
+	, CloudsComponent(nullptr)
+	, FirstChangeTime(-1.0f)
+	, LastChangeTime(-1.0f)
+	, bCaptureRequested(true)
+	, LastSearchTime(-BIG_NUMBER)
+{
+}
+
+USkyCaptureScheduler* USkyCaptureScheduler::Get(UWorld* World)
+{
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (USkyCaptureScheduler* Scheduler = Cast<USkyCaptureScheduler>(Object))
+		{
+			return Scheduler;
+		}
+	}
+
+	USkyCaptureScheduler* Scheduler = NewObject<USkyCaptureScheduler>(World);
+	World->PerModuleDataObjects.Add(Scheduler);
+
+	return Scheduler;
+}
+
+bool USkyCaptureScheduler::Init()
+{
+	UWorld* World = GetWorld();
+
+	for (TActorIterator<ASkyLight> SkyLightItr(World); SkyLightItr; ++SkyLightItr)
+	{
+		SkyLight = SkyLightItr->GetLightComponent();
+		break;
+	}
+
+	for (TActorIterator<ADirectionalLight> LightItr(World); LightItr; ++LightItr)
+	{
+		UDirectionalLightComponent* LightComponent = Cast<UDirectionalLightComponent>(LightItr->GetLightComponent());
+
+		if (LightComponent != nullptr && (SunLight == nullptr || LightComponent->IsUsedAsAtmosphereSunLight()))
+		{
+			SunLight = LightComponent;
+		}
+	}
+
+	for (TActorIterator<AStaticMeshActor> StaticMeshItr(World); StaticMeshItr; ++StaticMeshItr)
+	{
+		if (StaticMeshItr->GetClass()->GetFName() == "VolumetricClouds_C")
+		{
+			CloudsComponent = StaticMeshItr->GetStaticMeshComponent();
+			break;
+		}
+	}
+
+	return SkyLight != nullptr;
+}
+
+USkyCaptureScheduler::FLightingState USkyCaptureScheduler::GetLightingState() const
+{
+	FLightingState State;
+
+	if (SunLight != nullptr)
+	{
+		//Light points down from the sun, elevation is the angle of the opposite direction above the horizon.
+		State.SunElevation = FMath::RadiansToDegrees(FMath::Asin(FMath::Clamp(-SunLight->GetDirection().Z, -1.0f, 1.0f)));
+	}
+
+	//Clouds material may be replaced by a dynamic instance, so it is read every time.
+	if (CloudsComponent != nullptr && CloudsComponent->GetMaterial(0) != nullptr)
+	{
+		CloudsComponent->GetMaterial(0)->GetScalarParameterValue(FMaterialParameterInfo("Coverage"), State.Coverage);
+	}
+
+	if (const UEnvironmentPresetBlender* Blender = UEnvironmentPresetBlender::Find(GetWorld()))
+	{
+		State.PresetRevision = Blender->GetRevision();
+	}
+
+	return State;
+}
+
+bool USkyCaptureScheduler::Differs(const FLightingState& A, const FLightingState& B, float Scale) const
+{
+	return FMath::Abs(A.SunElevation - B.SunElevation) >= SunElevationThreshold * Scale
+		|| FMath::Abs(A.Coverage - B.Coverage) >= CoverageThreshold * Scale
+		|| A.PresetRevision != B.PresetRevision;
+}
+
+void USkyCaptureScheduler::Capture(const FLightingState& State)
+{
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::Sky);
+
+	SkyLight->RecaptureSky();
+
+	//Reflection captures are refreshed a few per frame from now on, the newest request restarts the list.
+	PendingReflectionCaptures.Reset();
+
+	for (TActorIterator<AReflectionCapture> CaptureItr(GetWorld()); CaptureItr; ++CaptureItr)
+	{
+		if (UReflectionCaptureComponent* CaptureComponent = CaptureItr->GetCaptureComponent())
+		{
+			PendingReflectionCaptures.Add(CaptureComponent);
+		}
+	}
+
+	CapturedState = State;
+	FirstChangeTime = -1.0f;
+	LastChangeTime = -1.0f;
+	bCaptureRequested = false;
+}
+
+void USkyCaptureScheduler::Tick(float DeltaTime)
+{
+	const float RealTime = GetWorld()->GetRealTimeSeconds();
+
+	if (SkyLight == nullptr)
+	{
+		//Sky may be streamed in later, search once per second.
+		if (RealTime - LastSearchTime < 1.0f)
+		{
+			return;
+		}
+
+		LastSearchTime = RealTime;
+
+		if (!Init())
+		{
+			return;
+		}
+
+		PreviousState = CapturedState = GetLightingState();
+	}
+
+	for (int32 Count = 0; Count < ReflectionCapturesPerFrame && PendingReflectionCaptures.Num() > 0; Count++)
+	{
+		if (UReflectionCaptureComponent* CaptureComponent = PendingReflectionCaptures.Pop(false))
+		{
+			CaptureComponent->MarkDirtyForRecapture();
+		}
+	}
+
+	const FLightingState State = GetLightingState();
+
+	if (bCaptureRequested)
+	{
+		Capture(State);
+		PreviousState = State;
+		return;
+	}
+
+	//Any visible movement since the previous frame restarts the debounce.
+	if (Differs(State, PreviousState, 0.01f))
+	{
+		LastChangeTime = RealTime;
+	}
+
+	PreviousState = State;
+
+	if (FirstChangeTime < 0.0f)
+	{
+		if (Differs(State, CapturedState, 1.0f))
+		{
+			FirstChangeTime = RealTime;
+			LastChangeTime = FMath::Max(LastChangeTime, RealTime);
+		}
+
+		return;
+	}
+
+	const bool bSettled = RealTime - LastChangeTime >= DebounceTime;
+	const bool bOverdue = RealTime - FirstChangeTime >= MaxDelay;
+
+	if (bSettled || bOverdue)
+	{
+		Capture(State);
+	}
+}
+
+bool USkyCaptureScheduler::IsTickable() const
+{
+	return bEnabled && !IsTemplate() && GetWorld() != nullptr && GetWorld()->IsGameWorld();
+}
+
+TStatId USkyCaptureScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USkyCaptureScheduler, STATGROUP_Tickables);
+}
@@ -0,0 +1,106 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Tickable.h"
+
+#include "SkyCaptureScheduler.generated.h"
+
+class UDirectionalLightComponent;
+class USkyLightComponent;
+class UStaticMeshComponent;
+class UReflectionCaptureComponent;
+
+/**
+* Recaptures the sky light and reflection captures only when the lighting changed enough: sun elevation, cloud coverage
+* or the blended environment preset. Changes are debounced, so scrubbing the time of day captures once it settles,
+* or every MaxDelay seconds while it keeps moving. Reflection captures are then recaptured a few per frame.
+*/
+UCLASS(Config = Game)
+class FULLENVIRONMENTDEV_API USkyCaptureScheduler : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	USkyCaptureScheduler();
+
+	/** Scheduler of a world, created on the first call. */
+	static USkyCaptureScheduler* Get(UWorld* World);
+
+	/** Recapture on the next tick regardless of thresholds. */
+	void RequestCapture() { bCaptureRequested = true; }
+
+	UPROPERTY(Config)
+	bool bEnabled;
+
+	/** Sun elevation change in degrees that needs a recapture. */
+	UPROPERTY(Config)
+	float SunElevationThreshold;
+
+	/** Clouds Coverage parameter change that needs a recapture. */
+	UPROPERTY(Config)
+	float CoverageThreshold;
+
+	/** Real seconds the lighting has to be steady before a pending recapture is done. */
+	UPROPERTY(Config)
+	float DebounceTime;
+
+	/** Longest real time a recapture is postponed while the lighting keeps changing. */
+	UPROPERTY(Config)
+	float MaxDelay;
+
+	/** Reflection captures updated per frame after a sky light recapture. */
+	UPROPERTY(Config)
+	int32 ReflectionCapturesPerFrame;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Lighting inputs compared against the last capture. */
+	struct FLightingState
+	{
+		float SunElevation = 0.0f;
+		float Coverage = 0.0f;
+		uint32 PresetRevision = 0;
+	};
+
+	/** Find the sky light, sun and clouds, false until the world has a sky light. */
+	bool Init();
+
+	FLightingState GetLightingState() const;
+
+	/** Does a state differ from another one by more than the thresholds. */
+	bool Differs(const FLightingState& A, const FLightingState& B, float Scale) const;
+
+	/** Recapture the sky light and queue the reflection captures. */
+	void Capture(const FLightingState& State);
+
+	UPROPERTY()
+	USkyLightComponent* SkyLight;
+
+	UPROPERTY()
+	UDirectionalLightComponent* SunLight;
+
+	UPROPERTY()
+	UStaticMeshComponent* CloudsComponent;
+
+	/** Reflection captures waiting for their recapture. */
+	UPROPERTY()
+	TArray<UReflectionCaptureComponent*> PendingReflectionCaptures;
+
+	FLightingState CapturedState;
+	FLightingState PreviousState;
+
+	/** Real time of the first and the latest change since the last capture, negative if nothing changed. */
+	float FirstChangeTime;
+	float LastChangeTime;
+
+	bool bCaptureRequested;
+	float LastSearchTime;
+};
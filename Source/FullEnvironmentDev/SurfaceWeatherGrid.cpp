@@ -0,0 +1,486 @@
+// 2015 - Community based open project
+
+#include "SurfaceWeatherGrid.h"
+#include "EnvironmentViewModel.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+#include "Materials/MaterialParameterCollection.h"
+#include "Materials/MaterialParameterCollectionInstance.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_STATS_GROUP(TEXT("SurfaceWeatherGrid"), STATGROUP_SurfaceWeatherGrid, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Integrate"), STAT_SurfaceWeatherGrid_Integrate, STATGROUP_SurfaceWeatherGrid);
+DECLARE_CYCLE_STAT(TEXT("Trace"), STAT_SurfaceWeatherGrid_Trace, STATGROUP_SurfaceWeatherGrid);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active tiles"), STAT_SurfaceWeatherGrid_ActiveTiles, STATGROUP_SurfaceWeatherGrid);
+DECLARE_MEMORY_STAT(TEXT("Tile memory"), STAT_SurfaceWeatherGrid_Memory, STATGROUP_SurfaceWeatherGrid);
+
+namespace SurfaceWeatherGrid
+{
+	/** Tiles integrated by a single task. */
+	static const int32 TilesPerBatch = 8;
+
+	/** Apply a step of precipitation, drying and melt to a single surface. */
+	FORCEINLINE void Accumulate(float& Wetness, float& Snow, float Rain, float Snowfall, float Drying, float Melt, float MinWetness)
+	{
+		const float Melted = FMath::Min(Snow, Melt);
+
+		Snow = FMath::Clamp(Snow - Melted + Snowfall, 0.0f, 1.0f);
+		Wetness = FMath::Clamp(Wetness + Rain - Drying + Melted, MinWetness, 1.0f);
+	}
+}
+
+USurfaceWeatherGrid::USurfaceWeatherGrid()
+	: CellSize(100.0f)
+	, ActiveRadius(6400.0f)
+	, UpdateInterval(0.25f)
+	, TracesPerFrame(64)
+	, TraceHeight(5000.0f)
+	, WetRate(1.0f / 60.0f)
+	, DryRate(1.0f / 1200.0f)
+	, DryRatePerDegree(0.1f)
+	, SnowRate(1.0f / 600.0f)
+	, MeltRatePerDegree(1.0f / 3600.0f)
+	, RainTemperature(2.0f)
+	, SnowTemperature(-1.0f)
+	, WetFriction(0.7f)
+	, SnowFriction(0.5f)
+	, WetnessParameter(TEXT("SurfaceWetness"))
+	, SnowParameter(TEXT("SurfaceSnow"))
+	, ParameterCollection(nullptr)
+	, ViewTile(FIntPoint::ZeroValue)
+	, TimeSinceUpdate(0.0f)
+	, bInitialized(false)
+	, bHasViewTile(false)
+{
+	//Water is always wet and melts snow, soil soaks water up, canopies hold some rain back.
+	FSurfaceWeatherResponse Water;
+	Water.Surface = TEXT("Water");
+	Water.MinWetness = 1.0f;
+	Water.SnowRate = 0.0f;
+	Surfaces.Add(Water);
+
+	FSurfaceWeatherResponse Ice;
+	Ice.Surface = TEXT("Ice");
+	Ice.DryRate = 0.5f;
+	Ice.MeltRate = 0.5f;
+	Surfaces.Add(Ice);
+
+	FSurfaceWeatherResponse Snow;
+	Snow.Surface = TEXT("Snow");
+	Snow.SnowRate = 2.0f;
+	Snow.MeltRate = 0.5f;
+	Surfaces.Add(Snow);
+
+	FSurfaceWeatherResponse BareSoil;
+	BareSoil.Surface = TEXT("BareSoil");
+	BareSoil.DryRate = 2.0f;
+	Surfaces.Add(BareSoil);
+
+	FSurfaceWeatherResponse Forest;
+	Forest.Surface = TEXT("Forest");
+	Forest.WetRate = 0.5f;
+	Forest.SnowRate = 0.5f;
+	Surfaces.Add(Forest);
+
+	FSurfaceWeatherResponse Metal;
+	Metal.Surface = TEXT("Metal");
+	Metal.DryRate = 1.5f;
+	Metal.MeltRate = 1.5f;
+	Surfaces.Add(Metal);
+}
+
+USurfaceWeatherGrid* USurfaceWeatherGrid::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (USurfaceWeatherGrid* Grid = Cast<USurfaceWeatherGrid>(Object))
+		{
+			return Grid;
+		}
+	}
+
+	USurfaceWeatherGrid* Grid = NewObject<USurfaceWeatherGrid>(World);
+	World->PerModuleDataObjects.Add(Grid);
+
+	return Grid;
+}
+
+void USurfaceWeatherGrid::InitResponses()
+{
+	bInitialized = true;
+
+	const UPhysicsSettings* PhysicsSettings = UPhysicsSettings::Get();
+
+	for (const FSurfaceWeatherResponse& Response : Surfaces)
+	{
+		const FPhysicalSurfaceName* SurfaceName = PhysicsSettings->PhysicalSurfaces.FindByPredicate([&Response](const FPhysicalSurfaceName& Name)
+		{
+			return Name.Name == Response.Surface;
+		});
+
+		if (SurfaceName == nullptr)
+		{
+			continue;
+		}
+
+		FResponse& Resolved = Responses[SurfaceName->Type];
+		Resolved.WetRate = Response.WetRate;
+		Resolved.DryRate = Response.DryRate;
+		Resolved.SnowRate = Response.SnowRate;
+		Resolved.MeltRate = Response.MeltRate;
+		Resolved.MinWetness = Response.MinWetness;
+		Resolved.Wetness = Response.MinWetness;
+	}
+
+	if (!ParameterCollectionPath.IsNull())
+	{
+		ParameterCollection = Cast<UMaterialParameterCollection>(ParameterCollectionPath.TryLoad());
+	}
+}
+
+FIntPoint USurfaceWeatherGrid::GetTileCoord(const FVector& Location) const
+{
+	const float TileSize = CellSize * TileCells;
+
+	return FIntPoint(FMath::FloorToInt(Location.X / TileSize), FMath::FloorToInt(Location.Y / TileSize));
+}
+
+bool USurfaceWeatherGrid::FindCell(const FVector& Location, int32& OutTileIndex, int32& OutCellIndex) const
+{
+	const FIntPoint Coord = GetTileCoord(Location);
+	const int32* TileIndex = TileIndices.Find(Coord);
+
+	if (TileIndex == nullptr)
+	{
+		return false;
+	}
+
+	const float TileSize = CellSize * TileCells;
+	const int32 CellX = FMath::Clamp(FMath::FloorToInt((Location.X - Coord.X * TileSize) / CellSize), 0, TileCells - 1);
+	const int32 CellY = FMath::Clamp(FMath::FloorToInt((Location.Y - Coord.Y * TileSize) / CellSize), 0, TileCells - 1);
+
+	OutTileIndex = *TileIndex;
+	OutCellIndex = CellY * TileCells + CellX;
+
+	return true;
+}
+
+FSurfaceWeather USurfaceWeatherGrid::GetSurfaceWeather(const FVector& Location) const
+{
+	FSurfaceWeather Weather;
+	int32 TileIndex;
+	int32 CellIndex;
+
+	if (!FindCell(Location, TileIndex, CellIndex))
+	{
+		Weather.Wetness = Responses[SurfaceType_Default].Wetness;
+		Weather.Snow = Responses[SurfaceType_Default].Snow;
+		return Weather;
+	}
+
+	const FTile& Tile = Tiles[TileIndex];
+	Weather.SurfaceType = EPhysicalSurface(Tile.Surface[CellIndex]);
+
+	//A cell's surface is about a cell thick, anything well below it is under a roof or a canopy.
+	if (Location.Z < Tile.SurfaceZ[CellIndex] - CellSize)
+	{
+		Weather.bSheltered = true;
+		return Weather;
+	}
+
+	Weather.Wetness = Tile.Wetness[CellIndex];
+	Weather.Snow = Tile.Snow[CellIndex];
+
+	return Weather;
+}
+
+float USurfaceWeatherGrid::GetFrictionScale(const FVector& Location) const
+{
+	const FSurfaceWeather Weather = GetSurfaceWeather(Location);
+
+	return FMath::Lerp(1.0f, WetFriction, Weather.Wetness) * FMath::Lerp(1.0f, SnowFriction, Weather.Snow);
+}
+
+void USurfaceWeatherGrid::AddAccumulation(const FVector& Location, float Radius, float Wetness, float Snow)
+{
+	const int32 NumCells = FMath::CeilToInt(Radius / CellSize);
+
+	for (int32 Y = -NumCells; Y <= NumCells; Y++)
+	{
+		for (int32 X = -NumCells; X <= NumCells; X++)
+		{
+			const FVector Offset(X * CellSize, Y * CellSize, 0.0f);
+
+			if (Offset.SizeSquared2D() > FMath::Square(Radius))
+			{
+				continue;
+			}
+
+			int32 TileIndex;
+			int32 CellIndex;
+
+			if (FindCell(Location + Offset, TileIndex, CellIndex))
+			{
+				FTile& Tile = Tiles[TileIndex];
+				Tile.Wetness[CellIndex] = FMath::Clamp(Tile.Wetness[CellIndex] + Wetness, Responses[Tile.Surface[CellIndex]].MinWetness, 1.0f);
+				Tile.Snow[CellIndex] = FMath::Clamp(Tile.Snow[CellIndex] + Snow, 0.0f, 1.0f);
+			}
+		}
+	}
+}
+
+void USurfaceWeatherGrid::UpdateActiveTiles(const FVector& ViewLocation)
+{
+	const FIntPoint NewViewTile = GetTileCoord(ViewLocation);
+
+	if (bHasViewTile && NewViewTile == ViewTile)
+	{
+		return;
+	}
+
+	bHasViewTile = true;
+	ViewTile = NewViewTile;
+
+	const float TileSize = CellSize * TileCells;
+	const FVector2D ViewLocation2D(ViewLocation);
+
+	//A tile more than the radius keeps tiles from flickering on a tile border.
+	for (auto TileItr = TileIndices.CreateIterator(); TileItr; ++TileItr)
+	{
+		const FVector2D TileCenter = (FVector2D(TileItr.Key()) + 0.5f) * TileSize;
+
+		if (FVector2D::DistSquared(TileCenter, ViewLocation2D) > FMath::Square(ActiveRadius + TileSize))
+		{
+			const int32 TileIndex = TileItr.Value();
+			Tiles[TileIndex].bActive = false;
+			FreeTiles.Add(TileIndex);
+			TraceQueue.RemoveSingleSwap(TileIndex, false);
+			TileItr.RemoveCurrent();
+		}
+	}
+
+	const int32 RadiusTiles = FMath::CeilToInt(ActiveRadius / TileSize);
+	const FResponse& Open = Responses[SurfaceType_Default];
+
+	for (int32 Y = ViewTile.Y - RadiusTiles; Y <= ViewTile.Y + RadiusTiles; Y++)
+	{
+		for (int32 X = ViewTile.X - RadiusTiles; X <= ViewTile.X + RadiusTiles; X++)
+		{
+			const FIntPoint Coord(X, Y);
+			const FVector2D TileCenter = (FVector2D(Coord) + 0.5f) * TileSize;
+
+			if (FVector2D::DistSquared(TileCenter, ViewLocation2D) > FMath::Square(ActiveRadius) || TileIndices.Contains(Coord))
+			{
+				continue;
+			}
+
+			//Recycled slots keep the tile count, and with it the memory, bounded by the radius.
+			const int32 TileIndex = FreeTiles.Num() > 0 ? FreeTiles.Pop(false) : Tiles.AddUninitialized();
+			FTile& Tile = Tiles[TileIndex];
+			Tile.Coord = Coord;
+			Tile.bActive = true;
+			Tile.NextTraceCell = 0;
+
+			//Until traced, cells are open ground that saw the same weather as everything else.
+			for (int32 CellIndex = 0; CellIndex < NumTileCells; CellIndex++)
+			{
+				Tile.Wetness[CellIndex] = Open.Wetness;
+				Tile.Snow[CellIndex] = Open.Snow;
+				Tile.SurfaceZ[CellIndex] = -BIG_NUMBER;
+				Tile.Surface[CellIndex] = SurfaceType_Default;
+			}
+
+			TileIndices.Add(Coord, TileIndex);
+			TraceQueue.Add(TileIndex);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_SurfaceWeatherGrid_ActiveTiles, TileIndices.Num());
+	SET_MEMORY_STAT(STAT_SurfaceWeatherGrid_Memory, Tiles.GetAllocatedSize() + TileIndices.GetAllocatedSize());
+}
+
+void USurfaceWeatherGrid::TraceCells(const FVector& ViewLocation)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SurfaceWeatherGrid_Trace);
+
+	const float TileSize = CellSize * TileCells;
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(SurfaceWeatherGrid), false);
+	QueryParams.bReturnPhysicalMaterial = true;
+
+	int32 NumTraces = 0;
+
+	while (NumTraces < TracesPerFrame && TraceQueue.Num() > 0)
+	{
+		FTile& Tile = Tiles[TraceQueue.Last()];
+		const int32 CellIndex = Tile.NextTraceCell++;
+
+		if (Tile.NextTraceCell >= NumTileCells)
+		{
+			TraceQueue.Pop(false);
+		}
+
+		const FVector2D CellCenter = FVector2D(Tile.Coord) * TileSize + (FVector2D(CellIndex % TileCells, CellIndex / TileCells) + 0.5f) * CellSize;
+		const FVector Start(CellCenter, ViewLocation.Z + TraceHeight);
+		const FVector End(CellCenter, ViewLocation.Z - TraceHeight);
+
+		FHitResult Hit;
+		NumTraces++;
+
+		if (!GetWorld()->LineTraceSingleByChannel(Hit, Start, End, ECC_Visibility, QueryParams))
+		{
+			continue;
+		}
+
+		const EPhysicalSurface Surface = UPhysicalMaterial::DetermineSurfaceType(Hit.PhysMaterial.Get());
+		Tile.SurfaceZ[CellIndex] = Hit.ImpactPoint.Z;
+		Tile.Surface[CellIndex] = Surface;
+		Tile.Wetness[CellIndex] = Responses[Surface].Wetness;
+		Tile.Snow[CellIndex] = Responses[Surface].Snow;
+	}
+}
+
+void USurfaceWeatherGrid::Integrate(float DeltaTime)
+{
+	using namespace SurfaceWeatherGrid;
+
+	SCOPE_CYCLE_COUNTER(STAT_SurfaceWeatherGrid_Integrate);
+
+	float Precipitation = 0.0f;
+	float Temperature = 10.0f;
+
+	if (const UEnvironmentViewModel* ViewModel = UEnvironmentViewModel::Get(GetWorld()))
+	{
+		Precipitation = FMath::Max(ViewModel->GetPrecipitation(), 0.0f);
+		Temperature = ViewModel->GetTemperature();
+	}
+
+	//Rain turns into snow between the two temperatures.
+	const float RainFraction = FMath::SmoothStep(SnowTemperature, RainTemperature, Temperature);
+	const float Warmth = FMath::Max(Temperature, 0.0f);
+
+	const float Rain = Precipitation * RainFraction * WetRate * DeltaTime;
+	const float Snowfall = Precipitation * (1.0f - RainFraction) * SnowRate * DeltaTime;
+	const float Drying = DryRate * (1.0f + DryRatePerDegree * Warmth) * DeltaTime;
+	const float Melt = MeltRatePerDegree * Warmth * DeltaTime;
+
+	for (FResponse& Response : Responses)
+	{
+		Accumulate(Response.Wetness, Response.Snow, Rain * Response.WetRate, Snowfall * Response.SnowRate, Drying * Response.DryRate, Melt * Response.MeltRate, Response.MinWetness);
+	}
+
+	const int32 NumBatches = FMath::DivideAndRoundUp(Tiles.Num(), TilesPerBatch);
+
+	ParallelFor(NumBatches, [&](int32 Batch)
+	{
+		const int32 LastTile = FMath::Min((Batch + 1) * TilesPerBatch, Tiles.Num());
+
+		for (int32 TileIndex = Batch * TilesPerBatch; TileIndex < LastTile; TileIndex++)
+		{
+			FTile& Tile = Tiles[TileIndex];
+
+			if (!Tile.bActive)
+			{
+				continue;
+			}
+
+			for (int32 CellIndex = 0; CellIndex < NumTileCells; CellIndex++)
+			{
+				const FResponse& Response = Responses[Tile.Surface[CellIndex]];
+				Accumulate(Tile.Wetness[CellIndex], Tile.Snow[CellIndex], Rain * Response.WetRate, Snowfall * Response.SnowRate, Drying * Response.DryRate, Melt * Response.MeltRate, Response.MinWetness);
+			}
+		}
+	});
+}
+
+void USurfaceWeatherGrid::Advance(float Seconds)
+{
+	if (!bInitialized)
+	{
+		InitResponses();
+	}
+
+	//Accumulation is clamped to its range, so long steps stay bounded.
+	Integrate(Seconds);
+}
+
+void USurfaceWeatherGrid::UpdateParameters(const FVector& ViewLocation)
+{
+	UMaterialParameterCollectionInstance* CollectionInstance = ParameterCollection != nullptr ? GetWorld()->GetParameterCollectionInstance(ParameterCollection) : nullptr;
+
+	if (CollectionInstance == nullptr)
+	{
+		return;
+	}
+
+	const FSurfaceWeather Weather = GetSurfaceWeather(ViewLocation);
+	CollectionInstance->SetScalarParameterValue(WetnessParameter, Weather.Wetness);
+	CollectionInstance->SetScalarParameterValue(SnowParameter, Weather.Snow);
+}
+
+bool USurfaceWeatherGrid::GetViewLocation(FVector& OutLocation) const
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+
+	if (PlayerController == nullptr)
+	{
+		return false;
+	}
+
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(OutLocation, ViewRotation);
+
+	return true;
+}
+
+void USurfaceWeatherGrid::Tick(float DeltaTime)
+{
+	if (!bInitialized)
+	{
+		InitResponses();
+	}
+
+	FVector ViewLocation;
+	const bool bHasView = GetViewLocation(ViewLocation);
+
+	if (bHasView)
+	{
+		UpdateActiveTiles(ViewLocation);
+		TraceCells(ViewLocation);
+	}
+
+	TimeSinceUpdate += DeltaTime;
+
+	if (TimeSinceUpdate < UpdateInterval)
+	{
+		return;
+	}
+
+	Integrate(TimeSinceUpdate);
+	TimeSinceUpdate = 0.0f;
+
+	if (bHasView)
+	{
+		UpdateParameters(ViewLocation);
+	}
+}
+
+bool USurfaceWeatherGrid::IsTickable() const
+{
+	return !IsTemplate() && GetWorld() != nullptr && GetWorld()->IsGameWorld();
+}
+
+TStatId USurfaceWeatherGrid::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USurfaceWeatherGrid, STATGROUP_Tickables);
+}
@@ -0,0 +1,246 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Tickable.h"
+
+#include "SurfaceWeatherGrid.generated.h"
+
+class UMaterialParameterCollection;
+
+/** How a physical surface takes rain and snow. Rates scale the grid wide rates. */
+USTRUCT()
+struct FSurfaceWeatherResponse
+{
+	GENERATED_BODY()
+
+	/** Physical surface name from the physics project settings. */
+	UPROPERTY(Config)
+	FName Surface;
+
+	UPROPERTY(Config)
+	float WetRate = 1.0f;
+
+	UPROPERTY(Config)
+	float DryRate = 1.0f;
+
+	UPROPERTY(Config)
+	float SnowRate = 1.0f;
+
+	UPROPERTY(Config)
+	float MeltRate = 1.0f;
+
+	/** Wetness of the surface when dry, 1 for water. */
+	UPROPERTY(Config)
+	float MinWetness = 0.0f;
+};
+
+/** Rain and snow accumulated on a surface. */
+USTRUCT(BlueprintType)
+struct FSurfaceWeather
+{
+	GENERATED_BODY()
+
+	/** 0 is dry, 1 is soaked. */
+	UPROPERTY(BlueprintReadOnly, Category = "Weather")
+	float Wetness = 0.0f;
+
+	/** 0 is bare, 1 is fully covered. */
+	UPROPERTY(BlueprintReadOnly, Category = "Weather")
+	float Snow = 0.0f;
+
+	/** Surface precipitation lands on above the queried location. */
+	UPROPERTY(BlueprintReadOnly, Category = "Weather")
+	TEnumAsByte<EPhysicalSurface> SurfaceType = SurfaceType_Default;
+
+	/** Is the queried location below the surface that takes the precipitation, e.g. under a roof. */
+	UPROPERTY(BlueprintReadOnly, Category = "Weather")
+	bool bSheltered = false;
+};
+
+/**
+* Wetness and snow cover of the surfaces around the view. Only tiles within ActiveRadius of the view are stored,
+* tiles are recycled as the view moves, so memory and update cost depend on the radius and not on the world size.
+* Every cell traces down once to find the surface precipitation lands on, a few traces per frame.
+* Tiles integrate precipitation, evaporation and melt in parallel batches at UpdateInterval.
+* Queries are a tile lookup and a cell read.
+*/
+UCLASS(Config = Game)
+class FULLENVIRONMENTDEV_API USurfaceWeatherGrid : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	USurfaceWeatherGrid();
+
+	/** Grid of a world, created on the first call. */
+	UFUNCTION(BlueprintPure, Category = "Weather", meta = (WorldContext = "WorldContextObject"))
+	static USurfaceWeatherGrid* Get(const UObject* WorldContextObject);
+
+	/** Wetness and snow at a location, locations outside of the grid read as an open surface. */
+	UFUNCTION(BlueprintPure, Category = "Weather")
+	FSurfaceWeather GetSurfaceWeather(const FVector& Location) const;
+
+	/** Friction multiplier of wetness and snow at a location. */
+	UFUNCTION(BlueprintPure, Category = "Weather")
+	float GetFrictionScale(const FVector& Location) const;
+
+	/** Add wetness and snow around a location, negative amounts remove them, e.g. footprints in snow. */
+	UFUNCTION(BlueprintCallable, Category = "Weather")
+	void AddAccumulation(const FVector& Location, float Radius, float Wetness, float Snow);
+
+	/** Integrate a long span at once, e.g. when the environment is fast-forwarded. */
+	void Advance(float Seconds);
+
+	/** Cell edge length in world units. */
+	UPROPERTY(Config)
+	float CellSize;
+
+	/** Tiles within this distance of the view are stored. */
+	UPROPERTY(Config)
+	float ActiveRadius;
+
+	/** Game seconds between two integrations. */
+	UPROPERTY(Config)
+	float UpdateInterval;
+
+	/** Surface traces per frame for newly activated cells. */
+	UPROPERTY(Config)
+	int32 TracesPerFrame;
+
+	/** Traces start this far above the view and end this far below it. */
+	UPROPERTY(Config)
+	float TraceHeight;
+
+	/** Wetness gained per second at full rain. */
+	UPROPERTY(Config)
+	float WetRate;
+
+	/** Wetness lost per second at 0 degrees Celsius, more when warmer. */
+	UPROPERTY(Config)
+	float DryRate;
+
+	/** Additional drying per degree above 0 degrees Celsius, relative to DryRate. */
+	UPROPERTY(Config)
+	float DryRatePerDegree;
+
+	/** Snow cover gained per second at full snowfall. */
+	UPROPERTY(Config)
+	float SnowRate;
+
+	/** Snow cover melted per second and degree above 0 degrees Celsius, melt water wets the surface. */
+	UPROPERTY(Config)
+	float MeltRatePerDegree;
+
+	/** Precipitation is all rain above RainTemperature and all snow below SnowTemperature. */
+	UPROPERTY(Config)
+	float RainTemperature;
+	UPROPERTY(Config)
+	float SnowTemperature;
+
+	/** Friction multipliers of a soaked and a snow covered surface. */
+	UPROPERTY(Config)
+	float WetFriction;
+	UPROPERTY(Config)
+	float SnowFriction;
+
+	UPROPERTY(Config)
+	TArray<FSurfaceWeatherResponse> Surfaces;
+
+	/** Optional collection that receives wetness and snow under the view. */
+	UPROPERTY(Config)
+	FSoftObjectPath ParameterCollectionPath;
+	UPROPERTY(Config)
+	FName WetnessParameter;
+	UPROPERTY(Config)
+	FName SnowParameter;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Cells per tile side. */
+	static const int32 TileCells = 16;
+	static const int32 NumTileCells = TileCells * TileCells;
+
+	struct FTile
+	{
+		FIntPoint Coord;
+		bool bActive;
+
+		/** Next cell without a surface trace, NumTileCells once all are traced. */
+		int32 NextTraceCell;
+
+		float Wetness[NumTileCells];
+		float Snow[NumTileCells];
+
+		/** Height precipitation lands at, locations below it are sheltered. */
+		float SurfaceZ[NumTileCells];
+
+		/** EPhysicalSurface of every cell. */
+		uint8 Surface[NumTileCells];
+	};
+
+	/** Resolved response of every EPhysicalSurface. */
+	struct FResponse
+	{
+		float WetRate = 1.0f;
+		float DryRate = 1.0f;
+		float SnowRate = 1.0f;
+		float MeltRate = 1.0f;
+		float MinWetness = 0.0f;
+
+		/** Accumulation of an open surface that never left the grid, new cells start from it. */
+		float Wetness = 0.0f;
+		float Snow = 0.0f;
+	};
+
+	/** Map surface names to EPhysicalSurface. */
+	void InitResponses();
+
+	/** Activate tiles around the view and recycle the ones that left the radius. */
+	void UpdateActiveTiles(const FVector& ViewLocation);
+
+	/** Trace the surface under a few cells. */
+	void TraceCells(const FVector& ViewLocation);
+
+	/** Integrate precipitation, drying and melt over all tiles. */
+	void Integrate(float DeltaTime);
+
+	/** Push wetness and snow under the view to the parameter collection. */
+	void UpdateParameters(const FVector& ViewLocation);
+
+	/** Tile and cell of a location, false if the tile isn't active. */
+	bool FindCell(const FVector& Location, int32& OutTileIndex, int32& OutCellIndex) const;
+
+	FIntPoint GetTileCoord(const FVector& Location) const;
+
+	/** Location of the view the grid is centered on. */
+	bool GetViewLocation(FVector& OutLocation) const;
+
+	/** Active tiles and recycled slots. */
+	TArray<FTile> Tiles;
+	TArray<int32> FreeTiles;
+	TMap<FIntPoint, int32> TileIndices;
+
+	/** Active tiles with cells left to trace. */
+	TArray<int32> TraceQueue;
+
+	/** Tile of the view when tiles were last activated. */
+	FIntPoint ViewTile;
+
+	FResponse Responses[SurfaceType_Max];
+
+	UPROPERTY()
+	UMaterialParameterCollection* ParameterCollection;
+
+	float TimeSinceUpdate;
+	bool bInitialized;
+	bool bHasViewTile;
+};
@@ -0,0 +1,178 @@
+// 2015 - Community based open project
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "CloudQualityGovernor.h"
+
+/**
+* Cloud quality governor tests fed with scripted frame time traces, run headless with:
+* UE4Editor-Cmd FullEnvironmentDev.uproject -nullrhi -unattended -ExecCmds="Automation RunTests FullEnvironmentDev.CloudQualityGovernor;Quit"
+*/
+namespace CloudQualityGovernorTests
+{
+	/** Frames of a constant CPU and GPU time. */
+	struct FTraceSegment
+	{
+		float Seconds;
+		float FrameMs;
+
+		/** 0 if the GPU time is unknown. */
+		float GpuMs;
+	};
+
+	/** Level change and the trace time it happened at. */
+	struct FTransition
+	{
+		double Time;
+		int32 Level;
+	};
+
+	/** Feeds traces at a fixed frame rate and records every level change. */
+	struct FTracePlayer
+	{
+		FCloudQualityGovernor& Governor;
+		double Time = 0.0;
+		TArray<FTransition> Transitions;
+
+		static constexpr float DeltaSeconds = 1.0f / 60.0f;
+
+		explicit FTracePlayer(FCloudQualityGovernor& InGovernor)
+			: Governor(InGovernor)
+		{
+		}
+
+		/** Play a segment, returns the level at its end. */
+		int32 Play(const FTraceSegment& Segment)
+		{
+			const int32 NumFrames = FMath::RoundToInt(Segment.Seconds / DeltaSeconds);
+
+			for (int32 Frame = 0; Frame < NumFrames; Frame++)
+			{
+				Time += DeltaSeconds;
+
+				if (Governor.Update(Segment.FrameMs, Segment.GpuMs, DeltaSeconds))
+				{
+					Transitions.Add({ Time, Governor.GetLevel() });
+				}
+			}
+
+			return Governor.GetLevel();
+		}
+
+		FString GetLevels() const
+		{
+			FString Levels;
+
+			for (const FTransition& Transition : Transitions)
+			{
+				Levels += FString::Printf(TEXT("%s%d"), Levels.IsEmpty() ? TEXT("") : TEXT(","), Transition.Level);
+			}
+
+			return Levels;
+		}
+	};
+
+	/** Default budget with fast smoothing, so level changes line up with the trace. */
+	FCloudQualityGovernorSettings MakeSettings()
+	{
+		FCloudQualityGovernorSettings Settings;
+		Settings.SmoothingTime = 0.05f;
+
+		return Settings;
+	}
+
+	/** Over budget, inside the hysteresis band and under budget for the default 16.6 ms target. */
+	const float OverMs = 25.0f;
+	const float BandMs = 15.0f;
+	const float UnderMs = 10.0f;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCloudQualityGovernorTransitionsTest, "FullEnvironmentDev.CloudQualityGovernor.Transitions",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FCloudQualityGovernorTransitionsTest::RunTest(const FString& Parameters)
+{
+	using namespace CloudQualityGovernorTests;
+
+	const FCloudQualityGovernorSettings Settings = MakeSettings();
+	FCloudQualityGovernor Governor(Settings);
+	FTracePlayer Player(Governor);
+
+	TestEqual(TEXT("Starts at the authored quality"), Governor.GetLevel(), Settings.NumLevels - 1);
+
+	//Over budget drops one level per DownscaleDelay, never several at once.
+	TestEqual(TEXT("Level after 1.2 s over budget"), Player.Play({ 1.2f, OverMs, OverMs }), 2);
+
+	if (TestEqual(TEXT("Downscales over budget"), Player.Transitions.Num(), 2))
+	{
+		TestTrue(TEXT("First downscale after DownscaleDelay"), FMath::IsWithin(Player.Transitions[0].Time, 0.5, 0.55));
+		TestTrue(TEXT("Second downscale one DownscaleDelay later"), FMath::IsWithin(Player.Transitions[1].Time - Player.Transitions[0].Time, 0.5, 0.55));
+	}
+
+	//Inside the hysteresis band nothing changes, however long it lasts.
+	TestEqual(TEXT("Level after 10 s in the band"), Player.Play({ 10.0f, BandMs, BandMs }), 2);
+	TestEqual(TEXT("No changes in the band"), Player.Transitions.Num(), 2);
+
+	//Under budget raises one level only after UpscaleDelay.
+	const double UnderStart = Player.Time;
+
+	TestEqual(TEXT("Level just before UpscaleDelay under budget"), Player.Play({ 2.8f, UnderMs, UnderMs }), 2);
+	TestEqual(TEXT("Level after UpscaleDelay under budget"), Player.Play({ 0.5f, UnderMs, UnderMs }), 3);
+
+	if (TestEqual(TEXT("Upscale under budget"), Player.Transitions.Num(), 3))
+	{
+		TestTrue(TEXT("Upscale after UpscaleDelay"), FMath::IsWithin(Player.Transitions[2].Time - UnderStart, 3.0, 3.1));
+	}
+
+	//Dropping right after the upscale doubles the delay before that level is tried again.
+	TestEqual(TEXT("Level after a failed upscale"), Player.Play({ 0.7f, OverMs, OverMs }), 2);
+
+	const double BackoffStart = Player.Time;
+
+	TestEqual(TEXT("Level before the doubled delay"), Player.Play({ 5.0f, UnderMs, UnderMs }), 2);
+	TestEqual(TEXT("Level after the doubled delay"), Player.Play({ 1.5f, UnderMs, UnderMs }), 3);
+	TestEqual(TEXT("Transitions"), Player.GetLevels(), FString(TEXT("3,2,3,2,3")));
+
+	if (Player.Transitions.Num() == 5)
+	{
+		TestTrue(TEXT("Retry after twice the UpscaleDelay"), FMath::IsWithin(Player.Transitions[4].Time - BackoffStart, 6.0, 6.1));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCloudQualityGovernorSourceTest, "FullEnvironmentDev.CloudQualityGovernor.CpuGpuTimes",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FCloudQualityGovernorSourceTest::RunTest(const FString& Parameters)
+{
+	using namespace CloudQualityGovernorTests;
+
+	FCloudQualityGovernor Governor(MakeSettings());
+	FTracePlayer Player(Governor);
+
+	//A slow CPU doesn't cost cloud quality while the GPU is within budget.
+	TestEqual(TEXT("Level with a slow CPU"), Player.Play({ 2.0f, OverMs, UnderMs }), 4);
+
+	//Without GPU time the frame time decides.
+	TestEqual(TEXT("Level without GPU time"), Player.Play({ 0.7f, OverMs, 0.0f }), 3);
+
+	//A slow GPU drops quality even when the frame time looks fine.
+	TestEqual(TEXT("Level with a slow GPU"), Player.Play({ 0.7f, UnderMs, OverMs }), 2);
+
+	//Levels are clamped at both ends.
+	TestEqual(TEXT("Lowest level"), Player.Play({ 10.0f, OverMs, OverMs }), 0);
+	TestEqual(TEXT("Highest level"), Player.Play({ 60.0f, UnderMs, UnderMs }), 4);
+	TestEqual(TEXT("Quality at the highest level"), Governor.GetQuality(), 1.0f);
+
+	//Invalid samples are ignored.
+	TestFalse(TEXT("Zero delta is ignored"), Governor.Update(OverMs, OverMs, 0.0f));
+	TestFalse(TEXT("Missing times are ignored"), Governor.Update(0.0f, 0.0f, FTracePlayer::DeltaSeconds));
+
+	return true;
+}
+
+#endif
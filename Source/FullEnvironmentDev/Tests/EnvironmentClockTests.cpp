@@ -0,0 +1,316 @@
+// 2015 - Community based open project
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "EnvironmentClock.h"
+#include "Algo/Find.h"
+#include "UObject/Package.h"
+
+/**
+* Timer wheel tests of the environment clock, run headless with:
+* UE4Editor-Cmd FullEnvironmentDev.uproject -nullrhi -unattended -ExecCmds="Automation RunTests FullEnvironmentDev.EnvironmentClock;Quit"
+*/
+namespace EnvironmentClockTests
+{
+	/** Event calls in the order they happened. */
+	struct FEventLog
+	{
+		struct FEntry
+		{
+			FString Name;
+			FDateTime Time;
+			int32 Occurrences;
+
+			/** Clock time while the event ran. */
+			FDateTime ClockTime;
+		};
+
+		TArray<FEntry> Entries;
+
+		/** Callback that appends a named entry. */
+		FEnvironmentClockCallback Record(UEnvironmentClock* Clock, const FString& Name)
+		{
+			return [this, Clock, Name](const FDateTime& Time, int32 Occurrences)
+			{
+				Entries.Add({ Name, Time, Occurrences, Clock->GetLocalTime() });
+			};
+		}
+
+		FString GetNames() const
+		{
+			FString Names;
+
+			for (const FEntry& Entry : Entries)
+			{
+				Names += (Names.IsEmpty() ? TEXT("") : TEXT(",")) + Entry.Name;
+			}
+
+			return Names;
+		}
+	};
+
+	/** Clock with one second ticks and a time set, not attached to a world. */
+	UEnvironmentClock* NewClock(const FDateTime& Start)
+	{
+		UEnvironmentClock* Clock = NewObject<UEnvironmentClock>(GetTransientPackage());
+		Clock->Resolution = 1.0f;
+		Clock->AdvanceTo(Start);
+
+		return Clock;
+	}
+
+	/** Time of a wheel tick, one second per tick. Ticks are 2^30 per wheel block. */
+	FDateTime TickTime(int64 Tick)
+	{
+		return FDateTime(Tick * ETimespan::TicksPerSecond);
+	}
+
+	const int64 BlockTicks = int64(1) << 30;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEnvironmentClockCascadeTest, "FullEnvironmentDev.EnvironmentClock.Cascade",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FEnvironmentClockCascadeTest::RunTest(const FString& Parameters)
+{
+	using namespace EnvironmentClockTests;
+
+	const FDateTime Start(2020, 3, 1, 6, 0, 0);
+
+	//One event per wheel level and one beyond the wheel, scheduled out of order.
+	struct FEvent
+	{
+		const TCHAR* Name;
+		FTimespan Delay;
+	};
+
+	const FEvent Events[] =
+	{
+		{ TEXT("Overflow"), FTimespan::FromDays(365.0 * 40.0) },
+		{ TEXT("Level3"), FTimespan::FromDays(30.0) },
+		{ TEXT("Level0"), FTimespan::FromSeconds(30.0) },
+		{ TEXT("Level4"), FTimespan::FromDays(365.0) },
+		{ TEXT("Level1"), FTimespan::FromHours(1.0) },
+		{ TEXT("Level2"), FTimespan::FromDays(2.0) },
+	};
+
+	const TCHAR* ExpectedOrder = TEXT("Level0,Level1,Level2,Level3,Level4,Overflow");
+
+	//The same events fire in the same order and on time whether the clock gets there at once or in small steps.
+	for (int32 NumSteps : { 1, 7, 1000 })
+	{
+		FEventLog Log;
+		UEnvironmentClock* Clock = NewClock(Start);
+
+		for (const FEvent& Event : Events)
+		{
+			Clock->ScheduleAt(Start + Event.Delay, Log.Record(Clock, Event.Name));
+		}
+
+		const FTimespan Span = FTimespan::FromDays(365.0 * 41.0);
+
+		for (int32 Step = 1; Step <= NumSteps; Step++)
+		{
+			Clock->AdvanceTo(Start + Span * (double(Step) / NumSteps));
+		}
+
+		TestEqual(FString::Printf(TEXT("Order in %d steps"), NumSteps), Log.GetNames(), FString(ExpectedOrder));
+
+		for (const FEventLog::FEntry& Entry : Log.Entries)
+		{
+			const FEvent* Event = Algo::FindByPredicate(Events, [&](const FEvent& Candidate) { return Entry.Name == Candidate.Name; });
+
+			TestEqual(FString::Printf(TEXT("%s time in %d steps"), *Entry.Name, NumSteps), Entry.Time.ToString(), (Start + Event->Delay).ToString());
+			TestTrue(FString::Printf(TEXT("%s doesn't see the clock early in %d steps"), *Entry.Name, NumSteps), Entry.ClockTime >= Entry.Time);
+		}
+	}
+
+	//An advance that ends just past a block boundary has to relink the overflow, or later wheel timers overtake it.
+	{
+		FEventLog Log;
+		const int64 Block = 60 * BlockTicks;
+		UEnvironmentClock* Clock = NewClock(TickTime(Block - 10));
+
+		Clock->ScheduleAt(TickTime(Block + 5), Log.Record(Clock, TEXT("First")));
+		Clock->AdvanceTo(TickTime(Block + 1));
+
+		Clock->ScheduleAt(TickTime(Block + (int64(1) << 20)), Log.Record(Clock, TEXT("Second")));
+		Clock->AdvanceTo(TickTime(Block + (int64(1) << 21)));
+
+		TestEqual(TEXT("Overflow relinked after crossing a block"), Log.GetNames(), FString(TEXT("First,Second")));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEnvironmentClockSameTickTest, "FullEnvironmentDev.EnvironmentClock.SameTickOrder",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FEnvironmentClockSameTickTest::RunTest(const FString& Parameters)
+{
+	using namespace EnvironmentClockTests;
+
+	const FDateTime Start(2020, 3, 1, 6, 0, 0);
+	const FDateTime Time = Start + FTimespan::FromDays(3.0);
+
+	FEventLog Log;
+	UEnvironmentClock* Clock = NewClock(Start);
+
+	//Scheduled from different distances, so they start on different levels and meet in the same slot.
+	Clock->ScheduleAt(Time, Log.Record(Clock, TEXT("A")));
+	Clock->AdvanceTo(Time - FTimespan::FromHours(2.0));
+	Clock->ScheduleAt(Time, Log.Record(Clock, TEXT("B")));
+	Clock->AdvanceTo(Time - FTimespan::FromSeconds(20.0));
+	Clock->ScheduleAt(Time, Log.Record(Clock, TEXT("C")));
+
+	//Cancelled events leave the order of the others alone.
+	FEnvironmentClockHandle Cancelled = Clock->ScheduleAt(Time, Log.Record(Clock, TEXT("X")));
+	Clock->ScheduleAt(Time, Log.Record(Clock, TEXT("D")));
+	Clock->Cancel(Cancelled);
+
+	TestFalse(TEXT("Cancelled handle is reset"), Clock->IsScheduled(Cancelled));
+
+	Clock->AdvanceTo(Time + FTimespan::FromMinutes(1.0));
+
+	TestEqual(TEXT("Same tick events fire in scheduling order"), Log.GetNames(), FString(TEXT("A,B,C,D")));
+
+	//An event that schedules another one at its own time gets it in the same advance, after the rest.
+	FEventLog ChainLog;
+	const FDateTime ChainTime = Time + FTimespan::FromHours(1.0);
+
+	Clock->ScheduleAt(ChainTime, [&ChainLog, Clock, ChainTime](const FDateTime& EventTime, int32 Occurrences)
+	{
+		ChainLog.Entries.Add({ TEXT("Outer"), EventTime, Occurrences, Clock->GetLocalTime() });
+		Clock->ScheduleAt(ChainTime, ChainLog.Record(Clock, TEXT("Inner")));
+	});
+
+	Clock->ScheduleAt(ChainTime, ChainLog.Record(Clock, TEXT("Sibling")));
+	Clock->AdvanceTo(ChainTime + FTimespan::FromMinutes(1.0));
+
+	TestEqual(TEXT("Events scheduled at the current tick fire in the same advance"), ChainLog.GetNames(), FString(TEXT("Outer,Sibling,Inner")));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEnvironmentClockCoalesceTest, "FullEnvironmentDev.EnvironmentClock.Coalesce",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FEnvironmentClockCoalesceTest::RunTest(const FString& Parameters)
+{
+	using namespace EnvironmentClockTests;
+
+	const FDateTime Start(2020, 3, 1, 6, 30, 0);
+
+	FEventLog Log;
+	UEnvironmentClock* Clock = NewClock(Start);
+
+	FEnvironmentClockHandle CoalescedHandle = Clock->ScheduleEvery(FTimespan::FromHours(1.0), FTimespan::Zero(), Log.Record(Clock, TEXT("Coalesced")), EEnvironmentClockCatchUp::Coalesce);
+	FEnvironmentClockHandle EveryHandle = Clock->ScheduleEvery(FTimespan::FromHours(1.0), FTimespan::Zero(), Log.Record(Clock, TEXT("Every")), EEnvironmentClockCatchUp::EveryOccurrence);
+
+	//07:00 to 16:00 in one advance.
+	Clock->AdvanceTo(FDateTime(2020, 3, 1, 16, 10, 0));
+
+	const TArray<FEventLog::FEntry> Coalesced = Log.Entries.FilterByPredicate([](const FEventLog::FEntry& Entry) { return Entry.Name == TEXT("Coalesced"); });
+	const TArray<FEventLog::FEntry> Every = Log.Entries.FilterByPredicate([](const FEventLog::FEntry& Entry) { return Entry.Name == TEXT("Every"); });
+
+	if (TestEqual(TEXT("Coalescing event fires once per advance"), Coalesced.Num(), 1))
+	{
+		TestEqual(TEXT("Coalesced occurrences"), Coalesced[0].Occurrences, 10);
+		TestEqual(TEXT("Coalesced time is the latest occurrence"), Coalesced[0].Time.ToString(), FDateTime(2020, 3, 1, 16, 0, 0).ToString());
+	}
+
+	TestEqual(TEXT("Every occurrence fires one by one"), Every.Num(), 10);
+
+	//A jump of several advances is heard about once, when it ends.
+	Log.Entries.Reset();
+	Clock->BeginJump();
+
+	for (int32 Hour = 18; Hour <= 22; Hour += 2)
+	{
+		Clock->AdvanceTo(FDateTime(2020, 3, 1, Hour, 10, 0));
+	}
+
+	const int32 CoalescedDuringJump = Log.Entries.FilterByPredicate([](const FEventLog::FEntry& Entry) { return Entry.Name == TEXT("Coalesced"); }).Num();
+	TestEqual(TEXT("Coalescing event is held back during a jump"), CoalescedDuringJump, 0);
+
+	Clock->EndJump();
+
+	const TArray<FEventLog::FEntry> AfterJump = Log.Entries.FilterByPredicate([](const FEventLog::FEntry& Entry) { return Entry.Name == TEXT("Coalesced"); });
+
+	if (TestEqual(TEXT("Coalescing event fires once after a jump"), AfterJump.Num(), 1))
+	{
+		TestEqual(TEXT("Jump occurrences"), AfterJump[0].Occurrences, 6);
+		TestEqual(TEXT("Jump time is the latest occurrence"), AfterJump[0].Time.ToString(), FDateTime(2020, 3, 1, 22, 0, 0).ToString());
+	}
+
+	//Monthly events coalesce over a year, April to March.
+	Clock->Cancel(CoalescedHandle);
+	Clock->Cancel(EveryHandle);
+
+	FEventLog MonthLog;
+	Clock->ScheduleMonthly(1, FTimespan::Zero(), MonthLog.Record(Clock, TEXT("Month")), EEnvironmentClockCatchUp::Coalesce);
+	Clock->AdvanceTo(FDateTime(2021, 3, 15));
+
+	if (TestEqual(TEXT("Monthly event fires once"), MonthLog.Entries.Num(), 1))
+	{
+		TestEqual(TEXT("Months"), MonthLog.Entries[0].Occurrences, 12);
+		TestEqual(TEXT("Latest month"), MonthLog.Entries[0].Time.ToString(), FDateTime(2021, 3, 1).ToString());
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEnvironmentClockRebaseTest, "FullEnvironmentDev.EnvironmentClock.Rebase",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FEnvironmentClockRebaseTest::RunTest(const FString& Parameters)
+{
+	using namespace EnvironmentClockTests;
+
+	FEventLog Log;
+	UEnvironmentClock* Clock = NewClock(FDateTime(2020, 3, 1, 6, 30, 0));
+
+	FEnvironmentClockHandle Hourly = Clock->ScheduleEvery(FTimespan::FromHours(1.0), FTimespan::Zero(), Log.Record(Clock, TEXT("Hourly")));
+	Clock->ScheduleAt(FDateTime(2020, 3, 1, 13, 0, 0), Log.Record(Clock, TEXT("Once")));
+	Clock->AdvanceTo(FDateTime(2020, 3, 1, 12, 30, 0));
+
+	TestEqual(TEXT("Hourly events before going back"), Log.Entries.Num(), 6);
+
+	//Going back fires nothing and reschedules from the earlier time.
+	Log.Entries.Reset();
+	Clock->AdvanceTo(FDateTime(2020, 3, 1, 8, 10, 0));
+
+	TestEqual(TEXT("Nothing fires when time goes back"), Log.Entries.Num(), 0);
+	TestEqual(TEXT("Clock moved back"), Clock->GetLocalTime().ToString(), FDateTime(2020, 3, 1, 8, 10, 0).ToString());
+
+	Clock->AdvanceTo(FDateTime(2020, 3, 1, 9, 5, 0));
+
+	if (TestEqual(TEXT("Repeating event fires again after going back"), Log.Entries.Num(), 1))
+	{
+		TestEqual(TEXT("Next occurrence after going back"), Log.Entries[0].Time.ToString(), FDateTime(2020, 3, 1, 9, 0, 0).ToString());
+	}
+
+	//The one shot event is still ahead and fires once.
+	Log.Entries.Reset();
+	Clock->AdvanceTo(FDateTime(2020, 3, 1, 13, 30, 0));
+
+	TestEqual(TEXT("Hourly events after going back"), Log.Entries.FilterByPredicate([](const FEventLog::FEntry& Entry) { return Entry.Name == TEXT("Hourly"); }).Num(), 4);
+	TestEqual(TEXT("One shot events after going back"), Log.Entries.FilterByPredicate([](const FEventLog::FEntry& Entry) { return Entry.Name == TEXT("Once"); }).Num(), 1);
+
+	//Going back across a wheel block relinks events beyond the wheel too.
+	Clock->Cancel(Hourly);
+
+	FEventLog FarLog;
+	Clock->ScheduleAt(FDateTime(2070, 1, 1), FarLog.Record(Clock, TEXT("Far")));
+	Clock->AdvanceTo(FDateTime(2000, 1, 1));
+	Clock->AdvanceTo(FDateTime(2070, 1, 1, 0, 0, 30));
+
+	TestEqual(TEXT("Far event fires once after going back decades"), FarLog.Entries.Num(), 1);
+
+	return true;
+}
+
+#endif
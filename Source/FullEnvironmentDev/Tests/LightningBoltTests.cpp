@@ -0,0 +1,151 @@
+// 2015 - Community based open project
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "LightningBolt.h"
+#include "Algo/NoneOf.h"
+
+/**
+* Lightning bolt generator tests, run headless with:
+* UE4Editor-Cmd FullEnvironmentDev.uproject -nullrhi -unattended -ExecCmds="Automation RunTests FullEnvironmentDev.LightningBolt;Quit"
+*/
+namespace LightningBoltTests
+{
+	const FVector Start(0.0f, 0.0f, 150000.0f);
+	const FVector End(20000.0f, -5000.0f, 0.0f);
+
+	bool IsSameSegment(const FLightningSegment& A, const FLightningSegment& B)
+	{
+		return A.Start == B.Start && A.End == B.End && A.Width == B.Width && A.Brightness == B.Brightness && A.Depth == B.Depth;
+	}
+
+	bool IsSameBolt(const TArray<FLightningSegment>& A, const TArray<FLightningSegment>& B)
+	{
+		if (A.Num() != B.Num())
+		{
+			return false;
+		}
+
+		for (int32 Index = 0; Index < A.Num(); Index++)
+		{
+			if (!IsSameSegment(A[Index], B[Index]))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLightningBoltDeterminismTest, "FullEnvironmentDev.LightningBolt.Determinism",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLightningBoltDeterminismTest::RunTest(const FString& Parameters)
+{
+	using namespace LightningBoltTests;
+
+	FLightningBoltGenerator First;
+	FLightningBoltGenerator Second;
+
+	First.Generate(42, Start, End);
+	const TArray<FLightningSegment> Bolt = First.GetSegments();
+
+	//Another bolt in between must not leak into the next one of the same seed.
+	Second.Generate(7, Start, End);
+	Second.Generate(42, Start, End);
+	TestTrue(TEXT("Same seed gives the same bolt on another generator"), IsSameBolt(Bolt, Second.GetSegments()));
+
+	First.Generate(42, Start, End);
+	TestTrue(TEXT("Same seed gives the same bolt again"), IsSameBolt(Bolt, First.GetSegments()));
+
+	First.Generate(43, Start, End);
+	TestFalse(TEXT("Another seed gives another bolt"), IsSameBolt(Bolt, First.GetSegments()));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLightningBoltBoundsTest, "FullEnvironmentDev.LightningBolt.Bounds",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLightningBoltBoundsTest::RunTest(const FString& Parameters)
+{
+	using namespace LightningBoltTests;
+
+	//Default, tight and branch heavy budgets.
+	FLightningBoltSettings Settings[3];
+	Settings[1].MaxSegments = 24;
+	Settings[2].MaxSegments = 4096;
+	Settings[2].BranchChance = 1.0f;
+	Settings[2].MaxBranchDepth = 3;
+
+	for (const FLightningBoltSettings& BoltSettings : Settings)
+	{
+		FLightningBoltGenerator Generator(BoltSettings);
+		int32 MostSegments = 0;
+		int32 DeepestBranch = 0;
+		bool bConnected = true;
+		bool bWholeMainChannel = true;
+
+		for (int32 Seed = 0; Seed < 100; Seed++)
+		{
+			Generator.Generate(Seed, Start, End);
+			const TArray<FLightningSegment>& Segments = Generator.GetSegments();
+
+			MostSegments = FMath::Max(MostSegments, Segments.Num());
+			int32 MainSegments = 0;
+
+			for (const FLightningSegment& Segment : Segments)
+			{
+				DeepestBranch = FMath::Max(DeepestBranch, Segment.Depth);
+				MainSegments += Segment.Depth == 0 ? 1 : 0;
+			}
+
+			//Main channel runs from the cloud to the strike point, branches only hang off it.
+			bConnected &= Segments.Num() > 0 && Segments[0].Start == Start && Segments[0].Depth == 0;
+
+			//Without a tight budget every main segment is split on every pass.
+			if (BoltSettings.MaxSegments >= 4096)
+			{
+				bWholeMainChannel &= MainSegments == (1 << BoltSettings.Subdivisions);
+			}
+		}
+
+		const FString Name = FString::Printf(TEXT("%d segments"), BoltSettings.MaxSegments);
+
+		TestTrue(Name + TEXT(": segments within MaxSegments"), MostSegments <= BoltSettings.MaxSegments);
+		TestTrue(Name + TEXT(": branches within MaxBranchDepth"), DeepestBranch <= BoltSettings.MaxBranchDepth);
+		TestTrue(Name + TEXT(": bolts start at the cloud"), bConnected);
+		TestTrue(Name + TEXT(": main channel fully split"), bWholeMainChannel);
+	}
+
+	//Mesh buffers keep their size for every bolt, so the mesh section is updated in place.
+	FLightningBoltGenerator Generator;
+	const int32 MaxSegments = Generator.GetSettings().MaxSegments;
+
+	TArray<FVector> Positions;
+	TArray<FVector2D> UVs;
+	TArray<FColor> Colors;
+	TArray<int32> Indices;
+
+	Generator.Generate(1, Start, End);
+	FLightningBoltGenerator::BuildVertices(Generator.GetSegments(), MaxSegments, Positions, UVs, Colors);
+	FLightningBoltGenerator::BuildIndices(MaxSegments, Indices);
+
+	const SIZE_T AllocatedSize = Positions.GetAllocatedSize() + UVs.GetAllocatedSize() + Colors.GetAllocatedSize();
+
+	Generator.Generate(2, Start, End);
+	FLightningBoltGenerator::BuildVertices(Generator.GetSegments(), MaxSegments, Positions, UVs, Colors);
+
+	TestEqual(TEXT("Vertices"), Positions.Num(), MaxSegments * FLightningBoltGenerator::VerticesPerSegment);
+	TestEqual(TEXT("Indices"), Indices.Num(), MaxSegments * FLightningBoltGenerator::IndicesPerSegment);
+	TestEqual(TEXT("Vertex buffers are reused"), Positions.GetAllocatedSize() + UVs.GetAllocatedSize() + Colors.GetAllocatedSize(), AllocatedSize);
+	TestTrue(TEXT("Indices within the vertices"), Algo::NoneOf(Indices, [&](int32 Index) { return Index < 0 || Index >= Positions.Num(); }));
+
+	return true;
+}
+
+#endif
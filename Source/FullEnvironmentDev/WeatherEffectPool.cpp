@@ -0,0 +1,399 @@
+// 2015 - Community based open project
+
+#include "WeatherEffectPool.h"
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/PlayerController.h"
+#include "Components/ActorComponent.h"
+#include "VolumetricCloudsMemory.h"
+
+DECLARE_STATS_GROUP(TEXT("WeatherEffectPool"), STATGROUP_WeatherEffectPool, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Tick"), STAT_WeatherEffectPool_Tick, STATGROUP_WeatherEffectPool);
+DECLARE_CYCLE_STAT(TEXT("Acquire"), STAT_WeatherEffectPool_Acquire, STATGROUP_WeatherEffectPool);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled actors"), STAT_WeatherEffectPool_Pooled, STATGROUP_WeatherEffectPool);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active actors"), STAT_WeatherEffectPool_Active, STATGROUP_WeatherEffectPool);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Acquired"), STAT_WeatherEffectPool_Acquired, STATGROUP_WeatherEffectPool);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawned"), STAT_WeatherEffectPool_Spawned, STATGROUP_WeatherEffectPool);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Taken over"), STAT_WeatherEffectPool_TakenOver, STATGROUP_WeatherEffectPool);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rejected"), STAT_WeatherEffectPool_Rejected, STATGROUP_WeatherEffectPool);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Culled"), STAT_WeatherEffectPool_Culled, STATGROUP_WeatherEffectPool);
+
+DEFINE_LOG_CATEGORY_STATIC(LogWeatherEffectPool, Log, All);
+
+UWeatherEffectPool::UWeatherEffectPool()
+	: bPrewarmed(false)
+{
+	//Rain and snow cover the view, lightning and thunder come in bursts during storms.
+	static const TTuple<const TCHAR*, int32, int32> DefaultClasses[] =
+	{
+		MakeTuple(TEXT("/Game/Universe/Sky/Weather/Effects/Rain.Rain_C"), 1, 1),
+		MakeTuple(TEXT("/Game/Universe/Sky/Weather/Effects/Snow.Snow_C"), 1, 1),
+		MakeTuple(TEXT("/Game/Universe/Sky/Weather/Effects/Lightning.Lightning_C"), 4, 4),
+		MakeTuple(TEXT("/Game/Universe/Sky/Weather/Effects/Thunder.Thunder_C"), 4, 4),
+		MakeTuple(TEXT("/Script/FullEnvironmentDev.LightningBoltActor"), 4, 4),
+	};
+
+	for (const TTuple<const TCHAR*, int32, int32>& DefaultClass : DefaultClasses)
+	{
+		FWeatherEffectPoolClass PoolClass;
+		PoolClass.Class = DefaultClass.Get<0>();
+		PoolClass.PrewarmCount = DefaultClass.Get<1>();
+		PoolClass.MaxActive = DefaultClass.Get<2>();
+		Classes.Add(PoolClass);
+	}
+}
+
+UWeatherEffectPool* UWeatherEffectPool::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UObject* Object : World->PerModuleDataObjects)
+	{
+		if (UWeatherEffectPool* Pool = Cast<UWeatherEffectPool>(Object))
+		{
+			return Pool;
+		}
+	}
+
+	UWeatherEffectPool* Pool = NewObject<UWeatherEffectPool>(World);
+	World->PerModuleDataObjects.Add(Pool);
+
+	return Pool;
+}
+
+void UWeatherEffectPool::Prewarm()
+{
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::WeatherEffects);
+
+	bPrewarmed = true;
+
+	for (const FWeatherEffectPoolClass& PoolClass : Classes)
+	{
+		UClass* Class = PoolClass.Class.TryLoadClass<AActor>();
+
+		if (Class == nullptr)
+		{
+			UE_LOG(LogWeatherEffectPool, Warning, TEXT("Weather effect class %s not found."), *PoolClass.Class.ToString());
+			continue;
+		}
+
+		FWeatherEffectPoolBucket& Bucket = FindOrAddBucket(Class);
+		Bucket.MaxActive = PoolClass.MaxActive;
+		Bucket.MaxDistance = PoolClass.MaxDistance;
+
+		//Reserve for the worst case so a storm never grows the lists.
+		const int32 Capacity = FMath::Max(PoolClass.PrewarmCount, PoolClass.MaxActive);
+		Bucket.FreeActors.Reserve(Capacity);
+		Bucket.ActiveActors.Reserve(Capacity);
+		Bucket.ReleaseTimes.Reserve(Capacity);
+
+		for (int32 Index = Bucket.FreeActors.Num(); Index < PoolClass.PrewarmCount; Index++)
+		{
+			if (AActor* Actor = SpawnActor(Class))
+			{
+				Bucket.FreeActors.Add(Actor);
+			}
+		}
+	}
+}
+
+FWeatherEffectPoolBucket& UWeatherEffectPool::FindOrAddBucket(UClass* Class)
+{
+	for (FWeatherEffectPoolBucket& Bucket : Buckets)
+	{
+		if (Bucket.Class == Class)
+		{
+			return Bucket;
+		}
+	}
+
+	FWeatherEffectPoolBucket& Bucket = Buckets.AddDefaulted_GetRef();
+	Bucket.Class = Class;
+
+	return Bucket;
+}
+
+AActor* UWeatherEffectPool::SpawnActor(UClass* Class)
+{
+	VOLUMETRIC_CLOUDS_LLM_SCOPE(EVolumetricCloudsMemorySystem::WeatherEffects);
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParameters.ObjectFlags |= RF_Transient;
+
+	AActor* Actor = GetWorld()->SpawnActor<AActor>(Class, FTransform::Identity, SpawnParameters);
+
+	if (Actor != nullptr)
+	{
+		INC_DWORD_STAT(STAT_WeatherEffectPool_Spawned);
+		SetActorActive(Actor, false);
+	}
+
+	return Actor;
+}
+
+void UWeatherEffectPool::SetActorActive(AActor* Actor, bool bActive)
+{
+	Actor->SetActorHiddenInGame(!bActive);
+	Actor->SetActorEnableCollision(bActive);
+	Actor->SetActorTickEnabled(bActive);
+
+	for (UActorComponent* Component : Actor->GetComponents())
+	{
+		if (bActive)
+		{
+			//Reset restarts particle systems and sounds from their first frame.
+			Component->Activate(true);
+		}
+		else
+		{
+			Component->Deactivate();
+		}
+	}
+
+	if (Actor->GetClass()->ImplementsInterface(UWeatherEffectPoolable::StaticClass()))
+	{
+		if (bActive)
+		{
+			IWeatherEffectPoolable::Execute_OnEffectActivated(Actor);
+		}
+		else
+		{
+			IWeatherEffectPoolable::Execute_OnEffectDeactivated(Actor);
+		}
+	}
+}
+
+bool UWeatherEffectPool::GetViewLocation(FVector& OutLocation) const
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+
+	if (PlayerController == nullptr)
+	{
+		return false;
+	}
+
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(OutLocation, ViewRotation);
+
+	return true;
+}
+
+int32 UWeatherEffectPool::FindFarthestActive(const FWeatherEffectPoolBucket& Bucket, float& OutDistanceSquared) const
+{
+	FVector ViewLocation;
+
+	if (!GetViewLocation(ViewLocation))
+	{
+		//Without a view the oldest actor is taken over.
+		OutDistanceSquared = BIG_NUMBER;
+		return Bucket.ActiveActors.Num() > 0 ? 0 : INDEX_NONE;
+	}
+
+	int32 FarthestIndex = INDEX_NONE;
+	OutDistanceSquared = -1.0f;
+
+	for (int32 Index = 0; Index < Bucket.ActiveActors.Num(); Index++)
+	{
+		const float DistanceSquared = FVector::DistSquared(Bucket.ActiveActors[Index]->GetActorLocation(), ViewLocation);
+
+		if (DistanceSquared > OutDistanceSquared)
+		{
+			OutDistanceSquared = DistanceSquared;
+			FarthestIndex = Index;
+		}
+	}
+
+	return FarthestIndex;
+}
+
+AActor* UWeatherEffectPool::Acquire(TSubclassOf<AActor> Class, const FTransform& Transform, float Lifetime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_WeatherEffectPool_Acquire);
+
+	if (Class == nullptr)
+	{
+		return nullptr;
+	}
+
+	FWeatherEffectPoolBucket& Bucket = FindOrAddBucket(Class);
+	AActor* Actor = nullptr;
+
+	if (Bucket.MaxActive > 0 && Bucket.ActiveActors.Num() >= Bucket.MaxActive)
+	{
+		float FarthestDistanceSquared;
+		const int32 FarthestIndex = FindFarthestActive(Bucket, FarthestDistanceSquared);
+
+		FVector ViewLocation;
+		const float DistanceSquared = GetViewLocation(ViewLocation) ? FVector::DistSquared(Transform.GetLocation(), ViewLocation) : 0.0f;
+
+		if (FarthestIndex == INDEX_NONE || DistanceSquared >= FarthestDistanceSquared)
+		{
+			INC_DWORD_STAT(STAT_WeatherEffectPool_Rejected);
+			return nullptr;
+		}
+
+		INC_DWORD_STAT(STAT_WeatherEffectPool_TakenOver);
+		ReleaseAt(Bucket, FarthestIndex);
+	}
+
+	//Destroyed actors, e.g. by a level unload, are dropped from the free list.
+	while (Actor == nullptr && Bucket.FreeActors.Num() > 0)
+	{
+		AActor* FreeActor = Bucket.FreeActors.Pop(false);
+		Actor = IsValid(FreeActor) ? FreeActor : nullptr;
+	}
+
+	if (Actor == nullptr)
+	{
+		Actor = SpawnActor(Class);
+
+		if (Actor == nullptr)
+		{
+			return nullptr;
+		}
+	}
+
+	Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorActive(Actor, true);
+
+	Bucket.ActiveActors.Add(Actor);
+	Bucket.ReleaseTimes.Add(Lifetime > 0.0f ? GetWorld()->GetTimeSeconds() + Lifetime : 0.0f);
+
+	INC_DWORD_STAT(STAT_WeatherEffectPool_Acquired);
+
+	return Actor;
+}
+
+void UWeatherEffectPool::ReleaseAt(FWeatherEffectPoolBucket& Bucket, int32 ActiveIndex)
+{
+	AActor* Actor = Bucket.ActiveActors[ActiveIndex];
+	Bucket.ActiveActors.RemoveAtSwap(ActiveIndex, 1, false);
+	Bucket.ReleaseTimes.RemoveAtSwap(ActiveIndex, 1, false);
+
+	if (IsValid(Actor))
+	{
+		SetActorActive(Actor, false);
+		Bucket.FreeActors.Add(Actor);
+	}
+}
+
+void UWeatherEffectPool::Release(AActor* Actor)
+{
+	if (Actor == nullptr)
+	{
+		return;
+	}
+
+	for (FWeatherEffectPoolBucket& Bucket : Buckets)
+	{
+		if (Bucket.Class == Actor->GetClass())
+		{
+			const int32 ActiveIndex = Bucket.ActiveActors.Find(Actor);
+
+			if (ActiveIndex != INDEX_NONE)
+			{
+				ReleaseAt(Bucket, ActiveIndex);
+			}
+
+			return;
+		}
+	}
+}
+
+void UWeatherEffectPool::ReleaseAll()
+{
+	for (FWeatherEffectPoolBucket& Bucket : Buckets)
+	{
+		while (Bucket.ActiveActors.Num() > 0)
+		{
+			ReleaseAt(Bucket, Bucket.ActiveActors.Num() - 1);
+		}
+	}
+}
+
+void UWeatherEffectPool::GetActiveEffects(TArray<FWeatherEffectPoolEntry>& OutEffects) const
+{
+	const float Time = GetWorld()->GetTimeSeconds();
+
+	OutEffects.Reset();
+
+	for (const FWeatherEffectPoolBucket& Bucket : Buckets)
+	{
+		for (int32 ActiveIndex = 0; ActiveIndex < Bucket.ActiveActors.Num(); ActiveIndex++)
+		{
+			FWeatherEffectPoolEntry& Effect = OutEffects.AddDefaulted_GetRef();
+			Effect.Class = Bucket.Class;
+			Effect.Transform = Bucket.ActiveActors[ActiveIndex]->GetActorTransform();
+
+			//Effects about to be released keep a short lifetime instead of living forever.
+			const float ReleaseTime = Bucket.ReleaseTimes[ActiveIndex];
+			Effect.Lifetime = ReleaseTime > 0.0f ? FMath::Max(ReleaseTime - Time, KINDA_SMALL_NUMBER) : 0.0f;
+		}
+	}
+}
+
+void UWeatherEffectPool::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_WeatherEffectPool_Tick);
+
+	if (!bPrewarmed)
+	{
+		Prewarm();
+	}
+
+	const float Time = GetWorld()->GetTimeSeconds();
+
+	FVector ViewLocation;
+	const bool bHasView = GetViewLocation(ViewLocation);
+
+	int32 NumPooled = 0;
+	int32 NumActive = 0;
+
+	for (FWeatherEffectPoolBucket& Bucket : Buckets)
+	{
+		//Backwards, released actors are swapped in from the end.
+		for (int32 Index = Bucket.ActiveActors.Num() - 1; Index >= 0; Index--)
+		{
+			AActor* Actor = Bucket.ActiveActors[Index];
+
+			const bool bExpired = Bucket.ReleaseTimes[Index] > 0.0f && Time >= Bucket.ReleaseTimes[Index];
+			const bool bTooFar = bHasView && Bucket.MaxDistance > 0.0f && IsValid(Actor)
+				&& FVector::DistSquared(Actor->GetActorLocation(), ViewLocation) > FMath::Square(Bucket.MaxDistance);
+
+			if (bTooFar)
+			{
+				INC_DWORD_STAT(STAT_WeatherEffectPool_Culled);
+			}
+
+			if (bExpired || bTooFar || !IsValid(Actor))
+			{
+				ReleaseAt(Bucket, Index);
+			}
+		}
+
+		NumPooled += Bucket.FreeActors.Num() + Bucket.ActiveActors.Num();
+		NumActive += Bucket.ActiveActors.Num();
+	}
+
+	SET_DWORD_STAT(STAT_WeatherEffectPool_Pooled, NumPooled);
+	SET_DWORD_STAT(STAT_WeatherEffectPool_Active, NumActive);
+}
+
+bool UWeatherEffectPool::IsTickable() const
+{
+	//Pre-warming spawns actors, so it waits until the world begins play.
+	return !IsTemplate() && GetWorld() != nullptr && GetWorld()->IsGameWorld() && GetWorld()->HasBegunPlay();
+}
+
+TStatId UWeatherEffectPool::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UWeatherEffectPool, STATGROUP_Tickables);
+}
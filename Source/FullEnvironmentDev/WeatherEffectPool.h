@@ -0,0 +1,158 @@
+// 2015 - Community based open project
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "UObject/Interface.h"
+#include "Tickable.h"
+
+#include "WeatherEffectPool.generated.h"
+
+/** Weather effect class kept in the pool. */
+USTRUCT()
+struct FWeatherEffectPoolClass
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+	FSoftClassPath Class;
+
+	/** Actors spawned when the world begins play. */
+	UPROPERTY(Config)
+	int32 PrewarmCount = 0;
+
+	/** Most actors active at once, the farthest one is recycled for a closer request. 0 is no limit. */
+	UPROPERTY(Config)
+	int32 MaxActive = 0;
+
+	/** Active actors farther than this from the view are deactivated. 0 is no limit. */
+	UPROPERTY(Config)
+	float MaxDistance = 0.0f;
+};
+
+/** Actors of a single effect class. */
+USTRUCT()
+struct FWeatherEffectPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UClass* Class = nullptr;
+
+	UPROPERTY()
+	TArray<AActor*> FreeActors;
+
+	UPROPERTY()
+	TArray<AActor*> ActiveActors;
+
+	/** World time an active actor is released at, 0 if it lives until released. Parallel to ActiveActors. */
+	TArray<float> ReleaseTimes;
+
+	int32 MaxActive = 0;
+	float MaxDistance = 0.0f;
+};
+
+/** Active pooled effect, e.g. to save and restore it. */
+struct FWeatherEffectPoolEntry
+{
+	UClass* Class = nullptr;
+	FTransform Transform;
+
+	/** Seconds until it is released on its own, 0 if it lives until released. */
+	float Lifetime = 0.0f;
+};
+
+UINTERFACE(BlueprintType)
+class FULLENVIRONMENTDEV_API UWeatherEffectPoolable : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/** Optional interface of pooled effects that need more than their components reactivated. */
+class FULLENVIRONMENTDEV_API IWeatherEffectPoolable
+{
+	GENERATED_BODY()
+
+public:
+	/** Actor was taken from the pool and moved to its new transform. */
+	UFUNCTION(BlueprintNativeEvent, Category = "Weather")
+	void OnEffectActivated();
+
+	/** Actor was returned to the pool. */
+	UFUNCTION(BlueprintNativeEvent, Category = "Weather")
+	void OnEffectDeactivated();
+};
+
+/**
+* Pool of weather effect actors. Rain, snow, lightning and thunder are pre-warmed when the world begins play
+* and recycled by hiding them and deactivating their components instead of spawning and destroying them,
+* so a steady storm neither spawns actors nor leaves garbage behind. Live counts are capped per class,
+* a request closer to the view than the farthest active actor takes that actor over.
+*/
+UCLASS(Config = Game)
+class FULLENVIRONMENTDEV_API UWeatherEffectPool : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UWeatherEffectPool();
+
+	/** Pool of a world, created on the first call. */
+	UFUNCTION(BlueprintPure, Category = "Weather", meta = (WorldContext = "WorldContextObject"))
+	static UWeatherEffectPool* Get(const UObject* WorldContextObject);
+
+	/** Activate a pooled effect actor.
+	* @param Class - effect class, classes that aren't configured get a pool without limits.
+	* @param Transform - effect transform.
+	* @param Lifetime - seconds until the actor is released on its own, 0 keeps it until Release.
+	* @return nullptr if the class is at its limit and every active actor is closer to the view.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Weather")
+	AActor* Acquire(TSubclassOf<AActor> Class, const FTransform& Transform, float Lifetime = 0.0f);
+
+	/** Return an effect actor to its pool, actors that weren't acquired from the pool are ignored. */
+	UFUNCTION(BlueprintCallable, Category = "Weather")
+	void Release(AActor* Actor);
+
+	/** Release every active actor, e.g. when the weather clears. */
+	UFUNCTION(BlueprintCallable, Category = "Weather")
+	void ReleaseAll();
+
+	/** Every active actor with its remaining lifetime. */
+	void GetActiveEffects(TArray<FWeatherEffectPoolEntry>& OutEffects) const;
+
+	UPROPERTY(Config)
+	TArray<FWeatherEffectPoolClass> Classes;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	/** Load the configured classes and spawn their pre-warmed actors. */
+	void Prewarm();
+
+	FWeatherEffectPoolBucket& FindOrAddBucket(UClass* Class);
+
+	AActor* SpawnActor(UClass* Class);
+
+	/** Show or hide an actor and (de)activate its components. */
+	void SetActorActive(AActor* Actor, bool bActive);
+
+	/** Move an active actor back to the free list. */
+	void ReleaseAt(FWeatherEffectPoolBucket& Bucket, int32 ActiveIndex);
+
+	/** Index of the active actor farthest from the view. */
+	int32 FindFarthestActive(const FWeatherEffectPoolBucket& Bucket, float& OutDistanceSquared) const;
+
+	/** Location of the first local player's view. */
+	bool GetViewLocation(FVector& OutLocation) const;
+
+	UPROPERTY()
+	TArray<FWeatherEffectPoolBucket> Buckets;
+
+	bool bPrewarmed;
+};